@@ -0,0 +1,175 @@
+//=============================================================================
+//
+//   File : KviConfigurationFileBenchmark.cpp
+//   Creation date : Tue Oct 20 2026 00:41:07 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 Szymon Stefanek (pragma at kvirc dot net)
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+//
+// Measures how long it takes to load a large configuration file from its
+// text and from its binary image (see KviConfigurationFile.cpp).
+//
+// Usage: kviconfigbench [entries] [runs]   (defaults: 50000 entries, 10 runs)
+//
+
+#include "KviConfigurationFile.h"
+#include "kvi_fileextensions.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// entries per group, roughly what the server database looks like
+#define BENCH_GROUP_SIZE 25
+
+static void bench_write(const QString & szFileName, int iEntries)
+{
+	KviConfigurationFile cfg(szFileName, KviConfigurationFile::Write);
+	for(int i = 0; i < iEntries; i++)
+	{
+		if((i % BENCH_GROUP_SIZE) == 0)
+			cfg.setGroup(QString("irc.network%1.org").arg(i / BENCH_GROUP_SIZE));
+		cfg.writeEntry(QString("Key%1").arg(i % BENCH_GROUP_SIZE), QString("value %1 with some text, \xc3\xa9\xc3\xa8 and spaces  ").arg(i));
+	}
+	// saved (and imaged) by the destructor
+}
+
+static unsigned int bench_count(KviConfigurationFile & cfg)
+{
+	unsigned int uCount = 0;
+	KviConfigurationFileIterator it(*(cfg.dict()));
+	while(KviConfigurationFileGroup * pGroup = it.current())
+	{
+		uCount += pGroup->count();
+		++it;
+	}
+	return uCount;
+}
+
+static bool bench_same(KviConfigurationFile & a, KviConfigurationFile & b)
+{
+	if(a.groupsCount() != b.groupsCount())
+		return false;
+	KviConfigurationFileIterator it(*(a.dict()));
+	while(KviConfigurationFileGroup * pGroup = it.current())
+	{
+		KviConfigurationFileGroup * pOther = b.dict()->find(it.currentKey());
+		if(!pOther || (pOther->count() != pGroup->count()))
+			return false;
+		KviConfigurationFileGroupIterator it2(*pGroup);
+		while(QString * pValue = it2.current())
+		{
+			QString * pOtherValue = pOther->find(it2.currentKey());
+			if(!pOtherValue || (*pOtherValue != *pValue))
+				return false;
+			++it2;
+		}
+		++it;
+	}
+	return true;
+}
+
+// returns the median load time in msecs
+static double bench_load(const QString & szFileName, int iRuns, unsigned int & uEntries)
+{
+	std::vector<qint64> vTimes;
+	for(int i = 0; i < iRuns; i++)
+	{
+		QElapsedTimer t;
+		t.start();
+		KviConfigurationFile cfg(szFileName, KviConfigurationFile::Read);
+		vTimes.push_back(t.nsecsElapsed());
+		uEntries = bench_count(cfg);
+	}
+	std::sort(vTimes.begin(), vTimes.end());
+	return vTimes[vTimes.size() / 2] / 1000000.0;
+}
+
+int main(int argc, char ** argv)
+{
+	QCoreApplication app(argc, argv);
+
+	int iEntries = (argc > 1) ? std::atoi(argv[1]) : 50000;
+	int iRuns = (argc > 2) ? std::atoi(argv[2]) : 10;
+	if((iEntries < 1) || (iRuns < 1))
+	{
+		std::fprintf(stderr, "Usage: %s [entries] [runs]\n", argv[0]);
+		return 1;
+	}
+
+	QTemporaryDir dir;
+	if(!dir.isValid())
+	{
+		std::fprintf(stderr, "Can't create a temporary directory\n");
+		return 1;
+	}
+	QString szFileName = dir.filePath("bench.kvc");
+	QString szCacheFileName = szFileName + QString::fromUtf8(KVI_FILEEXTENSION_CONFIGCACHE);
+
+	KviConfigurationFile::setCacheDirectory(dir.path());
+	bench_write(szFileName, iEntries);
+	std::printf("%d entries, %lld bytes of text, %lld bytes of image\n", iEntries,
+	    (long long)QFile(szFileName).size(), (long long)QFile(szCacheFileName).size());
+
+	// the text only
+	KviConfigurationFile::setCacheDirectory(QString());
+	unsigned int uTextEntries = 0;
+	double dText = bench_load(szFileName, iRuns, uTextEntries);
+
+	// parsing the text and writing the image
+	KviConfigurationFile::setCacheDirectory(dir.path());
+	std::vector<qint64> vTimes;
+	for(int i = 0; i < iRuns; i++)
+	{
+		QFile::remove(szCacheFileName);
+		QElapsedTimer t;
+		t.start();
+		KviConfigurationFile cfg(szFileName, KviConfigurationFile::Read);
+		vTimes.push_back(t.nsecsElapsed());
+	}
+	std::sort(vTimes.begin(), vTimes.end());
+	double dRebuild = vTimes[vTimes.size() / 2] / 1000000.0;
+
+	// the image
+	unsigned int uImageEntries = 0;
+	double dImage = bench_load(szFileName, iRuns, uImageEntries);
+
+	std::printf("text:          %9.3f ms (%u entries)\n", dText, uTextEntries);
+	std::printf("text + image:  %9.3f ms\n", dRebuild);
+	std::printf("image:         %9.3f ms (%u entries)\n", dImage, uImageEntries);
+
+	// the image must load exactly what the text does
+	KviConfigurationFile::setCacheDirectory(QString());
+	KviConfigurationFile fromText(szFileName, KviConfigurationFile::Read);
+	KviConfigurationFile::setCacheDirectory(dir.path());
+	KviConfigurationFile fromImage(szFileName, KviConfigurationFile::Read);
+	if(!QFile::exists(szCacheFileName) || !bench_same(fromText, fromImage))
+	{
+		std::fprintf(stderr, "The image doesn't match the text!\n");
+		return 1;
+	}
+	return 0;
+}
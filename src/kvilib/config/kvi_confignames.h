@@ -86,5 +86,6 @@
 #define KVI_CONFIGFILE_SCRIPTADDONS "scriptaddons" KVI_FILEEXTENSION_CONFIG
 #define KVI_CONFIGFILE_IDENTITIES "identities" KVI_FILEEXTENSION_CONFIG
 #define KVI_CONFIGFILE_DEFAULTSCRIPT "default" KVI_FILEEXTENSION_CONFIG
+#define KVI_CONFIGFILE_MODULESTATS "modulestats" KVI_FILEEXTENSION_CONFIG
 
 #endif //_KVI_CONFIGNAMES_H_
@@ -38,11 +38,13 @@
 * \def KVI_FILEEXTENSION_SCRIPT Script file .kvs
 * \def KVI_FILEEXTENSION_THEMEPACKAGE Theme package .kvt
 * \def KVI_FILEEXTENSION_ADDONPACKAGE Addon package .kva
+* \def KVI_FILEEXTENSION_CONFIGCACHE Binary image of a configuration file .kvcc (appended to the full name)
 */
 #define KVI_FILEEXTENSION_CONFIG ".kvc"
 #define KVI_FILEEXTENSION_SCRIPT ".kvs"
 #define KVI_FILEEXTENSION_THEMEPACKAGE ".kvt"
 #define KVI_FILEEXTENSION_ADDONPACKAGE ".kva"
+#define KVI_FILEEXTENSION_CONFIGCACHE ".kvcc"
 
 /**
 * \brief File filters
@@ -29,10 +29,57 @@
 #include "KviStringConversion.h"
 #include "KviMemory.h"
 #include "KviFile.h"
+#include "kvi_fileextensions.h"
 
 #include <QColor>
+#include <QCoreApplication>
+#include <QDir>
 #include <QRect>
 #include <QSaveFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+
+#include <cstring>
+#include <utility>
+
+// The files being parsed by preload(): a nullptr value means "not done yet"
+static QHash<QString, KviConfigurationFile *> g_hPreloaded;
+static QMutex g_preloadMutex;
+static QWaitCondition g_preloadDone;
+
+class KviConfigurationFilePreloader : public QRunnable
+{
+public:
+	KviConfigurationFilePreloader(const QString & szFileName)
+	    : m_szFileName(szFileName){};
+
+protected:
+	QString m_szFileName;
+
+public:
+	void run() override
+	{
+		// not through the Read constructor: it would wait for this very entry
+		KviConfigurationFile * pCfg = new KviConfigurationFile(m_szFileName, KviConfigurationFile::Write);
+		pCfg->setReadOnly(true);
+		pCfg->load();
+		QMutexLocker locker(&g_preloadMutex);
+		auto it = g_hPreloaded.find(m_szFileName);
+		if(it == g_hPreloaded.end())
+		{
+			delete pCfg; // discarded meanwhile
+			return;
+		}
+		it.value() = pCfg;
+		g_preloadDone.wakeAll();
+	}
+};
 
 KviConfigurationFile::KviConfigurationFile(const QString & filename, FileMode f, bool bLocal8Bit)
 {
@@ -42,10 +89,14 @@ KviConfigurationFile::KviConfigurationFile(const QString & filename, FileMode f,
 	m_szGroup = KVI_CONFIG_DEFAULT_GROUP;
 	m_bPreserveEmptyGroups = false;
 	m_bReadOnly = (f == KviConfigurationFile::Read);
+	m_bCacheStale = false;
 	m_pDict = new KviPointerHashTable<QString, KviConfigurationFileGroup>(17, false);
 	m_pDict->setAutoDelete(true);
 	if(f != KviConfigurationFile::Write)
-		load();
+	{
+		if(!adoptPreloaded())
+			load();
+	}
 }
 
 KviConfigurationFile::KviConfigurationFile(const char * filename, FileMode f, bool bLocal8Bit)
@@ -56,10 +107,14 @@ KviConfigurationFile::KviConfigurationFile(const char * filename, FileMode f, bo
 	m_szGroup = KVI_CONFIG_DEFAULT_GROUP;
 	m_bPreserveEmptyGroups = false;
 	m_bReadOnly = (f == KviConfigurationFile::Read);
+	m_bCacheStale = false;
 	m_pDict = new KviPointerHashTable<QString, KviConfigurationFileGroup>(17, false);
 	m_pDict->setAutoDelete(true);
 	if(f != KviConfigurationFile::Write)
-		load();
+	{
+		if(!adoptPreloaded())
+			load();
+	}
 }
 
 KviConfigurationFile::~KviConfigurationFile()
@@ -69,6 +124,67 @@ KviConfigurationFile::~KviConfigurationFile()
 	delete m_pDict;
 }
 
+void KviConfigurationFile::preload(const QStringList & lFileNames)
+{
+	for(auto & szFileName : lFileNames)
+	{
+		{
+			QMutexLocker locker(&g_preloadMutex);
+			if(g_hPreloaded.contains(szFileName))
+				continue;
+			g_hPreloaded.insert(szFileName, nullptr);
+		}
+		QThreadPool::globalInstance()->start(new KviConfigurationFilePreloader(szFileName));
+	}
+}
+
+void KviConfigurationFile::discardPreloaded()
+{
+	QMutexLocker locker(&g_preloadMutex);
+	// the running parsers see that their entry is gone and clean up by themselves
+	for(auto pCfg : g_hPreloaded)
+		delete pCfg;
+	g_hPreloaded.clear();
+	g_preloadDone.wakeAll();
+}
+
+bool KviConfigurationFile::adoptPreloaded()
+{
+	QMutexLocker locker(&g_preloadMutex);
+	if(g_hPreloaded.isEmpty())
+		return false; // the common case after startup
+
+	auto it = g_hPreloaded.find(m_szFileName);
+	if(it == g_hPreloaded.end())
+		return false;
+
+	while(!it.value())
+	{
+		g_preloadDone.wait(&g_preloadMutex);
+		it = g_hPreloaded.find(m_szFileName);
+		if(it == g_hPreloaded.end())
+			return false; // discarded meanwhile
+	}
+
+	KviConfigurationFile * pCfg = it.value();
+	g_hPreloaded.erase(it);
+	locker.unlock();
+
+	if(pCfg->m_bLocal8Bit != m_bLocal8Bit)
+	{
+		// parsed with the wrong encoding
+		delete pCfg;
+		return false;
+	}
+
+	std::swap(m_pDict, pCfg->m_pDict);
+	// the parser thread left the binary image to us
+	if(pCfg->m_bCacheStale)
+		refreshCache();
+	delete pCfg;
+	return true;
+}
+
 void KviConfigurationFile::clear()
 {
 	delete m_pDict;
@@ -97,7 +213,303 @@ void KviConfigurationFile::clearKey(const QString & szKey)
 
 #define LOAD_BLOCK_SIZE 32768
 
+//
+// The binary image of a parsed configuration file
+//
+// It is written next to the text file (with KVI_FILEEXTENSION_CONFIGCACHE appended
+// to its name) every time the text is parsed or saved and it is used instead of
+// the text as long as the modification time, the size and the hash of the text match
+// (hashing the text is still way cheaper than parsing it).
+// The text stays the authoritative (and hand editable) copy: a stale or broken
+// image is simply ignored and rewritten.
+//
+// Only the files in the directory set by setCacheDirectory() (the local
+// configuration directory) get an image and the images are written only
+// by the GUI thread: the preloader threads leave the job to whoever
+// adopts their results.
+//
+// The layout is: the header, the group index, the entry index and the string table.
+// Everything is in the native byte order (uVersion doubles as the byte order check),
+// the strings are utf16 and the file is mapped, so loading it is a matter of
+// copying the strings out of it.
+//
+
+// the small files are parsed faster than their image is validated
+#define KVI_CONFIG_CACHE_MIN_SIZE 16384
+#define KVI_CONFIG_CACHE_VERSION 2
+
+struct KviConfigurationCacheHeader
+{
+	char cMagic[4]; // "KVCC"
+	quint32 uVersion;
+	qint64 iTextModified; // msecs since epoch
+	qint64 iTextSize;
+	quint64 uTextHash;
+	quint32 uGroupCount;
+	quint32 uEntryCount;
+	quint32 uStringTableSize;
+	quint32 uReserved;
+	quint64 uHash; // of everything after the header
+};
+
+// uEntryCount entries of each group follow the ones of the previous group in the entry index
+struct KviConfigurationCacheGroup
+{
+	quint32 uName; // offset in the string table
+	quint32 uEntryCount;
+};
+
+struct KviConfigurationCacheEntry
+{
+	quint32 uKey;
+	quint32 uValue;
+};
+
+// A string in the table: a quint32 length in utf16 chars followed by the chars, padded to 4 bytes
+static quint32 config_cache_string(QByteArray & table, QHash<QString, quint32> & hOffsets, const QString & szString)
+{
+	auto it = hOffsets.constFind(szString);
+	if(it != hOffsets.constEnd())
+		return it.value(); // the keys repeat a lot
+
+	quint32 uOffset = table.size();
+	quint32 uLen = szString.length();
+	int iBytes = uLen * sizeof(QChar);
+	table.append((const char *)&uLen, sizeof(uLen));
+	table.append((const char *)szString.unicode(), iBytes);
+	table.append(((iBytes + 3) & ~3) - iBytes, '\0');
+	hOffsets.insert(szString, uOffset);
+	return uOffset;
+}
+
+static bool config_cache_read_string(const uchar * pTable, quint32 uTableSize, quint32 uOffset, QString & szString)
+{
+	if((uOffset & 3) || ((qint64)uOffset + 4 > uTableSize))
+		return false;
+	quint32 uLen;
+	std::memcpy(&uLen, pTable + uOffset, sizeof(uLen));
+	if((qint64)uOffset + 4 + (qint64)uLen * 2 > uTableSize)
+		return false;
+	// the empty values are loaded as null strings from the text too
+	szString = uLen ? QString((const QChar *)(pTable + uOffset + 4), uLen) : QString();
+	return true;
+}
+
+static QString config_cache_file_name(const QString & szFileName)
+{
+	return szFileName + QString::fromUtf8(KVI_FILEEXTENSION_CONFIGCACHE);
+}
+
+// set once at startup, before any preloader thread runs
+static QString g_szCacheDirectory;
+
+void KviConfigurationFile::setCacheDirectory(const QString & szDirectory)
+{
+	g_szCacheDirectory = szDirectory.isEmpty() ? QString() : QDir::cleanPath(QFileInfo(szDirectory).absoluteFilePath()) + "/";
+}
+
+static bool config_cache_enabled(const QFileInfo & inf)
+{
+	if(g_szCacheDirectory.isEmpty() || !inf.exists() || (inf.size() < KVI_CONFIG_CACHE_MIN_SIZE))
+		return false;
+	return QDir::cleanPath(inf.absoluteFilePath()).startsWith(g_szCacheDirectory);
+}
+
+static bool config_cache_on_gui_thread()
+{
+	// no application object at all: nobody else to leave the job to
+	QCoreApplication * pApp = QCoreApplication::instance();
+	return !pApp || (QThread::currentThread() == pApp->thread());
+}
+
+static bool config_cache_text_hash(const QString & szFileName, quint64 & uHash)
+{
+	QFile f(szFileName);
+	if(!f.open(QFile::ReadOnly))
+		return false;
+	qint64 iSize = f.size();
+	const uchar * pData = iSize ? f.map(0, iSize) : nullptr;
+	if(pData)
+	{
+		uHash = (quint64)qHashBits(pData, iSize, 0);
+		return true;
+	}
+	QByteArray data = f.readAll();
+	uHash = (quint64)qHashBits(data.constData(), data.size(), 0);
+	return true;
+}
+
+bool KviConfigurationFile::loadCache()
+{
+	if(m_bLocal8Bit)
+		return false;
+
+	QFileInfo inf(m_szFileName);
+	if(!config_cache_enabled(inf))
+		return false;
+
+	QFile f(config_cache_file_name(m_szFileName));
+	if(!f.open(QFile::ReadOnly))
+		return false;
+
+	qint64 iSize = f.size();
+	if(iSize < (qint64)sizeof(KviConfigurationCacheHeader))
+		return false;
+
+	QByteArray buffer;
+	const uchar * pData = f.map(0, iSize);
+	if(!pData)
+	{
+		buffer = f.readAll();
+		if(buffer.size() != iSize)
+			return false;
+		pData = (const uchar *)buffer.constData();
+	}
+
+	KviConfigurationCacheHeader h;
+	std::memcpy(&h, pData, sizeof(h));
+	if((std::memcmp(h.cMagic, "KVCC", 4) != 0) || (h.uVersion != KVI_CONFIG_CACHE_VERSION))
+		return false;
+	if((h.iTextModified != inf.lastModified().toMSecsSinceEpoch()) || (h.iTextSize != inf.size()))
+		return false; // the text has been changed
+
+	// a same size edit within the mtime granularity of the filesystem
+	quint64 uTextHash;
+	if(!config_cache_text_hash(m_szFileName, uTextHash) || (uTextHash != h.uTextHash))
+		return false;
+
+	qint64 iIndexSize = (qint64)h.uGroupCount * sizeof(KviConfigurationCacheGroup) + (qint64)h.uEntryCount * sizeof(KviConfigurationCacheEntry);
+	if((qint64)sizeof(h) + iIndexSize + h.uStringTableSize != iSize)
+		return false;
+
+	const uchar * pBody = pData + sizeof(h);
+	if((quint64)qHashBits(pBody, iSize - sizeof(h), 0) != h.uHash)
+		return false;
+
+	const uchar * pGroups = pBody;
+	const uchar * pEntries = pGroups + h.uGroupCount * sizeof(KviConfigurationCacheGroup);
+	const uchar * pTable = pEntries + h.uEntryCount * sizeof(KviConfigurationCacheEntry);
+
+	quint32 uEntry = 0;
+	QString szGroup, szKey, szValue;
+	for(quint32 i = 0; i < h.uGroupCount; i++)
+	{
+		KviConfigurationCacheGroup g;
+		std::memcpy(&g, pGroups + i * sizeof(g), sizeof(g));
+		if(((qint64)uEntry + g.uEntryCount > h.uEntryCount) || !config_cache_read_string(pTable, h.uStringTableSize, g.uName, szGroup))
+		{
+			clear();
+			m_bDirty = false;
+			return false;
+		}
+
+		KviConfigurationFileGroup * p_group = new KviConfigurationFileGroup(17, false);
+		p_group->setAutoDelete(true);
+		m_pDict->replace(szGroup, p_group);
+
+		for(quint32 j = 0; j < g.uEntryCount; j++)
+		{
+			KviConfigurationCacheEntry e;
+			std::memcpy(&e, pEntries + (uEntry++) * sizeof(e), sizeof(e));
+			if(!config_cache_read_string(pTable, h.uStringTableSize, e.uKey, szKey) || !config_cache_read_string(pTable, h.uStringTableSize, e.uValue, szValue))
+			{
+				clear();
+				m_bDirty = false;
+				return false;
+			}
+			p_group->replace(szKey, new QString(szValue));
+		}
+	}
+
+	return true;
+}
+
+void KviConfigurationFile::saveCache()
+{
+	if(m_bLocal8Bit)
+		return;
+
+	QFileInfo inf(m_szFileName);
+	if(!config_cache_enabled(inf))
+		return;
+
+	KviConfigurationCacheHeader h;
+	if(!config_cache_text_hash(m_szFileName, h.uTextHash))
+		return;
+
+	QSaveFile f(config_cache_file_name(m_szFileName));
+	if(!f.open(QFile::WriteOnly | QFile::Truncate))
+		return;
+
+	QByteArray groups, entries, table;
+	QHash<QString, quint32> hOffsets;
+	std::memcpy(h.cMagic, "KVCC", 4);
+	h.uVersion = KVI_CONFIG_CACHE_VERSION;
+	h.iTextModified = inf.lastModified().toMSecsSinceEpoch();
+	h.iTextSize = inf.size();
+	h.uGroupCount = 0;
+	h.uEntryCount = 0;
+	h.uReserved = 0;
+
+	KviPointerHashTableIterator<QString, KviConfigurationFileGroup> it(*m_pDict);
+	while(KviConfigurationFileGroup * pGroup = it.current())
+	{
+		KviConfigurationCacheGroup g;
+		g.uName = config_cache_string(table, hOffsets, it.currentKey());
+		g.uEntryCount = pGroup->count();
+		groups.append((const char *)&g, sizeof(g));
+		h.uGroupCount++;
+
+		KviConfigurationFileGroupIterator it2(*pGroup);
+		while(QString * pValue = it2.current())
+		{
+			KviConfigurationCacheEntry e;
+			e.uKey = config_cache_string(table, hOffsets, it2.currentKey());
+			e.uValue = config_cache_string(table, hOffsets, *pValue);
+			entries.append((const char *)&e, sizeof(e));
+			h.uEntryCount++;
+			++it2;
+		}
+		++it;
+	}
+
+	h.uStringTableSize = table.size();
+	QByteArray body = groups + entries + table;
+	h.uHash = (quint64)qHashBits(body.constData(), body.size(), 0);
+
+	if(f.write((const char *)&h, sizeof(h)) != sizeof(h))
+		return;
+	if(f.write(body) != body.size())
+		return;
+	f.commit();
+}
+
+void KviConfigurationFile::refreshCache()
+{
+	if(config_cache_on_gui_thread())
+	{
+		saveCache();
+		m_bCacheStale = false;
+	}
+	else
+	{
+		m_bCacheStale = true;
+	}
+}
+
 bool KviConfigurationFile::load()
+{
+	if(loadCache())
+		return true;
+	if(!loadText())
+		return false;
+	// next time it will be faster
+	if(config_cache_enabled(QFileInfo(m_szFileName)))
+		refreshCache();
+	return true;
+}
+
+bool KviConfigurationFile::loadText()
 {
 	// this is really faster than the old version :)
 	// open the file
@@ -401,6 +813,13 @@ bool KviConfigurationFile::save()
 	if(m_bReadOnly)
 		return false;
 
+	{
+		// the contents parsed by preload() are going to be outdated
+		QMutexLocker locker(&g_preloadMutex);
+		if(!g_hPreloaded.isEmpty())
+			delete g_hPreloaded.take(m_szFileName);
+	}
+
 	QSaveFile f(m_szFileName);
 
 	if(!f.open(QFile::WriteOnly | QFile::Truncate))
@@ -453,6 +872,16 @@ bool KviConfigurationFile::save()
 		return false;
 
 	m_bDirty = false;
+
+	// refresh the binary image: it must contain exactly what the next
+	// load of the text would produce, so the text is parsed again here.
+	// Off the GUI thread the stale image is just left to be ignored.
+	if(!m_bLocal8Bit && config_cache_on_gui_thread() && config_cache_enabled(QFileInfo(m_szFileName)))
+	{
+		KviConfigurationFile cfg(m_szFileName, KviConfigurationFile::Write);
+		if(cfg.loadText())
+			cfg.saveCache();
+	}
 	return true;
 }
 
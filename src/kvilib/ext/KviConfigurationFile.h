@@ -48,6 +48,8 @@ typedef KviPointerHashTableIterator<QString, KviConfigurationFileGroup> KviConfi
 
 class KVILIB_API KviConfigurationFile : public KviHeapObject
 {
+	friend class KviConfigurationFilePreloader;
+
 public:
 	enum FileMode
 	{
@@ -70,12 +72,38 @@ private:
 	QString m_szGroup;
 	bool m_bPreserveEmptyGroups;
 	bool m_bReadOnly;
+	bool m_bCacheStale; // parsed off the GUI thread: the binary image must be written yet
 
 private:
 	bool load();
+	bool loadText();
 	bool save();
+	bool adoptPreloaded();
+	// The binary image of the parsed file (see KviConfigurationFile.cpp)
+	bool loadCache();
+	void saveCache();
+	// writes the image now if on the GUI thread, marks it as stale otherwise
+	void refreshCache();
 	KviConfigurationFileGroup * getCurrentGroup();
 
+public:
+	//
+	// Startup helpers: the files are parsed in parallel on the global thread
+	// pool and the first KviConfigurationFile object created for each of them
+	// takes the parsed contents instead of reading the file again
+	// (waiting for the parsing to finish, if needed).
+	// The contents that nobody claimed are dropped by discardPreloaded().
+	//
+	static void preload(const QStringList & lFileNames);
+	static void discardPreloaded();
+
+	//
+	// The binary images of the large files are kept only for the files
+	// in this directory (the local configuration one): the others are
+	// often read only or not owned by us
+	//
+	static void setCacheDirectory(const QString & szDirectory);
+
 public:
 	//
 	// Useful when saving...
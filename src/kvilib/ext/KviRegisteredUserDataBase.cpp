@@ -130,17 +130,22 @@ KviRegisteredUserDataBase::KviRegisteredUserDataBase()
 	m_pWildMaskList = new KviRegisteredUserMaskList;
 	m_pWildMaskList->setAutoDelete(true);
 
+	m_pWildMaskIndex = new KviIrcMaskIndex<KviRegisteredUserMask>();
+
 	m_pMaskDict = new KviPointerHashTable<QString, KviRegisteredUserMaskList>(49, false); // copy keys here!
 	m_pMaskDict->setAutoDelete(true);
 
 	m_pGroupDict = new KviPointerHashTable<QString, KviRegisteredUserGroup>(5, false); // copy keys here!
 	m_pGroupDict->setAutoDelete(true);
+
+	m_bBulkUpdate = false;
 }
 
 KviRegisteredUserDataBase::~KviRegisteredUserDataBase()
 {
 	emit(databaseCleared());
 	delete m_pUserDict;
+	delete m_pWildMaskIndex;
 	delete m_pWildMaskList;
 	delete m_pMaskDict;
 	delete m_pGroupDict;
@@ -182,7 +187,7 @@ KviRegisteredUser * KviRegisteredUserDataBase::getUser(const QString & name)
 	return u;
 }
 
-static void append_mask_to_list(KviRegisteredUserMaskList * l, KviRegisteredUser * u, KviIrcMask * mask)
+static KviRegisteredUserMask * append_mask_to_list(KviRegisteredUserMaskList * l, KviRegisteredUser * u, KviIrcMask * mask)
 {
 	KviRegisteredUserMask * newMask = new KviRegisteredUserMask(u, mask);
 	int idx = 0;
@@ -191,11 +196,12 @@ static void append_mask_to_list(KviRegisteredUserMaskList * l, KviRegisteredUser
 		if(m->nonWildChars() < newMask->nonWildChars())
 		{
 			l->insert(idx, newMask);
-			return;
+			return newMask;
 		}
 		idx++;
 	}
 	l->append(newMask);
+	return newMask;
 }
 
 KviRegisteredUser * KviRegisteredUserDataBase::addMask(KviRegisteredUser * u, KviIrcMask * mask)
@@ -207,14 +213,12 @@ KviRegisteredUser * KviRegisteredUserDataBase::addMask(KviRegisteredUser * u, Kv
 	KviRegisteredUserMaskList * l;
 	if(mask->hasWildNick())
 	{
-		for(KviRegisteredUserMask * m = m_pWildMaskList->first(); m; m = m_pWildMaskList->next())
+		KviRegisteredUserMask * m = m_pWildMaskIndex->findExact(*mask);
+		if(m)
 		{
-			if(*(m->mask()) == *mask)
-			{
-				delete mask;
-				mask = nullptr;
-				return m->user();
-			}
+			delete mask;
+			mask = nullptr;
+			return m->user();
 		}
 		// not found ...ok... add it
 		// masks with more info go first in the list
@@ -253,6 +257,8 @@ KviRegisteredUser * KviRegisteredUserDataBase::addMask(KviRegisteredUser * u, Kv
 			{
 				append_mask_to_list(l, u, mask);
 				m_pMaskDict->insert(mask->nick(), l);
+				if(!m_bBulkUpdate)
+					emit(maskAdded(*mask));
 			}
 			return nullptr;
 		}
@@ -263,18 +269,26 @@ KviRegisteredUser * KviRegisteredUserDataBase::addMask(KviRegisteredUser * u, Kv
 		qDebug("Oops! Received an incoherent regusers action, recovered?");
 		return nullptr; // ops...already there ?
 	}
-	append_mask_to_list(l, u, mask);
+	KviRegisteredUserMask * newMask = append_mask_to_list(l, u, mask);
+	if(l == m_pWildMaskList)
+		m_pWildMaskIndex->insert(*mask, newMask);
+	if(!m_bBulkUpdate)
+		emit(maskAdded(*mask));
 	return nullptr;
 }
 
 void KviRegisteredUserDataBase::copyFrom(KviRegisteredUserDataBase * db)
 {
 	m_pUserDict->clear();
+	m_pWildMaskIndex->clear();
 	m_pWildMaskList->clear();
 	m_pMaskDict->clear();
 	m_pGroupDict->clear();
 	emit(databaseCleared());
 
+	// everything has been already invalidated by databaseCleared()
+	m_bBulkUpdate = true;
+
 	KviPointerHashTableIterator<QString, KviRegisteredUser> it(*(db->m_pUserDict));
 
 	while(KviRegisteredUser * theCur = it.current())
@@ -310,6 +324,8 @@ void KviRegisteredUserDataBase::copyFrom(KviRegisteredUserDataBase * db)
 		addGroup(git.currentKey());
 		++git;
 	}
+
+	m_bBulkUpdate = false;
 }
 
 bool KviRegisteredUserDataBase::removeUser(const QString & name)
@@ -319,11 +335,14 @@ bool KviRegisteredUserDataBase::removeUser(const QString & name)
 	KviRegisteredUser * u = m_pUserDict->find(name);
 	if(!u)
 		return false;
+	// a single userRemoved() is enough
+	m_bBulkUpdate = true;
 	while(KviIrcMask * mask = u->maskList()->first())
 	{
 		if(!removeMaskByPointer(mask))
 			qDebug("Oops! removeMaskByPointer(%s) has failed", name.toUtf8().data());
 	}
+	m_bBulkUpdate = false;
 	emit(userRemoved(name));
 	m_pUserDict->remove(name);
 	return true;
@@ -359,16 +378,16 @@ bool KviRegisteredUserDataBase::removeMaskByPointer(KviIrcMask * mask)
 	if(mask->hasWildNick())
 	{
 		// remove from the wild list
-		for(KviRegisteredUserMask * m = m_pWildMaskList->first(); m; m = m_pWildMaskList->next())
+		KviRegisteredUserMask * m = m_pWildMaskIndex->findExact(*mask);
+		if(m && (m->mask() == mask))
 		{
-			if(m->mask() == mask)
-			{
-				// ok..got it, remove from the list and from the user struct (user struct deletes it!)
-				emit(userChanged(mask->nick()));
-				m->user()->removeMask(mask);   // this one deletes m->mask()
-				m_pWildMaskList->removeRef(m); // this one deletes m
-				return true;
-			}
+			// ok..got it, remove from the list and from the user struct (user struct deletes it!)
+			if(!m_bBulkUpdate)
+				emit(userChanged(m->user()->name()));
+			m_pWildMaskIndex->remove(m);
+			m->user()->removeMask(mask);   // this one deletes m->mask()
+			m_pWildMaskList->removeRef(m); // this one deletes m
+			return true;
 		}
 		// not found ...opz :)
 	}
@@ -383,7 +402,8 @@ bool KviRegisteredUserDataBase::removeMaskByPointer(KviIrcMask * mask)
 				if(m->mask() == mask)
 				{
 					QString nick = mask->nick();
-					emit(userChanged(nick));
+					if(!m_bBulkUpdate)
+						emit(userChanged(m->user()->name()));
 					m->user()->removeMask(mask); // this one deletes m->mask() (or mask)
 					l->removeRef(m);             // this one deletes m
 					if(l->count() == 0)
@@ -421,12 +441,7 @@ KviRegisteredUserMask * KviRegisteredUserDataBase::findMatchingMask(const QStrin
 		}
 	}
 	// not found....lookup the wild ones
-	for(KviRegisteredUserMask * m = m_pWildMaskList->first(); m; m = m_pWildMaskList->next())
-	{
-		if(m->mask()->matchesFixed(nick, user, host))
-			return m;
-	}
-	return nullptr; // no match at all
+	return m_pWildMaskIndex->findBestMatch(nick, user, host);
 }
 
 KviRegisteredUser * KviRegisteredUserDataBase::findUserWithMask(const KviIrcMask & mask)
@@ -452,12 +467,7 @@ KviRegisteredUserMask * KviRegisteredUserDataBase::findExactMask(const KviIrcMas
 		}
 	}
 	// not found....lookup the wild ones
-	for(KviRegisteredUserMask * m = m_pWildMaskList->first(); m; m = m_pWildMaskList->next())
-	{
-		if(*(m->mask()) == mask)
-			return m;
-	}
-	return nullptr; // no match at all
+	return m_pWildMaskIndex->findExact(mask);
 }
 
 void KviRegisteredUserDataBase::load(const QString & filename)
@@ -465,6 +475,9 @@ void KviRegisteredUserDataBase::load(const QString & filename)
 	QString szCurrent;
 	KviConfigurationFile cfg(filename, KviConfigurationFile::Read);
 
+	// the masks are added only to new users: userAdded() has already invalidated the lookups
+	m_bBulkUpdate = true;
+
 	KviConfigurationFileIterator it(*cfg.dict());
 	while(it.current())
 	{
@@ -507,6 +520,8 @@ void KviRegisteredUserDataBase::load(const QString & filename)
 		}
 		++it;
 	}
+	m_bBulkUpdate = false;
+
 	if(!m_pGroupDict->find(__tr("Default")))
 		addGroup(__tr("Default"));
 }
@@ -37,6 +37,7 @@
 #include "KviRegisteredUserGroup.h"
 #include "KviRegisteredUserMask.h"
 #include "KviRegisteredUser.h"
+#include "KviIrcMaskIndex.h"
 
 #include <QObject>
 
@@ -50,6 +51,7 @@ class QString;
 //    The users are identified by masks stored in m_pMaskDict and m_pWildMaskList
 //    m_pMaskDict contains lists of non wild-nick KviRegisteredUserMask that point to users
 //    m_pWildMaskList is a list of wild-nick KviRegisteredUserMask that point to users
+//    m_pWildMaskIndex indexes m_pWildMaskList so we don't have to test every wild mask
 //
 
 class KVILIB_API KviRegisteredUserDataBase : public QObject
@@ -63,7 +65,9 @@ private:
 	KviPointerHashTable<QString, KviRegisteredUser> * m_pUserDict;         // unique namespace, owns the objects, does not copy keys
 	KviPointerHashTable<QString, KviRegisteredUserMaskList> * m_pMaskDict; // owns the objects, copies the keys
 	KviRegisteredUserMaskList * m_pWildMaskList;                           // owns the objects
+	KviIrcMaskIndex<KviRegisteredUserMask> * m_pWildMaskIndex;             // same objects as m_pWildMaskList
 	KviPointerHashTable<QString, KviRegisteredUserGroup> * m_pGroupDict;
+	bool m_bBulkUpdate;                                                    // don't emit the per-mask signals
 
 public:
 	void copyFrom(KviRegisteredUserDataBase * db);
@@ -94,6 +98,9 @@ signals:
 	void userRemoved(const QString &);
 	void userChanged(const QString &);
 	void userAdded(const QString &);
+	// emitted after a mask has been added to an existing user:
+	// only the irc users matching it may need to be associated again
+	void maskAdded(const KviIrcMask & mask);
 	void databaseCleared();
 };
 
@@ -0,0 +1,84 @@
+//=============================================================================
+//
+//   File : KviIrcCaseMapping.cpp
+//   Creation date : Mon Oct 19 2026 23:18:40 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2000-2026 Szymon Stefanek (pragma at kvirc dot net)
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviIrcCaseMapping.h"
+
+namespace KviIrcCaseMapping
+{
+	// the folding tables for the 7 bit characters; the others are never mapped
+	class FoldingTables
+	{
+	public:
+		unsigned short aTable[Unicode][128];
+
+		FoldingTables()
+		{
+			for(int m = 0; m < Unicode; m++)
+			{
+				for(unsigned short c = 0; c < 128; c++)
+					aTable[m][c] = ((c >= 'A') && (c <= 'Z')) ? c + 32 : c;
+			}
+			aTable[Rfc1459]['['] = '{';
+			aTable[Rfc1459][']'] = '}';
+			aTable[Rfc1459]['\\'] = '|';
+			aTable[Rfc1459]['~'] = '^';
+			aTable[StrictRfc1459]['['] = '{';
+			aTable[StrictRfc1459][']'] = '}';
+			aTable[StrictRfc1459]['\\'] = '|';
+		}
+	};
+
+	static FoldingTables g_tables;
+
+	Mapping fromName(const QString & szName)
+	{
+		if(szName.compare("ascii", Qt::CaseInsensitive) == 0)
+			return Ascii;
+		if(szName.compare("strict-rfc1459", Qt::CaseInsensitive) == 0)
+			return StrictRfc1459;
+		if((szName.compare("rfc7613", Qt::CaseInsensitive) == 0) || (szName.compare("rfc8265", Qt::CaseInsensitive) == 0) || (szName.compare("precis", Qt::CaseInsensitive) == 0))
+			return Unicode;
+		return Rfc1459;
+	}
+
+	QString toLower(const QString & szName, Mapping eMapping)
+	{
+		if(eMapping == Unicode)
+			return szName.toCaseFolded();
+
+		const unsigned short * pTable = g_tables.aTable[eMapping];
+		const QChar * p = szName.constData();
+		int iLen = szName.length();
+
+		// the names are usually lowercase already: share the data until a char changes
+		QString szRet = szName;
+		for(int i = 0; i < iLen; i++)
+		{
+			unsigned short c = p[i].unicode();
+			if((c < 128) && (pTable[c] != c))
+				szRet[i] = QChar(pTable[c]);
+		}
+		return szRet;
+	}
+}
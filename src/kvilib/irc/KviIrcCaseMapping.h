@@ -0,0 +1,76 @@
+#ifndef _KVI_IRCCASEMAPPING_H_
+#define _KVI_IRCCASEMAPPING_H_
+//=============================================================================
+//
+//   File : KviIrcCaseMapping.h
+//   Creation date : Mon Oct 19 2026 23:18:40 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2000-2026 Szymon Stefanek (pragma at kvirc dot net)
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+/**
+* \file KviIrcCaseMapping.h
+* \brief The case mappings used by the irc servers to compare names
+*
+* The servers announce the mapping with the CASEMAPPING ISUPPORT token.
+* Two nicknames or channel names are the same if their casemapped
+* versions are equal.
+*/
+
+#include "kvi_settings.h"
+
+#include <QString>
+
+/**
+* \namespace KviIrcCaseMapping
+* \brief Casemapping of nicknames and channel names
+*/
+namespace KviIrcCaseMapping
+{
+	/**
+	* \enum Mapping
+	* \brief The supported case mappings
+	*/
+	enum Mapping
+	{
+		Ascii,         /**< only A-Z are mapped to a-z */
+		Rfc1459,       /**< A-Z and []\~ are mapped to a-z and {}|^: the default */
+		StrictRfc1459, /**< A-Z and []\ are mapped to a-z and {}| */
+		Unicode        /**< the full unicode case folding (rfc7613 and friends) */
+	};
+
+	/**
+	* \brief Returns the mapping named by a CASEMAPPING ISUPPORT token value
+	*
+	* Unknown names map to Rfc1459.
+	* \param szName The name of the mapping
+	* \return Mapping
+	*/
+	extern KVILIB_API Mapping fromName(const QString & szName);
+
+	/**
+	* \brief Returns the casemapped version of the name
+	* \param szName The nickname or the channel name
+	* \param eMapping The mapping to use
+	* \return QString
+	*/
+	extern KVILIB_API QString toLower(const QString & szName, Mapping eMapping);
+}
+
+#endif //_KVI_IRCCASEMAPPING_H_
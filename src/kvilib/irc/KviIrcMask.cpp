@@ -502,7 +502,7 @@ bool KviIrcMask::operator==(const KviIrcMask & user)
 	return false;
 }
 
-bool KviIrcMask::hasWildNick()
+bool KviIrcMask::hasWildNick() const
 {
 	const QChar * pAux = m_szNick.constData();
 	if(!pAux)
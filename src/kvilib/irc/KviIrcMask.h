@@ -261,7 +261,7 @@ public:
 	* \brief Returns true if the nickname contains wildcards (* and ?)
 	* \return bool
 	*/
-	bool hasWildNick();
+	bool hasWildNick() const;
 
 	/**
 	* \brief Wild external matches (this and external are wild)
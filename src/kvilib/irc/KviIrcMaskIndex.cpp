@@ -0,0 +1,452 @@
+//=============================================================================
+//
+//   File : KviIrcMaskIndex.cpp
+//   Creation date : Mon Oct 19 2026 20:14:08 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2000-2026 Szymon Stefanek (pragma at kvirc dot net)
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviIrcMaskIndex.h"
+
+#include <algorithm>
+
+// Number of literal chars used as key for the nick and user prefix/suffix buckets.
+// A lookup costs up to this number of hash lookups per bucket kind.
+#define KVI_IRCMASKINDEX_AFFIX_LEN 4
+
+static inline bool mask_index_is_wild(const QChar & c)
+{
+	return (c.unicode() == '*') || (c.unicode() == '?');
+}
+
+static int mask_index_literal_prefix_len(const QString & szStr)
+{
+	int iLen = szStr.length();
+	for(int i = 0; i < iLen; i++)
+	{
+		if(mask_index_is_wild(szStr.at(i)))
+			return i;
+	}
+	return iLen;
+}
+
+static int mask_index_literal_suffix_len(const QString & szStr)
+{
+	int iLen = szStr.length();
+	for(int i = iLen - 1; i >= 0; i--)
+	{
+		if(mask_index_is_wild(szStr.at(i)))
+			return iLen - i - 1;
+	}
+	return iLen;
+}
+
+// splits a host (or a part of it) at the dots and at the colons (IPv6)
+static void mask_index_split_host(const QString & szHost, QStringList & lLabels)
+{
+	lLabels.clear();
+	int iLen = szHost.length();
+	int iStart = 0;
+	for(int i = 0; i < iLen; i++)
+	{
+		ushort c = szHost.at(i).unicode();
+		if((c == '.') || (c == ':'))
+		{
+			lLabels.append(szHost.mid(iStart, i - iStart));
+			iStart = i + 1;
+		}
+	}
+	lLabels.append(szHost.mid(iStart));
+}
+
+static int mask_index_labels_len(const QStringList & lLabels)
+{
+	int iLen = 0;
+	for(auto & s : lLabels)
+		iLen += s.length();
+	return iLen;
+}
+
+KviIrcMaskIndexBase::KviIrcMaskIndexBase()
+{
+	m_HostSuffixRoot.pParent = nullptr;
+	m_HostSuffixRoot.bucket.pOwnerHash = nullptr;
+	m_HostSuffixRoot.bucket.pOwnerNode = &m_HostSuffixRoot;
+	m_HostPrefixRoot.pParent = nullptr;
+	m_HostPrefixRoot.bucket.pOwnerHash = nullptr;
+	m_HostPrefixRoot.bucket.pOwnerNode = &m_HostPrefixRoot;
+	m_Fallback.pOwnerHash = nullptr;
+	m_Fallback.pOwnerNode = nullptr;
+	m_uNextSerial = 0;
+	m_uLookups = 0;
+	m_uCandidates = 0;
+}
+
+KviIrcMaskIndexBase::~KviIrcMaskIndexBase()
+{
+	clear();
+}
+
+void KviIrcMaskIndexBase::clear()
+{
+	qDeleteAll(m_hData);
+	m_hData.clear();
+	m_hExact.clear();
+	qDeleteAll(m_hNick);
+	m_hNick.clear();
+	qDeleteAll(m_hNickPrefix);
+	m_hNickPrefix.clear();
+	qDeleteAll(m_hUserPrefix);
+	m_hUserPrefix.clear();
+	qDeleteAll(m_hUserSuffix);
+	m_hUserSuffix.clear();
+	clearTree(&m_HostSuffixRoot);
+	clearTree(&m_HostPrefixRoot);
+	m_Fallback.vEntries.clear();
+}
+
+void KviIrcMaskIndexBase::clearTree(HostNode * pNode)
+{
+	for(auto pChild : pNode->hChildren)
+	{
+		clearTree(pChild);
+		delete pChild;
+	}
+	pNode->hChildren.clear();
+	pNode->bucket.vEntries.clear();
+}
+
+QString KviIrcMaskIndexBase::exactKey(const KviIrcMask & mask)
+{
+	QString szKey = mask.nick().toLower();
+	szKey.append(QChar('!'));
+	szKey.append(mask.user().toLower());
+	szKey.append(QChar('@'));
+	szKey.append(mask.host().toLower());
+	return szKey;
+}
+
+KviIrcMaskIndexBase::Bucket * KviIrcMaskIndexBase::bucketInHash(QHash<QString, Bucket *> & hHash, const QString & szKey)
+{
+	Bucket * b = hHash.value(szKey, nullptr);
+	if(b)
+		return b;
+	b = new Bucket;
+	b->pOwnerHash = &hHash;
+	b->szOwnerKey = szKey;
+	b->pOwnerNode = nullptr;
+	hHash.insert(szKey, b);
+	return b;
+}
+
+KviIrcMaskIndexBase::Bucket * KviIrcMaskIndexBase::bucketInTree(HostNode * pRoot, const QStringList & lLabels)
+{
+	HostNode * pNode = pRoot;
+	for(auto & szLabel : lLabels)
+	{
+		HostNode * pChild = pNode->hChildren.value(szLabel, nullptr);
+		if(!pChild)
+		{
+			pChild = new HostNode;
+			pChild->pParent = pNode;
+			pChild->szLabel = szLabel;
+			pChild->bucket.pOwnerHash = nullptr;
+			pChild->bucket.pOwnerNode = pChild;
+			pNode->hChildren.insert(szLabel, pChild);
+		}
+		pNode = pChild;
+	}
+	return &(pNode->bucket);
+}
+
+void KviIrcMaskIndexBase::insertData(const KviIrcMask & mask, void * pData)
+{
+	if(m_hData.contains(pData))
+		removeData(pData);
+
+	Entry * e = new Entry;
+	e->mask = mask;
+	e->szKey = exactKey(mask);
+	e->pData = pData;
+	e->iNonWildChars = e->mask.nonWildChars();
+	e->uSerial = m_uNextSerial++;
+
+	m_hData.insert(pData, e);
+	// if the same mask is inserted twice findExact() returns the last one
+	m_hExact.insert(e->szKey, e);
+
+	QString szNick = mask.nick().toLower();
+	QString szUser = mask.user().toLower();
+	QString szHost = mask.host().toLower();
+
+	Bucket * b;
+
+	if(mask_index_literal_prefix_len(szNick) == szNick.length())
+	{
+		// the best case: the nickname is fixed
+		b = bucketInHash(m_hNick, szNick);
+	}
+	else
+	{
+		// pick the most selective literal part
+		enum
+		{
+			None,
+			HostSuffix,
+			HostPrefix,
+			UserPrefix,
+			UserSuffix,
+			NickPrefix
+		} eWhere = None;
+		int iBest = 0;
+
+		QStringList lSuffixLabels;
+		int iLast = szHost.length() - mask_index_literal_suffix_len(szHost) - 1;
+		mask_index_split_host(szHost.mid(iLast + 1), lSuffixLabels);
+		if(iLast >= 0)
+			lSuffixLabels.removeFirst(); // preceded by a wildcard: only a part of a label
+		int iScore = mask_index_labels_len(lSuffixLabels);
+		if(iScore > iBest)
+		{
+			iBest = iScore;
+			eWhere = HostSuffix;
+		}
+
+		QStringList lPrefixLabels;
+		int iFirst = mask_index_literal_prefix_len(szHost);
+		if(iFirst < szHost.length())
+		{
+			mask_index_split_host(szHost.left(iFirst), lPrefixLabels);
+			lPrefixLabels.removeLast(); // followed by a wildcard
+			iScore = mask_index_labels_len(lPrefixLabels);
+			if(iScore > iBest)
+			{
+				iBest = iScore;
+				eWhere = HostPrefix;
+			}
+		}
+
+		int iUserPrefix = qMin(mask_index_literal_prefix_len(szUser), KVI_IRCMASKINDEX_AFFIX_LEN);
+		if(iUserPrefix > iBest)
+		{
+			iBest = iUserPrefix;
+			eWhere = UserPrefix;
+		}
+
+		int iUserSuffix = qMin(mask_index_literal_suffix_len(szUser), KVI_IRCMASKINDEX_AFFIX_LEN);
+		if(iUserSuffix > iBest)
+		{
+			iBest = iUserSuffix;
+			eWhere = UserSuffix;
+		}
+
+		int iNickPrefix = qMin(mask_index_literal_prefix_len(szNick), KVI_IRCMASKINDEX_AFFIX_LEN);
+		if(iNickPrefix > iBest)
+		{
+			iBest = iNickPrefix;
+			eWhere = NickPrefix;
+		}
+
+		switch(eWhere)
+		{
+			case HostSuffix:
+				std::reverse(lSuffixLabels.begin(), lSuffixLabels.end());
+				b = bucketInTree(&m_HostSuffixRoot, lSuffixLabels);
+				break;
+			case HostPrefix:
+				b = bucketInTree(&m_HostPrefixRoot, lPrefixLabels);
+				break;
+			case UserPrefix:
+				b = bucketInHash(m_hUserPrefix, szUser.left(iUserPrefix));
+				break;
+			case UserSuffix:
+				b = bucketInHash(m_hUserSuffix, szUser.right(iUserSuffix));
+				break;
+			case NickPrefix:
+				b = bucketInHash(m_hNickPrefix, szNick.left(iNickPrefix));
+				break;
+			default:
+				b = &m_Fallback;
+				break;
+		}
+	}
+
+	e->pBucket = b;
+	e->uBucketIndex = b->vEntries.size();
+	b->vEntries.push_back(e);
+}
+
+void KviIrcMaskIndexBase::removeFromBucket(Entry * e)
+{
+	Bucket * b = e->pBucket;
+
+	// swap with the last one so the removal is O(1)
+	Entry * pLast = b->vEntries.back();
+	b->vEntries[e->uBucketIndex] = pLast;
+	pLast->uBucketIndex = e->uBucketIndex;
+	b->vEntries.pop_back();
+
+	if(!b->vEntries.empty())
+		return;
+
+	if(b->pOwnerHash)
+	{
+		b->pOwnerHash->remove(b->szOwnerKey);
+		delete b;
+		return;
+	}
+
+	// prune the empty branches of the host trees
+	HostNode * pNode = b->pOwnerNode;
+	while(pNode && pNode->pParent && pNode->bucket.vEntries.empty() && pNode->hChildren.isEmpty())
+	{
+		HostNode * pParent = pNode->pParent;
+		pParent->hChildren.remove(pNode->szLabel);
+		delete pNode;
+		pNode = pParent;
+	}
+}
+
+bool KviIrcMaskIndexBase::removeData(void * pData)
+{
+	Entry * e = m_hData.value(pData, nullptr);
+	if(!e)
+		return false;
+	m_hData.remove(pData);
+
+	m_hExact.remove(e->szKey, e);
+
+	removeFromBucket(e);
+	delete e;
+	return true;
+}
+
+void * KviIrcMaskIndexBase::findExactData(const KviIrcMask & mask) const
+{
+	Entry * e = m_hExact.value(exactKey(mask), nullptr);
+	return e ? e->pData : nullptr;
+}
+
+void KviIrcMaskIndexBase::collectCandidates(const QString & szNick, const QString & szUser, const QString & szHost, std::vector<Entry *> & vCandidates) const
+{
+	QString szLNick = szNick.toLower();
+	QString szLUser = szUser.toLower();
+	QString szLHost = szHost.toLower();
+
+	vCandidates.insert(vCandidates.end(), m_Fallback.vEntries.begin(), m_Fallback.vEntries.end());
+
+	Bucket * b = m_hNick.value(szLNick, nullptr);
+	if(b)
+		vCandidates.insert(vCandidates.end(), b->vEntries.begin(), b->vEntries.end());
+
+	int iMax = qMin(szLNick.length(), KVI_IRCMASKINDEX_AFFIX_LEN);
+	for(int i = 1; i <= iMax; i++)
+	{
+		b = m_hNickPrefix.value(szLNick.left(i), nullptr);
+		if(b)
+			vCandidates.insert(vCandidates.end(), b->vEntries.begin(), b->vEntries.end());
+	}
+
+	iMax = qMin(szLUser.length(), KVI_IRCMASKINDEX_AFFIX_LEN);
+	for(int i = 1; i <= iMax; i++)
+	{
+		b = m_hUserPrefix.value(szLUser.left(i), nullptr);
+		if(b)
+			vCandidates.insert(vCandidates.end(), b->vEntries.begin(), b->vEntries.end());
+		b = m_hUserSuffix.value(szLUser.right(i), nullptr);
+		if(b)
+			vCandidates.insert(vCandidates.end(), b->vEntries.begin(), b->vEntries.end());
+	}
+
+	QStringList lLabels;
+	mask_index_split_host(szLHost, lLabels);
+
+	const HostNode * pNode = &m_HostPrefixRoot;
+	for(auto & szLabel : lLabels)
+	{
+		pNode = pNode->hChildren.value(szLabel, nullptr);
+		if(!pNode)
+			break;
+		vCandidates.insert(vCandidates.end(), pNode->bucket.vEntries.begin(), pNode->bucket.vEntries.end());
+	}
+
+	pNode = &m_HostSuffixRoot;
+	for(int i = lLabels.count() - 1; i >= 0; i--)
+	{
+		pNode = pNode->hChildren.value(lLabels.at(i), nullptr);
+		if(!pNode)
+			break;
+		vCandidates.insert(vCandidates.end(), pNode->bucket.vEntries.begin(), pNode->bucket.vEntries.end());
+	}
+}
+
+// true if e1 takes precedence over e2
+static inline bool mask_index_entry_precedes(int iNonWild1, kvi_u64_t uSerial1, int iNonWild2, kvi_u64_t uSerial2)
+{
+	if(iNonWild1 != iNonWild2)
+		return iNonWild1 > iNonWild2;
+	return uSerial1 < uSerial2;
+}
+
+void * KviIrcMaskIndexBase::findBestMatchData(const QString & szNick, const QString & szUser, const QString & szHost) const
+{
+	std::vector<Entry *> vCandidates;
+	collectCandidates(szNick, szUser, szHost, vCandidates);
+
+	m_uLookups++;
+
+	Entry * pBest = nullptr;
+	for(auto e : vCandidates)
+	{
+		// don't run the (expensive) wildcard match if it can't win anyway
+		if(pBest && !mask_index_entry_precedes(e->iNonWildChars, e->uSerial, pBest->iNonWildChars, pBest->uSerial))
+			continue;
+		m_uCandidates++;
+		if(e->mask.matchesFixed(szNick, szUser, szHost))
+			pBest = e;
+	}
+
+	return pBest ? pBest->pData : nullptr;
+}
+
+void KviIrcMaskIndexBase::findMatchingData(const QString & szNick, const QString & szUser, const QString & szHost, std::vector<void *> & vData) const
+{
+	std::vector<Entry *> vCandidates;
+	collectCandidates(szNick, szUser, szHost, vCandidates);
+
+	m_uLookups++;
+	m_uCandidates += vCandidates.size();
+
+	std::vector<Entry *> vMatches;
+	for(auto e : vCandidates)
+	{
+		if(e->mask.matchesFixed(szNick, szUser, szHost))
+			vMatches.push_back(e);
+	}
+
+	std::sort(vMatches.begin(), vMatches.end(),
+	    [](const Entry * a, const Entry * b) {
+		    return mask_index_entry_precedes(a->iNonWildChars, a->uSerial, b->iNonWildChars, b->uSerial);
+	    });
+
+	vData.clear();
+	vData.reserve(vMatches.size());
+	for(auto e : vMatches)
+		vData.push_back(e->pData);
+}
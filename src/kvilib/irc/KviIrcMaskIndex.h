@@ -0,0 +1,171 @@
+#ifndef _KVI_IRCMASKINDEX_H_
+#define _KVI_IRCMASKINDEX_H_
+//=============================================================================
+//
+//   File : KviIrcMaskIndex.h
+//   Creation date : Mon Oct 19 2026 20:14:08 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2000-2026 Szymon Stefanek (pragma at kvirc dot net)
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+/**
+* \file KviIrcMaskIndex.h
+* \brief An index over large sets of wildcard irc masks
+*
+* Answers "which masks match nick!user\@host" without testing every mask.
+* Each mask is filed under the most selective literal part it contains:
+* the exact nickname, the trailing labels of the host (*.host.top),
+* the leading labels of the host (numeric masks like 192.168.*),
+* a prefix of the nickname or the username or a suffix of the username.
+* Only the masks in the buckets reachable from the queried
+* nick!user\@host are tested with KviIrcMask::matchesFixed().
+*
+* All the keys are case insensitive, as KviIrcMask matching is.
+*/
+
+#include "kvi_settings.h"
+#include "kvi_inttypes.h"
+#include "KviIrcMask.h"
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+
+/**
+* \class KviIrcMaskIndexBase
+* \brief The untyped implementation of KviIrcMaskIndex
+*/
+class KVILIB_API KviIrcMaskIndexBase
+{
+public:
+	KviIrcMaskIndexBase();
+	~KviIrcMaskIndexBase();
+
+protected:
+	class Bucket;
+	class HostNode;
+
+	class Entry
+	{
+	public:
+		KviIrcMask mask;
+		QString szKey; // the lowercase nick!user@host
+		void * pData;
+		int iNonWildChars;
+		kvi_u64_t uSerial; // insertion order
+		Bucket * pBucket;
+		std::size_t uBucketIndex;
+	};
+
+	// The buckets that live in a hash have an owner hash and a key,
+	// the ones embedded in the host trees have an owner node.
+	class Bucket
+	{
+	public:
+		std::vector<Entry *> vEntries;
+		QHash<QString, Bucket *> * pOwnerHash;
+		QString szOwnerKey;
+		HostNode * pOwnerNode;
+	};
+
+	class HostNode
+	{
+	public:
+		HostNode * pParent;
+		QString szLabel;
+		QHash<QString, HostNode *> hChildren;
+		Bucket bucket;
+	};
+
+	QMultiHash<QString, Entry *> m_hExact; // lowercase nick!user@host -> entries
+	QHash<void *, Entry *> m_hData;
+	QHash<QString, Bucket *> m_hNick;
+	QHash<QString, Bucket *> m_hNickPrefix;
+	QHash<QString, Bucket *> m_hUserPrefix;
+	QHash<QString, Bucket *> m_hUserSuffix;
+	HostNode m_HostSuffixRoot; // labels from the top level domain down
+	HostNode m_HostPrefixRoot; // labels from the left (numeric masks)
+	Bucket m_Fallback;         // nothing literal to index on: *!*@*
+	kvi_u64_t m_uNextSerial;
+
+	mutable kvi_u64_t m_uLookups;
+	mutable kvi_u64_t m_uCandidates;
+
+public:
+	unsigned int count() const { return m_hData.count(); };
+	bool isEmpty() const { return m_hData.isEmpty(); };
+	void clear();
+
+	// statistics: the average number of masks tested per lookup
+	// is candidatesTested() / lookups()
+	kvi_u64_t lookups() const { return m_uLookups; };
+	kvi_u64_t candidatesTested() const { return m_uCandidates; };
+
+protected:
+	// pData must be unique in the index
+	void insertData(const KviIrcMask & mask, void * pData);
+	bool removeData(void * pData);
+	void * findExactData(const KviIrcMask & mask) const;
+	// the match with the most non wild chars (the oldest one if there are several)
+	void * findBestMatchData(const QString & szNick, const QString & szUser, const QString & szHost) const;
+	// all the matches, in the same order as above
+	void findMatchingData(const QString & szNick, const QString & szUser, const QString & szHost, std::vector<void *> & vData) const;
+
+	void collectCandidates(const QString & szNick, const QString & szUser, const QString & szHost, std::vector<Entry *> & vCandidates) const;
+	Bucket * bucketInHash(QHash<QString, Bucket *> & hHash, const QString & szKey);
+	Bucket * bucketInTree(HostNode * pRoot, const QStringList & lLabels);
+	void removeFromBucket(Entry * e);
+	void clearTree(HostNode * pNode);
+
+	static QString exactKey(const KviIrcMask & mask);
+};
+
+/**
+* \class KviIrcMaskIndex
+* \brief Indexes a set of objects by their (wildcard) irc mask
+*
+* The objects are not owned: remove them before deleting them.
+*/
+template <typename T>
+class KviIrcMaskIndex : public KviIrcMaskIndexBase
+{
+public:
+	// the mask is copied
+	void insert(const KviIrcMask & mask, T * pData) { insertData(mask, (void *)pData); };
+	bool remove(T * pData) { return removeData((void *)pData); };
+	bool contains(T * pData) const { return m_hData.contains((void *)pData); };
+	T * findExact(const KviIrcMask & mask) const { return (T *)findExactData(mask); };
+	T * findBestMatch(const QString & szNick, const QString & szUser, const QString & szHost) const
+	{
+		return (T *)findBestMatchData(szNick, szUser, szHost);
+	};
+	void findMatches(const QString & szNick, const QString & szUser, const QString & szHost, std::vector<T *> & vMatches) const
+	{
+		std::vector<void *> v;
+		findMatchingData(szNick, szUser, szHost, v);
+		vMatches.clear();
+		vMatches.reserve(v.size());
+		for(auto p : v)
+			vMatches.push_back((T *)p);
+	};
+};
+
+#endif //_KVI_IRCMASKINDEX_H_
@@ -27,6 +27,10 @@
 #include "KviRegisteredUser.h"
 #include "KviRegisteredUserDataBase.h"
 #include "KviStringConversion.h"
+#include "KviIrcMask.h"
+
+#include <utility>
+#include <vector>
 
 KviIrcUserDataBase::KviIrcUserDataBase()
     : QObject()
@@ -39,7 +43,8 @@ KviIrcUserDataBase::KviIrcUserDataBase()
 	// the performance increase since kvirc versions < 3.0.0
 	// is really big anyway (there was a linear list instead of a hash!!!)
 
-	m_pDict = new KviPointerHashTable<QString, KviIrcUserEntry>(4001, false);
+	// the keys are already casemapped: a case sensitive dictionary is both faster and correct
+	m_pDict = new KviPointerHashTable<QString, KviIrcUserEntry>(4001, true);
 	m_pDict->setAutoDelete(true);
 	setupConnectionWithReguserDb();
 }
@@ -100,8 +105,14 @@ KviRegisteredUser * KviIrcUserDataBase::registeredUser(const QString & szNick, c
 			pUser = g_pRegisteredUserDataBase->findMatchingUser(szNick, pEntry->user(), pEntry->host());
 			if(pUser)
 			{
+				if(pEntry->m_szRegisteredUserName != pUser->name())
+				{
+					if(!pEntry->m_szRegisteredUserName.isEmpty())
+						m_hRegisteredEntries.remove(pEntry->m_szRegisteredUserName, pEntry);
+					pEntry->m_szRegisteredUserName = pUser->name();
+					m_hRegisteredEntries.insert(pEntry->m_szRegisteredUserName, pEntry);
+				}
 				pEntry->m_szLastRegisteredMatchNick = szNick;
-				pEntry->m_szRegisteredUserName = pUser->name();
 
 				pEntry->m_bUseCustomColor = pUser->getBoolProperty("useCustomColor");
 				QString szTmp = pUser->getProperty("customColor");
@@ -111,6 +122,12 @@ KviRegisteredUser * KviIrcUserDataBase::registeredUser(const QString & szNick, c
 			}
 			else
 			{
+				// no longer matching: drop it from the index too
+				if(!pEntry->m_szRegisteredUserName.isEmpty())
+				{
+					m_hRegisteredEntries.remove(pEntry->m_szRegisteredUserName, pEntry);
+					pEntry->m_szRegisteredUserName = "";
+				}
 				pEntry->m_szLastRegisteredMatchNick = szNick;
 				pEntry->m_bNotFoundRegUserLookup = true;
 			}
@@ -132,16 +149,19 @@ KviRegisteredUser * KviIrcUserDataBase::registeredUser(const QString & szNick)
 
 void KviIrcUserDataBase::clear()
 {
+	m_hRegisteredEntries.clear();
 	delete m_pDict;
-	m_pDict = new KviPointerHashTable<QString, KviIrcUserEntry>(4001, false);
+	m_pDict = new KviPointerHashTable<QString, KviIrcUserEntry>(4001, true);
 	m_pDict->setAutoDelete(true);
 }
 
 KviIrcUserEntry * KviIrcUserDataBase::insertUser(const QString & szNick, const QString & szUser, const QString & szHost)
 {
-	KviIrcUserEntry * pEntry = m_pDict->find(szNick);
+	QString szKey = key(szNick);
+	KviIrcUserEntry * pEntry = m_pDict->find(szKey);
 	if(pEntry)
 	{
+		pEntry->m_szNick = szNick;
 		pEntry->m_nRefs++;
 		if(pEntry->m_szUser.isEmpty())
 		{
@@ -152,7 +172,8 @@ KviIrcUserEntry * KviIrcUserDataBase::insertUser(const QString & szNick, const Q
 	else
 	{
 		pEntry = new KviIrcUserEntry(szUser, szHost);
-		m_pDict->insert(szNick, pEntry);
+		pEntry->m_szNick = szNick;
+		m_pDict->insert(szKey, pEntry);
 	}
 	return pEntry;
 }
@@ -162,30 +183,104 @@ bool KviIrcUserDataBase::removeUser(const QString & szNick, KviIrcUserEntry * pE
 	pEntry->m_nRefs--;
 	if(pEntry->m_nRefs == 0)
 	{
-		m_pDict->remove(szNick);
+		if(!pEntry->m_szRegisteredUserName.isEmpty())
+			m_hRegisteredEntries.remove(pEntry->m_szRegisteredUserName, pEntry);
+		QString szKey = key(szNick);
+		if(m_pDict->find(szKey) == pEntry)
+			m_pDict->remove(szKey);
+		else
+			delete pEntry; // left out of the index by a casemapping switch
 		return true;
 	}
 	return false;
 }
 
+void KviIrcUserDataBase::setCaseMapping(KviIrcCaseMapping::Mapping eMapping)
+{
+	if(eMapping == m_eCaseMapping)
+		return;
+	m_eCaseMapping = eMapping;
+
+	// only the entries whose key changes are moved
+	std::vector<std::pair<QString, KviIrcUserEntry *>> vMoved;
+	KviPointerHashTableIterator<QString, KviIrcUserEntry> it(*m_pDict);
+	while(KviIrcUserEntry * pEntry = it.current())
+	{
+		if(it.currentKey() != key(pEntry->m_szNick))
+			vMoved.emplace_back(it.currentKey(), pEntry);
+		++it;
+	}
+
+	if(vMoved.empty())
+		return;
+
+	m_pDict->setAutoDelete(false);
+	for(auto & p : vMoved)
+		m_pDict->remove(p.first);
+	for(auto & p : vMoved)
+	{
+		KviIrcUserEntry * pEntry = p.second;
+		// two nicknames that were different may be the same user now: the first one wins
+		// and the other entry lives outside of the index until its references are gone
+		QString szKey = key(pEntry->m_szNick);
+		if(!m_pDict->find(szKey))
+			m_pDict->insert(szKey, pEntry);
+	}
+	m_pDict->setAutoDelete(true);
+}
+
 void KviIrcUserDataBase::setupConnectionWithReguserDb()
 {
 	connect(g_pRegisteredUserDataBase, SIGNAL(userRemoved(const QString &)), this, SLOT(registeredUserChanged(const QString &)));
 	connect(g_pRegisteredUserDataBase, SIGNAL(userChanged(const QString &)), this, SLOT(registeredUserChanged(const QString &)));
 	connect(g_pRegisteredUserDataBase, SIGNAL(userAdded(const QString &)), this, SLOT(registeredUserAdded(const QString &)));
+	connect(g_pRegisteredUserDataBase, SIGNAL(maskAdded(const KviIrcMask &)), this, SLOT(registeredMaskAdded(const KviIrcMask &)));
 	connect(g_pRegisteredUserDataBase, SIGNAL(databaseCleared()), this, SLOT(registeredDatabaseCleared()));
 }
 
+void KviIrcUserDataBase::invalidateRegisteredUser(KviIrcUserEntry * pEntry)
+{
+	if(!pEntry->m_szRegisteredUserName.isEmpty())
+	{
+		m_hRegisteredEntries.remove(pEntry->m_szRegisteredUserName, pEntry);
+		pEntry->m_szRegisteredUserName = "";
+	}
+	pEntry->m_bNotFoundRegUserLookup = false;
+}
+
 void KviIrcUserDataBase::registeredUserChanged(const QString & szUser)
 {
+	// only the entries associated to this user are affected
+	QList<KviIrcUserEntry *> lEntries = m_hRegisteredEntries.values(szUser);
+	m_hRegisteredEntries.remove(szUser);
+	for(auto pEntry : lEntries)
+	{
+		pEntry->m_szRegisteredUserName = "";
+		pEntry->m_bNotFoundRegUserLookup = false;
+	}
+}
+
+void KviIrcUserDataBase::registeredMaskAdded(const KviIrcMask & mask)
+{
+	// the entries matching the new mask may now be associated
+	// to a different user (or to an user at all)
+	if(!mask.hasWildNick())
+	{
+		KviIrcUserEntry * pEntry = find(mask.nick());
+		if(pEntry)
+			invalidateRegisteredUser(pEntry);
+		return;
+	}
+
 	KviPointerHashTableIterator<QString, KviIrcUserEntry> it(*m_pDict);
 	for(; it.current(); ++it)
 	{
-		if(it.current()->m_szRegisteredUserName == szUser)
-		{
-			it.current()->m_szRegisteredUserName = "";
-			it.current()->m_bNotFoundRegUserLookup = false;
-		}
+		KviIrcUserEntry * pEntry = it.current();
+		// nothing cached: it will be looked up anyway
+		if(pEntry->m_szRegisteredUserName.isEmpty() && !pEntry->m_bNotFoundRegUserLookup)
+			continue;
+		if(mask.matchesFixed(pEntry->nick(), pEntry->user(), pEntry->host()))
+			invalidateRegisteredUser(pEntry);
 	}
 }
 
@@ -203,6 +298,7 @@ void KviIrcUserDataBase::registeredUserAdded(const QString &)
 
 void KviIrcUserDataBase::registeredDatabaseCleared()
 {
+	m_hRegisteredEntries.clear();
 	KviPointerHashTableIterator<QString, KviIrcUserEntry> it(*m_pDict);
 	for(; it.current(); ++it)
 	{
@@ -31,13 +31,16 @@
 */
 
 #include "kvi_settings.h"
+#include "KviIrcCaseMapping.h"
 #include "KviIrcUserEntry.h"
 #include "KviPointerHashTable.h"
 
 #include <QObject>
 #include <QString>
+#include <QHash>
 
 class KviRegisteredUser;
+class KviIrcMask;
 
 /**
 * \class KviIrcUserDataBase
@@ -59,7 +62,10 @@ public:
 	~KviIrcUserDataBase();
 
 private:
-	KviPointerHashTable<QString, KviIrcUserEntry> * m_pDict;
+	KviPointerHashTable<QString, KviIrcUserEntry> * m_pDict; // indexed by the casemapped nicknames
+	KviIrcCaseMapping::Mapping m_eCaseMapping = KviIrcCaseMapping::Rfc1459;
+	// registered user name -> entries associated to it: used to invalidate only the affected entries
+	QMultiHash<QString, KviIrcUserEntry *> m_hRegisteredEntries;
 
 public:
 	/**
@@ -82,7 +88,32 @@ public:
 	* \param szNick The nickname of the user to find
 	* \return KviIrcUserEntry *
 	*/
-	KviIrcUserEntry * find(const QString & szNick) { return m_pDict->find(szNick); };
+	KviIrcUserEntry * find(const QString & szNick) { return m_pDict->find(key(szNick)); };
+
+	/**
+	* \brief Returns the key used to index the nickname
+	*
+	* The key is the nickname casemapped as announced by the server: two
+	* nicknames are the same user if their keys are equal.
+	* \param szNick The nickname of the user
+	* \return QString
+	*/
+	QString key(const QString & szNick) const { return KviIrcCaseMapping::toLower(szNick, m_eCaseMapping); };
+
+	/**
+	* \brief Returns the casemapping used for the keys
+	* \return KviIrcCaseMapping::Mapping
+	*/
+	KviIrcCaseMapping::Mapping caseMapping() const { return m_eCaseMapping; };
+
+	/**
+	* \brief Switches to another casemapping and rebuilds the keys
+	*
+	* The user lists that use this database must rebuild their keys too.
+	* \param eMapping The new casemapping
+	* \return void
+	*/
+	void setCaseMapping(KviIrcCaseMapping::Mapping eMapping);
 
 	/**
 	* \brief Decrements the user reference count and if it reaches 0 then deletes the user from the database
@@ -94,6 +125,8 @@ public:
 
 	/**
 	* \brief Returns the database dictionary
+	*
+	* The keys are casemapped: use KviIrcUserEntry::nick() to get the nicknames.
 	* \return KviPointerHashTable<QString,KviIrcUserEntry> *
 	*/
 	KviPointerHashTable<QString, KviIrcUserEntry> * dict() { return m_pDict; };
@@ -133,6 +166,14 @@ public:
 	* \return void
 	*/
 	void setupConnectionWithReguserDb();
+
+protected:
+	/**
+	* \brief Forgets the registered user associated to the entry
+	* \param pEntry The entry of the user
+	* \return void
+	*/
+	void invalidateRegisteredUser(KviIrcUserEntry * pEntry);
 protected slots:
 	/**
 	* \brief Slot called when a registered user is changed or removed
@@ -148,6 +189,13 @@ protected slots:
 	*/
 	void registeredUserAdded(const QString & szUser);
 
+	/**
+	* \brief Slot called when a mask is added to a registered user
+	* \param mask The mask added
+	* \return void
+	*/
+	void registeredMaskAdded(const KviIrcMask & mask);
+
 	/**
 	* \brief Slot called when the database is cleared
 	* \return void
@@ -26,6 +26,8 @@
 #include "KviControlCodes.h"
 #include "KviNickColors.h"
 
+#include <algorithm>
+
 KviIrcUserEntry::KviIrcUserEntry(const QString & szUser, const QString & szHost)
 {
 	m_szUser = szUser;
@@ -112,3 +114,10 @@ std::unique_ptr<KviAvatar> KviIrcUserEntry::forgetAvatar()
 {
 	return std::move(m_upAvatar);
 }
+
+void KviIrcUserEntry::removeUserList(KviUserListView * pUserList)
+{
+	auto it = std::find(m_vUserLists.begin(), m_vUserLists.end(), pUserList);
+	if(it != m_vUserLists.end())
+		m_vUserLists.erase(it);
+}
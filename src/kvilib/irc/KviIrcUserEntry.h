@@ -36,6 +36,9 @@
 #include "KviAvatar.h"
 
 #include <memory>
+#include <vector>
+
+class KviUserListView;
 
 /**
 * \class KviIrcUserEntry
@@ -81,6 +84,7 @@ public:
 	KviIrcUserEntry(const QString & user, const QString & host);
 
 protected:
+	QString m_szNick; // as last seen: the database is indexed by its casemapped version
 	QString m_szUser;
 	QString m_szHost;
 
@@ -109,6 +113,9 @@ protected:
 	int m_iSmartNickColor;
 	QString m_szAccountName;
 
+	// the user lists (channels and queries) this user is in: one for each reference
+	std::vector<KviUserListView *> m_vUserLists;
+
 public:
 	/**
 	* \brief Returns the ircview smart nick color of the user
@@ -264,6 +271,12 @@ public:
 	*/
 	bool hasHops() { return m_iHops >= 0; };
 
+	/**
+	* \brief Returns the nickname of the user
+	* \return const QString &
+	*/
+	const QString & nick() { return m_szNick; };
+
 	/**
 	* \brief Returns the username of the user
 	* \return const QString &
@@ -345,6 +358,29 @@ public:
 	* \return bool
 	*/
 	bool hasAccountName() { return (!m_szAccountName.isEmpty()); };
+
+	/**
+	* \brief Returns the user lists the user is in
+	*
+	* This is maintained by KviUserListView and allows finding the channels
+	* of a user without scanning all of them.
+	* \return const std::vector<KviUserListView *> &
+	*/
+	const std::vector<KviUserListView *> & userLists() const { return m_vUserLists; };
+
+	/**
+	* \brief Records that the user has been added to a user list
+	* \param pUserList The user list
+	* \return void
+	*/
+	void addUserList(KviUserListView * pUserList) { m_vUserLists.push_back(pUserList); };
+
+	/**
+	* \brief Records that the user has been removed from a user list
+	* \param pUserList The user list
+	* \return void
+	*/
+	void removeUserList(KviUserListView * pUserList);
 };
 
 #endif // _KVI_IRCUSER_ENTRY_H_
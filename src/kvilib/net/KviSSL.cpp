@@ -36,6 +36,8 @@
 #include <openssl/err.h>
 #include <openssl/dh.h>
 
+#include <QHash>
+
 #include <cstdio>
 
 #if !(defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW))
@@ -46,6 +48,11 @@
 static bool g_bSSLInitialized = false;
 static KviMutex * g_pSSLMutex = nullptr;
 
+// the contexts shared by the objects with the same configuration (we hold a reference to each)
+static QHash<QString, SSL_CTX *> g_hSharedContexts;
+// the last client session negotiated for each key, for resumption (we hold a reference to each)
+static QHash<QString, SSL_SESSION *> g_hSessions;
+
 static inline void my_ssl_lock()
 {
 	g_pSSLMutex->lock();
@@ -259,6 +266,12 @@ void KviSSL::globalDestroy()
 	if(dh_4096)
 		DH_free(dh_4096);
 #endif
+	for(auto pSession : g_hSessions)
+		SSL_SESSION_free(pSession);
+	g_hSessions.clear();
+	for(auto pCtx : g_hSharedContexts)
+		SSL_CTX_free(pCtx);
+	g_hSharedContexts.clear();
 	globalSSLDestroy();
 	delete g_pSSLMutex;
 	g_pSSLMutex = nullptr;
@@ -364,6 +377,25 @@ int verify_clientCallback(int, X509_STORE_CTX *)
 	return 1;
 }
 
+/**
+ * Called by OpenSSL when the server gives us a new session (with TLS 1.3 this
+ * happens after the handshake): keep it for the next connection with the same key
+ */
+static int my_new_session_callback(SSL * ssl, SSL_SESSION * pSession)
+{
+	KviSSL * s = (KviSSL *)SSL_get_app_data(ssl);
+	if(!s || s->m_szSessionKey.isEmpty())
+		return 0; // not taken
+
+	my_ssl_lock();
+	SSL_SESSION * pOld = g_hSessions.value(s->m_szSessionKey, nullptr);
+	if(pOld)
+		SSL_SESSION_free(pOld);
+	g_hSessions.insert(s->m_szSessionKey, pSession);
+	my_ssl_unlock();
+	return 1; // we keep the reference
+}
+
 bool KviSSL::initContext(Method m)
 {
 	if(m_pSSL)
@@ -376,6 +408,14 @@ bool KviSSL::initContext(Method m)
 	{
 		// we have to request the peer certificate, else only the client can see the peer identity, not the server
 		SSL_CTX_set_verify(m_pSSLCtx, SSL_VERIFY_PEER, verify_clientCallback);
+		// the sessions can't be resumed on a verifying server without an id context
+		SSL_CTX_set_session_id_context(m_pSSLCtx, (const unsigned char *)"KVIrc", 5);
+	}
+	else
+	{
+		// the client sessions are kept in g_hSessions, by server
+		SSL_CTX_set_session_cache_mode(m_pSSLCtx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+		SSL_CTX_sess_set_new_cb(m_pSSLCtx, my_new_session_callback);
 	}
 
 	SSL_CTX_set_options (m_pSSLCtx,
@@ -403,6 +443,64 @@ bool KviSSL::initContext(Method m)
 	return true;
 }
 
+bool KviSSL::initSharedContext(const QString & szKey)
+{
+	if(m_pSSL || m_pSSLCtx)
+		return false;
+
+	my_ssl_lock();
+	SSL_CTX * pCtx = g_hSharedContexts.value(szKey, nullptr);
+	if(pCtx)
+	{
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+		SSL_CTX_up_ref(pCtx);
+#else
+		CRYPTO_add(&(pCtx->references), 1, CRYPTO_LOCK_SSL_CTX);
+#endif
+		m_pSSLCtx = pCtx;
+	}
+	my_ssl_unlock();
+	return pCtx != nullptr;
+}
+
+void KviSSL::shareContext(const QString & szKey)
+{
+	if(!m_pSSLCtx)
+		return;
+
+	my_ssl_lock();
+	if(!g_hSharedContexts.contains(szKey))
+	{
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+		SSL_CTX_up_ref(m_pSSLCtx);
+#else
+		CRYPTO_add(&(m_pSSLCtx->references), 1, CRYPTO_LOCK_SSL_CTX);
+#endif
+		g_hSharedContexts.insert(szKey, m_pSSLCtx);
+	}
+	my_ssl_unlock();
+}
+
+void KviSSL::setSessionKey(const QString & szKey)
+{
+	m_szSessionKey = szKey;
+	if(!m_pSSL)
+		return;
+
+	my_ssl_lock();
+	SSL_SESSION * pSession = g_hSessions.value(szKey, nullptr);
+	if(pSession)
+		SSL_set_session(m_pSSL, pSession); // the server will fall back to a full handshake if it's stale
+	my_ssl_unlock();
+}
+
+bool KviSSL::sessionReused()
+{
+	if(!m_pSSL)
+		return false;
+	return SSL_session_reused(m_pSSL) ? true : false;
+}
+
 bool KviSSL::enableADHCiphers()
 {
 	if(!m_pSSLCtx)
@@ -425,6 +523,7 @@ bool KviSSL::initSocket(kvi_socket_t fd)
 	m_pSSL = SSL_new(m_pSSLCtx);
 	if(!m_pSSL)
 		return false;
+	SSL_set_app_data(m_pSSL, this);
 	if(!SSL_set_fd(m_pSSL, fd))
 		return false;
 	return true;
@@ -32,6 +32,8 @@
 #include "KviPointerHashTable.h"
 #include "kvi_sockettype.h"
 
+#include <QString>
+
 // Apple deprecated openssl since osx 10.7:
 
 #ifdef DEPRECATED_IN_MAC_OS_X_VERSION_10_7_AND_LATER
@@ -181,6 +183,7 @@ public:
 	SSL * m_pSSL;
 	SSL_CTX * m_pSSLCtx;
 	KviCString m_szPass;
+	QString m_szSessionKey; // the sessions negotiated by this object are cached under this key
 
 public:
 	static void globalInit();
@@ -191,6 +194,13 @@ public:
 public:
 	bool initSocket(kvi_socket_t fd);
 	bool initContext(KviSSL::Method m);
+	// Uses the context shared under szKey: returns false if there is none yet
+	bool initSharedContext(const QString & szKey);
+	// Shares our (fully set up) context with the next objects asking for szKey
+	void shareContext(const QString & szKey);
+	// Resumes the session cached under szKey, if any, and caches the new ones there: call before connect()
+	void setSessionKey(const QString & szKey);
+	bool sessionReused();
 	void shutdown();
 	bool setTLSHostname(const char * name);
 	bool enableADHCiphers();
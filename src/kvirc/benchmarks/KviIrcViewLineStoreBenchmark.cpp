@@ -0,0 +1,300 @@
+//=============================================================================
+//
+//   File : KviIrcViewLineStoreBenchmark.cpp
+//   Creation date : Tue Oct 20 2026 04:27:15 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 Szymon Stefanek (pragma at kvirc dot net)
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+//
+// Measures the memory taken by the scrollback lines of a KviIrcView:
+// packed in the line store (see KviIrcView_linestore.cpp) and laid out
+// as they were before it, with a heap string, a heap chunk array,
+// heap chunk strings and the wrapped blocks kept for every line.
+//
+// Usage: kviircviewbench [lines] [store|old]   (defaults: 100000 lines, store)
+//
+// The bytes are counted for both layouts. The resident memory is measured
+// (on Linux) only for the layout on the command line: run it twice.
+//
+
+#include "KviIrcView_private.h"
+#include "KviControlCodes.h"
+#include "KviMemory.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// the lines that keep their wrapped blocks in a view (see KviIrcView::wrappedBlocksCacheLines())
+#define BENCH_CACHED_LINES 256
+
+// what a heap block costs on a typical 64 bit malloc (header and 16 byte rounding)
+static std::size_t bench_heap(std::size_t uBytes)
+{
+	std::size_t uSize = (uBytes + sizeof(std::size_t) + 15) & ~(std::size_t)15;
+	return (uSize < 32) ? 32 : uSize;
+}
+
+// the line struct before the line store
+struct BenchOldLine
+{
+	QString szText;
+	unsigned int uIndex;
+	int iMsgType;
+	KviIrcViewLineBuilderChunk * pChunks;
+	unsigned int uChunkCount;
+	unsigned int uLineWraps;
+	KviIrcViewWrappedBlock * pBlocks;
+	int iMaxLineWidth;
+	int iBlockCount;
+	BenchOldLine * pPrev;
+	BenchOldLine * pNext;
+};
+
+static long bench_resident_bytes()
+{
+#ifdef Q_OS_LINUX
+	QFile f("/proc/self/statm");
+	if(!f.open(QIODevice::ReadOnly))
+		return -1;
+	QList<QByteArray> lFields = f.readAll().split(' ');
+	if(lFields.count() < 2)
+		return -1;
+	return lFields.at(1).toLong() * 4096;
+#else
+	return -1;
+#endif
+}
+
+static kvi_wchar_t * bench_wstring(const char * sz)
+{
+	int iLen = std::strlen(sz);
+	kvi_wchar_t * p = (kvi_wchar_t *)KviMemory::allocate((iLen + 1) * sizeof(kvi_wchar_t));
+	for(int i = 0; i <= iLen; i++)
+		p[i] = (unsigned char)sz[i];
+	return p;
+}
+
+static void bench_add_chunk(KviIrcViewLineBuilder & b, unsigned char type, int iStart, int iLen, const char * szPayload = nullptr, const char * szSmileId = nullptr)
+{
+	b.pChunks = (KviIrcViewLineBuilderChunk *)KviMemory::reallocate(b.pChunks, (b.uChunkCount + 1) * sizeof(KviIrcViewLineBuilderChunk));
+	KviIrcViewLineBuilderChunk * c = b.pChunks + b.uChunkCount;
+	c->iTextStart = iStart;
+	c->iTextLen = iLen;
+	c->customFore = 0;
+	c->type = type;
+	c->colors.back = KviControlCodes::Transparent;
+	c->colors.fore = KviControlCodes::Black;
+	c->szPayload = nullptr;
+	c->szSmileId = nullptr;
+	if(szPayload)
+	{
+		c->szPayload = bench_wstring(szPayload);
+		if(type == KviControlCodes::Icon)
+			c->szSmileId = szSmileId ? bench_wstring(szSmileId) : c->szPayload;
+	}
+	b.uChunkCount++;
+}
+
+// a channel message: timestamp, nick link, text and now and then an url or a smiley
+static void bench_build_line(KviIrcViewLineBuilder & b, unsigned int uLine)
+{
+	static const char * words[] = { "hello", "there", "the", "build", "is", "broken", "again", "kvirc", "works", "for", "me", "on", "linux", "ok" };
+	unsigned int uSeed = (uLine * 1103515245u) + 12345u;
+
+	QString szNick = QString("nick%1").arg(uSeed % 97);
+	QString szText = QString("[%1:%2:%3] ").arg((uLine / 3600) % 24, 2, 10, QChar('0')).arg((uLine / 60) % 60, 2, 10, QChar('0')).arg(uLine % 60, 2, 10, QChar('0'));
+	int iNickStart = szText.length();
+	szText += szNick;
+	int iMsgStart = szText.length();
+	szText += QChar(' ');
+
+	bench_add_chunk(b, KviControlCodes::Color, 0, iNickStart);
+	bench_add_chunk(b, KviControlCodes::Escape, iNickStart, szNick.length(), "nc");
+	bench_add_chunk(b, KviControlCodes::UnEscape, iMsgStart, 0);
+
+	unsigned int uWords = 4 + ((uSeed >> 8) % 20);
+	for(unsigned int i = 0; i < uWords; i++)
+	{
+		szText += words[(uSeed >> (i % 16)) % (sizeof(words) / sizeof(words[0]))];
+		szText += QChar(' ');
+	}
+
+	if((uLine % 10) == 0)
+	{
+		int iUrlStart = szText.length();
+		szText += QString("https://www.kvirc.net/?id=%1").arg(uLine);
+		bench_add_chunk(b, KviControlCodes::Escape, iUrlStart, szText.length() - iUrlStart, "u");
+		bench_add_chunk(b, KviControlCodes::UnEscape, szText.length(), 0);
+	}
+
+	if((uLine % 25) == 0)
+	{
+		szText += QChar(' ');
+		int iIconStart = szText.length();
+		szText += QString(":)");
+		bench_add_chunk(b, KviControlCodes::Icon, iIconStart, 2, ":)", "smile");
+		bench_add_chunk(b, KviControlCodes::UnIcon, szText.length(), 0);
+	}
+
+	// the plain text runs up to the next chunk
+	for(unsigned int i = 0; i < b.uChunkCount; i++)
+	{
+		KviIrcViewLineBuilderChunk * c = b.pChunks + i;
+		if((c->type == KviControlCodes::UnEscape) || (c->type == KviControlCodes::UnIcon))
+			c->iTextLen = ((i + 1) < b.uChunkCount ? c[1].iTextStart : szText.length()) - c->iTextStart;
+	}
+	b.szText = szText;
+}
+
+// the heap bytes taken by the line laid out as before the line store
+static std::size_t bench_old_bytes(KviIrcViewLineBuilder & b)
+{
+	// QString: the shared data header and the zero terminated text
+	std::size_t uBytes = bench_heap(sizeof(BenchOldLine)) + bench_heap(24 + ((b.szText.length() + 1) * sizeof(QChar)));
+	uBytes += bench_heap(b.uChunkCount * sizeof(KviIrcViewLineBuilderChunk));
+	for(unsigned int i = 0; i < b.uChunkCount; i++)
+	{
+		KviIrcViewLineBuilderChunk * c = b.pChunks + i;
+		if(!c->szPayload)
+			continue;
+		uBytes += bench_heap((kvi_wstrlen(c->szPayload) + 1) * sizeof(kvi_wchar_t));
+		if(c->szSmileId && (c->szSmileId != c->szPayload))
+			uBytes += bench_heap((kvi_wstrlen(c->szSmileId) + 1) * sizeof(kvi_wchar_t));
+	}
+	// one block per chunk at least (the wraps add more) plus the spare one calculateLineWraps() leaves
+	uBytes += bench_heap((b.uChunkCount + 1) * sizeof(KviIrcViewWrappedBlock));
+	return uBytes;
+}
+
+int main(int argc, char ** argv)
+{
+	QCoreApplication app(argc, argv);
+
+	int iLines = (argc > 1) ? std::atoi(argv[1]) : 100000;
+	bool bOld = (argc > 2) && (std::strcmp(argv[2], "old") == 0);
+	if((iLines < 1) || ((argc > 2) && !bOld && (std::strcmp(argv[2], "store") != 0)))
+	{
+		std::fprintf(stderr, "Usage: %s [lines] [store|old]\n", argv[0]);
+		return 1;
+	}
+
+	KviIrcViewLineStore store;
+	std::vector<KviIrcViewLine *> vLines;
+	std::vector<BenchOldLine *> vOldLines;
+	std::size_t uOldBytes = 0;
+	std::size_t uTextChars = 0;
+	unsigned int uChunks = 0;
+
+	long lResident = bench_resident_bytes();
+	QElapsedTimer t;
+	t.start();
+
+	KviIrcViewLineBuilder b;
+	for(int i = 0; i < iLines; i++)
+	{
+		bench_build_line(b, i);
+		uOldBytes += bench_old_bytes(b);
+		uTextChars += b.szText.length();
+		uChunks += b.uChunkCount;
+
+		if(bOld)
+		{
+			// the builder gives its data away as the old getTextLine() did
+			BenchOldLine * l = new BenchOldLine;
+			l->szText = b.szText;
+			l->szText.squeeze();
+			l->pChunks = b.pChunks;
+			l->uChunkCount = b.uChunkCount;
+			l->iBlockCount = b.uChunkCount;
+			l->pBlocks = (KviIrcViewWrappedBlock *)KviMemory::allocate((l->iBlockCount + 1) * sizeof(KviIrcViewWrappedBlock));
+			std::memset(l->pBlocks, 0, (l->iBlockCount + 1) * sizeof(KviIrcViewWrappedBlock));
+			vOldLines.push_back(l);
+			b.pChunks = nullptr;
+			b.uChunkCount = 0;
+			b.clear();
+		}
+		else
+		{
+			vLines.push_back(store.allocateLine(b, 0));
+			b.clear();
+		}
+	}
+
+	qint64 iElapsed = t.nsecsElapsed();
+	long lResidentAfter = bench_resident_bytes();
+
+	std::printf("%d lines, %llu text chars, %u chunks\n", iLines, (unsigned long long)uTextChars, uChunks);
+	std::printf("old layout:    %12llu bytes (%7.1f per line, wrapped blocks for every line)\n",
+	    (unsigned long long)uOldBytes, (double)uOldBytes / iLines);
+	if(!bOld)
+	{
+		std::printf("line store:    %12llu bytes (%7.1f per line, %u pages, %llu bytes used by the records)\n",
+		    (unsigned long long)store.pageBytes(), (double)store.pageBytes() / iLines, store.pages(), (unsigned long long)store.lineBytes());
+		// the blocks are cached only for the lines near the view
+		unsigned int uBlocksPerLine = (uChunks / iLines) + 1;
+		std::size_t uBlocks = BENCH_CACHED_LINES * bench_heap(uBlocksPerLine * sizeof(KviIrcViewWrappedBlock));
+		std::printf("blocks cache:  %12llu bytes (%d lines of %u blocks)\n", (unsigned long long)uBlocks, BENCH_CACHED_LINES, uBlocksPerLine);
+	}
+	std::printf("%s: %9.3f ms to build\n", bOld ? "old layout" : "line store", iElapsed / 1000000.0);
+	if((lResident >= 0) && (lResidentAfter >= 0))
+		std::printf("%s: %12ld resident bytes (%7.1f per line)\n", bOld ? "old layout" : "line store",
+		    lResidentAfter - lResident, (double)(lResidentAfter - lResident) / iLines);
+
+	// the store must give back what it was given
+	bool bOk = true;
+	for(auto & l : vLines)
+	{
+		if(l->uChunkCount < 3 || (l->pChunks[1].type != KviControlCodes::Escape) || (kvi_wstrlen(l->payload(l->pChunks + 1)) != 2))
+			bOk = false;
+		for(unsigned int i = 0; i < l->uChunkCount; i++)
+		{
+			if((l->pChunks[i].type == KviControlCodes::Icon) && (kvi_wstrlen(l->smileId(l->pChunks + i)) != 5))
+				bOk = false;
+		}
+		store.freeLine(l);
+	}
+	for(auto & l : vOldLines)
+	{
+		for(unsigned int i = 0; i < l->uChunkCount; i++)
+		{
+			if(!l->pChunks[i].szPayload)
+				continue;
+			if(l->pChunks[i].szSmileId && (l->pChunks[i].szSmileId != l->pChunks[i].szPayload))
+				KviMemory::free(l->pChunks[i].szSmileId);
+			KviMemory::free(l->pChunks[i].szPayload);
+		}
+		KviMemory::free(l->pChunks);
+		KviMemory::free(l->pBlocks);
+		delete l;
+	}
+
+	if(!bOk || store.lines() || (store.pages() > 1))
+	{
+		std::fprintf(stderr, "The line store lost track of its lines!\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,274 @@
+//=============================================================================
+//
+//   File : KviIrcViewWrapBenchmark.cpp
+//   Creation date : Tue Oct 20 2026 19:14:08 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2026 Szymon Stefanek (pragma at kvirc dot net)
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+//
+// Measures the re-wraps of a KviIrcView buffer full of wide text (CJK,
+// kana and emoji mixed with some latin): the characters above 0xff are
+// measured with QFontMetricsF on each pass (as before the width cache)
+// and looked up in KviIrcViewCharWidthCache (see KviIrcView_charwidth.cpp).
+//
+// The walk follows KviIrcView::calculateLineWraps() for a line without
+// attributes: measure the text, go back to a space on overflow and
+// force a wrap when there is none.
+//
+// Usage: kviircviewwrapbench [lines] [passes] [font family]
+//        (defaults: 20000 lines, 10 passes, the application font)
+//
+// Needs a GUI platform for the fonts: QT_QPA_PLATFORM=offscreen will do.
+//
+
+#include "KviIrcView_private.h"
+
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QFont>
+#include <QFontMetricsF>
+#include <QString>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#define BENCH_ISHIGHSURROGATE(c) ((c).unicode() >= 0xD800 && (c).unicode() <= 0xDBFF)
+#define BENCH_ISLOWSURROGATE(c) ((c).unicode() >= 0xDC00 && (c).unicode() <= 0xDFFF)
+
+// the view widths of the passes: a window dragged to a new size
+static const int g_iWidths[] = { 1200, 1100, 1000, 900, 800, 700, 600, 500, 400, 300 };
+
+// what the view measured before the width cache
+class BenchDirectWidths
+{
+public:
+	BenchDirectWidths(QFontMetricsF * pFm, float * pLatin)
+	    : m_pFm(pFm), m_pLatin(pLatin)
+	{
+	}
+
+private:
+	QFontMetricsF * m_pFm;
+	float * m_pLatin;
+
+public:
+	float width(const QChar * p) { return (p->unicode() < 0xff) ? m_pLatin[p->unicode()] : m_pFm->horizontalAdvance(*p); };
+	float pairWidth(const QChar * p) { return m_pFm->horizontalAdvance(QString(p, 2)); };
+};
+
+// what the view measures now
+class BenchCachedWidths
+{
+public:
+	BenchCachedWidths(KviIrcViewCharWidthCache * pCache, float * pLatin)
+	    : m_pCache(pCache), m_pLatin(pLatin)
+	{
+	}
+
+private:
+	KviIrcViewCharWidthCache * m_pCache;
+	float * m_pLatin;
+
+public:
+	float width(const QChar * p) { return (p->unicode() < 0xff) ? m_pLatin[p->unicode()] : m_pCache->width(p->unicode()); };
+	float pairWidth(const QChar * p) { return m_pCache->width(QChar::surrogateToUcs4(*p, *(p + 1))); };
+};
+
+// a chat line: runs of CJK ideographs and kana, a few emoji and some latin words
+static QString bench_build_line(unsigned int uLine)
+{
+	static const char * words[] = { "ok", "kvirc", "lol", "irc", "http", "brb" };
+	unsigned int uSeed = (uLine * 1103515245u) + 12345u;
+	QString szText;
+
+	unsigned int uRuns = 3 + ((uSeed >> 4) % 8);
+	for(unsigned int r = 0; r < uRuns; r++)
+	{
+		uSeed = (uSeed * 1103515245u) + 12345u;
+		unsigned int uLen = 2 + ((uSeed >> 8) % 14);
+		for(unsigned int i = 0; i < uLen; i++)
+		{
+			uSeed = (uSeed * 1103515245u) + 12345u;
+			unsigned int uKind = (uSeed >> 16) % 10;
+			if(uKind < 6)
+				szText += QChar(0x4E00 + ((uSeed >> 3) % 3000)); // common ideographs
+			else if(uKind < 8)
+				szText += QChar(0x3041 + ((uSeed >> 5) % 86)); // hiragana
+			else if(uKind < 9)
+				szText += QChar(0xAC00 + ((uSeed >> 7) % 2000)); // hangul
+			else
+			{
+				unsigned int uEmoji = 0x1F600 + ((uSeed >> 9) % 80); // emoticons
+				szText += QChar(QChar::highSurrogate(uEmoji));
+				szText += QChar(QChar::lowSurrogate(uEmoji));
+			}
+		}
+		szText += QChar(' ');
+		if((uSeed >> 20) % 3 == 0)
+		{
+			szText += words[(uSeed >> 12) % (sizeof(words) / sizeof(words[0]))];
+			szText += QChar(' ');
+		}
+	}
+	return szText;
+}
+
+// the wraps of the line at the given width
+template <class W>
+static unsigned int bench_wrap_line(const QString & szText, int iMaxWidth, W & w)
+{
+	const QChar * pBegin = szText.unicode();
+	const QChar * pEnd = pBegin + szText.length();
+	const QChar * pLineStart = pBegin;
+	unsigned int uWraps = 0;
+
+	while(pLineStart < pEnd)
+	{
+		const QChar * p = pLineStart;
+		float fWidth = 0;
+		while(p < pEnd)
+		{
+			float fChar;
+			int iLen = 1;
+			if(BENCH_ISHIGHSURROGATE(*p) && (p + 1) < pEnd)
+			{
+				fChar = w.pairWidth(p);
+				iLen = 2;
+			}
+			else
+			{
+				fChar = w.width(p);
+			}
+			if((fWidth + fChar) >= iMaxWidth)
+				break;
+			fWidth += fChar;
+			p += iLen;
+		}
+
+		if(p >= pEnd)
+			break;
+
+		// go back to a space, as calculateLineWraps() does
+		const QChar * pWrap = p;
+		while((pWrap > pLineStart) && (pWrap->unicode() != ' '))
+		{
+			pWrap--;
+			if(BENCH_ISLOWSURROGATE(*pWrap) && (pWrap > pLineStart))
+			{
+				pWrap--;
+				fWidth -= w.pairWidth(pWrap);
+			}
+			else
+			{
+				fWidth -= w.width(pWrap);
+			}
+		}
+
+		if(pWrap > pLineStart)
+			pLineStart = pWrap + 1; // the space stays on the upper line
+		else
+			pLineStart = (p > pLineStart) ? p : p + (BENCH_ISHIGHSURROGATE(*p) ? 2 : 1); // forced wrap
+		uWraps++;
+	}
+	return uWraps;
+}
+
+// re-wraps the whole buffer at each of the widths, returns the median pass time in msecs
+template <class W>
+static double bench_rewrap(const std::vector<QString> & vLines, int iPasses, W & w, unsigned long long & uWraps)
+{
+	std::vector<qint64> vTimes;
+	uWraps = 0;
+	for(int i = 0; i < iPasses; i++)
+	{
+		int iWidth = g_iWidths[i % (sizeof(g_iWidths) / sizeof(g_iWidths[0]))];
+		QElapsedTimer t;
+		t.start();
+		for(auto & l : vLines)
+			uWraps += bench_wrap_line(l, iWidth, w);
+		vTimes.push_back(t.nsecsElapsed());
+	}
+	std::sort(vTimes.begin(), vTimes.end());
+	return vTimes[vTimes.size() / 2] / 1000000.0;
+}
+
+int main(int argc, char ** argv)
+{
+	QGuiApplication app(argc, argv);
+
+	int iLines = (argc > 1) ? std::atoi(argv[1]) : 20000;
+	int iPasses = (argc > 2) ? std::atoi(argv[2]) : 10;
+	if((iLines < 1) || (iPasses < 1))
+	{
+		std::fprintf(stderr, "Usage: %s [lines] [passes] [font family]\n", argv[0]);
+		return 1;
+	}
+
+	QFont f = QGuiApplication::font();
+	if(argc > 3)
+		f.setFamily(QString::fromLocal8Bit(argv[3]));
+	QFontMetricsF fm(f);
+
+	// the view keeps the latin widths in a table anyway (m_iFontCharacterWidth)
+	float fLatin[256];
+	for(int i = 0; i < 256; i++)
+		fLatin[i] = fm.horizontalAdvance(QChar(i));
+
+	std::vector<QString> vLines;
+	unsigned long long uChars = 0;
+	for(int i = 0; i < iLines; i++)
+	{
+		vLines.push_back(bench_build_line(i));
+		uChars += vLines.back().length();
+	}
+
+	std::printf("%d lines, %llu utf16 chars, font %s %.1fpt, %d passes at widths 1200 to 300 px\n",
+	    iLines, uChars, f.family().toUtf8().data(), f.pointSizeF(), iPasses);
+
+	BenchDirectWidths direct(&fm, fLatin);
+	unsigned long long uDirectWraps;
+	double dDirect = bench_rewrap(vLines, iPasses, direct, uDirectWraps);
+
+	KviIrcViewCharWidthCache cache;
+	cache.setFontMetrics(&fm);
+	BenchCachedWidths cached(&cache, fLatin);
+	QElapsedTimer t;
+	t.start();
+	unsigned long long uFirstWraps = 0;
+	for(auto & l : vLines)
+		uFirstWraps += bench_wrap_line(l, g_iWidths[0], cached);
+	double dFirst = t.nsecsElapsed() / 1000000.0;
+	unsigned long long uCachedWraps;
+	double dCached = bench_rewrap(vLines, iPasses, cached, uCachedWraps);
+
+	std::printf("without the width cache: %9.3f ms per re-wrap (median)\n", dDirect);
+	std::printf("with the width cache:    %9.3f ms per re-wrap (median), %9.3f ms for the first one (filling the cache)\n", dCached, dFirst);
+	std::printf("speedup:                 %9.2fx\n", dDirect / dCached);
+
+	// both must wrap the lines in the same places
+	if(uDirectWraps != uCachedWraps)
+	{
+		std::fprintf(stderr, "The wraps differ: %llu without the cache, %llu with it!\n", uDirectWraps, uCachedWraps);
+		return 1;
+	}
+	return 0;
+}
@@ -223,6 +223,7 @@ KviApplication::KviApplication(int & argc, char ** argv)
 	m_iHeartbeatTimerId = -1;
 	m_fntDefaultFont = font();
 	m_bSetupDone = false;
+	m_iStartupTime = 0;
 	m_bClosingDown = false;
 	kvi_socket_flushTrafficCounters();
 	// don't let qt quit the application by itself
@@ -252,6 +253,9 @@ void KviApplication::setup()
 	// on each other and we must activate them in the right order.
 	// Don't move stuff around unless you really know what you're doing.
 
+	m_iStartupTime = KviTimeUtils::getCurrentTimeMills();
+	m_vStartupPhases.clear();
+
 	// Initialize the random number generator
 	::srand(::time(nullptr));
 
@@ -280,6 +284,14 @@ void KviApplication::setup()
 	loadDirectories();
 	KviStringConversion::init(m_szGlobalKvircDir, m_szLocalKvircDir);
 
+	// the binary images of the configuration files are kept only for our own files
+	QString szConfigDir;
+	getLocalKvircDirectory(szConfigDir, Config);
+	KviConfigurationFile::setCacheDirectory(szConfigDir);
+
+	// parse the configuration files in parallel while we set up the rest
+	preloadConfiguration();
+
 	g_pIconManager = new KviIconManager();
 
 	// add KVIrc common dirs to QT searchpath
@@ -312,6 +324,8 @@ void KviApplication::setup()
 
 	QString szTmp;
 
+	markStartupPhase(__tr2qs("directories"));
+
 	// Initialize the scripting engine
 	KviKvs::init();
 
@@ -322,6 +336,8 @@ void KviApplication::setup()
 	g_pModuleExtensionManager = new KviModuleExtensionManager();
 
 	g_pModuleManager = new KviModuleManager();
+	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_MODULESTATS))
+		g_pModuleManager->loadUsageStats(szTmp);
 
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_USERACTIONS))
 		KviActionManager::instance()->load(szTmp);
@@ -334,11 +350,19 @@ void KviApplication::setup()
 
 	KviAnimatedPixmapCache::init();
 
+	markStartupPhase(__tr2qs("kernel and identities"));
+
 	// Load the remaining configuration
 	// Note that loadOptions() assumes that the current progress is 12 and
 	// will bump it up to 45 in small steps
 	loadOptions();
 
+	markStartupPhase(__tr2qs("options"));
+
+	// map the frequently used modules while the rest of the startup goes on
+	if(KVI_OPTION_BOOL(KviOption_boolPreloadFrequentModules))
+		g_pModuleManager->preloadFrequentModules();
+
 	// set the global font if needed
 	updateApplicationFont();
 
@@ -353,6 +377,8 @@ void KviApplication::setup()
 	getLocalKvircDirectory(szTmp, Config, KVI_CONFIGFILE_WINPROPERTIES);
 	g_pWinPropertiesConfig = new KviConfigurationFile(szTmp, KviConfigurationFile::ReadWrite);
 
+	markStartupPhase(__tr2qs("gui setup"));
+
 	// Load the server database
 	g_pServerDataBase = new KviIrcServerDataBase();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_SERVERDB))
@@ -363,6 +389,8 @@ void KviApplication::setup()
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_PROXYDB))
 		g_pProxyDataBase->load(szTmp);
 
+	markStartupPhase(__tr2qs("server database"));
+
 	// Event manager
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_EVENTS))
 		KviKvs::loadAppEvents(szTmp);
@@ -387,6 +415,8 @@ void KviApplication::setup()
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_SCRIPTADDONS))
 		KviKvs::loadScriptAddons(szTmp);
 
+	markStartupPhase(__tr2qs("scripts"));
+
 	g_pTextIconManager = new KviTextIconManager();
 	g_pTextIconManager->load();
 
@@ -402,6 +432,8 @@ void KviApplication::setup()
 		g_pMediaManager->load(szTmp);
 	g_pMediaManager->unlock();
 
+	markStartupPhase(__tr2qs("icons and media"));
+
 	// registered user data base
 	g_pRegisteredUserDataBase = new KviRegisteredUserDataBase();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_REGUSERDB))
@@ -427,6 +459,8 @@ void KviApplication::setup()
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_PROFILESDATABASE))
 		KviIdentityProfileSet::instance()->load(szTmp);
 
+	markStartupPhase(__tr2qs("user databases"));
+
 	KviAvatarCache::init();
 	if(getReadOnlyConfigPath(szTmp, KVI_CONFIGFILE_AVATARCACHE))
 		KviAvatarCache::instance()->load(szTmp);
@@ -441,6 +475,11 @@ void KviApplication::setup()
 	else
 		KviDefaultScriptManager::instance()->loadEmptyConfig();
 
+	markStartupPhase(__tr2qs("caches"));
+
+	// anything not claimed by now is not going to be
+	KviConfigurationFile::discardPreloaded();
+
 // Eventually initialize the crypt engine manager
 #ifdef COMPILE_CRYPT_SUPPORT
 	g_pCryptEngineManager = new KviCryptEngineManager();
@@ -461,6 +500,8 @@ void KviApplication::setup()
 	// create the frame window, we're almost up and running...
 	createFrame();
 
+	markStartupPhase(__tr2qs("main window"));
+
 	// ok, we also have an UI now
 
 	// check if this is the first time this version of KVIrc runs...
@@ -486,6 +527,67 @@ void KviApplication::setup()
 
 	// start our heartbeat now
 	m_iHeartbeatTimerId = startTimer(1000);
+
+	reportStartupTiming();
+}
+
+void KviApplication::preloadConfiguration()
+{
+	// the files read by the loaders in setup(): they are all independent
+	static const char * aFiles[] = {
+		KVI_CONFIGFILE_USERACTIONS, KVI_CONFIGFILE_IDENTITIES, KVI_CONFIGFILE_MAIN,
+		KVI_CONFIGFILE_SERVERDB, KVI_CONFIGFILE_PROXYDB, KVI_CONFIGFILE_EVENTS,
+		KVI_CONFIGFILE_RAWEVENTS, KVI_CONFIGFILE_POPUPS, KVI_CONFIGFILE_CUSTOMTOOLBARS,
+		KVI_CONFIGFILE_ALIASES, KVI_CONFIGFILE_SCRIPTADDONS, KVI_CONFIGFILE_MEDIATYPES,
+		KVI_CONFIGFILE_REGUSERDB, KVI_CONFIGFILE_REGCHANDB, KVI_CONFIGFILE_SHAREDFILES,
+		KVI_CONFIGFILE_NICKSERVDATABASE, KVI_CONFIGFILE_PROFILESDATABASE, KVI_CONFIGFILE_AVATARCACHE,
+		KVI_CONFIGFILE_INPUTHISTORY, KVI_CONFIGFILE_DEFAULTSCRIPT, KVI_CONFIGFILE_MODULESTATS
+	};
+
+	QStringList lFiles;
+	QString szTmp;
+	for(auto szFile : aFiles)
+	{
+		if(getReadOnlyConfigPath(szTmp, szFile))
+			lFiles.append(szTmp);
+	}
+
+	getLocalKvircDirectory(szTmp, Config, KVI_CONFIGFILE_WINPROPERTIES);
+	if(KviFileUtils::fileExists(szTmp))
+		lFiles.append(szTmp);
+
+	KviConfigurationFile::preload(lFiles);
+}
+
+void KviApplication::markStartupPhase(const QString & szPhase)
+{
+	m_vStartupPhases.emplace_back(szPhase, KviTimeUtils::getCurrentTimeMills());
+}
+
+void KviApplication::reportStartupTiming()
+{
+	// reported only on request, like the other verbose output
+	if(!_OUTPUT_VERBOSE)
+		return;
+
+	QString szPhases;
+	long long iLast = m_iStartupTime;
+	for(auto & p : m_vStartupPhases)
+	{
+		if(!szPhases.isEmpty())
+			szPhases.append(", ");
+		szPhases.append(QString("%1 %2 ms").arg(p.first).arg(p.second - iLast));
+		iLast = p.second;
+	}
+
+	QString szReport = __tr2qs("Startup took %1 ms (%2)").arg(KviTimeUtils::getCurrentTimeMills() - m_iStartupTime).arg(szPhases);
+	qDebug("%s", szReport.toUtf8().data());
+
+	if(!g_pMainWindow)
+		return;
+	KviConsoleWindow * pConsole = g_pMainWindow->firstConsole();
+	if(pConsole)
+		pConsole->outputNoFmt(KVI_OUT_VERBOSE, szReport);
 }
 
 void KviApplication::frameDestructorCallback()
@@ -530,6 +632,7 @@ KviApplication::~KviApplication()
 	// Dangerous part.... we're unloading all the modules
 	// We need to unload them early since they may use other subsystems
 	// that we are going to kill now.
+	saveModuleStats();
 	delete g_pModuleManager;
 	delete g_pModuleExtensionManager;
 	// No more external modules exist: all that happens from now is generated
@@ -1418,6 +1521,13 @@ void KviApplication::saveRecentEntries()
 	cfg.writeEntry("RecentTopicList", *g_pRecentTopicList);
 }
 
+void KviApplication::saveModuleStats()
+{
+	QString szTmp;
+	getLocalKvircDirectory(szTmp, Config, KVI_CONFIGFILE_MODULESTATS);
+	g_pModuleManager->saveUsageStats(szTmp);
+}
+
 void KviApplication::saveAvatarCache()
 {
 	QString szTmp;
@@ -1572,6 +1682,7 @@ void KviApplication::saveConfiguration()
 	saveProxyDataBase();
 	saveRecentEntries();
 	saveAvatarCache();
+	saveModuleStats();
 	saveAppEvents();
 	saveRawEvents();
 	saveMediaTypes();
@@ -2009,14 +2120,28 @@ void KviApplication::heartbeat(kvi_time_t tNow)
 		++;
 	}
 
-	if(pTm && !pTm->tm_hour && !pTm->tm_min && !pTm->tm_sec)
+	if(pTm && !pTm->tm_hour && !pTm->tm_min && !pTm->tm_sec && KVI_OPTION_BOOL(KviOption_boolRotateLogsDaily))
 	{
+		// restart the logs so they continue in the files of the new day
 		for(auto & it : g_pGlobalWindowDict)
 		{
 			if(it.second->view() && it.second->view()->isLogging())
 				it.second->view()->startLogging(nullptr);
 		}
 	}
+
+	if(KVI_OPTION_BOOL(KviOption_boolKeepScrollbackSnapshots) && KVI_OPTION_UINT(KviOption_uintScrollbackSnapshotInterval))
+	{
+		// the heartbeat may skip seconds when the gui thread is busy
+		if(!m_tLastSnapshotSave)
+			m_tLastSnapshotSave = tNow;
+		else if((tNow - m_tLastSnapshotSave) >= (kvi_time_t)KVI_OPTION_UINT(KviOption_uintScrollbackSnapshotInterval))
+		{
+			m_tLastSnapshotSave = tNow;
+			for(auto & it : g_pGlobalWindowDict)
+				it.second->saveScrollbackSnapshot();
+		}
+	}
 }
 
 void KviApplication::timerEvent(QTimerEvent * e)
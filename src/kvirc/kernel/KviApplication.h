@@ -37,6 +37,7 @@
 
 #include <memory>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #ifdef COMPILE_KDE_SUPPORT
@@ -138,7 +139,8 @@ public:
 		Themes,
 		Classes,
 		SmallIcons,
-		EasyPlugins
+		EasyPlugins,
+		Snapshots
 	};
 
 	KviApplication(int & argc, char ** argv);
@@ -158,6 +160,7 @@ protected:
 	QString m_szGlobalKvircDir;
 	QString m_szLocalKvircDir;
 	int m_iHeartbeatTimerId;
+	kvi_time_t m_tLastSnapshotSave = 0;
 	bool m_bFirstTimeRun = false;
 	bool m_bClosingDown;
 #if defined(COMPILE_ON_WINDOWS) || defined(COMPILE_ON_MINGW)
@@ -175,6 +178,14 @@ protected:
 	KviIpcSentinel * m_pIpcSentinel;
 #endif
 	QFont m_fntDefaultFont;
+	// startup timing: the phases of setup() and the time they ended at (msecs)
+	long long m_iStartupTime;
+	std::vector<std::pair<QString, long long>> m_vStartupPhases;
+
+protected:
+	void preloadConfiguration();
+	void markStartupPhase(const QString & szPhase);
+	void reportStartupTiming();
 
 public:
 	void setup(); // THIS SHOULD BE PRIVATE! (but is accessed from KviMain.cpp)
@@ -222,6 +233,7 @@ public:
 	void saveRegisteredChannels();
 	void saveInputHistory();
 	void saveAvatarCache();
+	void saveModuleStats();
 	void saveToolBars();
 	void saveActions();
 	void saveScriptAddons();
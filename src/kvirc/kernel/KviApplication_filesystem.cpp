@@ -103,6 +103,9 @@ void KviApplication::getGlobalKvircDirectory(QString & szData, KvircSubdir dir,
 		case Trash:
 			qDebug("WARNING Global trash directory requested!");
 			break;
+		case Snapshots:
+			qDebug("WARNING Global snapshots directory requested!");
+			break;
 		case Config:
 			szData.append("config");
 			break;
@@ -171,6 +174,9 @@ void KviApplication::getLocalKvircDirectory(QString & szData, KvircSubdir dir, c
 		case EasyPlugins:
 			szData.append("easyplugins");
 			break;
+		case Snapshots:
+			szData.append("snapshots");
+			break;
 		case Config:
 			szData.append("config");
 			break;
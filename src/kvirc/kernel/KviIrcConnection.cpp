@@ -77,6 +77,9 @@
 extern KVIRC_API KviIrcServerDataBase * g_pServerDataBase;
 extern KVIRC_API KviProxyDataBase * g_pProxyDataBase;
 
+// when the next join burst may start, shared by all the connections (msecs)
+static long long g_iNextJoinBurstTime = 0;
+
 KviIrcConnection::KviIrcConnection(KviIrcContext * pContext, KviIrcConnectionTarget * pTarget, KviUserIdentity * pIdentity)
     : QObject(), m_pContext(pContext), m_pTarget(pTarget), m_pUserIdentity(pIdentity)
 {
@@ -113,6 +116,9 @@ KviIrcConnection::~KviIrcConnection()
 	delete m_pNotifyListTimer;
 	m_pNotifyListTimer = nullptr;
 
+	delete m_pJoinTimer;
+	m_pJoinTimer = nullptr;
+
 	delete m_pNotifyListManager; // destroy this before the userDb
 	m_pNotifyListManager = nullptr;
 
@@ -274,6 +280,7 @@ void KviIrcConnection::abort()
 void KviIrcConnection::start()
 {
 	m_eState = Connecting;
+	m_pStatistics->markPhase(KviIrcConnectionStatistics::Started);
 	if(KVI_OPTION_BOOL(KviOption_boolUseIdentService) && KVI_OPTION_BOOL(KviOption_boolUseIdentServiceOnlyOnConnect))
 	{
 		g_pMainWindow->executeInternalCommand(KVI_INTERNALCOMMAND_IDENT_START);
@@ -566,38 +573,48 @@ void KviIrcConnection::linkAttemptFailed(int iError)
 
 KviChannelWindow * KviIrcConnection::findChannel(const QString & szName)
 {
-	for(auto & c : m_pChannelList)
+	return m_hChannels.value(caseMappedName(szName), nullptr);
+}
+
+int KviIrcConnection::getUserChannels(const QString & szNick, std::vector<KviChannelWindow *> & vChannels)
+{
+	vChannels.clear();
+	KviIrcUserEntry * pEntry = m_pUserDataBase->find(szNick);
+	if(!pEntry)
+		return 0;
+	for(auto & pUserList : pEntry->userLists())
 	{
-		if(KviQString::equalCI(szName, c->windowName()))
-			return c;
+		// the other user lists belong to queries
+		if(pUserList->window()->type() == KviWindow::Channel)
+			vChannels.push_back((KviChannelWindow *)pUserList->window());
 	}
-	return nullptr;
+	return vChannels.size();
 }
 
 int KviIrcConnection::getCommonChannels(const QString & szNick, QString & szChansBuffer, bool bAddEscapeSequences)
 {
+	std::vector<KviChannelWindow *> vChannels;
+	getUserChannels(szNick, vChannels);
+
 	int iCount = 0;
-	for(auto & c : m_pChannelList)
+	for(auto & c : vChannels)
 	{
-		if(c->isOn(szNick))
-		{
-			if(!szChansBuffer.isEmpty())
-				szChansBuffer.append(", ");
+		if(!szChansBuffer.isEmpty())
+			szChansBuffer.append(", ");
 
-			char uFlag = c->getUserFlag(szNick);
-			if(uFlag)
-			{
-				KviQString::appendFormatted(szChansBuffer, bAddEscapeSequences ? "%c\r!c\r%Q\r" : "%c%Q", uFlag, &(c->windowName()));
-			}
+		char uFlag = c->getUserFlag(szNick);
+		if(uFlag)
+		{
+			KviQString::appendFormatted(szChansBuffer, bAddEscapeSequences ? "%c\r!c\r%Q\r" : "%c%Q", uFlag, &(c->windowName()));
+		}
+		else
+		{
+			if(bAddEscapeSequences)
+				KviQString::appendFormatted(szChansBuffer, "\r!c\r%Q\r", &(c->windowName()));
 			else
-			{
-				if(bAddEscapeSequences)
-					KviQString::appendFormatted(szChansBuffer, "\r!c\r%Q\r", &(c->windowName()));
-				else
-					szChansBuffer.append(c->windowName());
-			}
-			iCount++;
+				szChansBuffer.append(c->windowName());
 		}
+		iCount++;
 	}
 	return iCount;
 }
@@ -698,17 +715,49 @@ KviQueryWindow * KviIrcConnection::createQuery(const QString & szNick, CreateQue
 
 KviQueryWindow * KviIrcConnection::findQuery(const QString & szName)
 {
+	return m_hQueries.value(caseMappedName(szName), nullptr);
+}
+
+QString KviIrcConnection::caseMappedName(const QString & szName) const
+{
+	return KviIrcCaseMapping::toLower(szName, m_pServerInfo->caseMapping());
+}
+
+void KviIrcConnection::setCaseMapping(KviIrcCaseMapping::Mapping eMapping)
+{
+	if(eMapping == m_pServerInfo->caseMapping())
+		return;
+	m_pServerInfo->setCaseMapping(eMapping);
+
+	m_pUserDataBase->setCaseMapping(eMapping);
+	for(auto & c : m_pChannelList)
+		c->userListView()->caseMappingChanged();
 	for(auto & q : m_pQueryList)
+		q->userListView()->caseMappingChanged();
+
+	// the names that were different may be the same now: the first registered wins as in a linear search
+	m_hChannels.clear();
+	for(auto & c : m_pChannelList)
 	{
-		if(KviQString::equalCI(szName, q->windowName()))
-			return q;
+		QString szKey = caseMappedName(c->windowName());
+		if(!m_hChannels.contains(szKey))
+			m_hChannels.insert(szKey, c);
+	}
+	m_hQueries.clear();
+	for(auto & q : m_pQueryList)
+	{
+		QString szKey = caseMappedName(q->windowName());
+		if(!m_hQueries.contains(szKey))
+			m_hQueries.insert(szKey, q);
 	}
-	return nullptr;
 }
 
 void KviIrcConnection::registerChannel(KviChannelWindow * c)
 {
 	m_pChannelList.push_back(c);
+	QString szKey = caseMappedName(c->windowName());
+	if(!m_hChannels.contains(szKey))
+		m_hChannels.insert(szKey, c);
 	if(KVI_OPTION_BOOL(KviOption_boolLogChannelHistory))
 		g_pApp->addRecentChannel(c->windowName(), m_pServerInfo->networkName());
 	emit(channelRegistered(c));
@@ -718,6 +767,20 @@ void KviIrcConnection::registerChannel(KviChannelWindow * c)
 void KviIrcConnection::unregisterChannel(KviChannelWindow * c)
 {
 	m_pChannelList.erase(std::remove(m_pChannelList.begin(), m_pChannelList.end(), c), m_pChannelList.end());
+	QString szKey = caseMappedName(c->windowName());
+	if(m_hChannels.value(szKey, nullptr) == c)
+	{
+		m_hChannels.remove(szKey);
+		// another channel with the same name may be waiting (a dead one being resurrected)
+		for(auto & other : m_pChannelList)
+		{
+			if(caseMappedName(other->windowName()) == szKey)
+			{
+				m_hChannels.insert(szKey, other);
+				break;
+			}
+		}
+	}
 	requestQueue()->dequeueChannel(c);
 	emit(channelUnregistered(c));
 	emit(chanListChanged());
@@ -726,11 +789,40 @@ void KviIrcConnection::unregisterChannel(KviChannelWindow * c)
 void KviIrcConnection::registerQuery(KviQueryWindow * q)
 {
 	m_pQueryList.push_back(q);
+	QString szKey = caseMappedName(q->windowName());
+	if(!m_hQueries.contains(szKey))
+		m_hQueries.insert(szKey, q);
 }
 
 void KviIrcConnection::unregisterQuery(KviQueryWindow * q)
 {
 	m_pQueryList.erase(std::remove(m_pQueryList.begin(), m_pQueryList.end(), q), m_pQueryList.end());
+	unindexQuery(q, caseMappedName(q->windowName()));
+}
+
+void KviIrcConnection::unindexQuery(KviQueryWindow * q, const QString & szKey)
+{
+	if(m_hQueries.value(szKey, nullptr) != q)
+		return;
+	m_hQueries.remove(szKey);
+	for(auto & other : m_pQueryList)
+	{
+		if((other != q) && (caseMappedName(other->windowName()) == szKey))
+		{
+			m_hQueries.insert(szKey, other);
+			break;
+		}
+	}
+}
+
+void KviIrcConnection::queryRenamed(KviQueryWindow * q, const QString & szOldName)
+{
+	if(std::find(m_pQueryList.begin(), m_pQueryList.end(), q) == m_pQueryList.end())
+		return; // dead query
+	unindexQuery(q, caseMappedName(szOldName));
+	QString szKey = caseMappedName(q->windowName());
+	if(!m_hQueries.contains(szKey))
+		m_hQueries.insert(szKey, q);
 }
 
 void KviIrcConnection::keepChannelsOpenAfterDisconnect()
@@ -931,13 +1023,16 @@ void KviIrcConnection::resolveLocalHost()
 {
 	QString szIp;
 
-	if(!link()->socket()->getLocalHostIp(szIp, target()->server()->isIPv6()))
+	// the family of the socket: the server may have been reached by any of its addresses
+	bool bIPv6 = link()->socket()->usingIPv6();
+
+	if(!link()->socket()->getLocalHostIp(szIp, bIPv6))
 	{
 		bool bGotIp = false;
 		if(!KVI_OPTION_STRING(KviOption_stringLocalHostIp).isEmpty())
 		{
 #ifdef COMPILE_IPV6_SUPPORT
-			if(target()->server()->isIPv6())
+			if(bIPv6)
 			{
 				if(KviNetUtils::isValidStringIPv6(KVI_OPTION_STRING(KviOption_stringLocalHostIp)))
 					bGotIp = true;
@@ -1755,6 +1850,8 @@ void KviIrcConnection::loginComplete(const QString & szNickName)
 	// ...but to be on the safe side we just disable the special handling here.
 	m_pStateData->setIgnoreOneYouHaveNotRegisteredError(false);
 
+	m_pStatistics->markPhase(KviIrcConnectionStatistics::LoggedIn);
+
 	context()->loginComplete();
 
 	if(m_bIdentdAttached)
@@ -1841,13 +1938,14 @@ void KviIrcConnection::loginComplete(const QString & szNickName)
 	}
 
 	bool bJoinStdChannels = true;
+	std::vector<std::pair<QString, QString>> lChansAndPass;
 
 	if(target()->server()->reconnectInfo())
 	{
 		if(!target()->server()->reconnectInfo()->m_lJoinChannels.empty())
 		{
 			bJoinStdChannels = false;
-			joinChannels(target()->server()->reconnectInfo()->m_lJoinChannels);
+			lChansAndPass = target()->server()->reconnectInfo()->m_lJoinChannels;
 		}
 
 		KviQueryWindow * pQuery;
@@ -1880,8 +1978,6 @@ void KviIrcConnection::loginComplete(const QString & szNickName)
 
 	if(bJoinStdChannels)
 	{
-		std::vector<std::pair<QString, QString>> lChansAndPass;
-
 		if(target()->network()->autoJoinChannelList())
 		{
 			if(_OUTPUT_VERBOSE)
@@ -1917,9 +2013,86 @@ void KviIrcConnection::loginComplete(const QString & szNickName)
 				lChansAndPass.emplace_back(szCurChan, szCurPass);
 			}
 		}
+	}
+
+	if(lChansAndPass.empty())
+		reportConnectionTiming();
+	else
+		scheduleJoinChannels(lChansAndPass);
+}
+
+void KviIrcConnection::scheduleJoinChannels(const std::vector<std::pair<QString, QString>> & lChannelsAndPasses)
+{
+	m_vDelayedJoins.insert(m_vDelayedJoins.end(), lChannelsAndPasses.begin(), lChannelsAndPasses.end());
+	if(m_pJoinTimer)
+		return; // already waiting for our slot
+
+	long long iNow = KviTimeUtils::getCurrentTimeMills();
+	long long iSlot = std::max(iNow, g_iNextJoinBurstTime);
+	g_iNextJoinBurstTime = iSlot + KVI_OPTION_UINT(KviOption_uintJoinBurstInterval);
 
-		joinChannels(lChansAndPass);
+	if(iSlot <= iNow)
+	{
+		delayedJoinChannels();
+		return;
 	}
+
+	if(_OUTPUT_VERBOSE)
+		m_pConsole->outputNoFmt(KVI_OUT_VERBOSE, __tr2qs("Other connections are joining channels: waiting %1 msecs").arg(iSlot - iNow));
+
+	m_pJoinTimer = new QTimer();
+	m_pJoinTimer->setSingleShot(true);
+	connect(m_pJoinTimer, SIGNAL(timeout()), this, SLOT(delayedJoinChannels()));
+	m_pJoinTimer->start(iSlot - iNow);
+}
+
+void KviIrcConnection::delayedJoinChannels()
+{
+	delete m_pJoinTimer;
+	m_pJoinTimer = nullptr;
+
+	std::vector<std::pair<QString, QString>> lChansAndPass;
+	lChansAndPass.swap(m_vDelayedJoins);
+	joinChannels(lChansAndPass);
+
+	if(!m_pStatistics->phaseTime(KviIrcConnectionStatistics::Joined))
+	{
+		m_pStatistics->markPhase(KviIrcConnectionStatistics::Joined);
+		reportConnectionTiming();
+	}
+}
+
+void KviIrcConnection::reportConnectionTiming()
+{
+	if(_OUTPUT_QUIET)
+		return;
+
+	const std::pair<KviIrcConnectionStatistics::Phase, QString> aSteps[] = {
+		{ KviIrcConnectionStatistics::Resolved, __tr2qs("lookup") },
+		{ KviIrcConnectionStatistics::LinkUp, __tr2qs("connect") },
+		{ KviIrcConnectionStatistics::Secured, m_pStatistics->sslSessionResumed() ? __tr2qs("resumed SSL handshake") : __tr2qs("SSL handshake") },
+		{ KviIrcConnectionStatistics::LoggedIn, __tr2qs("login") },
+		{ KviIrcConnectionStatistics::Joined, __tr2qs("join wait") }
+	};
+
+	QString szSteps;
+	long long iLast = 0;
+	for(auto & s : aSteps)
+	{
+		long long iDuration = m_pStatistics->phaseDuration(s.first);
+		if(iDuration < 0)
+			continue;
+		if(!szSteps.isEmpty())
+			szSteps.append(", ");
+		szSteps.append(QString("%1 %2 ms").arg(s.second).arg(iDuration));
+		iLast = m_pStatistics->phaseTime(s.first);
+	}
+
+	if(szSteps.isEmpty() || !m_pStatistics->phaseTime(KviIrcConnectionStatistics::Started))
+		return;
+
+	m_pConsole->outputNoFmt(KVI_OUT_SYSTEMMESSAGE, __tr2qs("Connection setup took %1 ms (%2)")
+	    .arg(iLast - m_pStatistics->phaseTime(KviIrcConnectionStatistics::Started)).arg(szSteps));
 }
 
 void KviIrcConnection::incomingMessage(const char * pcMessage)
@@ -31,10 +31,12 @@
 */
 
 #include "kvi_settings.h"
+#include "KviIrcCaseMapping.h"
 #include "KviQString.h"
 #include "KviTimeUtils.h"
 
 #include <QByteArray>
+#include <QHash>
 #include <QObject>
 #include <QStringList>
 
@@ -163,12 +165,18 @@ private:
 
 	std::vector<KviChannelWindow *> m_pChannelList; // elements are borrowed and never null
 	std::vector<KviQueryWindow *> m_pQueryList;     // elements are borrowed and never null
+	// m_pChannelList and m_pQueryList indexed by the casemapped window names
+	QHash<QString, KviChannelWindow *> m_hChannels;
+	QHash<QString, KviQueryWindow *> m_hQueries;
 
 	KviIrcUserDataBase * m_pUserDataBase; // owned, never null
 
 	KviNotifyListManager * m_pNotifyListManager = nullptr; // owned, see restartNotifyList()
 	QTimer * m_pNotifyListTimer = nullptr;       // delayed startup timer for the notify lists
 
+	std::vector<std::pair<QString, QString>> m_vDelayedJoins; // the channels waiting for our join slot
+	QTimer * m_pJoinTimer = nullptr;                          // fires when our join slot comes
+
 	KviLagMeter * m_pLagMeter = nullptr; // owned, may be null (when not running)
 
 	KviIrcConnectionAntiCtcpFloodData * m_pAntiCtcpFloodData;       // owned, never null
@@ -422,6 +430,20 @@ public:
 	*/
 	int getCommonChannels(const QString & szNick, QString & szChansBuffer, bool bAddEscapeSequences = true);
 
+	/**
+	* \brief Returns the channels that the specified user is on
+	*
+	* The channels are found via the memberships stored in the user database
+	* entry so the cost depends only on the number of channels of the user.
+	* They are listed in the order the user has joined them.
+	*
+	* Returns the number of channels found.
+	* \param szNick The nickname of the user
+	* \param vChannels The buffer where to store the channels
+	* \return int
+	*/
+	int getUserChannels(const QString & szNick, std::vector<KviChannelWindow *> & vChannels);
+
 	/**
 	* \brief Creates a new channel with the specified name.
 	*
@@ -540,6 +562,30 @@ public:
 	///
 	void unregisterQuery(KviQueryWindow * q);
 
+	///
+	/// This is called by KviQueryWindow when its target changes, you shouldn't need to use it.
+	///
+	void queryRenamed(KviQueryWindow * q, const QString & szOldName);
+
+	/**
+	* \brief Returns the name in the form used to index the channels and the queries
+	*
+	* This applies the casemapping announced by the server.
+	* \param szName The nickname or the channel name
+	* \return QString
+	*/
+	QString caseMappedName(const QString & szName) const;
+
+	/**
+	* \brief Switches to the casemapping announced by the server
+	*
+	* The channel and query indexes, the user database and the user lists
+	* are rebuilt with the new mapping.
+	* \param eMapping The new casemapping
+	* \return void
+	*/
+	void setCaseMapping(KviIrcCaseMapping::Mapping eMapping);
+
 	/**
 	* \brief Marks all the currently open queries as DEAD
 	*
@@ -773,6 +819,24 @@ protected:
 	*/
 	void joinChannels(const std::vector<std::pair<QString, QString>> & lChannelsAndPasses);
 
+	/**
+	* \brief Joins a list of channels in the next free join slot
+	*
+	* The join bursts of the connections that log in together (at startup
+	* or after a network outage) are spread by KviOption_uintJoinBurstInterval
+	* msecs so the channel windows and the NAMES replies don't all hit
+	* the GUI at once.
+	* \param lChannelsAndPasses The channels and their passwords
+	* \return void
+	*/
+	void scheduleJoinChannels(const std::vector<std::pair<QString, QString>> & lChannelsAndPasses);
+
+	/**
+	* \brief Prints the time spent in each phase of the connection setup
+	* \return void
+	*/
+	void reportConnectionTiming();
+
 	/**
 	* Gather the list of currently joined channels with the relative passwords.
 	*/
@@ -951,6 +1015,16 @@ private:
 	* \return void
 	*/
 	void setupSrvCodec();
+
+	/**
+	* \brief Removes the query from the index under the specified key
+	*
+	* If another query has the same name, it takes its place in the index.
+	* \param q The query
+	* \param szKey The casemapped name the query was indexed with
+	* \return void
+	*/
+	void unindexQuery(KviQueryWindow * q, const QString & szKey);
 public slots:
 	/**
 	* \brief Called when we unhighlight all channels
@@ -975,6 +1049,12 @@ private slots:
 	* \return void
 	*/
 	void hostNameLookupTerminated(KviDnsResolver * pDns);
+
+	/**
+	* \brief Called when our join slot comes
+	* \return void
+	*/
+	void delayedJoinChannels();
 signals:
 	/**
 	* \brief Emitted when the away state changes
@@ -25,6 +25,7 @@
 //=============================================================================
 
 #include "kvi_settings.h"
+#include "KviIrcCaseMapping.h"
 #include "KviQString.h"
 #include "kvi_inttypes.h"
 
@@ -333,6 +334,7 @@ private:
 	bool m_bSupportsCap = false;
 	QStringList m_lSupportedCaps;
 	bool m_bSupportsWhox = false; // supports WHOX
+	KviIrcCaseMapping::Mapping m_eCaseMapping = KviIrcCaseMapping::Rfc1459; // from the CASEMAPPING ISUPPORT token
 public:
 	char registerModeChar() const { return m_pServInfo ? m_pServInfo->getRegisterModeChar() : 0; }
 	const char * software() const { return m_pServInfo ? m_pServInfo->getSoftware() : 0; }
@@ -355,6 +357,7 @@ public:
 	bool supportsWatchList() const { return m_bSupportsWatchList; }
 	bool supportsCodePages() const { return m_bSupportsCodePages; }
 	bool supportsWhox() const { return m_bSupportsWhox; }
+	KviIrcCaseMapping::Mapping caseMapping() const { return m_eCaseMapping; }
 
 	int maxTopicLen() const { return m_iMaxTopicLen; }
 	int maxModeChanges() const { return m_iMaxModeChanges; }
@@ -390,6 +393,8 @@ protected:
 	void setMaxTopicLen(int iTopLen) { m_iMaxTopicLen = iTopLen; }
 	void setMaxModeChanges(int iModes) { m_iMaxModeChanges = iModes; }
 	void setSupportsWhox(bool bSupportsWhox) { m_bSupportsWhox = bSupportsWhox; }
+	// use KviIrcConnection::setCaseMapping() that keeps the window indexes in sync
+	void setCaseMapping(KviIrcCaseMapping::Mapping eMapping) { m_eCaseMapping = eMapping; }
 private:
 	void buildModePrefixTable();
 };
@@ -29,3 +29,16 @@ KviIrcConnectionStatistics::KviIrcConnectionStatistics()
 
 KviIrcConnectionStatistics::~KviIrcConnectionStatistics()
     = default;
+
+long long KviIrcConnectionStatistics::phaseDuration(Phase ePhase) const
+{
+	if(!m_aPhaseTime[ePhase])
+		return -1;
+
+	for(int i = ePhase - 1; i >= 0; i--)
+	{
+		if(m_aPhaseTime[i])
+			return m_aPhaseTime[ePhase] - m_aPhaseTime[i];
+	}
+	return 0;
+}
@@ -31,20 +31,41 @@
 class KVIRC_API KviIrcConnectionStatistics
 {
 	friend class KviIrcConnection;
+	friend class KviIrcLink;
 
 public:
 	KviIrcConnectionStatistics();
 	~KviIrcConnectionStatistics();
 
+	// the steps of the connection setup, in the order they happen
+	enum Phase
+	{
+		Started,      // the connection has been requested
+		Resolved,     // the server (or proxy) address is known
+		LinkUp,       // the tcp connection has been established
+		Secured,      // the ssl handshake has been completed (not set for plain connections)
+		LoggedIn,     // the server has accepted the registration
+		Joined,       // the autojoin channels have been requested
+		PhaseCount
+	};
+
 protected:
 	kvi_time_t m_tConnectionStart = 0; // (valid only when Connected or LoggingIn)
 	kvi_time_t m_tLastMessage = 0;     // last message received from server
+	long long m_aPhaseTime[PhaseCount] = {}; // msecs, 0 if the phase has not been reached
+	bool m_bSSLSessionResumed = false;       // the ssl handshake resumed a previous session
 public:
 	kvi_time_t connectionStartTime() const { return m_tConnectionStart; }
 	kvi_time_t lastMessageTime() const { return m_tLastMessage; }
+	long long phaseTime(Phase ePhase) const { return m_aPhaseTime[ePhase]; }
+	bool sslSessionResumed() const { return m_bSSLSessionResumed; }
+	// the msecs spent in ePhase since the previous reached phase, -1 if ePhase has not been reached
+	long long phaseDuration(Phase ePhase) const;
 protected:
 	void setLastMessageTime(kvi_time_t t) { m_tLastMessage = t; }
 	void setConnectionStartTime(kvi_time_t t) { m_tConnectionStart = t; }
+	void markPhase(Phase ePhase) { m_aPhaseTime[ePhase] = KviTimeUtils::getCurrentTimeMills(); }
+	void setSSLSessionResumed(bool bResumed) { m_bSSLSessionResumed = bResumed; }
 };
 
 #endif //!_KVI_IRCCONNECTIONSTATISTICS_H_
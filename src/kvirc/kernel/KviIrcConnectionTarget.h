@@ -28,6 +28,8 @@
 #include "KviQString.h"
 #include "KviHeapObject.h"
 
+#include <vector>
+
 class KviIrcNetwork;
 class KviIrcServer;
 class KviProxy;
@@ -47,10 +49,11 @@ public:
 	~KviIrcConnectionTarget();
 
 private:
-	KviIrcNetwork * m_pNetwork;    // owned, never null, it's a COPY of the entry in the db
-	KviIrcServer * m_pServer;      // owned, never null, it's a COPY of the entry in the db
-	KviProxy * m_pProxy = nullptr; // owned, may be null, it's a COPY of the entry in the db
-	QString m_szBindAddress;       // forced bind address
+	KviIrcNetwork * m_pNetwork;        // owned, never null, it's a COPY of the entry in the db
+	KviIrcServer * m_pServer;          // owned, never null, it's a COPY of the entry in the db
+	KviProxy * m_pProxy = nullptr;     // owned, may be null, it's a COPY of the entry in the db
+	QString m_szBindAddress;           // forced bind address
+	std::vector<QString> m_vAddresses; // the server addresses to try in parallel, in order of preference
 
 public:
 	KviIrcServer * server() const { return m_pServer; }
@@ -58,11 +61,13 @@ public:
 	KviProxy * proxy() const { return m_pProxy; }
 	const QString & bindAddress() const { return m_szBindAddress; }
 	bool hasBindAddress() const { return !m_szBindAddress.isEmpty(); }
+	const std::vector<QString> & addresses() const { return m_vAddresses; }
 
 protected:
 	// this is for KviIrcConnectionTargetResolver only
 	void clearProxy();
 	void setBindAddress(const QString & szBindAddress) { m_szBindAddress = szBindAddress; }
+	void setAddresses(const std::vector<QString> & vAddresses) { m_vAddresses = vAddresses; }
 };
 
 #endif //!_KVI_IRCCONNECTIONTARGET_H_
@@ -41,14 +41,30 @@
 #include "KviIrcConnection.h"
 #include "KviIrcConnectionTarget.h"
 #include "KviIrcNetwork.h"
+#include "KviTimeUtils.h"
 
+#include <QHash>
 #include <QTimer>
 
+#include <algorithm>
 #include <cstdlib>
 
+// how long we wait for the other address family after the first lookup answered (msecs)
+#define KVI_RESOLVER_RESOLUTION_DELAY 50
+
 extern KVIRC_API KviIrcServerDataBase * g_pServerDataBase;
 extern KVIRC_API KviProxyDataBase * g_pProxyDataBase;
 
+struct KviServerLookupCacheEntry
+{
+	QString szHostName;
+	std::vector<QString> vAddresses;
+	kvi_time_t tExpire;
+};
+
+// the recent server hostname lookups, shared by all the connections
+static QHash<QString, KviServerLookupCacheEntry> g_hServerLookupCache;
+
 KviIrcConnectionTargetResolver::KviIrcConnectionTargetResolver(KviIrcConnection * pConnection)
     : QObject(), m_pConnection(pConnection)
 {
@@ -78,21 +94,12 @@ void KviIrcConnectionTargetResolver::cleanup()
 		}
 		m_pProxyDns = nullptr;
 	}
-	if(m_pServerDns)
+	deleteDns(&m_pServerDns);
+	deleteDns(&m_pServerDnsIPv6);
+	if(m_pResolutionDelayTimer)
 	{
-		if(m_pServerDns->isRunning())
-		{
-			// deleting a running dns may block
-			// thus garbage-collect it and delete later
-			//g_pGarbageCollector->collect(m_pServerDns);
-			m_pServerDns->deleteLater();
-		}
-		else
-		{
-			// can't block : just delete it
-			delete m_pServerDns;
-		}
-		m_pServerDns = nullptr;
+		delete m_pResolutionDelayTimer;
+		m_pResolutionDelayTimer = nullptr;
 	}
 	if(m_pStartTimer)
 	{
@@ -101,6 +108,26 @@ void KviIrcConnectionTargetResolver::cleanup()
 	}
 }
 
+void KviIrcConnectionTargetResolver::deleteDns(KviDnsResolver ** ppDns)
+{
+	if(!*ppDns)
+		return;
+
+	if((*ppDns)->isRunning())
+	{
+		// deleting a running dns may block
+		// thus garbage-collect it and delete later
+		(*ppDns)->disconnect(this);
+		(*ppDns)->deleteLater();
+	}
+	else
+	{
+		// can't block : just delete it
+		delete *ppDns;
+	}
+	*ppDns = nullptr;
+}
+
 void KviIrcConnectionTargetResolver::start(KviIrcConnectionTarget * t)
 {
 	KVI_ASSERT(m_eState == Idle);
@@ -311,17 +338,51 @@ void KviIrcConnectionTargetResolver::lookupServerHostname()
 		}
 		else
 		{
-			if(m_pServerDns)
+			if(KVI_OPTION_UINT(KviOption_uintDnsCacheTimeout) > 0)
+			{
+				auto it = g_hServerLookupCache.find(serverCacheKey());
+				if(it != g_hServerLookupCache.end())
+				{
+					if(it->tExpire > kvi_unixTime())
+					{
+						if(!_OUTPUT_QUIET)
+							m_pConsole->output(KVI_OUT_SYSTEMMESSAGE,
+							    __tr2qs("Using cached lookup of the server hostname (%s)"),
+							    m_pTarget->server()->hostName().toUtf8().data());
+						setServerAddresses(it->szHostName, it->vAddresses);
+						haveServerIp();
+						return;
+					}
+					g_hServerLookupCache.erase(it);
+				}
+			}
+
+			if(m_pServerDns || m_pServerDnsIPv6)
 			{
 				qDebug("Something weird is happening, m_pServerDns is non-zero in lookupServerHostname()");
-				delete m_pServerDns;
-				m_pServerDns = nullptr;
+				deleteDns(&m_pServerDns);
+				deleteDns(&m_pServerDnsIPv6);
 			}
 			m_pServerDns = new KviDnsResolver();
 			connect(m_pServerDns, SIGNAL(lookupDone(KviDnsResolver *)), this,
 			    SLOT(serverLookupTerminated(KviDnsResolver *)));
-			if(!m_pServerDns->lookup(m_pTarget->server()->hostName(),
-			       m_pTarget->server()->isIPv6() ? KviDnsResolver::IPv6 : KviDnsResolver::IPv4))
+			bool bStarted = m_pServerDns->lookup(m_pTarget->server()->hostName(),
+			    m_pTarget->server()->isIPv6() ? KviDnsResolver::IPv6 : KviDnsResolver::IPv4);
+
+			if(bStarted && useBothFamilies())
+			{
+				// the AAAA lookup runs in parallel with the A one
+				m_pServerDnsIPv6 = new KviDnsResolver();
+				connect(m_pServerDnsIPv6, SIGNAL(lookupDone(KviDnsResolver *)), this,
+				    SLOT(serverLookupTerminated(KviDnsResolver *)));
+				if(!m_pServerDnsIPv6->lookup(m_pTarget->server()->hostName(), KviDnsResolver::IPv6))
+				{
+					delete m_pServerDnsIPv6;
+					m_pServerDnsIPv6 = nullptr;
+				}
+			}
+
+			if(!bStarted)
 			{
 				m_pConsole->outputNoFmt(KVI_OUT_SYSTEMERROR,
 				    __tr2qs("Unable to look up the server hostname: Can't start the DNS slave"));
@@ -338,77 +399,195 @@ void KviIrcConnectionTargetResolver::lookupServerHostname()
 	}
 }
 
-void KviIrcConnectionTargetResolver::serverLookupTerminated(KviDnsResolver *)
+bool KviIrcConnectionTargetResolver::useBothFamilies()
+{
+#ifdef COMPILE_IPV6_SUPPORT
+	// the proxies get a single address: only direct connections race the families
+	return KVI_OPTION_BOOL(KviOption_boolConnectToFastestServerAddress) && !m_pTarget->proxy() && !m_pTarget->server()->isIPv6();
+#else
+	return false;
+#endif
+}
+
+QString KviIrcConnectionTargetResolver::serverCacheKey()
+{
+	QString szKey = m_pTarget->server()->hostName().toLower();
+	if(m_pTarget->server()->isIPv6())
+		szKey.append(QString(" ipv6"));
+	else if(useBothFamilies())
+		szKey.append(QString(" any"));
+	return szKey;
+}
+
+void KviIrcConnectionTargetResolver::setServerAddresses(const QString & szHostName, const std::vector<QString> & vAddresses)
 {
-	if(m_pServerDns->state() != KviDnsResolver::Success)
+	QString szIpAddress;
+
+	if(useBothFamilies() && (vAddresses.size() > 1))
 	{
-		QString szErr = m_pServerDns->errorString();
-		m_pConsole->output(KVI_OUT_SYSTEMERROR,
-		    __tr2qs("Can't find the server IP address: %Q"),
-		    &szErr);
+		// alternate the families, IPv6 first, so the socket can race them
+		std::vector<QString> vIPv4, vIPv6;
+		for(auto & a : vAddresses)
+		{
+			if(KviNetUtils::isValidStringIp(a))
+				vIPv4.push_back(a);
+			else
+				vIPv6.push_back(a);
+		}
 
-#ifdef COMPILE_IPV6_SUPPORT
-		if(!(m_pTarget->server()->isIPv6()))
+		if(KVI_OPTION_BOOL(KviOption_boolPickRandomIpAddressForRoundRobinServers))
 		{
-			m_pConsole->output(KVI_OUT_SYSTEMERROR,
-			    __tr2qs("If this server is an IPv6 one, try /server -i %Q"),
-			    &(m_pTarget->server()->hostName()));
+			// start each family from a random entry
+			if(!vIPv4.empty())
+				std::rotate(vIPv4.begin(), vIPv4.begin() + (::rand() % vIPv4.size()), vIPv4.end());
+			if(!vIPv6.empty())
+				std::rotate(vIPv6.begin(), vIPv6.begin() + (::rand() % vIPv6.size()), vIPv6.end());
 		}
-#endif
-		terminate(Error, m_pServerDns->error());
-		return;
-	}
 
-	QString szIpAddress;
+		std::vector<QString> vOrdered;
+		vOrdered.reserve(vAddresses.size());
+		for(std::size_t i = 0; i < std::max(vIPv4.size(), vIPv6.size()); i++)
+		{
+			if(i < vIPv6.size())
+				vOrdered.push_back(vIPv6[i]);
+			if(i < vIPv4.size())
+				vOrdered.push_back(vIPv4[i]);
+		}
 
-	if(m_pServerDns->ipAddressCount() > 1)
+		if(!_OUTPUT_MUTE)
+			m_pConsole->output(KVI_OUT_SYSTEMMESSAGE,
+			    __tr2qs("Server has %d IPv4 and %d IPv6 addresses, trying them in parallel"),
+			    (int)vIPv4.size(), (int)vIPv6.size());
+
+		szIpAddress = vOrdered.front();
+		m_pTarget->setAddresses(vOrdered);
+	}
+	else if(vAddresses.size() > 1)
 	{
 		if(KVI_OPTION_BOOL(KviOption_boolPickRandomIpAddressForRoundRobinServers))
 		{
 			if(!_OUTPUT_MUTE)
 				m_pConsole->output(KVI_OUT_SYSTEMMESSAGE,
 				    __tr2qs("Server has %d IP addresses, picking a random one"),
-				    m_pServerDns->ipAddressCount());
+				    (int)vAddresses.size());
 
-			int r = ::rand() % m_pServerDns->ipAddressCount();
-			szIpAddress = m_pServerDns->ipAddressList()[r];
+			int r = ::rand() % vAddresses.size();
+			szIpAddress = vAddresses[r];
 		}
 		else
 		{
 			if(!_OUTPUT_MUTE)
 				m_pConsole->output(KVI_OUT_SYSTEMMESSAGE,
 				    __tr2qs("Server has %d IP addresses, using the first one"),
-				    m_pServerDns->ipAddressCount());
-			szIpAddress = m_pServerDns->firstIpAddress();
+				    (int)vAddresses.size());
+			szIpAddress = vAddresses.front();
 		}
 	}
 	else
 	{
-		szIpAddress = m_pServerDns->firstIpAddress();
+		szIpAddress = vAddresses.front();
 	}
 
 	if(!_OUTPUT_MUTE)
 		m_pConsole->output(KVI_OUT_SYSTEMMESSAGE,
 		    __tr2qs("Server hostname resolved to %Q"),
 		    &szIpAddress);
-	m_pTarget->server()->setIp(szIpAddress);
 
-	const QString & szFirstHostname = m_pServerDns->hostName();
-
-	if(!KviQString::equalCI(m_pTarget->server()->hostName(), m_pServerDns->hostName()))
+	if(!szHostName.isEmpty() && !KviQString::equalCI(m_pTarget->server()->hostName(), szHostName))
 	{
 		if(!_OUTPUT_QUIET)
 			m_pConsole->output(KVI_OUT_SYSTEMMESSAGE,
 			    __tr2qs("Real hostname for %Q is %Q"),
 			    &(m_pTarget->server()->hostName()),
-			    &szFirstHostname);
-		m_pTarget->server()->setHostName(szFirstHostname);
+			    &szHostName);
+		m_pTarget->server()->setHostName(szHostName);
 	}
 
 	m_pTarget->server()->setIp(szIpAddress);
+}
+
+void KviIrcConnectionTargetResolver::serverLookupTerminated(KviDnsResolver * pDns)
+{
+	if(pDns->state() == KviDnsResolver::Success)
+	{
+		KviDnsResolver * pOther = (pDns == m_pServerDns) ? m_pServerDnsIPv6 : m_pServerDns;
+		if(pOther && pOther->isRunning())
+		{
+			// give the other family a chance to answer, but don't wait for it too long
+			if(!m_pResolutionDelayTimer)
+			{
+				m_pResolutionDelayTimer = new QTimer(this);
+				m_pResolutionDelayTimer->setSingleShot(true);
+				connect(m_pResolutionDelayTimer, SIGNAL(timeout()), this, SLOT(serverLookupDone()));
+				m_pResolutionDelayTimer->start(KVI_RESOLVER_RESOLUTION_DELAY);
+			}
+			return;
+		}
+	}
+	else if((m_pServerDns && m_pServerDns->isRunning()) || (m_pServerDnsIPv6 && m_pServerDnsIPv6->isRunning()))
+	{
+		// this family failed: wait for the other one
+		return;
+	}
+
+	serverLookupDone();
+}
+
+void KviIrcConnectionTargetResolver::serverLookupDone()
+{
+	if(m_pResolutionDelayTimer)
+	{
+		delete m_pResolutionDelayTimer;
+		m_pResolutionDelayTimer = nullptr;
+	}
+
+	std::vector<QString> vAddresses;
+	QString szHostName;
+
+	for(auto pDns : { m_pServerDns, m_pServerDnsIPv6 })
+	{
+		if(!pDns || (pDns->state() != KviDnsResolver::Success))
+			continue;
+		if(szHostName.isEmpty())
+			szHostName = pDns->hostName();
+		vAddresses.insert(vAddresses.end(), pDns->ipAddressList().begin(), pDns->ipAddressList().end());
+	}
+
+	if(vAddresses.empty())
+	{
+		QString szErr = m_pServerDns->errorString();
+		m_pConsole->output(KVI_OUT_SYSTEMERROR,
+		    __tr2qs("Can't find the server IP address: %Q"),
+		    &szErr);
+
+#ifdef COMPILE_IPV6_SUPPORT
+		if(!(m_pTarget->server()->isIPv6()) && !m_pServerDnsIPv6)
+		{
+			m_pConsole->output(KVI_OUT_SYSTEMERROR,
+			    __tr2qs("If this server is an IPv6 one, try /server -i %Q"),
+			    &(m_pTarget->server()->hostName()));
+		}
+#endif
+		terminate(Error, m_pServerDns->error());
+		return;
+	}
+
+	QString szKey = serverCacheKey();
+
+	setServerAddresses(szHostName, vAddresses);
+
+	if(KVI_OPTION_UINT(KviOption_uintDnsCacheTimeout) > 0)
+	{
+		// the resolver doesn't tell us the record ttl: use the configured one
+		KviServerLookupCacheEntry e;
+		e.szHostName = szHostName;
+		e.vAddresses = vAddresses;
+		e.tExpire = kvi_unixTime() + KVI_OPTION_UINT(KviOption_uintDnsCacheTimeout);
+		g_hServerLookupCache.insert(szKey, e);
+	}
 
-	delete m_pServerDns;
-	m_pServerDns = nullptr;
+	deleteDns(&m_pServerDns);
+	deleteDns(&m_pServerDnsIPv6);
 	haveServerIp();
 }
 
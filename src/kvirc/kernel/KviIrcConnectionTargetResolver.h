@@ -30,6 +30,8 @@
 
 #include <QObject>
 
+#include <vector>
+
 #ifdef Status
 #undef Status
 #endif
@@ -81,6 +83,9 @@ private:
 	QTimer * m_pStartTimer = nullptr;        // timer used to start the connection
 	KviDnsResolver * m_pProxyDns = nullptr;  // the dns object for the proxy hostnames
 	KviDnsResolver * m_pServerDns = nullptr; // the dns object for the server hostnames
+	// the dns object for the IPv6 addresses of the server when both the families are tried
+	KviDnsResolver * m_pServerDnsIPv6 = nullptr;
+	QTimer * m_pResolutionDelayTimer = nullptr; // waits a bit for the other family after the first answer
 
 	int m_iLastError = KviError::Success;
 
@@ -96,11 +101,16 @@ protected slots:
 	void asyncStartResolve();
 	void serverLookupTerminated(KviDnsResolver *);
 	void proxyLookupTerminated(KviDnsResolver *);
+	void serverLookupDone();
 
 private:
 	void cleanup();
 	void lookupProxyHostname();
 	void lookupServerHostname();
+	bool useBothFamilies();
+	QString serverCacheKey();
+	void setServerAddresses(const QString & szHostName, const std::vector<QString> & vAddresses);
+	void deleteDns(KviDnsResolver ** ppDns);
 	void haveServerIp();
 	bool validateLocalAddress(const QString & szAddress, QString & szBuffer);
 	void terminate(Status s, int iLastError);
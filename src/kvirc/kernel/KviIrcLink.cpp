@@ -32,6 +32,7 @@
 #include "kvi_out.h"
 #include "KviOptions.h"
 #include "KviIrcSocket.h"
+#include "KviSSL.h"
 #include "KviConsoleWindow.h"
 #include "KviNetUtils.h"
 #include "KviInternalCommand.h"
@@ -41,10 +42,15 @@
 #include "KviIrcConnection.h"
 #include "KviIrcConnectionTarget.h"
 #include "KviIrcConnectionTargetResolver.h"
+#include "KviIrcConnectionStatistics.h"
 #include "KviDataBuffer.h"
 #include "kvi_debug.h"
 
 #include <QTimer>
+#include <QElapsedTimer>
+
+// the maximum time spent processing the incoming lines before returning to the event loop (msecs)
+#define KVI_IRCLINK_PROCESSING_SLICE 25
 
 extern KVIRC_API KviIrcServerDataBase * g_pServerDataBase;
 extern KVIRC_API KviProxyDataBase * g_pProxyDataBase;
@@ -80,6 +86,9 @@ void KviIrcLink::linkFilterDestroyed()
 
 void KviIrcLink::destroySocket()
 {
+	// the lines of the old session must not reach the next one
+	m_lPendingLines.clear();
+
 	if(m_pLinkFilter)
 	{
 		QObject::disconnect(m_pLinkFilter, nullptr, this, nullptr);
@@ -173,10 +182,13 @@ void KviIrcLink::resolverTerminated()
 	delete m_pResolver;
 	m_pResolver = nullptr;
 
+	m_pConnection->statistics()->markPhase(KviIrcConnectionStatistics::Resolved);
+
 	createSocket(m_pTarget->server()->linkFilter());
 
 	KviError::Code eError = m_pSocket->startConnection(m_pTarget->server(), m_pTarget->proxy(),
-	    m_pTarget->bindAddress().isEmpty() ? nullptr : m_pTarget->bindAddress().toUtf8().data());
+	    m_pTarget->bindAddress().isEmpty() ? nullptr : m_pTarget->bindAddress().toUtf8().data(),
+	    m_pTarget->addresses());
 
 	if(eError != KviError::Success)
 	{
@@ -206,23 +218,20 @@ void KviIrcLink::processData(char * buffer, int iLen)
 	char * p = buffer;
 	char * cBeginOfCurData = buffer;
 	int iBufLen = 0;
-	char * cMessageBuffer = (char *)KviMemory::allocate(1);
 
 	while(*p)
 	{
 		if((*p == '\r') || (*p == '\n'))
 		{
 			//found a CR or LF...
-			//prepare a message buffer
 			iBufLen = p - cBeginOfCurData;
 			//check for previous unterminated data
 			if(m_uReadBufferLen > 0)
 			{
 				KVI_ASSERT(m_pReadBuffer);
-				cMessageBuffer = (char *)KviMemory::reallocate(cMessageBuffer, iBufLen + m_uReadBufferLen + 1);
-				KviMemory::move(cMessageBuffer, m_pReadBuffer, m_uReadBufferLen);
-				KviMemory::move((void *)(cMessageBuffer + m_uReadBufferLen), cBeginOfCurData, iBufLen);
-				*(cMessageBuffer + iBufLen + m_uReadBufferLen) = '\0';
+				QByteArray szLine(m_pReadBuffer, m_uReadBufferLen);
+				szLine.append(cBeginOfCurData, iBufLen);
+				m_lPendingLines.push_back(szLine);
 				m_uReadBufferLen = 0;
 				KviMemory::free(m_pReadBuffer);
 				m_pReadBuffer = nullptr;
@@ -230,40 +239,11 @@ void KviIrcLink::processData(char * buffer, int iLen)
 			else
 			{
 				KVI_ASSERT(!m_pReadBuffer);
-				cMessageBuffer = (char *)KviMemory::reallocate(cMessageBuffer, iBufLen + 1);
-				KviMemory::move(cMessageBuffer, cBeginOfCurData, iBufLen);
-				*(cMessageBuffer + iBufLen) = '\0';
+				if(iBufLen > 0)
+					m_lPendingLines.emplace_back(cBeginOfCurData, iBufLen);
 			}
 			m_uReadPackets++;
 
-			// FIXME: actually it can happen that the socket gets disconnected
-			// in an incomingMessage() call.
-			// The problem might be that some other parts of KVIrc assume
-			// that the IRC context still exists after a failed write to the socket
-			// (some parts don't even check the return value!)
-			// If the problem presents itself again then the solution is:
-			//   disable queue flushing for the "incomingMessage" call
-			//   and just call queue_insertMessage()
-			//   then after the call terminates flush the queue (eventually detecting
-			//   the disconnect and thus destroying the IRC context).
-			// For now we try to rely on the remaining parts to handle correctly
-			// such conditions. Let's see...
-			if(*cMessageBuffer != 0)
-				m_pConnection->incomingMessage(cMessageBuffer);
-
-			if(!m_pSocket || (m_pSocket->state() != KviIrcSocket::Connected))
-			{
-				// Disconnected in KviConsoleWindow::incomingMessage() call.
-				// This may happen for several reasons (local event loop
-				// with the user hitting the disconnect button, a scripting
-				// handler event that disconnects explicitly)
-				//
-				// We handle it by simply returning control to readData() which
-				// will return immediately (and safely) control to Qt
-				KviMemory::free(cMessageBuffer);
-				return;
-			}
-
 			while(*p && ((*p == '\r') || (*p == '\n')))
 				p++;
 			cBeginOfCurData = p;
@@ -297,7 +277,49 @@ void KviIrcLink::processData(char * buffer, int iLen)
 			KviMemory::move(m_pReadBuffer, cBeginOfCurData, m_uReadBufferLen);
 		}
 	}
-	KviMemory::free(cMessageBuffer);
+}
+
+bool KviIrcLink::processPendingLines()
+{
+	QElapsedTimer tSlice;
+	tSlice.start();
+
+	while(!m_lPendingLines.empty())
+	{
+		QByteArray szLine = m_lPendingLines.front();
+		m_lPendingLines.pop_front();
+
+		// FIXME: actually it can happen that the socket gets disconnected
+		// in an incomingMessage() call.
+		// The problem might be that some other parts of KVIrc assume
+		// that the IRC context still exists after a failed write to the socket
+		// (some parts don't even check the return value!)
+		// If the problem presents itself again then the solution is:
+		//   disable queue flushing for the "incomingMessage" call
+		//   and just call queue_insertMessage()
+		//   then after the call terminates flush the queue (eventually detecting
+		//   the disconnect and thus destroying the IRC context).
+		// For now we try to rely on the remaining parts to handle correctly
+		// such conditions. Let's see...
+		m_pConnection->incomingMessage(szLine.constData());
+
+		if(!m_pSocket || (m_pSocket->state() != KviIrcSocket::Connected))
+		{
+			// Disconnected in KviConsoleWindow::incomingMessage() call.
+			// This may happen for several reasons (local event loop
+			// with the user hitting the disconnect button, a scripting
+			// handler event that disconnects explicitly)
+			//
+			// The rest of the data is meaningless now
+			m_lPendingLines.clear();
+			return true;
+		}
+
+		if(tSlice.elapsed() >= KVI_IRCLINK_PROCESSING_SLICE)
+			break;
+	}
+
+	return m_lPendingLines.empty();
 }
 
 //
@@ -345,9 +367,22 @@ bool KviIrcLink::sendPacket(KviDataBuffer * pData)
 
 void KviIrcLink::socketStateChange()
 {
+	// the socket might have connected to another address of the server
+	if((!m_pTarget->proxy()) && (!m_pSocket->remoteAddress().isEmpty()))
+		m_pTarget->server()->setIp(m_pSocket->remoteAddress());
+
 	switch(m_pSocket->state())
 	{
 		case KviIrcSocket::Connected:
+			if(!m_pConnection->statistics()->phaseTime(KviIrcConnectionStatistics::LinkUp))
+				m_pConnection->statistics()->markPhase(KviIrcConnectionStatistics::LinkUp);
+#ifdef COMPILE_SSL_SUPPORT
+			if(m_pSocket->usingSSL())
+			{
+				m_pConnection->statistics()->markPhase(KviIrcConnectionStatistics::Secured);
+				m_pConnection->statistics()->setSSLSessionResumed(m_pSocket->getSSL()->sessionReused());
+			}
+#endif
 			m_eState = Connected;
 			m_pConnection->linkEstablished();
 			break;
@@ -377,6 +412,8 @@ void KviIrcLink::socketStateChange()
 			    connection()->target()->proxy() ? connection()->target()->proxy()->port() : connection()->target()->server()->port());
 			break;
 		case KviIrcSocket::SSLHandshake:
+			if(!m_pConnection->statistics()->phaseTime(KviIrcConnectionStatistics::LinkUp))
+				m_pConnection->statistics()->markPhase(KviIrcConnectionStatistics::LinkUp);
 			m_pConsole->output(KVI_OUT_CONNECTION, __tr2qs("Low-level transport connection established [%s (%s:%u)]"),
 			    connection()->target()->proxy() ? connection()->target()->proxy()->hostname().toUtf8().data() : connection()->target()->server()->hostName().toUtf8().data(),
 			    connection()->target()->proxy() ? connection()->target()->proxy()->ip().toUtf8().data() : connection()->target()->server()->ip().toUtf8().data(),
@@ -384,6 +421,7 @@ void KviIrcLink::socketStateChange()
 			m_pConsole->outputNoFmt(KVI_OUT_CONNECTION, __tr2qs("Starting Secure Socket Layer handshake"));
 			break;
 		case KviIrcSocket::ProxyLogin:
+			m_pConnection->statistics()->markPhase(KviIrcConnectionStatistics::LinkUp);
 			m_pConsole->output(KVI_OUT_CONNECTION, __tr2qs("%Q established [%s (%s:%u)]"),
 			    connection()->link()->socket()->usingSSL() ? &(__tr2qs("Secure proxy connection")) : &(__tr2qs("Proxy connection")),
 			    connection()->target()->proxy()->hostname().toUtf8().data(),
@@ -34,6 +34,9 @@
 #include "KviQString.h"
 
 #include <QObject>
+#include <QByteArray>
+
+#include <deque>
 
 class KviConsoleWindow;
 class KviIrcServer;
@@ -100,6 +103,7 @@ private:
 	char * m_pReadBuffer = nullptr;    // incoming data buffer
 	unsigned int m_uReadBufferLen = 0; // incoming data buffer length
 	unsigned int m_uReadPackets = 0;   // total packets read per session
+	std::deque<QByteArray> m_lPendingLines; // complete lines waiting to be processed
 
 	KviIrcConnectionTargetResolver * m_pResolver = nullptr; // owned
 public:
@@ -183,12 +187,22 @@ protected:
 	* This is called by KviIrcSocket.
 	* The buffer is iLength+1 bytes long and contains a null terminator
 	* It's an interface for KviIrcSocket (lower protocol in stack)
+	* The complete lines are queued: KviIrcSocket then calls processPendingLines()
 	* \param buffer The buffer :)
 	* \param iLength The length of the buffer
 	* \return void
 	*/
 	void processData(char * buffer, int iLength);
 
+	/**
+	* \brief Passes the queued lines to the connection, in order
+	*
+	* Stops when a time slice is exhausted so that a big burst of
+	* data from a busy server can't freeze the user interface.
+	* \return True if the queue is empty, false if there are lines left
+	*/
+	bool processPendingLines();
+
 	/**
 	* \brief Called at each state change
 	* \return void
@@ -45,6 +45,8 @@
 
 #include <QTimer>
 #include <QSocketNotifier>
+
+#include <algorithm>
 #include <memory>
 
 #if !defined(COMPILE_ON_WINDOWS) && !defined(COMPILE_ON_MINGW)
@@ -55,6 +57,12 @@
 
 // FIXME: #warning "Lag-o-meter"
 
+// the maximum amount of data read from the socket at once
+#define KVI_IRCSOCKET_READ_BUFFER_SIZE 16384
+
+// the delay between the parallel connection attempts (the RFC 8305 recommended value)
+#define KVI_IRCSOCKET_CONNECT_ATTEMPT_DELAY 250
+
 unsigned int g_uNextIrcLinkId = 1;
 
 KviIrcSocket::KviIrcSocket(KviIrcLink * pLink)
@@ -73,6 +81,11 @@ KviIrcSocket::KviIrcSocket(KviIrcLink * pLink)
 
 	m_pFlushTimer = std::make_unique<QTimer>(); // queue flush timer
 	connect(m_pFlushTimer.get(), SIGNAL(timeout()), this, SLOT(flushSendQueue()));
+
+	m_pProcessTimer = std::make_unique<QTimer>();
+	m_pProcessTimer->setSingleShot(true);
+	m_pProcessTimer->setInterval(0);
+	connect(m_pProcessTimer.get(), SIGNAL(timeout()), this, SLOT(processIncomingLines()));
 }
 
 KviIrcSocket::~KviIrcSocket()
@@ -119,6 +132,17 @@ void KviIrcSocket::reset()
 		m_sock = KVI_INVALID_SOCKET;
 	}
 
+	closeConnectAttempts();
+
+	if(m_pConnectAttemptTimer)
+	{
+		delete m_pConnectAttemptTimer;
+		m_pConnectAttemptTimer = nullptr;
+	}
+
+	m_szRemoteAddress = QString();
+	m_bIPv6 = false;
+
 	if(m_pTimeoutTimer)
 	{
 		m_pTimeoutTimer->stop();
@@ -139,6 +163,9 @@ void KviIrcSocket::reset()
 	if(m_pFlushTimer->isActive())
 		m_pFlushTimer->stop();
 
+	if(m_pProcessTimer->isActive())
+		m_pProcessTimer->stop();
+
 	queue_removeAllMessages();
 
 	setState(Idle);
@@ -231,7 +258,7 @@ void KviIrcSocket::raiseError(KviError::Code eError)
 		outputSocketError(KviError::getDescription(eError));
 }
 
-KviError::Code KviIrcSocket::startConnection(KviIrcServer * pServer, KviProxy * pProxy, const char * pcBindAddress)
+KviError::Code KviIrcSocket::startConnection(KviIrcServer * pServer, KviProxy * pProxy, const char * pcBindAddress, const std::vector<QString> & vAddresses)
 {
 	// Attempts to establish an IRC connection
 	// to the server specified by *srv.
@@ -287,6 +314,30 @@ KviError::Code KviIrcSocket::startConnection(KviIrcServer * pServer, KviProxy *
 		}
 	}
 
+	if(pProxy)
+	{
+		m_vPendingAddresses.emplace_back(m_pProxy->ip(), bTargetIPv6);
+	}
+	else if(!vAddresses.empty())
+	{
+		// each address has its own family here
+		for(auto & szAddress : vAddresses)
+		{
+#ifdef COMPILE_IPV6_SUPPORT
+			if(KviNetUtils::isValidStringIPv6(szAddress))
+			{
+				m_vPendingAddresses.emplace_back(szAddress, true);
+				continue;
+			}
+#endif
+			if(KviNetUtils::isValidStringIp(szAddress))
+				m_vPendingAddresses.emplace_back(szAddress, false);
+		}
+		if(m_vPendingAddresses.empty())
+			return KviError::InvalidIpAddress;
+		bNeedServerIp = false;
+	}
+
 	if(bNeedServerIp)
 	{
 // check the IRC host IP
@@ -308,57 +359,123 @@ KviError::Code KviIrcSocket::startConnection(KviIrcServer * pServer, KviProxy *
 #ifdef COMPILE_IPV6_SUPPORT
 		}
 #endif
+		if(!m_pProxy)
+			m_vPendingAddresses.emplace_back(m_pIrcServer->ip(), bTargetIPv6);
+	}
+
+	m_szBindAddress = pcBindAddress ? QString::fromUtf8(pcBindAddress) : QString();
+	m_uConnectPort = pProxy ? m_pProxy->port() : m_pIrcServer->port();
+
+	m_pConnectAttemptTimer = new QTimer();
+	QObject::connect(m_pConnectAttemptTimer, SIGNAL(timeout()), this, SLOT(connectAttemptTimerFired()));
+	m_pConnectAttemptTimer->setSingleShot(true);
+	m_pConnectAttemptTimer->setInterval(KVI_IRCSOCKET_CONNECT_ATTEMPT_DELAY);
+
+	KviError::Code eError = startNextConnectAttempt();
+	if(eError != KviError::Success)
+	{
+		reset();
+		return eError;
 	}
 
-	KviSockaddr sa(pProxy ? m_pProxy->ip().toUtf8().data() : m_pIrcServer->ip().toUtf8().data(), pProxy ? m_pProxy->port() : m_pIrcServer->port(), bTargetIPv6);
+	// set the timer
+	if(KVI_OPTION_UINT(KviOption_uintIrcSocketTimeout) < 5)
+		KVI_OPTION_UINT(KviOption_uintIrcSocketTimeout) = 5;
+
+	m_pTimeoutTimer = new QTimer();
+	QObject::connect(m_pTimeoutTimer, SIGNAL(timeout()), this, SLOT(connectionTimedOut()));
+	m_pTimeoutTimer->setSingleShot(true);
+	m_pTimeoutTimer->setInterval(KVI_OPTION_UINT(KviOption_uintIrcSocketTimeout) * 1000);
+	m_pTimeoutTimer->start();
+
+	// and wait for connect
+	setState(Connecting);
+
+	return KviError::Success;
+}
+
+KviError::Code KviIrcSocket::startNextConnectAttempt()
+{
+	KviError::Code eError = KviError::InvalidIpAddress;
+
+	while(!m_vPendingAddresses.empty())
+	{
+		std::pair<QString, bool> address = m_vPendingAddresses.front();
+		m_vPendingAddresses.erase(m_vPendingAddresses.begin());
+
+		eError = startConnectAttempt(address.first, address.second);
+		if(eError == KviError::Success)
+		{
+			if(m_state == Connecting)
+				outputSocketMessage(QString(__tr2qs("Trying also %1")).arg(address.first));
+			if(!m_vPendingAddresses.empty())
+				m_pConnectAttemptTimer->start();
+			return eError;
+		}
+
+		if(!m_vPendingAddresses.empty() || !m_vConnectAttempts.empty())
+			outputSocketWarning(QString(__tr2qs("Can't connect to %1: %2")).arg(address.first, KviError::getDescription(eError)));
+	}
+
+	return eError;
+}
+
+KviError::Code KviIrcSocket::startConnectAttempt(const QString & szAddress, bool bIPv6)
+{
+	KviSockaddr sa(szAddress.toUtf8().data(), m_uConnectPort, bIPv6);
 
 	if(!sa.socketAddress())
 		return KviError::InvalidIpAddress;
 
 // create the socket
 #ifdef COMPILE_IPV6_SUPPORT
-	m_sock = kvi_socket_create(bTargetIPv6 ? KVI_SOCKET_PF_INET6 : KVI_SOCKET_PF_INET, KVI_SOCKET_TYPE_STREAM, KVI_SOCKET_PROTO_TCP);
+	kvi_socket_t sock = kvi_socket_create(bIPv6 ? KVI_SOCKET_PF_INET6 : KVI_SOCKET_PF_INET, KVI_SOCKET_TYPE_STREAM, KVI_SOCKET_PROTO_TCP);
 #else
-	m_sock = kvi_socket_create(KVI_SOCKET_PF_INET, KVI_SOCKET_TYPE_STREAM, KVI_SOCKET_PROTO_TCP);
+	kvi_socket_t sock = kvi_socket_create(KVI_SOCKET_PF_INET, KVI_SOCKET_TYPE_STREAM, KVI_SOCKET_PROTO_TCP);
 #endif
 
-	if(m_sock < 0)
+	if(sock < 0)
 		return KviError::SocketCreationFailed;
 
-	if(pcBindAddress)
+	// the bind address has the family of the server: the attempts to the other family go unbound
+	bool bBindFamily = !bIPv6;
+#ifdef COMPILE_IPV6_SUPPORT
+	bBindFamily = (KviNetUtils::isValidStringIPv6(m_szBindAddress) == bIPv6);
+#endif
+	if(!m_szBindAddress.isEmpty() && bBindFamily)
 	{
 		// we have to bind the socket to a local address
-		KviSockaddr localSa(pcBindAddress, 0, bTargetIPv6);
+		KviSockaddr localSa(m_szBindAddress.toUtf8().data(), 0, bIPv6);
 		bool bBindOk = localSa.socketAddress();
 
 		if(bBindOk)
 		{
-			bBindOk = kvi_socket_bind(m_sock, localSa.socketAddress(), ((int)(localSa.addressLength())));
+			bBindOk = kvi_socket_bind(sock, localSa.socketAddress(), ((int)(localSa.addressLength())));
 		}
 
 		QString szTmp;
 		if(bBindOk)
 		{
 			if(_OUTPUT_VERBOSE)
-				szTmp = QString(__tr2qs("Binding to local address %1")).arg(pcBindAddress);
+				szTmp = QString(__tr2qs("Binding to local address %1")).arg(m_szBindAddress);
 			outputSocketMessage(szTmp);
 		}
 		else
 		{
 			if(_OUTPUT_VERBOSE)
-				szTmp = QString(__tr2qs("Binding to local address %1 failed: the kernel will choose the correct interface")).arg(pcBindAddress);
+				szTmp = QString(__tr2qs("Binding to local address %1 failed: the kernel will choose the correct interface")).arg(m_szBindAddress);
 			outputSocketWarning(szTmp);
 		}
 	}
 
 	// make it non blocking
-	if(!kvi_socket_setNonBlocking(m_sock))
+	if(!kvi_socket_setNonBlocking(sock))
 	{
-		reset();
+		kvi_socket_destroy(sock);
 		return KviError::AsyncSocketFailed;
 	}
 
-	if(!kvi_socket_connect(m_sock, sa.socketAddress(), ((int)(sa.addressLength()))))
+	if(!kvi_socket_connect(sock, sa.socketAddress(), ((int)(sa.addressLength()))))
 	{
 		// Oops!
 		int iErr = kvi_socket_error();
@@ -371,11 +488,11 @@ KviError::Code KviIrcSocket::startConnection(KviIrcServer * pServer, KviProxy *
 			{
 				// Zero error ?...let's look closer
 				int iSize = sizeof(int);
-				if(!kvi_socket_getsockopt(m_sock, SOL_SOCKET, SO_ERROR, (void *)&iSockError, &iSize))
+				if(!kvi_socket_getsockopt(sock, SOL_SOCKET, SO_ERROR, (void *)&iSockError, &iSize))
 					iSockError = 0;
 			}
 			// die :(
-			reset();
+			kvi_socket_destroy(sock);
 			// And declare problems :)
 			if(iSockError)
 				return KviError::translateSystemError(iSockError);
@@ -385,24 +502,40 @@ KviError::Code KviIrcSocket::startConnection(KviIrcServer * pServer, KviProxy *
 	}
 
 	// and setup the WRITE notifier...
-	m_pWsn = new QSocketNotifier((int)m_sock, QSocketNotifier::Write);
-	QObject::connect(m_pWsn, SIGNAL(activated(int)), this, SLOT(writeNotifierFired(int)));
-	m_pWsn->setEnabled(true);
-
-	// set the timer
-	if(KVI_OPTION_UINT(KviOption_uintIrcSocketTimeout) < 5)
-		KVI_OPTION_UINT(KviOption_uintIrcSocketTimeout) = 5;
+	KviIrcSocketConnectAttempt attempt;
+	attempt.sock = sock;
+	attempt.pNotifier = new QSocketNotifier((int)sock, QSocketNotifier::Write);
+	attempt.szAddress = szAddress;
+	attempt.bIPv6 = bIPv6;
+	QObject::connect(attempt.pNotifier, SIGNAL(activated(int)), this, SLOT(writeNotifierFired(int)));
+	attempt.pNotifier->setEnabled(true);
+
+	m_vConnectAttempts.push_back(attempt);
+	return KviError::Success;
+}
 
-	m_pTimeoutTimer = new QTimer();
-	QObject::connect(m_pTimeoutTimer, SIGNAL(timeout()), this, SLOT(connectionTimedOut()));
-	m_pTimeoutTimer->setSingleShot(true);
-	m_pTimeoutTimer->setInterval(KVI_OPTION_UINT(KviOption_uintIrcSocketTimeout) * 1000);
-	m_pTimeoutTimer->start();
+void KviIrcSocket::closeConnectAttempts()
+{
+	for(auto & attempt : m_vConnectAttempts)
+	{
+		delete attempt.pNotifier;
+		kvi_socket_destroy(attempt.sock);
+	}
+	m_vConnectAttempts.clear();
+	m_vPendingAddresses.clear();
 
-	// and wait for connect
-	setState(Connecting);
+	if(m_pConnectAttemptTimer)
+		m_pConnectAttemptTimer->stop();
+}
 
-	return KviError::Success;
+void KviIrcSocket::connectAttemptTimerFired()
+{
+	KviError::Code eError = startNextConnectAttempt();
+	if((eError != KviError::Success) && m_vConnectAttempts.empty())
+	{
+		raiseError(eError);
+		reset();
+	}
 }
 
 void KviIrcSocket::connectionTimedOut()
@@ -412,19 +545,23 @@ void KviIrcSocket::connectionTimedOut()
 	reset();
 }
 
-void KviIrcSocket::writeNotifierFired(int)
+void KviIrcSocket::writeNotifierFired(int iSock)
 {
-	// kill the timeout timer
-	if(m_pTimeoutTimer)
-	{
-		delete m_pTimeoutTimer;
-		m_pTimeoutTimer = nullptr;
-	}
+	auto it = std::find_if(m_vConnectAttempts.begin(), m_vConnectAttempts.end(),
+	    [iSock](const KviIrcSocketConnectAttempt & a) { return (int)a.sock == iSock; });
+	if(it == m_vConnectAttempts.end())
+		return; // already closed
+
+	KviIrcSocketConnectAttempt attempt = *it;
+	m_vConnectAttempts.erase(it);
+
+	// kill the write notifier
+	delete attempt.pNotifier;
 
 	// Check for errors...
 	int iSockError;
 	int iSize = sizeof(int);
-	if(!kvi_socket_getsockopt(m_sock, SOL_SOCKET, SO_ERROR, (void *)&iSockError, &iSize))
+	if(!kvi_socket_getsockopt(attempt.sock, SOL_SOCKET, SO_ERROR, (void *)&iSockError, &iSize))
 		iSockError = -1;
 
 	//sockError = 0;
@@ -437,14 +574,39 @@ void KviIrcSocket::writeNotifierFired(int)
 		else
 			eError = KviError::UnknownError; //Error 0 ?
 
+		kvi_socket_destroy(attempt.sock);
+
+		if(!m_vConnectAttempts.empty() || !m_vPendingAddresses.empty())
+		{
+			// the others may still succeed
+			outputSocketWarning(QString(__tr2qs("Can't connect to %1: %2")).arg(attempt.szAddress, KviError::getDescription(eError)));
+			if(!m_vPendingAddresses.empty())
+			{
+				// don't wait for the attempt delay
+				m_pConnectAttemptTimer->stop();
+				connectAttemptTimerFired();
+			}
+			return;
+		}
+
 		raiseError(eError);
 		reset();
 		return;
 	}
 
-	// kill the write notifier
-	delete m_pWsn;
-	m_pWsn = nullptr;
+	// kill the timeout timer
+	if(m_pTimeoutTimer)
+	{
+		delete m_pTimeoutTimer;
+		m_pTimeoutTimer = nullptr;
+	}
+
+	// drop the slower attempts
+	closeConnectAttempts();
+
+	m_sock = attempt.sock;
+	m_szRemoteAddress = attempt.szAddress;
+	m_bIPv6 = attempt.bIPv6;
 
 	//Successfully connected...
 	connectionEstablished();
@@ -536,6 +698,8 @@ void KviIrcSocket::enterSSLMode()
 		reset();
 		return;
 	}
+	// reconnects to the same server skip the full handshake when the server allows it
+	m_pSSL->setSessionKey(QString("%1:%2").arg(m_pIrcServer->hostName()).arg(m_pIrcServer->port()));
 	setState(SSLHandshake);
 	doSSLHandshake(0);
 }
@@ -1363,6 +1527,8 @@ void KviIrcSocket::doSSLHandshake(int)
 	{
 		case KviSSL::Success:
 			// done!
+			if(m_pSSL->sessionReused() && !_OUTPUT_QUIET)
+				outputSSLMessage(__tr2qs("Resumed the previous session with the server"));
 			printSSLCipherInfo();
 			printSSLPeerCertificate();
 			linkUp();
@@ -1451,12 +1617,12 @@ void KviIrcSocket::linkUp()
 void KviIrcSocket::readData(int)
 {
 	//read data
-	char cBuffer[1025];
+	char cBuffer[KVI_IRCSOCKET_READ_BUFFER_SIZE + 1];
 	int iReadLength;
 #ifdef COMPILE_SSL_SUPPORT
 	if(m_pSSL)
 	{
-		iReadLength = m_pSSL->read(cBuffer, 1024);
+		iReadLength = m_pSSL->read(cBuffer, KVI_IRCSOCKET_READ_BUFFER_SIZE);
 		if(iReadLength <= 0)
 		{
 			// ssl error....?
@@ -1501,7 +1667,7 @@ void KviIrcSocket::readData(int)
 	else
 	{
 #endif
-		iReadLength = kvi_socket_recv(m_sock, cBuffer, 1024);
+		iReadLength = kvi_socket_recv(m_sock, cBuffer, KVI_IRCSOCKET_READ_BUFFER_SIZE);
 		if(iReadLength <= 0)
 		{
 			handleInvalidSocketRead(iReadLength);
@@ -1519,22 +1685,43 @@ void KviIrcSocket::readData(int)
 	// Shut up the socket notifier
 	// in case that we enter in a local loop somewhere
 	// while processing data...
+	// It stays disabled until all the lines of this chunk have been processed.
 	m_pRsn->setEnabled(false);
+
+	// split the lines (a link filter processes the data immediately instead)
+	m_pLink->processData(cBuffer, iReadLength);
+
+	processIncomingLines();
+}
+
+void KviIrcSocket::processIncomingLines()
+{
+	if(m_state != Connected)
+		return; // reset() in the meantime
+
 	// shut also the flushing of the message queue
 	// in this way we prevent disconnect detection
 	// during the processing of a message effectively
 	// making it always an asynchronous event.
 	m_bInProcessData = true;
 
-	m_pLink->processData(cBuffer, iReadLength);
+	bool bDone = m_pLink->processPendingLines();
 	// after this line there should be nothing that relies
 	// on the "connected" state of this socket.
-	// It may happen that it has been reset() in the middle of the processData() call
-	// and (unverified) it might have been even deleted.
+	// It may happen that it has been reset() in the middle of the processPendingLines() call.
+	// The socket itself is destroyed with deleteLater() so it's still there.
 
-	// re-enable the socket notifier... (if it's still there)
-	if(m_pRsn)
-		m_pRsn->setEnabled(true);
+	if(bDone)
+	{
+		// re-enable the socket notifier... (if it's still there)
+		if(m_pRsn)
+			m_pRsn->setEnabled(true);
+	}
+	else
+	{
+		// out of time: let the GUI process its events and continue later
+		m_pProcessTimer->start();
+	}
 	// and the message queue flushing
 	m_bInProcessData = false;
 	// and flush the queue too!
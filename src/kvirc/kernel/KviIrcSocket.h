@@ -39,8 +39,11 @@
 #include "KviTimeUtils.h"
 
 #include <QObject>
+#include <QString>
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 class KviConsoleWindow;
 class KviDataBuffer;
@@ -64,6 +67,18 @@ struct KviIrcSocketMsgEntry
 	KviIrcSocketMsgEntry * next_ptr;
 };
 
+/**
+* \struct KviIrcSocketConnectAttempt
+* \brief A connect() in progress to one of the addresses of the target
+*/
+struct KviIrcSocketConnectAttempt
+{
+	kvi_socket_t sock;
+	QSocketNotifier * pNotifier; // write notifier
+	QString szAddress;
+	bool bIPv6;
+};
+
 /**
 * \class KviIrcSocket
 * \brief This class is the lowest level of the KVIrc networking stack
@@ -124,8 +139,17 @@ protected:
 	KviIrcSocketMsgEntry * m_pSendQueueHead = nullptr; // data queue
 	KviIrcSocketMsgEntry * m_pSendQueueTail = nullptr;
 	std::unique_ptr<QTimer> m_pFlushTimer;
+	std::unique_ptr<QTimer> m_pProcessTimer; // resumes the processing of the incoming lines
 	struct timeval m_tAntiFloodLastMessageTime;
 	bool m_bInProcessData = false;
+	// the addresses are tried in parallel with staggered starts (RFC 8305): the first one that connects wins
+	std::vector<std::pair<QString, bool>> m_vPendingAddresses; // address and IPv6 flag, not tried yet
+	std::vector<KviIrcSocketConnectAttempt> m_vConnectAttempts; // in progress
+	QTimer * m_pConnectAttemptTimer = nullptr;                  // starts the next attempt
+	QString m_szBindAddress;                                    // the local address for the attempts
+	kvi_u32_t m_uConnectPort = 0;
+	QString m_szRemoteAddress; // the address that m_sock is connected to
+	bool m_bIPv6 = false;      // the family of m_sock
 #ifdef COMPILE_SSL_SUPPORT
 	KviSSL * m_pSSL = nullptr;
 #endif
@@ -205,14 +229,34 @@ public:
 	*/
 	bool isConnected() const { return m_state == Connected; }
 
+	/**
+	* \brief Returns the address the socket has connected to
+	*
+	* This is the proxy address for the proxied connections.
+	* \return const QString &
+	*/
+	const QString & remoteAddress() const { return m_szRemoteAddress; }
+
+	/**
+	* \brief Returns true if the socket is an IPv6 one
+	* \return bool
+	*/
+	bool usingIPv6() const { return m_bIPv6; }
+
 	/**
 	* \brief Starts the connection
+	*
+	* If vAddresses is not empty and there is no proxy then the server is
+	* contacted at all these addresses, starting a new attempt every 250 ms
+	* or as soon as one fails, and the first connection that succeeds is used.
+	* Otherwise the server ip() is used.
 	* \param pServer The server where to connect to
 	* \param pProxy The proxy to use during connection
 	* \param pcBindAddress The address to bind the connection to
+	* \param vAddresses The addresses of the server in order of preference
 	* \return int
 	*/
-	KviError::Code startConnection(KviIrcServer * pServer, KviProxy * pProxy = nullptr, const char * pcBindAddress = nullptr);
+	KviError::Code startConnection(KviIrcServer * pServer, KviProxy * pProxy = nullptr, const char * pcBindAddress = nullptr, const std::vector<QString> & vAddresses = {});
 
 #ifdef COMPILE_SSL_SUPPORT
 	/**
@@ -404,6 +448,26 @@ protected:
 	*/
 	virtual void reset();
 
+	/**
+	* \brief Starts the connection attempt to the next address that doesn't fail immediately
+	* \return KviError::Code the error of the last address tried if none could be started
+	*/
+	KviError::Code startNextConnectAttempt();
+
+	/**
+	* \brief Creates a socket and starts the non blocking connect() to the address
+	* \param szAddress The address
+	* \param bIPv6 Whether the address is an IPv6 one
+	* \return KviError::Code
+	*/
+	KviError::Code startConnectAttempt(const QString & szAddress, bool bIPv6);
+
+	/**
+	* \brief Closes all the connection attempts in progress and forgets the pending ones
+	* \return void
+	*/
+	void closeConnectAttempts();
+
 	/**
 	* \brief Removes the message entry
 	* \param e The entry
@@ -502,7 +566,13 @@ protected slots:
 	void connectionTimedOut();
 
 	/**
-	* \brief Called when the write notifier is enabled
+	* \brief Called when it's time to start the next connection attempt
+	* \return void
+	*/
+	void connectAttemptTimerFired();
+
+	/**
+	* \brief Called when one of the connection attempts completes
 	* \return void
 	*/
 	void writeNotifierFired(int);
@@ -513,6 +583,16 @@ protected slots:
 	*/
 	void readData(int);
 
+	/**
+	* \brief Processes a slice of the incoming lines queued in the link
+	*
+	* The socket is not read again until all the queued lines have
+	* been processed: this keeps their order and lets the GUI breathe
+	* between the slices when a lot of data arrives at once.
+	* \return void
+	*/
+	void processIncomingLines();
+
 	/**
 	* \brief Called when the proxy read notifier is enabled
 	* \return void
@@ -333,7 +333,11 @@ KviBoolOption g_boolOptionsTable[KVI_NUM_BOOL_OPTIONS] = {
 	BOOL_OPTION("MenuBarVisible", true, KviOption_sectFlagFrame | KviOption_resetUpdateGui),
 	BOOL_OPTION("WarnAboutHidingMenuBar", true, KviOption_sectFlagFrame),
 	BOOL_OPTION("WhoRepliesToActiveWindow", false, KviOption_sectFlagConnection),
-	BOOL_OPTION("DropConnectionOnSaslFailure", false, KviOption_sectFlagConnection)
+	BOOL_OPTION("DropConnectionOnSaslFailure", false, KviOption_sectFlagConnection),
+	BOOL_OPTION("RotateLogsDaily", true, KviOption_sectFlagLogging),
+	BOOL_OPTION("ConnectToFastestServerAddress", true, KviOption_sectFlagConnection),
+	BOOL_OPTION("KeepScrollbackSnapshots", false, KviOption_sectFlagIrcView),
+	BOOL_OPTION("PreloadFrequentModules", true, KviOption_sectFlagModules)
 };
 
 // NOTICE: REUSE EQUIVALENT UNUSED KviOption_bool in KviOptions.h ENTRIES BEFORE ADDING NEW ENTRIES ABOVE
@@ -637,7 +641,13 @@ KviUIntOption g_uintOptionsTable[KVI_NUM_UINT_OPTIONS] = {
 	UINT_OPTION("ToolBarButtonStyle", 0, KviOption_groupTheme), // 0 = Qt::ToolButtonIconOnly
 	UINT_OPTION("MaximumBlowFishKeySize", 56, KviOption_sectFlagNone),
 	UINT_OPTION("CustomCursorWidth", 1, KviOption_resetUpdateGui),
-	UINT_OPTION("UserListMinimumWidth", 100, KviOption_sectFlagUserListView | KviOption_resetUpdateGui | KviOption_groupTheme)
+	UINT_OPTION("UserListMinimumWidth", 100, KviOption_sectFlagUserListView | KviOption_resetUpdateGui | KviOption_groupTheme),
+	UINT_OPTION("LogWriteLatency", 1000, KviOption_sectFlagLogging), // msecs, 0 = write each line immediately
+	UINT_OPTION("LogRotationSize", 100, KviOption_sectFlagLogging),  // MiB, 0 = never
+	UINT_OPTION("DnsCacheTimeout", 300, KviOption_sectFlagConnection), // secs, 0 = disabled
+	UINT_OPTION("JoinBurstInterval", 500, KviOption_sectFlagConnection), // msecs, 0 = no staggering
+	UINT_OPTION("ScrollbackSnapshotLines", 500, KviOption_sectFlagIrcView),
+	UINT_OPTION("ScrollbackSnapshotInterval", 300, KviOption_sectFlagIrcView) // secs, 0 = only when closing
 };
 
 #define FONT_OPTION(_name, _face, _size, _flags) \
@@ -355,10 +355,14 @@ DECLARE_OPTION_STRUCT(KviStringListOption, QStringList)
 #define KviOption_boolWarnAboutHidingMenuBar 262
 #define KviOption_boolWhoRepliesToActiveWindow 263                             /* irc::output */
 #define KviOption_boolDropConnectionOnSaslFailure 264                          /* connection::advanced */
+#define KviOption_boolRotateLogsDaily 265                                      /* ircengine::logging */
+#define KviOption_boolConnectToFastestServerAddress 266                        /* connection::transport */
+#define KviOption_boolKeepScrollbackSnapshots 267                              /* interface::features::components::ircview */
+#define KviOption_boolPreloadFrequentModules 268                               /* uparser */
 
 // NOTICE: REUSE EQUIVALENT UNUSED BOOL_OPTION in KviOptions.cpp ENTRIES BEFORE ADDING NEW ENTRIES ABOVE
 
-#define KVI_NUM_BOOL_OPTIONS 265
+#define KVI_NUM_BOOL_OPTIONS 269
 
 #define KVI_STRING_OPTIONS_PREFIX "string"
 #define KVI_STRING_OPTIONS_PREFIX_LEN 6
@@ -597,8 +601,14 @@ DECLARE_OPTION_STRUCT(KviStringListOption, QStringList)
 #define KviOption_uintMaximumBlowFishKeySize 80
 #define KviOption_uintCustomCursorWidth 81                                    /* Interface */
 #define KviOption_uintUserListMinimumWidth 82
-
-#define KVI_NUM_UINT_OPTIONS 83
+#define KviOption_uintLogWriteLatency 83                                      /* ircengine::logging */
+#define KviOption_uintLogRotationSize 84                                      /* ircengine::logging */
+#define KviOption_uintDnsCacheTimeout 85                                      /* connection::transport */
+#define KviOption_uintJoinBurstInterval 86                                    /* connection::transport */
+#define KviOption_uintScrollbackSnapshotLines 87                              /* interface::features::components::ircview */
+#define KviOption_uintScrollbackSnapshotInterval 88                           /* interface::features::components::ircview */
+
+#define KVI_NUM_UINT_OPTIONS 89
 
 namespace KviIdentdOutputMode
 {
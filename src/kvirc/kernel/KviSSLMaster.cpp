@@ -112,14 +112,10 @@ namespace KviSSLMaster
 			wnd->outputNoFmt(KVI_OUT_SSL, __tr2qs("[SSL]: Can't find out the current cipher info"));
 	}
 
-	KVIRC_API KviSSL * allocSSL(KviWindow * wnd, kvi_socket_t sock, KviSSL::Method m, const char * contextString)
+	// loads the certificate and the private key: returns false if something failed
+	static bool setupContext(KviSSL * s, KviWindow * wnd, const char * contextString)
 	{
-		KviSSL * s = new KviSSL();
-		if(!s->initContext(m))
-		{
-			delete s;
-			return nullptr;
-		}
+		bool bOk = true;
 
 		if(!contextString)
 			contextString = KviCString::emptyString().ptr();
@@ -135,11 +131,13 @@ namespace KviSSLMaster
 						wnd->output(KVI_OUT_SSL, __tr2qs("[%s]: [SSL]: Using certificate file %s"), contextString, KVI_OPTION_STRING(KviOption_stringSSLCertificatePath).toUtf8().data());
 					break;
 				case KviSSL::FileIoError:
+					bOk = false;
 					if(wnd)
 						wnd->output(KVI_OUT_SSL, __tr2qs("[%s]: [SSL ERROR]: File I/O error while trying to use the certificate file %s"), contextString, KVI_OPTION_STRING(KviOption_stringSSLCertificatePath).toUtf8().data());
 					break;
 				default:
 				{
+					bOk = false;
 					KviCString buffer;
 					while(s->getLastErrorString(buffer))
 					{
@@ -161,11 +159,13 @@ namespace KviSSLMaster
 						wnd->output(KVI_OUT_SSL, __tr2qs("[%s]: [SSL]: Using private key file %s"), contextString, KVI_OPTION_STRING(KviOption_stringSSLPrivateKeyPath).toUtf8().data());
 					break;
 				case KviSSL::FileIoError:
+					bOk = false;
 					if(wnd)
 						wnd->output(KVI_OUT_SSL, __tr2qs("[%s]: [SSL ERROR]: File I/O error while trying to use the private key file %s"), contextString, KVI_OPTION_STRING(KviOption_stringSSLPrivateKeyPath).toUtf8().data());
 					break;
 				default:
 				{
+					bOk = false;
 					KviCString buffer;
 					while(s->getLastErrorString(buffer))
 					{
@@ -177,6 +177,31 @@ namespace KviSSLMaster
 			}
 		}
 
+		return bOk;
+	}
+
+	KVIRC_API KviSSL * allocSSL(KviWindow * wnd, kvi_socket_t sock, KviSSL::Method m, const char * contextString)
+	{
+		KviSSL * s = new KviSSL();
+
+		// setting up a context (and loading the certificates) is expensive:
+		// the sockets with the same configuration share one
+		QString szContextKey = QString("%1|%2|%3").arg(m == KviSSL::Client ? QString("client") : QString("server"),
+		    KVI_OPTION_BOOL(KviOption_boolUseSSLCertificate) ? KVI_OPTION_STRING(KviOption_stringSSLCertificatePath) : QString(),
+		    KVI_OPTION_BOOL(KviOption_boolUseSSLPrivateKey) ? KVI_OPTION_STRING(KviOption_stringSSLPrivateKeyPath) : QString());
+
+		if(!s->initSharedContext(szContextKey))
+		{
+			if(!s->initContext(m))
+			{
+				delete s;
+				return nullptr;
+			}
+
+			if(setupContext(s, wnd, contextString))
+				s->shareContext(szContextKey);
+		}
+
 		if(!s->initSocket(sock))
 		{
 			delete s;
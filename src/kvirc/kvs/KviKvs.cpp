@@ -31,12 +31,16 @@
 #include "KviKvsEventManager.h"
 #include "KviKvsScriptAddonManager.h"
 #include "KviKvsObjectController.h"
+#include "KviKvsProfiler.h"
+#include "KviKvsScriptCache.h"
 
 namespace KviKvs
 {
 	void init()
 	{
 		KviKvsKernel::init();
+		KviKvsProfiler::init();
+		KviKvsScriptCache::init();
 		KviKvsAliasManager::init();
 		KviKvsPopupManager::init();
 		KviKvsEventManager::init();
@@ -56,6 +60,8 @@ namespace KviKvs
 		KviKvsScriptAddonManager::done();
 		KviKvsTimerManager::done();
 		KviKvsDnsManager::done();
+		KviKvsScriptCache::done();
+		KviKvsProfiler::done();
 		KviKvsKernel::done();
 	}
 
@@ -23,6 +23,7 @@
 //=============================================================================
 
 #include "KviKvsAliasManager.h"
+#include "KviKvsScriptCache.h"
 #include "KviConfigurationFile.h"
 
 KviKvsAliasManager * KviKvsAliasManager::m_pAliasManager = nullptr;
@@ -60,6 +61,18 @@ void KviKvsAliasManager::done()
 	delete KviKvsAliasManager::instance();
 }
 
+bool KviKvsAliasManager::remove(const QString & szName)
+{
+	KviKvsScriptCache::instance()->clear();
+	return m_pAliasDict->remove(szName);
+}
+
+void KviKvsAliasManager::clear()
+{
+	KviKvsScriptCache::instance()->clear();
+	m_pAliasDict->clear();
+}
+
 bool KviKvsAliasManager::removeNamespace(const QString & szName)
 {
 	KviPointerHashTableIterator<QString, KviKvsScript> it(*m_pAliasDict);
@@ -75,8 +88,10 @@ bool KviKvsAliasManager::removeNamespace(const QString & szName)
 		return false;
 
 	for(auto & szKill : lKill)
-		remove(szKill);
+		m_pAliasDict->remove(szKill);
 
+	// the compiled scripts may still call the removed aliases
+	KviKvsScriptCache::instance()->clear();
 	return true;
 }
 
@@ -113,6 +128,7 @@ void KviKvsAliasManager::add(const QString & szName, KviKvsScript * pAlias)
 
 	// The bad news is that this problem may pop up also in other pieces of code...
 	m_pAliasDict->replace(szName, pAlias);
+	KviKvsScriptCache::instance()->clear();
 	emit aliasRefresh(szName);
 }
 
@@ -146,7 +162,7 @@ void KviKvsAliasManager::save(const QString & filename)
 
 void KviKvsAliasManager::load(const QString & filename)
 {
-	m_pAliasDict->clear();
+	clear();
 	KviConfigurationFile cfg(filename, KviConfigurationFile::Read);
 
 	KviConfigurationFileIterator it(*(cfg.dict()));
@@ -58,15 +58,9 @@ public:
 		return m_pAliasDict->find(szName);
 	};
 	void add(const QString & szName, KviKvsScript * pAlias);
-	bool remove(const QString & szName)
-	{
-		return m_pAliasDict->remove(szName);
-	};
+	bool remove(const QString & szName);
 	bool removeNamespace(const QString & szName);
-	void clear()
-	{
-		m_pAliasDict->clear();
-	};
+	void clear();
 
 	void save(const QString & filename);
 	void load(const QString & filename);
@@ -112,6 +112,7 @@ namespace KviKvsCoreSimpleCommands
 		_REGCMD("play", play)
 		_REGCMD("popup", popup)
 		_REGCMD("privmsg", privmsg)
+		_REGCMD("profile", profile)
 		_REGCMD("query", query)
 		_REGCMD("quit", quit)
 		_REGCMD("quote", raw)
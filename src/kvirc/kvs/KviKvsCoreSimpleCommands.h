@@ -109,6 +109,7 @@ namespace KviKvsCoreSimpleCommands
 	KVSCSC(play);
 	KVSCSC(popup);
 	KVSCSC(privmsg);
+	KVSCSC(profile);
 	KVSCSC(query);
 	KVSCSC(quit);
 	KVSCSC(raise);
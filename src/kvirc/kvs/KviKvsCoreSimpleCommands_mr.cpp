@@ -44,6 +44,8 @@
 #include "KviKvsVariantList.h"
 #include "KviKvsScript.h"
 #include "KviKvsPopupManager.h"
+#include "KviKvsProfiler.h"
+#include "KviKvsScriptCache.h"
 
 #include <QCursor>
 #include <QProcess>
@@ -1014,6 +1016,150 @@ namespace KviKvsCoreSimpleCommands
 		return true;
 	}
 
+	/*
+		@doc: profile
+		@type:
+			command
+		@title:
+			profile
+		@syntax:
+			profile [-n=<count:uint>] [-q] <operation:string> [<filename:string>]
+		@short:
+			Controls the script profiler
+		@switches:
+			!sw: -n=<count:uint> | --count=<count:uint>
+			Show at most <count> script contexts in the report (defaults to 20)
+			!sw: -q | --quiet
+			Do not print any output (except for the report)
+		@description:
+			Controls the built-in KVS profiler.[br]
+			While the profiler is running every script execution (aliases, event handlers,
+			timers, popups, actions...) is accounted to its script context name, like
+			"OnChannelMessage::myhandler". The profiler records the number of calls,
+			the inclusive and exclusive wall clock time and the number of
+			allocated variables for each context.[br]
+			The exclusive figures don't include the time spent in the nested script
+			contexts (for example aliases called by an event handler).[br]
+			<operation> can be one of:[br]
+			[b]start[/b]: starts (or resumes) collecting the statistics[br]
+			[b]stop[/b]: stops collecting the statistics; the collected data is kept[br]
+			[b]reset[/b]: discards the collected data[br]
+			[b]report[/b]: prints the script contexts sorted by exclusive time
+			followed by the hit and miss counters of the parsed script cache used
+			by the internal one-shot snippets (link handlers, sound commands, part messages...)[br]
+			[b]export[/b]: writes the collected data to <filename> in the callgrind format.
+			The file can be then analyzed with tools like KCachegrind or QCachegrind.[br]
+			The profiler has practically no cost when it is not running.
+		@examples:
+			[example]
+				profile start
+				[comment]# ... use KVIrc for a while ...[/comment]
+				profile stop
+				profile -n=10 report
+				profile export /tmp/kvirc.callgrind
+			[/example]
+	*/
+
+	KVSCSC(profile)
+	{
+		QString szOperation, szFileName;
+		KVSCSC_PARAMETERS_BEGIN
+		KVSCSC_PARAMETER("operation", KVS_PT_NONEMPTYSTRING, 0, szOperation)
+		KVSCSC_PARAMETER("filename", KVS_PT_STRING, KVS_PF_OPTIONAL, szFileName)
+		KVSCSC_PARAMETERS_END
+
+		KviKvsProfiler * p = KviKvsProfiler::instance();
+		bool bQuiet = KVSCSC_pSwitches->find('q', "quiet");
+
+		if(KviQString::equalCI(szOperation, "start"))
+		{
+			p->start();
+			if(!bQuiet)
+				KVSCSC_pWindow->outputNoFmt(KVI_OUT_VERBOSE, __tr2qs_ctx("Script profiler started", "kvs"));
+			return true;
+		}
+
+		if(KviQString::equalCI(szOperation, "stop"))
+		{
+			p->stop();
+			if(!bQuiet)
+				KVSCSC_pWindow->outputNoFmt(KVI_OUT_VERBOSE, __tr2qs_ctx("Script profiler stopped", "kvs"));
+			return true;
+		}
+
+		if(KviQString::equalCI(szOperation, "reset"))
+		{
+			p->reset();
+			if(!bQuiet)
+				KVSCSC_pWindow->outputNoFmt(KVI_OUT_VERBOSE, __tr2qs_ctx("Script profiler data discarded", "kvs"));
+			return true;
+		}
+
+		if(KviQString::equalCI(szOperation, "export"))
+		{
+			if(szFileName.isEmpty())
+			{
+				KVSCSC_pContext->error(__tr2qs_ctx("The export operation requires a file name", "kvs"));
+				return false;
+			}
+			KviFileUtils::adjustFilePath(szFileName);
+			if(!p->exportCallgrind(szFileName))
+			{
+				KVSCSC_pContext->warning(__tr2qs_ctx("Can't write the profile data to the file %Q", "kvs"), &szFileName);
+				return true;
+			}
+			if(!bQuiet)
+				KVSCSC_pWindow->output(KVI_OUT_VERBOSE, __tr2qs_ctx("Profile data written to %Q", "kvs"), &szFileName);
+			return true;
+		}
+
+		if(!KviQString::equalCI(szOperation, "report"))
+		{
+			KVSCSC_pContext->error(__tr2qs_ctx("Unknown profiler operation '%Q'", "kvs"), &szOperation);
+			return false;
+		}
+
+		kvs_int_t iCount = 20;
+		if(KviKvsVariant * pCount = KVSCSC_pSwitches->find('n', "count"))
+		{
+			if(!pCount->asInteger(iCount) || (iCount < 1))
+			{
+				KVSCSC_pContext->warning(__tr2qs_ctx("Invalid count specified, using the default", "kvs"));
+				iCount = 20;
+			}
+		}
+
+		std::vector<KviKvsProfilerEntry *> vEntries;
+		p->sortedEntries(vEntries);
+
+		QString szTotal = QString::number(p->profileTime() / 1000000.0, 'f', 3);
+		KVSCSC_pWindow->output(KVI_OUT_VERBOSE, __tr2qs_ctx("Script profile over %Q msecs (%u contexts)", "kvs"), &szTotal, (unsigned int)vEntries.size());
+		KVSCSC_pWindow->outputNoFmt(KVI_OUT_VERBOSE, __tr2qs_ctx("Calls, exclusive msecs, inclusive msecs, exclusive allocations, inclusive allocations, context", "kvs"));
+
+		kvs_int_t iIdx = 0;
+		for(auto e : vEntries)
+		{
+			if(iIdx++ >= iCount)
+				break;
+
+			QString szLine = QString("%1 %2 %3 %4 %5 %6")
+			                     .arg(e->calls(), 8)
+			                     .arg(e->exclusiveTime() / 1000000.0, 10, 'f', 3)
+			                     .arg(e->inclusiveTime() / 1000000.0, 10, 'f', 3)
+			                     .arg(e->exclusiveAllocations(), 8)
+			                     .arg(e->inclusiveAllocations(), 8)
+			                     .arg(e->name());
+			KVSCSC_pWindow->outputNoFmt(KVI_OUT_VERBOSE, szLine);
+		}
+
+		KviKvsScriptCache * pCache = KviKvsScriptCache::instance();
+		QString szHits = QString::number(pCache->hits());
+		QString szMisses = QString::number(pCache->misses());
+		KVSCSC_pWindow->output(KVI_OUT_VERBOSE, __tr2qs_ctx("Parsed script cache: %u entries, %Q hits, %Q misses", "kvs"), pCache->count(), &szHits, &szMisses);
+
+		return true;
+	}
+
 	/*
 		@doc: query
 		@type:
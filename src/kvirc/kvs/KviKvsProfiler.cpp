@@ -0,0 +1,270 @@
+//=============================================================================
+//
+//   File : KviKvsProfiler.cpp
+//   Creation date : Mon Oct 19 2026 10:12:31 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2000-2026 Szymon Stefanek (pragma at kvirc dot net)
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviKvsProfiler.h"
+#include "KviKvsVariant.h"
+#include "KviFileUtils.h"
+
+#include <algorithm>
+
+KviKvsProfilerEntry::KviKvsProfilerEntry(const QString & szName)
+    : m_szName(szName)
+{
+	m_pCallees = new KviPointerHashTable<QString, KviKvsProfilerCall>(17, true);
+	m_pCallees->setAutoDelete(true);
+	m_uActive = 0;
+	reset();
+}
+
+KviKvsProfilerEntry::~KviKvsProfilerEntry()
+{
+	delete m_pCallees;
+}
+
+void KviKvsProfilerEntry::reset()
+{
+	m_uCalls = 0;
+	m_iInclusiveTime = 0;
+	m_iExclusiveTime = 0;
+	m_uInclusiveAllocations = 0;
+	m_uExclusiveAllocations = 0;
+	m_pCallees->clear();
+}
+
+KviKvsProfiler * KviKvsProfiler::m_pInstance = nullptr;
+
+KviKvsProfiler::KviKvsProfiler()
+{
+	m_bRunning = false;
+	m_iStartTime = 0;
+	m_iProfileTime = 0;
+	m_pEntryDict = new KviPointerHashTable<QString, KviKvsProfilerEntry>(101, true);
+	m_pEntryDict->setAutoDelete(true);
+	m_Timer.start();
+}
+
+KviKvsProfiler::~KviKvsProfiler()
+{
+	delete m_pEntryDict;
+}
+
+void KviKvsProfiler::init()
+{
+	if(m_pInstance)
+	{
+		qDebug("WARNING: trying to call KviKvsProfiler::init() twice");
+		return;
+	}
+	m_pInstance = new KviKvsProfiler();
+}
+
+void KviKvsProfiler::done()
+{
+	if(!m_pInstance)
+	{
+		qDebug("WARNING: trying to call KviKvsProfiler::done() without init()");
+		return;
+	}
+	delete m_pInstance;
+	m_pInstance = nullptr;
+}
+
+void KviKvsProfiler::start()
+{
+	if(m_bRunning)
+		return;
+	m_bRunning = true;
+	m_iStartTime = m_Timer.nsecsElapsed();
+}
+
+void KviKvsProfiler::stop()
+{
+	if(!m_bRunning)
+		return;
+	m_bRunning = false;
+	m_iProfileTime += m_Timer.nsecsElapsed() - m_iStartTime;
+}
+
+void KviKvsProfiler::reset()
+{
+	m_iProfileTime = 0;
+	m_iStartTime = m_Timer.nsecsElapsed();
+
+	if(m_Stack.empty())
+	{
+		m_pEntryDict->clear();
+		return;
+	}
+
+	// we're being called from inside a profiled script:
+	// the frames on the stack still point to the entries, don't kill them
+	KviPointerHashTableIterator<QString, KviKvsProfilerEntry> it(*m_pEntryDict);
+	while(KviKvsProfilerEntry * e = it.current())
+	{
+		e->reset();
+		++it;
+	}
+}
+
+kvi_i64_t KviKvsProfiler::profileTime() const
+{
+	if(m_bRunning)
+		return m_iProfileTime + m_Timer.nsecsElapsed() - m_iStartTime;
+	return m_iProfileTime;
+}
+
+void KviKvsProfiler::enter(const QString & szName)
+{
+	KviKvsProfilerEntry * e = m_pEntryDict->find(szName);
+	if(!e)
+	{
+		e = new KviKvsProfilerEntry(szName);
+		m_pEntryDict->replace(szName, e);
+	}
+
+	e->m_uCalls++;
+	e->m_uActive++;
+
+	if(!m_Stack.empty())
+	{
+		KviKvsProfilerEntry * pCaller = m_Stack.back().pEntry;
+		KviKvsProfilerCall * c = pCaller->m_pCallees->find(szName);
+		if(!c)
+		{
+			c = new KviKvsProfilerCall;
+			c->m_pCallee = e;
+			c->m_uCalls = 0;
+			c->m_iInclusiveTime = 0;
+			c->m_uInclusiveAllocations = 0;
+			pCaller->m_pCallees->replace(szName, c);
+		}
+		c->m_uCalls++;
+	}
+
+	Frame f;
+	f.pEntry = e;
+	f.iChildrenTime = 0;
+	f.uChildrenAllocations = 0;
+	f.uStartAllocations = KviKvsVariantData::m_uAllocations;
+	// sample the time as last thing so we don't account our own overhead
+	f.iStartTime = m_Timer.nsecsElapsed();
+	m_Stack.push_back(f);
+}
+
+void KviKvsProfiler::leave()
+{
+	kvi_i64_t iNow = m_Timer.nsecsElapsed();
+
+	if(m_Stack.empty())
+	{
+		qDebug("WARNING: KviKvsProfiler::leave() called without a matching enter()");
+		return;
+	}
+
+	Frame f = m_Stack.back();
+	m_Stack.pop_back();
+
+	kvi_i64_t iElapsed = iNow - f.iStartTime;
+	kvi_u64_t uAllocations = KviKvsVariantData::m_uAllocations - f.uStartAllocations;
+
+	KviKvsProfilerEntry * e = f.pEntry;
+	e->m_iExclusiveTime += iElapsed - f.iChildrenTime;
+	e->m_uExclusiveAllocations += uAllocations - f.uChildrenAllocations;
+	e->m_uActive--;
+	if(e->m_uActive == 0)
+	{
+		// don't count recursive calls twice
+		e->m_iInclusiveTime += iElapsed;
+		e->m_uInclusiveAllocations += uAllocations;
+	}
+
+	if(m_Stack.empty())
+		return;
+
+	Frame & pf = m_Stack.back();
+	pf.iChildrenTime += iElapsed;
+	pf.uChildrenAllocations += uAllocations;
+
+	KviKvsProfilerCall * c = pf.pEntry->m_pCallees->find(e->m_szName);
+	if(c)
+	{
+		c->m_iInclusiveTime += iElapsed;
+		c->m_uInclusiveAllocations += uAllocations;
+	}
+}
+
+void KviKvsProfiler::sortedEntries(std::vector<KviKvsProfilerEntry *> & vEntries) const
+{
+	vEntries.clear();
+	vEntries.reserve(m_pEntryDict->count());
+
+	KviPointerHashTableIterator<QString, KviKvsProfilerEntry> it(*m_pEntryDict);
+	while(KviKvsProfilerEntry * e = it.current())
+	{
+		if(e->calls() > 0)
+			vEntries.push_back(e);
+		++it;
+	}
+
+	std::sort(vEntries.begin(), vEntries.end(),
+	    [](const KviKvsProfilerEntry * a, const KviKvsProfilerEntry * b) {
+		    return a->exclusiveTime() > b->exclusiveTime();
+	    });
+}
+
+bool KviKvsProfiler::exportCallgrind(const QString & szFileName) const
+{
+	std::vector<KviKvsProfilerEntry *> vEntries;
+	sortedEntries(vEntries);
+
+	kvi_i64_t iTotalTime = 0;
+	kvi_u64_t uTotalAllocations = 0;
+	for(auto e : vEntries)
+	{
+		iTotalTime += e->exclusiveTime();
+		uTotalAllocations += e->exclusiveAllocations();
+	}
+
+	// see http://valgrind.org/docs/manual/cl-format.html
+	// The script contexts have no file/line information, so every cost
+	// is attributed to "line" 0 of a fake "kvs" file.
+	QString szOut;
+	szOut.append(QString("# callgrind format\nversion: 1\ncreator: KVIrc %1\n").arg(KVI_VERSION));
+	szOut.append("cmd: kvs profile\npositions: line\nevents: Nanoseconds Allocations\n");
+	szOut.append(QString("summary: %1 %2\n\nfl=kvs\n").arg(iTotalTime).arg(uTotalAllocations));
+
+	for(auto e : vEntries)
+	{
+		szOut.append(QString("\nfn=%1\n0 %2 %3\n").arg(e->name()).arg(e->exclusiveTime()).arg(e->exclusiveAllocations()));
+
+		KviPointerHashTableIterator<QString, KviKvsProfilerCall> it(*(e->callees()));
+		while(KviKvsProfilerCall * c = it.current())
+		{
+			szOut.append(QString("cfn=%1\ncalls=%2 0\n0 %3 %4\n").arg(c->m_pCallee->name()).arg(c->m_uCalls).arg(c->m_iInclusiveTime).arg(c->m_uInclusiveAllocations));
+			++it;
+		}
+	}
+
+	return KviFileUtils::writeFile(szFileName, szOut);
+}
@@ -0,0 +1,177 @@
+#ifndef _KVI_KVS_PROFILER_H_
+#define _KVI_KVS_PROFILER_H_
+//=============================================================================
+//
+//   File : KviKvsProfiler.h
+//   Creation date : Mon Oct 19 2026 10:12:31 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2000-2026 Szymon Stefanek (pragma at kvirc dot net)
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+/**
+* \file KviKvsProfiler.h
+* \brief Instrumenting profiler for KVS script contexts
+*
+* Every script execution (aliases, events, timers, popups...) is
+* accounted to its script context name (e.g. "OnChannelMessage::myhandler").
+* The profiler is idle by default and costs a single boolean test per
+* script execution in that state.
+*/
+
+#include "kvi_settings.h"
+#include "kvi_inttypes.h"
+#include "KviQString.h"
+#include "KviPointerHashTable.h"
+
+#include <QElapsedTimer>
+
+#include <vector>
+
+class KviKvsProfilerEntry;
+
+/**
+* \class KviKvsProfilerCall
+* \brief A caller -> callee edge of the profile call graph
+*/
+class KVIRC_API KviKvsProfilerCall
+{
+public:
+	KviKvsProfilerEntry * m_pCallee;
+	kvi_u64_t m_uCalls;
+	kvi_i64_t m_iInclusiveTime;           // in nanoseconds
+	kvi_u64_t m_uInclusiveAllocations;
+};
+
+/**
+* \class KviKvsProfilerEntry
+* \brief The statistics collected for a single script context
+*/
+class KVIRC_API KviKvsProfilerEntry
+{
+	friend class KviKvsProfiler;
+
+public:
+	KviKvsProfilerEntry(const QString & szName);
+	~KviKvsProfilerEntry();
+
+protected:
+	QString m_szName;
+	kvi_u64_t m_uCalls;
+	kvi_i64_t m_iInclusiveTime; // in nanoseconds
+	kvi_i64_t m_iExclusiveTime; // in nanoseconds
+	kvi_u64_t m_uInclusiveAllocations;
+	kvi_u64_t m_uExclusiveAllocations;
+	unsigned int m_uActive; // recursion depth: inclusive costs are added only by the outermost call
+	KviPointerHashTable<QString, KviKvsProfilerCall> * m_pCallees;
+
+public:
+	const QString & name() const { return m_szName; };
+	kvi_u64_t calls() const { return m_uCalls; };
+	kvi_i64_t inclusiveTime() const { return m_iInclusiveTime; };
+	kvi_i64_t exclusiveTime() const { return m_iExclusiveTime; };
+	kvi_u64_t inclusiveAllocations() const { return m_uInclusiveAllocations; };
+	kvi_u64_t exclusiveAllocations() const { return m_uExclusiveAllocations; };
+	KviPointerHashTable<QString, KviKvsProfilerCall> * callees() const { return m_pCallees; };
+
+protected:
+	void reset();
+};
+
+/**
+* \class KviKvsProfiler
+* \brief The one and only KVS profiler
+*/
+class KVIRC_API KviKvsProfiler
+{
+protected: // it only can be created and destroyed by KviKvsProfiler::init()/done()
+	KviKvsProfiler();
+	~KviKvsProfiler();
+
+protected:
+	class Frame
+	{
+	public:
+		KviKvsProfilerEntry * pEntry;
+		kvi_i64_t iStartTime;
+		kvi_i64_t iChildrenTime;
+		kvi_u64_t uStartAllocations;
+		kvi_u64_t uChildrenAllocations;
+	};
+
+	static KviKvsProfiler * m_pInstance;
+
+	bool m_bRunning;
+	QElapsedTimer m_Timer;
+	kvi_i64_t m_iStartTime;   // time of the last start()
+	kvi_i64_t m_iProfileTime; // total time spent in the running state
+	KviPointerHashTable<QString, KviKvsProfilerEntry> * m_pEntryDict;
+	std::vector<Frame> m_Stack;
+
+public:
+	static KviKvsProfiler * instance() { return m_pInstance; };
+	static void init(); // called by KviKvs::init()
+	static void done(); // called by KviKvs::done()
+
+	bool isRunning() const { return m_bRunning; };
+	void start();
+	void stop();
+	void reset();
+
+	// Entering and leaving must be perfectly nested: use KviKvsProfilerScope
+	// unless you know what you're doing.
+	void enter(const QString & szName);
+	void leave();
+
+	// total wall time spent with the profiler running, in nanoseconds
+	kvi_i64_t profileTime() const;
+
+	// returns the entries sorted by decreasing exclusive time
+	void sortedEntries(std::vector<KviKvsProfilerEntry *> & vEntries) const;
+
+	// writes the collected data in the callgrind format
+	// (readable by kcachegrind, qcachegrind and friends)
+	bool exportCallgrind(const QString & szFileName) const;
+};
+
+/**
+* \class KviKvsProfilerScope
+* \brief Accounts the lifetime of the object to the specified script context
+*
+* Does nothing if the profiler was not running at construction time.
+*/
+class KviKvsProfilerScope
+{
+public:
+	KviKvsProfilerScope(const QString & szName)
+	    : m_bActive(KviKvsProfiler::instance()->isRunning())
+	{
+		if(m_bActive)
+			KviKvsProfiler::instance()->enter(szName);
+	}
+	~KviKvsProfilerScope()
+	{
+		if(m_bActive)
+			KviKvsProfiler::instance()->leave();
+	}
+
+private:
+	bool m_bActive;
+};
+
+#endif //!_KVI_KVS_PROFILER_H_
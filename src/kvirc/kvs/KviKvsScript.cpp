@@ -30,6 +30,8 @@
 #include "KviKvsTreeNodeInstruction.h"
 #include "KviKvsVariantList.h"
 #include "KviKvsKernel.h"
+#include "KviKvsProfiler.h"
+#include "KviKvsScriptCache.h"
 #include "KviLocale.h"
 #include "KviWindow.h"
 #include "KviApplication.h"
@@ -145,24 +147,21 @@ const QChar * KviKvsScript::buffer() const
 
 int KviKvsScript::run(const QString & szCode, KviWindow * pWindow, KviKvsVariantList * pParams, KviKvsVariant * pRetVal)
 {
-	// static helper
-	KviKvsScript s("kvirc::corecall(run)", szCode);
-	return s.run(pWindow, pParams, pRetVal, PreserveParams);
+	// static helper: these snippets are often the same, use the parsed tree cache
+	return KviKvsScriptCache::instance()->run("kvirc::corecall(run)", szCode, InstructionList, pWindow, pParams, pRetVal);
 }
 
 int KviKvsScript::evaluate(const QString & szCode, KviWindow * pWindow, KviKvsVariantList * pParams, KviKvsVariant * pRetVal)
 {
 	// static helper
-	KviKvsScript s("kvirc::corecall(evaluate)", szCode, Parameter);
-	return s.run(pWindow, pParams, pRetVal, PreserveParams);
+	return KviKvsScriptCache::instance()->run("kvirc::corecall(evaluate)", szCode, Parameter, pWindow, pParams, pRetVal);
 }
 
 int KviKvsScript::evaluateAsString(const QString & szCode, KviWindow * pWindow, KviKvsVariantList * pParams, QString & szRetVal)
 {
 	// static helper
 	KviKvsVariant ret;
-	KviKvsScript s("kvirc::corecall(evaluate)", szCode, Parameter);
-	int iRet = s.run(pWindow, pParams, &ret, PreserveParams);
+	int iRet = KviKvsScriptCache::instance()->run("kvirc::corecall(evaluate)", szCode, Parameter, pWindow, pParams, &ret);
 	ret.asString(szRetVal);
 	return iRet;
 }
@@ -294,6 +293,9 @@ bool KviKvsScript::parse(KviWindow * pOutput, int iRunFlags)
 
 int KviKvsScript::executeInternal(KviKvsRunTimeContext * pContext)
 {
+	// account the execution time to this script context (no-op if not profiling)
+	KviKvsProfilerScope profile(m_pData->m_szName);
+
 	// lock this script
 	m_pData->m_uLock++;
 
@@ -61,6 +61,7 @@ class KVIRC_API KviKvsScript : public KviHeapObject
 	friend class KviKvsObject;
 	friend class KviKvsParser;
 	friend class KviKvsRunTimeContext;
+	friend class KviKvsScriptCache;
 
 public:
 	/**
@@ -0,0 +1,130 @@
+//=============================================================================
+//
+//   File : KviKvsScriptCache.cpp
+//   Creation date : Mon Oct 19 2026 16:40:12 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2000-2026 Szymon Stefanek (pragma at kvirc dot net)
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviKvsScriptCache.h"
+#include "KviKvsVariant.h"
+#include "KviKvsVariantList.h"
+#include "KviWindow.h"
+
+// maximum number of cached trees
+#define KVI_KVS_SCRIPTCACHE_MAX_ENTRIES 128
+// longer snippets are quite likely one-shot: don't waste the cache on them
+#define KVI_KVS_SCRIPTCACHE_MAX_CODE_LENGTH 8192
+
+KviKvsScriptCache * KviKvsScriptCache::m_pInstance = nullptr;
+
+KviKvsScriptCache::KviKvsScriptCache()
+{
+	m_uHits = 0;
+	m_uMisses = 0;
+}
+
+KviKvsScriptCache::~KviKvsScriptCache()
+{
+	clear();
+}
+
+void KviKvsScriptCache::init()
+{
+	if(m_pInstance)
+	{
+		qDebug("WARNING: trying to call KviKvsScriptCache::init() twice");
+		return;
+	}
+	m_pInstance = new KviKvsScriptCache();
+}
+
+void KviKvsScriptCache::done()
+{
+	if(!m_pInstance)
+	{
+		qDebug("WARNING: trying to call KviKvsScriptCache::done() without init()");
+		return;
+	}
+	delete m_pInstance;
+	m_pInstance = nullptr;
+}
+
+void KviKvsScriptCache::clear()
+{
+	// the scripts that are running right now hold a shallow copy
+	// so the trees survive until they finish
+	for(auto & e : m_lEntries)
+		delete e.pScript;
+	m_lEntries.clear();
+	m_hIndex.clear();
+}
+
+int KviKvsScriptCache::run(const QString & szName, const QString & szCode, KviKvsScript::ScriptType eType, KviWindow * pWnd, KviKvsVariantList * pParams, KviKvsVariant * pRetVal)
+{
+	if(szCode.length() > KVI_KVS_SCRIPTCACHE_MAX_CODE_LENGTH)
+	{
+		m_uMisses++;
+		KviKvsScript s(szName, szCode, eType);
+		return s.run(pWnd, pParams, pRetVal, KviKvsScript::PreserveParams);
+	}
+
+	QString szKey = QString::number((int)eType);
+	szKey.append(QChar(':'));
+	szKey.append(szCode);
+
+	KviKvsScript * pScript;
+
+	auto h = m_hIndex.find(szKey);
+	if(h != m_hIndex.end())
+	{
+		m_uHits++;
+		// move to the front
+		m_lEntries.splice(m_lEntries.begin(), m_lEntries, h.value());
+		pScript = m_lEntries.front().pScript;
+	}
+	else
+	{
+		m_uMisses++;
+		pScript = new KviKvsScript(szName, szCode, eType);
+		if(!pScript->parse(pWnd))
+		{
+			delete pScript;
+			return KviKvsScript::Error;
+		}
+
+		if(m_lEntries.size() >= KVI_KVS_SCRIPTCACHE_MAX_ENTRIES)
+		{
+			m_hIndex.remove(m_lEntries.back().szKey);
+			delete m_lEntries.back().pScript;
+			m_lEntries.pop_back();
+		}
+
+		Entry e;
+		e.szKey = szKey;
+		e.pScript = pScript;
+		m_lEntries.push_front(e);
+		m_hIndex.insert(szKey, m_lEntries.begin());
+	}
+
+	// run a shallow copy: the code may trigger a cache flush
+	// (by defining an alias, for example) or push the entry out
+	KviKvsScript s(*pScript);
+	return s.run(pWnd, pParams, pRetVal, KviKvsScript::PreserveParams);
+}
@@ -0,0 +1,104 @@
+#ifndef _KVI_KVS_SCRIPTCACHE_H_
+#define _KVI_KVS_SCRIPTCACHE_H_
+//=============================================================================
+//
+//   File : KviKvsScriptCache.h
+//   Creation date : Mon Oct 19 2026 16:40:12 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2000-2026 Szymon Stefanek (pragma at kvirc dot net)
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+/**
+* \file KviKvsScriptCache.h
+* \brief A bounded LRU cache of parsed scripts
+*
+* Used by the static KviKvsScript::run() and KviKvsScript::evaluate() helpers
+* which are called over and over with the same few snippets of code
+* (link handlers, sound commands, part messages...).
+*/
+
+#include "kvi_settings.h"
+#include "kvi_inttypes.h"
+#include "KviQString.h"
+#include "KviKvsScript.h"
+
+#include <QHash>
+
+#include <list>
+
+class KviWindow;
+class KviKvsVariant;
+class KviKvsVariantList;
+
+/**
+* \class KviKvsScriptCache
+* \brief The one and only parsed script cache
+*/
+class KVIRC_API KviKvsScriptCache
+{
+protected: // it only can be created and destroyed by KviKvsScriptCache::init()/done()
+	KviKvsScriptCache();
+	~KviKvsScriptCache();
+
+protected:
+	class Entry
+	{
+	public:
+		QString szKey;
+		KviKvsScript * pScript; // owned, always successfully parsed
+	};
+
+	static KviKvsScriptCache * m_pInstance;
+
+	// most recently used entries first
+	std::list<Entry> m_lEntries;
+	QHash<QString, std::list<Entry>::iterator> m_hIndex;
+	kvi_u64_t m_uHits;
+	kvi_u64_t m_uMisses;
+
+public:
+	static KviKvsScriptCache * instance() { return m_pInstance; };
+	static void init(); // called by KviKvs::init()
+	static void done(); // called by KviKvs::done()
+
+	/**
+	* \brief Runs the specified code by using the cached syntax tree (if any)
+	*
+	* The code is parsed and cached on the first call. Code that fails
+	* to parse is never cached (so the errors are reported at every call).
+	* The parameters are always preserved.
+	* \param szName The script context name used on a cache miss
+	* \param szCode The code to run
+	* \param eType The type of the code
+	* \param pWnd The window the code runs in
+	* \param pParams The parameters, may be nullptr
+	* \param pRetVal The return value, may be nullptr
+	* \return int (a combination of KviKvsScript::RunStatus)
+	*/
+	int run(const QString & szName, const QString & szCode, KviKvsScript::ScriptType eType, KviWindow * pWnd, KviKvsVariantList * pParams, KviKvsVariant * pRetVal);
+
+	// drops all the cached trees: called when aliases or modules change
+	void clear();
+
+	unsigned int count() const { return m_lEntries.size(); };
+	kvi_u64_t hits() const { return m_uHits; };
+	kvi_u64_t misses() const { return m_uMisses; };
+};
+
+#endif //!_KVI_KVS_SCRIPTCACHE_H_
@@ -237,6 +237,8 @@ int KviKvsVariantComparison::compareHObjectArray(const KviKvsVariant * pV1, cons
 	return pV1->m_pData->m_u.hObject == ((kvs_hobject_t) nullptr) ? KviKvsVariantComparison::FirstGreater : KviKvsVariantComparison::Equal;
 }
 
+kvi_u64_t KviKvsVariantData::m_uAllocations = 0;
+
 KviKvsVariant::KviKvsVariant()
 {
 	m_pData = nullptr;
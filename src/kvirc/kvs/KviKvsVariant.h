@@ -145,10 +145,26 @@ public:
 		kvs_hobject_t hObject;
 	};
 
+public:
+	/**
+	* \brief Constructs the variant data
+	*
+	* The data members are NOT initialized: the KviKvsVariant
+	* routines take care of it.
+	*/
+	KviKvsVariantData() { m_uAllocations++; };
+
 public:
 	unsigned int m_uRefs;
 	Type m_eType;
 	DataType m_u;
+
+	/**
+	* \brief The number of data blocks allocated so far
+	*
+	* This is used by KviKvsProfiler to compute the allocation counts.
+	*/
+	static kvi_u64_t m_uAllocations;
 };
 
 /**
@@ -26,6 +26,7 @@
 #include "KviConfigurationFile.h"
 #include "KviKvsScript.h"
 #include "KviKvsVariant.h"
+#include "KviKvsProfiler.h"
 #include "KviOptions.h"
 #include "KviLocale.h"
 #include "kvi_out.h"
@@ -490,8 +491,14 @@ bool KviKvsEventManager::triggerHandlers(KviPointerList<KviKvsEventHandler> * pH
 				KviKvsVariant retVal;
 				KviKvsRunTimeContext ctx(nullptr, pWnd, pParams, &retVal);
 				KviKvsModuleEventCall call(m, &ctx, pParams);
+				// module handlers don't run through KviKvsScript: account them here
+				bool bProfile = KviKvsProfiler::instance()->isRunning();
+				if(bProfile)
+					KviKvsProfiler::instance()->enter(QString("module::%1").arg(m->name()));
 				if(!(*proc)(&call))
 					bGotHalt = true;
+				if(bProfile)
+					KviKvsProfiler::instance()->leave();
 			}
 			break;
 		}
@@ -31,18 +31,82 @@
 #include "KviMainWindow.h"
 #include "KviConsoleWindow.h"
 #include "KviLocale.h"
+#include "KviKvsScriptCache.h"
+#include "KviConfigurationFile.h"
 #include "kvi_out.h"
 
 #include <QDir>
 #include <QLibrary>
+#include <QEvent>
+#include <QCoreApplication>
 #include <vector>
+#include <utility>
+
+// Scores: each session keeps 3/4 of the previous score and adds 250 if the module was used.
+// A module used in every session converges to 1000, one used in two of the last three
+// sessions scores at least 328 (used, used, unused) and is hot, one used only in the
+// last session scores 250 and is not
+#define KVI_MODULE_USAGE_SESSION_SCORE 250
+#define KVI_MODULE_USAGE_HOT_SCORE 320
 
 KviModuleManager * g_pModuleManager = nullptr;
 
+class KviModulePreloadEvent : public QEvent
+{
+public:
+	KviModulePreloadEvent()
+	    : QEvent(QEvent::User){};
+	~KviModulePreloadEvent()
+	{
+		// not picked up by the manager (it is being destroyed)
+		for(auto & p : m_vLibraries)
+		{
+			p.second->unload();
+			delete p.second;
+		}
+	}
+
+public:
+	std::vector<std::pair<QString, QLibrary *>> m_vLibraries;
+};
+
+KviModulePreloaderThread::KviModulePreloaderThread(QObject * pReceiver, const QStringList & lNames, const QStringList & lPaths)
+    : QThread(), m_pReceiver(pReceiver), m_lNames(lNames), m_lPaths(lPaths)
+{
+}
+
+KviModulePreloaderThread::~KviModulePreloaderThread()
+{
+	wait();
+}
+
+void KviModulePreloaderThread::run()
+{
+	// the costly part of the loading (reading, mapping and relocating the
+	// library) is done here: the initialization must happen in the main thread
+	KviModulePreloadEvent * e = new KviModulePreloadEvent();
+	QThread * pMainThread = QCoreApplication::instance()->thread();
+
+	for(int i = 0; i < m_lNames.count(); i++)
+	{
+		QLibrary * pLibrary = new QLibrary(m_lPaths.at(i));
+		if(!pLibrary->load())
+		{
+			delete pLibrary;
+			continue;
+		}
+		pLibrary->moveToThread(pMainThread);
+		e->m_vLibraries.emplace_back(m_lNames.at(i), pLibrary);
+	}
+
+	QCoreApplication::postEvent(m_pReceiver, e);
+}
+
 KviModuleManager::KviModuleManager()
 {
 	m_pModuleDict = new KviPointerHashTable<QString, KviModule>(17, false);
 	m_pModuleDict->setAutoDelete(false);
+	m_pPreloader = nullptr;
 
 	m_pCleanupTimer = new QTimer(this);
 	connect(m_pCleanupTimer, SIGNAL(timeout()), this, SLOT(cleanupUnusedModules()));
@@ -50,11 +114,115 @@ KviModuleManager::KviModuleManager()
 
 KviModuleManager::~KviModuleManager()
 {
+	if(m_pPreloader)
+		delete m_pPreloader; // waits for it
+	for(auto pLibrary : m_hPreloadedLibraries)
+	{
+		pLibrary->unload();
+		delete pLibrary;
+	}
 	unloadAllModules();
 	delete m_pModuleDict;
 	delete m_pCleanupTimer;
 }
 
+void KviModuleManager::loadUsageStats(const QString & szFileName)
+{
+	KviConfigurationFile cfg(szFileName, KviConfigurationFile::Read);
+
+	KviConfigurationFileIterator it(*(cfg.dict()));
+	while(it.current())
+	{
+		cfg.setGroup(it.currentKey());
+		KviModuleUsage u;
+		u.uScore = cfg.readUIntEntry("Score", 0);
+		u.uUses = 0;
+		if(u.uScore)
+			m_hUsage.insert(it.currentKey(), u);
+		++it;
+	}
+}
+
+void KviModuleManager::saveUsageStats(const QString & szFileName)
+{
+	KviConfigurationFile cfg(szFileName, KviConfigurationFile::Write);
+
+	for(auto it = m_hUsage.begin(); it != m_hUsage.end(); ++it)
+	{
+		// this is the score the next session will see
+		unsigned int uScore = (it.value().uScore * 3) / 4;
+		if(it.value().uUses)
+			uScore += KVI_MODULE_USAGE_SESSION_SCORE;
+		if(!uScore)
+			continue; // forgotten
+		cfg.setGroup(it.key());
+		cfg.writeEntry("Score", uScore);
+		cfg.writeEntry("Uses", it.value().uUses);
+	}
+}
+
+bool KviModuleManager::isHotModule(const QString & modName)
+{
+	auto it = m_hUsage.constFind(modName.toLower());
+	return (it != m_hUsage.constEnd()) && (it.value().uScore >= KVI_MODULE_USAGE_HOT_SCORE);
+}
+
+void KviModuleManager::preloadFrequentModules()
+{
+	if(m_pPreloader)
+		return;
+
+	QStringList lNames, lPaths;
+	for(auto it = m_hUsage.constBegin(); it != m_hUsage.constEnd(); ++it)
+	{
+		if((it.value().uScore < KVI_MODULE_USAGE_HOT_SCORE) || m_pModuleDict->find(it.key()))
+			continue;
+		QString szName, szPath;
+		getModuleLibraryPath(it.key(), szName, szPath);
+		if(!KviFileUtils::fileExists(szPath))
+			continue;
+		lNames.append(it.key());
+		lPaths.append(szPath);
+	}
+
+	if(lNames.isEmpty())
+		return;
+
+	m_pPreloader = new KviModulePreloaderThread(this, lNames, lPaths);
+	m_pPreloader->start(QThread::LowPriority);
+}
+
+void KviModuleManager::customEvent(QEvent * e)
+{
+	if(e->type() != QEvent::User)
+	{
+		QObject::customEvent(e);
+		return;
+	}
+
+	KviModulePreloadEvent * ev = (KviModulePreloadEvent *)e;
+
+	delete m_pPreloader; // already done
+	m_pPreloader = nullptr;
+
+	std::vector<std::pair<QString, QLibrary *>> vLibraries;
+	vLibraries.swap(ev->m_vLibraries);
+
+	for(auto & p : vLibraries)
+	{
+		if(m_pModuleDict->find(p.first))
+		{
+			// requested (and loaded synchronously) in the meantime: drop our reference
+			p.second->unload();
+			delete p.second;
+			continue;
+		}
+		m_hPreloadedLibraries.insert(p.first, p.second);
+		if(!loadModule(p.first))
+			qDebug("Failed to initialize the preloaded module %s: %s", p.first.toUtf8().data(), m_szLastError.toUtf8().data());
+	}
+}
+
 void KviModuleManager::loadModulesByCaps(const QString & caps, const QString & dir)
 {
 	QString szCapsPath = dir;
@@ -146,19 +314,16 @@ KviModule * KviModuleManager::getModule(const QString & modName)
 		m = m_pModuleDict->find(modName);
 	}
 	if(m)
+	{
 		m->updateAccessTime();
+		m_hUsage[modName.toLower()].uUses++; // default constructed entries are zeroed
+	}
 	return m;
 }
 
-bool KviModuleManager::loadModule(const QString & modName)
+void KviModuleManager::getModuleLibraryPath(const QString & modName, QString & szName, QString & szPath)
 {
-	if(findModule(modName))
-	{
-		//qDebug("MODULE %s ALREADY IN CORE MEMORY",modName);
-		return true;
-	}
-	QString tmp;
-	QString szName;
+	szName.clear();
 #if defined(COMPILE_ON_WINDOWS)
 	KviQString::appendFormatted(szName, "kvi%Q.dll", &modName);
 #elif defined(COMPILE_ON_MINGW)
@@ -168,18 +333,35 @@ bool KviModuleManager::loadModule(const QString & modName)
 #endif
 	szName = szName.toLower();
 
-	g_pApp->getLocalKvircDirectory(tmp, KviApplication::Modules, szName);
-	if(!KviFileUtils::fileExists(tmp))
+	g_pApp->getLocalKvircDirectory(szPath, KviApplication::Modules, szName);
+	if(!KviFileUtils::fileExists(szPath))
 	{
-		g_pApp->getGlobalKvircDirectory(tmp, KviApplication::Modules, szName);
+		g_pApp->getGlobalKvircDirectory(szPath, KviApplication::Modules, szName);
 	}
+}
 
-	QLibrary * pLibrary = new QLibrary(tmp);
-	if(!pLibrary->load())
+bool KviModuleManager::loadModule(const QString & modName)
+{
+	if(findModule(modName))
 	{
-		m_szLastError = pLibrary->errorString();
-		delete pLibrary;
-		return false;
+		//qDebug("MODULE %s ALREADY IN CORE MEMORY",modName);
+		return true;
+	}
+	QString tmp;
+	QString szName;
+	getModuleLibraryPath(modName, szName, tmp);
+
+	// already mapped by the preloader?
+	QLibrary * pLibrary = m_hPreloadedLibraries.take(modName);
+	if(!pLibrary)
+	{
+		pLibrary = new QLibrary(tmp);
+		if(!pLibrary->load())
+		{
+			m_szLastError = pLibrary->errorString();
+			delete pLibrary;
+			return false;
+		}
 	}
 	KviModuleInfo * info = (KviModuleInfo *)pLibrary->resolve(KVIRC_MODULE_STRUCTURE_SYMBOL);
 	if(!info)
@@ -257,6 +439,9 @@ bool KviModuleManager::loadModule(const QString & modName)
 			m_pCleanupTimer->start(KVI_OPTION_UINT(KviOption_uintModuleCleanupTimerInterval) * 1000);
 		}
 	}
+	// the cached parse trees may have been built without this module
+	if(KviKvsScriptCache::instance())
+		KviKvsScriptCache::instance()->clear();
 	// be verbose if needed....just make sure that we're not shutting down...
 	if(_OUTPUT_VERBOSE && !g_pApp->kviClosingDown())
 	{
@@ -296,6 +481,10 @@ bool KviModuleManager::unloadModule(KviModule * module)
 	m_pModuleDict->remove(szModName);
 	delete module;
 
+	// and the parse trees built while it was there
+	if(KviKvsScriptCache::instance())
+		KviKvsScriptCache::instance()->clear();
+
 	// unload the message catalogues, if any
 	KviLocale::instance()->unloadCatalogue(szModName);
 
@@ -334,6 +523,12 @@ void KviModuleManager::cleanupUnusedModules()
 
 	while(it.current())
 	{
+		// unloading the frequently used modules would just mean loading them again soon
+		if(isHotModule(it.currentKey()))
+		{
+			++it;
+			continue;
+		}
 		if(it.current()->secondsSinceLastAccess() > KVI_OPTION_UINT(KviOption_uintModuleCleanupTimeout))
 		{
 			if(it.current()->moduleInfo()->can_unload)
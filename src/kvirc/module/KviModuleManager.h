@@ -30,8 +30,36 @@
 
 #include <QTimer>
 #include <QObject>
+#include <QThread>
+#include <QHash>
+#include <QStringList>
 #include <vector>
 
+class QLibrary;
+
+// How much each module has been used in the recent sessions
+struct KviModuleUsage
+{
+	unsigned int uScore; // decays at every session: see KviModuleManager::saveUsageStats()
+	unsigned int uUses;  // in the current session
+};
+
+// Maps the libraries of the modules in the background: see KviModuleManager::preloadFrequentModules()
+class KviModulePreloaderThread : public QThread
+{
+public:
+	KviModulePreloaderThread(QObject * pReceiver, const QStringList & lNames, const QStringList & lPaths);
+	~KviModulePreloaderThread();
+
+protected:
+	QObject * m_pReceiver;
+	QStringList m_lNames;
+	QStringList m_lPaths;
+
+protected:
+	void run() override;
+};
+
 class KVIRC_API KviModuleManager : public QObject
 {
 	Q_OBJECT
@@ -43,6 +71,9 @@ private:
 	KviPointerHashTable<QString, KviModule> * m_pModuleDict;
 	QTimer * m_pCleanupTimer;
 	QString m_szLastError;
+	QHash<QString, KviModuleUsage> m_hUsage;
+	QHash<QString, QLibrary *> m_hPreloadedLibraries; // mapped by the preloader, not initialized yet
+	KviModulePreloaderThread * m_pPreloader;
 
 public:
 	QString & lastError() { return m_szLastError; };
@@ -58,8 +89,19 @@ public:
 	bool hasLockedModules();
 	void completeModuleNames(const QString & word, std::vector<QString> & matches);
 
+	// Usage statistics (kept across the sessions)
+	void loadUsageStats(const QString & szFileName);
+	void saveUsageStats(const QString & szFileName);
+	// Frequently used modules are preloaded at startup and never cleaned up
+	bool isHotModule(const QString & modName);
+	// Maps the libraries of the hot modules in a slave thread:
+	// they are then initialized when the control returns to the main loop
+	void preloadFrequentModules();
+
 protected:
 	void completeModuleNames(const QString & path, const QString & work, std::vector<QString> & matches);
+	void getModuleLibraryPath(const QString & modName, QString & szName, QString & szPath);
+	void customEvent(QEvent * e) override;
 public slots:
 	void cleanupUnusedModules();
 signals:
@@ -201,27 +201,26 @@ void KviIrcServerParser::parseLiteralChghost(KviIrcMessage * msg)
 	if(KVS_TRIGGER_EVENT_5_HALTED(KviEvent_OnHostChange, console, szNick, szUser, szHost, szNewUser, szNewHost))
 		msg->setHaltOutput();
 
-	for(auto & c : console->connection()->channelList())
+	std::vector<KviChannelWindow *> vChannels;
+	console->connection()->getUserChannels(szNick, vChannels);
+	for(auto & c : vChannels)
 	{
-		if(c->isOn(szNick))
+		if(!msg->haltOutput())
 		{
-			if(!msg->haltOutput())
+			if(szHost == szNewHost)
 			{
-				if(szHost == szNewHost)
-				{
-					c->output(KVI_OUT_NICK, __tr2qs("\r!n\r%Q\r [%Q@\r!h\r%Q\r] now has user %Q"),
-					    &szNick, &szUser, &szHost, &szNewUser);
-				}
-				else if(szUser == szNewUser)
-				{
-					c->output(KVI_OUT_NICK, __tr2qs("\r!n\r%Q\r [%Q@\r!h\r%Q\r] now has host \r!h\r%Q\r"),
-					    &szNick, &szUser, &szHost, &szNewHost);
-				}
-				else
-				{
-					c->output(KVI_OUT_NICK, __tr2qs("\r!n\r%Q\r [%Q@\r!h\r%Q\r] now has user@host %Q@\r!h\r%Q\r"),
-					    &szNick, &szUser, &szHost, &szNewUser, &szNewHost);
-				}
+				c->output(KVI_OUT_NICK, __tr2qs("\r!n\r%Q\r [%Q@\r!h\r%Q\r] now has user %Q"),
+				    &szNick, &szUser, &szHost, &szNewUser);
+			}
+			else if(szUser == szNewUser)
+			{
+				c->output(KVI_OUT_NICK, __tr2qs("\r!n\r%Q\r [%Q@\r!h\r%Q\r] now has host \r!h\r%Q\r"),
+				    &szNick, &szUser, &szHost, &szNewHost);
+			}
+			else
+			{
+				c->output(KVI_OUT_NICK, __tr2qs("\r!n\r%Q\r [%Q@\r!h\r%Q\r] now has user@host %Q@\r!h\r%Q\r"),
+				    &szNick, &szUser, &szHost, &szNewUser, &szNewHost);
 			}
 		}
 	}
@@ -594,6 +593,8 @@ void KviIrcServerParser::parseLiteralQuit(KviIrcMessage * msg)
 		}
 	}
 
+	std::vector<KviChannelWindow *> vChannels;
+
 	// FIXME: #warning "Add a netsplit parameter ?"
 	if(KviKvsEventManager::instance()->hasAppHandlers(KviEvent_OnQuit))
 	{
@@ -603,17 +604,15 @@ void KviIrcServerParser::parseLiteralQuit(KviIrcMessage * msg)
 
 		if(console->connection())
 		{
-			for(auto & c : console->connection()->channelList())
+			console->connection()->getUserChannels(szNick, vChannels);
+			for(auto & c : vChannels)
 			{
-				if(c->isOn(szNick))
+				if(chanlist.isEmpty())
+					chanlist = c->windowName();
+				else
 				{
-					if(chanlist.isEmpty())
-						chanlist = c->windowName();
-					else
-					{
-						chanlist.append(',');
-						chanlist.append(c->windowName());
-					}
+					chanlist.append(',');
+					chanlist.append(c->windowName());
 				}
 			}
 		}
@@ -629,7 +628,9 @@ void KviIrcServerParser::parseLiteralQuit(KviIrcMessage * msg)
 			msg->setHaltOutput();
 	}
 
-	for(auto & c : console->connection()->channelList())
+	// look them up again: the event handlers might have closed some windows
+	console->connection()->getUserChannels(szNick, vChannels);
+	for(auto & c : vChannels)
 	{
 		if(c->part(szNick))
 		{
@@ -1144,14 +1145,9 @@ void KviIrcServerParser::parseLiteralPrivmsg(KviIrcMessage * msg)
 						pOut = aWin;
 					else
 					{
-						for(auto & c : pConnection->channelList())
-						{
-							if(c->isOn(szOtherNick))
-							{
-								pOut = c;
-								break;
-							}
-						}
+						std::vector<KviChannelWindow *> vChannels;
+						if(pConnection->getUserChannels(szOtherNick, vChannels))
+							pOut = vChannels.front();
 					}
 				}
 
@@ -1564,12 +1560,9 @@ void KviIrcServerParser::parseLiteralNotice(KviIrcMessage * msg)
 						pOut = aWin;
 					else
 					{
-						for(auto & c : pConnection->channelList())
-							if(c->isOn(szNick))
-							{
-								pOut = c;
-								break;
-							}
+						std::vector<KviChannelWindow *> vChannels;
+						if(pConnection->getUserChannels(szNick, vChannels))
+							pOut = vChannels.front();
 					}
 				}
 
@@ -1774,7 +1767,9 @@ void KviIrcServerParser::parseLiteralNick(KviIrcMessage * msg)
 	if(pUserEntry)
 		pUserEntry->setSmartNickColor(-1);
 
-	for(auto & c : console->connection()->channelList())
+	std::vector<KviChannelWindow *> vChannels;
+	console->connection()->getUserChannels(szNick, vChannels);
+	for(auto & c : vChannels)
 	{
 		if(c->nickChange(szNick, szNewNick))
 		{
@@ -1783,7 +1778,11 @@ void KviIrcServerParser::parseLiteralNick(KviIrcMessage * msg)
 				    &szNick, &szUser, &szHost, &szNewNick);
 			// FIXME if(bIsMe)output(YOU ARE now known as.. ?)
 		}
-		if(bIsMe)
+	}
+
+	if(bIsMe)
+	{
+		for(auto & c : console->connection()->channelList())
 			c->updateCaption();
 	}
 
@@ -246,7 +246,6 @@ void KviIrcServerParser::parseNumeric005(KviIrcMessage * msg)
 			 * MAXLIST -> Maximum number entries in the list per mode (e.g. MAXLIST=beI:30)
 			 * WALLCHOPS -> The server supports messaging channel operators (deprecated by STATUSMSG, e.g. usage: NOTICE @#channel)
 			 * WALLVOICES -> The server supports messaging channel voiced users (deprecated by STATUSMSG, e.g. usage: NOTICE +#channel)
-			 * CASEMAPPING -> Case mapping used for nick- and channel name comparing (e.g. CASEMAPPING=rfc1459)
 			 * ELIST -> search extensions to list modes, like mask search, topic search, creation time search (e.g. ELIST=MNUCT)
 			 * KICKLEN -> Maximum kick comment length (e.g. KICKLEN=80)
 			 * CHANNELLEN -> Maximum channel name length (e.g. CHANNELLEN=50)
@@ -298,6 +297,11 @@ void KviIrcServerParser::parseNumeric005(KviIrcMessage * msg)
 				if(tmp.hasData())
 					msg->connection()->serverInfo()->setSupportedChannelTypes(tmp.ptr());
 			}
+			else if(kvi_strEqualCIN("CASEMAPPING=", p, 12))
+			{
+				p += 12;
+				msg->connection()->setCaseMapping(KviIrcCaseMapping::fromName(QString::fromLatin1(p)));
+			}
 			else if(kvi_strEqualCI("WATCH", p) || kvi_strEqualCIN("WATCH=", p, 6))
 			{
 				msg->connection()->serverInfo()->setSupportsWatchList(true);
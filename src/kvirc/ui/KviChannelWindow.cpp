@@ -57,6 +57,7 @@
 #include "KviCryptController.h"
 #endif //COMPILE_CRYPT_SUPPORT
 
+#include <algorithm>
 #include <set>
 #include <ctime>
 
@@ -243,6 +244,8 @@ KviChannelWindow::KviChannelWindow(KviConsoleWindow * lpConsole, const QString &
 	if(KVI_OPTION_BOOL(KviOption_boolAutoLogChannels))
 		m_pIrcView->startLogging();
 
+	restoreScrollbackSnapshot();
+
 	applyOptions();
 	m_joinTime = QDateTime::currentDateTime();
 	m_tLastReceivedWhoReply = (kvi_time_t)m_joinTime.toSecsSinceEpoch();
@@ -250,6 +253,8 @@ KviChannelWindow::KviChannelWindow(KviConsoleWindow * lpConsole, const QString &
 
 KviChannelWindow::~KviChannelWindow()
 {
+	saveScrollbackSnapshot();
+
 	// Unregister ourself
 	if(type() == KviWindow::DeadChannel && context())
 		context()->unregisterDeadChannel(this);
@@ -740,6 +745,9 @@ bool KviChannelWindow::setOp(const QString & szNick, bool bOp, bool bIsMe)
 
 void KviChannelWindow::setDeadChan()
 {
+	// the network name is not known anymore after this point
+	saveScrollbackSnapshot();
+
 	m_iStateFlags |= DeadChan;
 	m_iStateFlags &= ~(NoCloseOnPart | SentSyncWhoRequest);
 
@@ -754,9 +762,14 @@ void KviChannelWindow::setDeadChan()
 
 	//clear all mask lists (eg bans)
 	for(auto & iter : m_ModeLists)
+	{
+		for(auto e : iter.second)
+			delete e;
 		iter.second.clear();
+	}
 
 	m_ModeLists.clear();
+	m_ModeListIndexes.clear();
 	m_szSentModeRequests.clear();
 
 	m_pTopicWidget->reset();
@@ -1923,55 +1936,77 @@ void KviChannelWindow::setModeInList(char cMode, const QString & szMask, bool bA
 	if(m_ListEditors.count(cMode))
 		pEditor = m_ListEditors[cMode];
 
-	internalMask(szMask, bAdd, szSetBy, uSetAt, pList, &pEditor, szChangeMask);
+	internalMask(szMask, bAdd, szSetBy, uSetAt, pList, m_ModeListIndexes[cMode], &pEditor, szChangeMask);
 	m_pUserListView->setMaskEntries(cMode, pList.size());
 }
 
-void KviChannelWindow::internalMask(const QString & szMask, bool bAdd, const QString & szSetBy, unsigned int uSetAt, std::vector<KviMaskEntry *> & pList, KviMaskEditor ** ppEd, QString & szChangeMask)
+void KviChannelWindow::internalMask(const QString & szMask, bool bAdd, const QString & szSetBy, unsigned int uSetAt, std::vector<KviMaskEntry *> & pList, ModeListIndex & index, KviMaskEditor ** ppEd, QString & szChangeMask)
 {
-	KviMaskEntry * pEntry = nullptr;
+	KviMaskEntry * pEntry = index.hMasks.value(szMask.toLower(), nullptr);
 	if(bAdd)
 	{
-		for(auto & e : pList)
-		{
-			if(KviQString::equalCI(e->szMask, szMask))
-				return; //already there
-		}
+		if(pEntry)
+			return; //already there
 		pEntry = new KviMaskEntry;
 		pEntry->szMask = szMask;
 		pEntry->szSetBy = (!szSetBy.isEmpty()) ? szSetBy : __tr2qs("(Unknown)");
 		pEntry->uSetAt = uSetAt;
 		pList.push_back(pEntry);
+		index.hMasks.insert(szMask.toLower(), pEntry);
+		index.matcher.insert(KviIrcMask(szMask), pEntry);
 		if(*ppEd)
 			(*ppEd)->addMask(pEntry);
 	}
 	else
 	{
-		auto iter = pList.begin();
-		for(; iter != pList.end() && !KviQString::equalCI((*iter)->szMask, szMask); ++iter);
+		if(!pEntry)
+			return;
+
+		//delete mask from the editor
+		if(*ppEd)
+			(*ppEd)->removeMask(pEntry);
 
-		if(iter != pList.end())
+		index.hMasks.remove(szMask.toLower());
+		index.matcher.remove(pEntry);
+
+		// the new mask may be already in the list: then the old entry just goes away
+		if(!szChangeMask.isNull() && !index.hMasks.contains(szChangeMask.toLower()))
 		{
-			//delete mask from the editor
+			//update mask
+			pEntry->szMask = szChangeMask;
+			index.hMasks.insert(szChangeMask.toLower(), pEntry);
+			index.matcher.insert(KviIrcMask(szChangeMask), pEntry);
 			if(*ppEd)
-				(*ppEd)->removeMask(*iter);
-
-			if(szChangeMask.isNull())
-			{
-				//delete mask
-				pList.erase(iter);
-			}
-			else
-			{
-				//update mask
-				(*iter)->szMask = szChangeMask;
-				if(*ppEd)
-					(*ppEd)->addMask(*iter);
-			}
+				(*ppEd)->addMask(pEntry);
+			return;
 		}
+
+		//delete mask
+		// keep the server order: $chan.banlist and the mask editor show the list as it is
+		auto it = std::find(pList.begin(), pList.end(), pEntry);
+		if(it != pList.end())
+			pList.erase(it);
+		delete pEntry;
 	}
 }
 
+KviMaskEntry * KviChannelWindow::findModeMask(char cMode, const QString & szMask) const
+{
+	const auto it = m_ModeListIndexes.find(cMode);
+	if(it == m_ModeListIndexes.end())
+		return nullptr;
+	return it->second.hMasks.value(szMask.toLower(), nullptr);
+}
+
+void KviChannelWindow::matchingModeMasks(char cMode, const QString & szNick, const QString & szUser, const QString & szHost, std::vector<KviMaskEntry *> & vMatches) const
+{
+	vMatches.clear();
+	const auto it = m_ModeListIndexes.find(cMode);
+	if(it == m_ModeListIndexes.end())
+		return;
+	it->second.matcher.findMatches(szNick, szUser, szHost, vMatches);
+}
+
 void KviChannelWindow::updateModeLabel()
 {
 	static QString br("<br>");
@@ -34,6 +34,7 @@
 #include "KviConsoleWindow.h"
 #include "KviWindow.h"
 #include "KviIrcUserDataBase.h"
+#include "KviIrcMaskIndex.h"
 #include "KviMaskEditor.h"
 #include "KviPixmap.h"
 #include "KviUserListView.h"
@@ -41,6 +42,7 @@
 #include "KviModeWidget.h"
 
 #include <QDateTime>
+#include <QHash>
 #include <QList>
 #include <QString>
 #include <QStringList>
@@ -169,6 +171,14 @@ protected:
 	QString m_szChannelMode;
 	std::map<char, QString> m_szChannelParameterModes;
 	std::map<char, std::vector<KviMaskEntry *>> m_ModeLists;
+	// indexes the entries of m_ModeLists (huge ban lists are common on large channels)
+	class ModeListIndex
+	{
+	public:
+		QHash<QString, KviMaskEntry *> hMasks; // lowercase mask -> entry
+		KviIrcMaskIndex<KviMaskEntry> matcher;
+	};
+	std::map<char, ModeListIndex> m_ModeListIndexes;
 	KviPixmap m_privateBackground;
 	QDateTime m_joinTime;
 	QString m_szNameWithUserFlag;
@@ -218,6 +228,28 @@ public:
 		return EMPTY_VECTOR;
 	};
 
+	/**
+	* \brief Returns the entry of the cMode list with the specified mask
+	* \param cMode The mode of the list
+	* \param szMask The mask to look for (case insensitive)
+	* \return KviMaskEntry *
+	*/
+	KviMaskEntry * findModeMask(char cMode, const QString & szMask) const;
+
+	/**
+	* \brief Finds the entries of the cMode list that match nick!user@host
+	*
+	* Only the list entries that are masks in the nick!user@host form are matched
+	* (so no extended bans). The most specific masks come first.
+	* \param cMode The mode of the list
+	* \param szNick The nickname of the user
+	* \param szUser The username of the user
+	* \param szHost The hostname of the user
+	* \param vMatches The list of matching entries
+	* \return void
+	*/
+	void matchingModeMasks(char cMode, const QString & szNick, const QString & szUser, const QString & szHost, std::vector<KviMaskEntry *> & vMatches) const;
+
 	/**
 	* \brief Returns the first selected nickname in the userlist
 	* \return QString *
@@ -958,11 +990,12 @@ protected:
 	* \param szSetBy Who set the mask
 	* \param uSetAt The datetime when the mask was set
 	* \param l The list of masks in the channel lists
+	* \param index The index of l
 	* \param ppEd The mask editor window
 	* \param szChangeMask If bAdd is false and this string is set, the mask will be updated instead that removed
 	* \return void
 	*/
-	void internalMask(const QString & szMask, bool bAdd, const QString & szSetBy, unsigned int uSetAt, std::vector<KviMaskEntry *> & l, KviMaskEditor ** ppEd, QString & szChangeMask);
+	void internalMask(const QString & szMask, bool bAdd, const QString & szSetBy, unsigned int uSetAt, std::vector<KviMaskEntry *> & l, ModeListIndex & index, KviMaskEditor ** ppEd, QString & szChangeMask);
 
 	/**
 	* \brief Splits the channel view into two views
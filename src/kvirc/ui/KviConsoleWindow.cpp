@@ -879,7 +879,9 @@ void KviConsoleWindow::avatarChangedUpdateWindows(const QString & nick, const QS
 	// in quiet mode avoid bugging the user about avatar changes
 	bool bOut = ((!textLine.isEmpty()) && (!(_OUTPUT_QUIET)));
 
-	for(auto & c : connection()->channelList())
+	std::vector<KviChannelWindow *> vChannels;
+	connection()->getUserChannels(nick, vChannels);
+	for(auto & c : vChannels)
 	{
 		if(c->avatarChanged(nick))
 		{
@@ -988,11 +990,11 @@ void KviConsoleWindow::resetAvatarForMatchingUsers(KviRegisteredUser * u)
 	{
 		if(e->hasHost())
 		{
-			if(u->matchesFixed(it.currentKey(), e->user(), e->host()))
+			if(u->matchesFixed(e->nick(), e->user(), e->host()))
 			{
 				KviAvatar * a = g_pIconManager->getAvatar(QString(), szAvatar);
 				e->setAvatar(a);
-				avatarChangedUpdateWindows(it.currentKey(), QString());
+				avatarChangedUpdateWindows(e->nick(), QString());
 			}
 		}
 		++it;
@@ -38,7 +38,6 @@
 #include "KviInputEditor.h"
 #include "KviInputHistory.h"
 #include "KviIrcView.h"
-#include "KviKvsArrayCast.h"
 #include "KviKvsEventTriggers.h"
 #include "KviKvsKernel.h"
 #include "KviKvsScript.h"
@@ -48,6 +47,7 @@
 #include "KviRegExp.h"
 #include "KviQString.h"
 #include "KviShortcut.h"
+#include "KviSpellChecker.h"
 #include "KviTextIconManager.h"
 #include "KviTextIconWindow.h"
 #include "KviUserInput.h"
@@ -133,6 +133,7 @@ class KviInputEditorPrivate
 public:
 	QList<KviInputEditorTextBlock *> lTextBlocks;
 	bool bTextBlocksDirty;
+	bool bSpellCheckPending; // some words of the last rebuildTextBlocks() are still being checked
 	qreal fXOffset; // positive (but shifts text to the left). Does NOT include margin.
 	QString szFontElision;
 	qreal fFontElisionWidth;
@@ -148,6 +149,7 @@ KviInputEditor::KviInputEditor(QWidget * pPar, QWidget * pInputParent, KviWindow
 {
 	m_p = new KviInputEditorPrivate();
 	m_p->bTextBlocksDirty = true;
+	m_p->bSpellCheckPending = false;
 	m_p->fXOffset = 0;
 	m_p->szFontElision = QString::fromUtf8("…"); // DANGER: make sure this file is saved as utf8
 
@@ -344,11 +346,22 @@ bool KviInputEditor::checkWordSpelling(const QString & szWord)
 		}
 	}
 
-	KviKvsVariant bCorrect;
-	KviKvsVariantList params(new KviKvsVariant(szWord));
-	KviKvsScript::evaluate("$spellchecker.check($0)", nullptr, &params, &bCorrect);
-
-	return bCorrect.asBoolean();
+	// the results are cached: most of the words are looked up only once
+	switch(KviSpellChecker::instance()->check(szWord))
+	{
+		case KviSpellChecker::Mistake:
+			return false;
+		case KviSpellChecker::Pending:
+			// looked up in background: assume correct and underline it later
+			if(!m_p->bSpellCheckPending)
+			{
+				m_p->bSpellCheckPending = true;
+				connect(KviSpellChecker::instance(), SIGNAL(resultsAvailable()), this, SLOT(spellCheckerResultsAvailable()), Qt::UniqueConnection);
+			}
+			return true;
+		default:
+			return true;
+	}
 #else
 	return true; // assume correct
 #endif
@@ -520,6 +533,7 @@ void KviInputEditor::rebuildTextBlocks()
 	std::vector<KviInputEditorSpellCheckerBlock> lSpellCheckerBlocks;
 
 #ifdef COMPILE_ENCHANT_SUPPORT
+	m_p->bSpellCheckPending = false;
 	splitTextIntoSpellCheckerBlocks(m_szTextBuffer, lSpellCheckerBlocks);
 #else
 	ADD_SPELLCHECKER_BLOCK(lSpellCheckerBlocks, m_szTextBuffer, 0, false, true);
@@ -1242,26 +1256,11 @@ void KviInputEditor::fillSpellCheckerCorrectionsPopup()
 		pLabel->setText(__tr2qs("Spelling Suggestions for '%1'").arg(pCurrentBlock->szText));
 		m_SpellCheckerPopup.addAction(pWidgetAction);
 
-		KviKvsVariant aRet;
-		KviKvsVariantList params(new KviKvsVariant(pCurrentBlock->szText));
-		KviKvsScript::evaluate("$spellchecker.suggestions($0)", nullptr, &params, &aRet);
-
-		KviKvsArrayCast aCast;
-		aRet.castToArray(&aCast);
-
-		KviKvsArray * pArray = aCast.array();
+		QStringList lSuggestions;
+		KviSpellChecker::instance()->suggestions(pCurrentBlock->szText, lSuggestions);
 
-		int s = pArray->size();
-
-		for(int i = 0; i < s; i++)
+		for(auto & szWord : lSuggestions)
 		{
-			KviKvsVariant * v = pArray->at(i);
-			if(!v)
-				continue;
-
-			QString szWord;
-			v->asString(szWord);
-
 			if(szWord.isEmpty())
 				continue;
 
@@ -1278,6 +1277,15 @@ void KviInputEditor::fillSpellCheckerCorrectionsPopup()
 #endif
 }
 
+void KviInputEditor::spellCheckerResultsAvailable()
+{
+	if(!m_p->bSpellCheckPending)
+		return;
+	// the words that were pending are now in the cache
+	m_p->bTextBlocksDirty = true;
+	update();
+}
+
 void KviInputEditor::showSpellCheckerCorrectionsPopup()
 {
 	m_iSpellCheckPosition = m_iCursorPosition;
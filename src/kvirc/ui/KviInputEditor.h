@@ -951,6 +951,11 @@ private slots:
 	*/
 	void spellCheckerPopupCorrectionActionTriggered();
 
+	/**
+	* Rebuilds the text blocks when the background spell checks are done
+	*/
+	void spellCheckerResultsAvailable();
+
 	/**
 	* Adds line to input history
 	*/
@@ -106,7 +106,13 @@
 #include <QByteArray>
 #include <QMenu>
 #include <QWindow>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QScreen>
+#include <QGuiApplication>
+#include <QTimerEvent>
 
+#include <algorithm>
 #include <ctime>
 
 #ifdef COMPILE_ON_WINDOWS
@@ -166,6 +172,11 @@ extern QPixmap * g_pShadedChildGlobalDesktopBackground;
 
 #define KVI_IRCVIEW_PIXMAP_SIZE 16
 
+// maximum time spent in a single background re-wrap step (msecs)
+#define KVI_IRCVIEW_REWRAP_SLICE 8
+// the minimum number of lines above and below the view that keep their wrapped blocks
+#define KVI_IRCVIEW_WRAPPED_BLOCKS_CACHE_LINES 256
+
 #define KVI_IRCVIEW_ESCAPE_TAG_URLLINK 'u'
 #define KVI_IRCVIEW_ESCAPE_TAG_NICKLINK 'n'
 #define KVI_IRCVIEW_ESCAPE_TAG_SERVERLINK 's'
@@ -191,10 +202,14 @@ extern QPixmap * g_pShadedChildGlobalDesktopBackground;
 // The IrcView : construct and destroy
 //
 
+// the shared caches live as long as there is a view
+static unsigned int g_uIrcViewCount = 0;
+
 KviIrcView::KviIrcView(QWidget * parent, KviWindow * pWnd)
     : QWidget(parent)
 {
 	setObjectName("irc_view");
+	g_uIrcViewCount++;
 	// Ok...here we go
 	// initialize the initializable
 
@@ -208,6 +223,7 @@ KviIrcView::KviIrcView(QWidget * parent, KviWindow * pWnd)
 	m_pCurLine = nullptr;
 	m_pLastLine = nullptr;
 	m_pCursorLine = nullptr;
+	m_pLineStore = new KviIrcViewLineStore();
 	m_uLineMarkLineIndex = KVI_IRCVIEW_INVALID_LINE_MARK_INDEX;
 	m_bHaveUnreadedHighlightedMessages = false;
 	m_bHaveUnreadedMessages = false;
@@ -215,6 +231,9 @@ KviIrcView::KviIrcView(QWidget * parent, KviWindow * pWnd)
 	m_iMaxLines = KVI_OPTION_UINT(KviOption_uintIrcViewMaxBufferSize);
 
 	m_uNextLineIndex = 0;
+	m_uSnapshotSkip = 0;
+	m_uSnapshotLines = 0;
+	m_uSnapshotBaseIndex = 0;
 	m_pSelectionInitLine = nullptr;
 	m_pSelectionEndLine = nullptr;
 	m_iSelectionInitCharIndex = 0;
@@ -242,7 +261,7 @@ KviIrcView::KviIrcView(QWidget * parent, KviWindow * pWnd)
 	m_pKviWindow = pWnd;
 
 	m_iUnprocessedPaintEventRequests = 0;
-	m_bPostedPaintEventPending = false;
+	m_bRepaintScheduled = false;
 
 	m_pLastLinkUnderMouse = nullptr;
 	m_iLastLinkRectTop = -1;
@@ -258,10 +277,27 @@ KviIrcView::KviIrcView(QWidget * parent, KviWindow * pWnd)
 	setAutoFillBackground(false);
 
 	m_pFm = nullptr; // will be updated in the first paint event
+	m_pCharWidthCache = new KviIrcViewCharWidthCache();
+	m_uPaintCount = 0;
+	m_iPaintTime = 0;
+	m_uPaintRequests = 0;
+	m_uSkippedRepaints = 0;
+	m_uPaintRate = 0;
+	m_uPaintsInSecond = 0;
+	m_iPaintRateSecond = 0;
 	m_iFontDescent = 0;
 	m_iFontLineSpacing = 0;
 	m_iFontLineWidth = 0;
 
+	m_pRewrapUpLine = nullptr;
+	m_pRewrapDownLine = nullptr;
+	m_iRewrapWidth = -1;
+	m_uRewrapDistance = 0;
+	m_pRewrapTimer = new QTimer(this);
+	m_pRewrapTimer->setSingleShot(true);
+	m_pRewrapTimer->setInterval(0);
+	connect(m_pRewrapTimer, SIGNAL(timeout()), this, SLOT(rewrapStep()));
+
 	m_pToolTip = new KviIrcViewToolTip(this);
 
 	// Create the scroll bar
@@ -313,26 +349,15 @@ KviIrcView::KviIrcView(QWidget * parent, KviWindow * pWnd)
 	setSizePolicy(oSizePolicy);
 }
 
-static inline void delete_text_line(KviIrcViewLine * line, QMultiHash<KviIrcViewLine *, KviAnimatedPixmap *> * animatedSmiles)
+static inline void delete_text_line(KviIrcViewLine * line, KviIrcViewLineStore * store, QMultiHash<KviIrcViewLine *, KviAnimatedPixmap *> * animatedSmiles)
 {
 	QMultiHash<KviIrcViewLine *, KviAnimatedPixmap *>::iterator it = animatedSmiles->find(line);
 	while(it != animatedSmiles->end() && it.key() == line)
 	{
 		it = animatedSmiles->erase(it);
 	}
-	for(size_t i{}; i < line->uChunkCount; i++)
-	{
-		if((line->pChunks[i].type == KviControlCodes::Escape) || (line->pChunks[i].type == KviControlCodes::Icon))
-		{
-			if((line->pChunks[i].type == KviControlCodes::Icon) && (line->pChunks[i].szPayload != line->pChunks[i].szSmileId))
-				KviMemory::free(line->pChunks[i].szSmileId);
-			KviMemory::free(line->pChunks[i].szPayload);
-		}
-	}
-	KviMemory::free(line->pChunks); // free attributes data
-	if(line->iBlockCount)
-		KviMemory::free(line->pBlocks);
-	delete line;
+	KviIrcViewGlyphCache::instance()->drop(line);
+	store->freeLine(line); // the chunks, the text and the blocks go away with it
 }
 
 KviIrcView::~KviIrcView()
@@ -345,6 +370,9 @@ KviIrcView::~KviIrcView()
 	if(m_iMouseTimer)
 		killTimer(m_iMouseTimer);
 
+	if(m_bRepaintScheduled)
+		KviIrcViewRepaintScheduler::instance()->unschedule(this);
+
 	// and close the log file (flush!)
 	stopLogging();
 
@@ -360,19 +388,29 @@ KviIrcView::~KviIrcView()
 
 	// the pending ones too!
 	for(const auto & l : m_pMessagesStoppedWhileSelecting)
-		delete_text_line(l, &m_hAnimatedSmiles);
+		delete_text_line(l, m_pLineStore, &m_hAnimatedSmiles);
 
 	m_pMessagesStoppedWhileSelecting.clear();
 
+	delete m_pLineStore;
+
 	if(m_pFm)
 		delete m_pFm;
+	delete m_pCharWidthCache;
 
 	delete m_pToolTip;
 	delete m_pWrappedBlockSelectionInfo;
+
+	g_uIrcViewCount--;
+	if(!g_uIrcViewCount)
+		KviIrcViewGlyphCache::destroy();
 }
 
 void KviIrcView::showEvent(QShowEvent * e)
 {
+	if(m_uSnapshotLines)
+		loadSnapshot();
+
 	QWindow * pWin = topLevelWidget()->windowHandle();
 	if(!pWin)
 		return; // huh ?
@@ -397,6 +435,7 @@ void KviIrcView::setFont(const QFont & f)
 	if(m_pFm)
 	{
 		// force an update to the font variables
+		m_pCharWidthCache->setFontMetrics(nullptr);
 		delete m_pFm;
 		m_pFm = nullptr;
 	}
@@ -406,6 +445,9 @@ void KviIrcView::setFont(const QFont & f)
 		l->iMaxLineWidth = -1;
 		l = l->pNext;
 	}
+	// the next paint event will restart the re-wrap with the new metrics
+	stopRewrap();
+	m_iRewrapWidth = -1;
 
 	QFont newFont(f);
 	newFont.setKerning(false);
@@ -482,6 +524,10 @@ void KviIrcView::setPrivateBackgroundPixmap(const QPixmap & pixmap, bool bRepain
 
 void KviIrcView::emptyBuffer(bool bRepaint)
 {
+	// the lines of the previous session go away too
+	m_uSnapshotSkip = 0;
+	m_uSnapshotLines = 0;
+	m_szSnapshotFile.clear();
 	while(m_pLastLine != nullptr)
 		removeHeadLine();
 	if(bRepaint)
@@ -541,12 +587,12 @@ void KviIrcView::setTimestamp(bool bTimestamp)
 //	while(l){
 //		nLines++;
 //		nAlloc += sizeof(KviIrcViewLine);
-//		nStringBytes += l->data_len + 1;
-//		nAlloc += l->data_len + 1;
+//		nStringBytes += l->iTextLen * sizeof(QChar);
+//		nAlloc += l->iTextLen * sizeof(QChar);
 //		nAlloc += (l->uChunkCount * sizeof(KviIrcViewLineChunk));
 //		nAttrBytes +=(l->uChunkCount * sizeof(KviIrcViewLineChunk));
-//		nAlloc += (l->iBlockCount * sizeof(KviIrcViewLineChunk));
-//		nBlockBytes += (l->iBlockCount * sizeof(KviIrcViewLineChunk));
+//		nAlloc += (l->iBlockCount * sizeof(KviIrcViewWrappedBlock));
+//		nBlockBytes += (l->iBlockCount * sizeof(KviIrcViewWrappedBlock));
 //		nBlocks += (l->iBlockCount);
 //		nAttributes += (l->uChunkCount);
 //		l = l->pNext;
@@ -586,55 +632,46 @@ void KviIrcView::scrollBarPositionChanged(int newValue)
 		repaint();
 }
 
-void KviIrcView::postUpdateEvent()
+void KviIrcView::postUpdateEvent(int iNewLines)
 {
-	// This will post a QEvent with a full repaint request
-	if(!m_bPostedPaintEventPending)
-	{
-		m_bPostedPaintEventPending = true;
-		QEvent * e = new QEvent(QEvent::User);
-		g_pApp->postEvent(this, e); // queue a repaint
-	}
+	// The repaint is done in the next display frame, together with the other views
+	m_uPaintRequests++;
+	m_iUnprocessedPaintEventRequests += iNewLines; // paintEvent() will set it to 0
+	KviIrcViewRepaintScheduler::instance()->schedule(this);
+}
 
-	m_iUnprocessedPaintEventRequests++; // paintEvent() will set it to 0
+void KviIrcView::scheduledRepaint()
+{
+	if(!m_iUnprocessedPaintEventRequests)
+		return; // a full paint event already did the job
 
-	if(m_iUnprocessedPaintEventRequests == 3)
+	if(!isVisible() || visibleRegion().isEmpty() || window()->isMinimized())
 	{
-// Three unprocessed paint events...do it now
+		// Nobody would see it: the view gets a full paint event when shown again
+		m_uSkippedRepaints++;
+		return;
+	}
+
 #ifdef COMPILE_PSEUDO_TRANSPARENCY
-		if(!((KVI_OPTION_PIXMAP(KviOption_pixmapIrcViewBackground).pixmap()) || m_pPrivateBackgroundPixmap || g_pShadedChildGlobalDesktopBackground || KVI_OPTION_BOOL(KviOption_boolUseCompositingForTransparency)))
-			fastScroll(3);
+	if(!((KVI_OPTION_PIXMAP(KviOption_pixmapIrcViewBackground).pixmap()) || m_pPrivateBackgroundPixmap || g_pShadedChildGlobalDesktopBackground || KVI_OPTION_BOOL(KviOption_boolUseCompositingForTransparency)))
 #else
-		if(!((KVI_OPTION_PIXMAP(KviOption_pixmapIrcViewBackground).pixmap()) || m_pPrivateBackgroundPixmap))
-			fastScroll(3);
+	if(!((KVI_OPTION_PIXMAP(KviOption_pixmapIrcViewBackground).pixmap()) || m_pPrivateBackgroundPixmap))
 #endif
-		else
-			repaint();
-	}
+		fastScroll(m_iUnprocessedPaintEventRequests); // falls back to a full repaint if the new lines don't fit
+	else
+		update();
 }
 
-void KviIrcView::appendLine(KviIrcViewLine * ptr, const QDateTime & date, bool bRepaint)
+void KviIrcView::logAndIndexLine(KviIrcViewLine * ptr, const QDateTime & date)
 {
-	// This one appends a KviIrcViewLine to
-	// the buffer list (at the end)
-
-	if(m_bMouseIsDown)
-	{
-		// Do not move the view!
-		// So we append the text line to a temp queue
-		// and then we'll add it when the mouse button is released
-		m_pMessagesStoppedWhileSelecting.push_back(ptr);
-		return;
-	}
-
-	// First log the line and assign the index
+	// Log the line and assign the index
 	// Don't use add2log here!...we must go as fast as possible, so we avoid some push and pop calls, and also a couple of branches
 	if(m_pLogFile && KVI_OPTION_BOOL(KviOption_boolStripControlCodesInLogs))
 	{
 		// a slave view has no log files!
 		if(KVI_OPTION_MSGTYPE(ptr->iMsgType).logEnabled())
 		{
-			add2Log(ptr->szText, date, ptr->iMsgType, false);
+			add2Log(ptr->textString(), date, ptr->iMsgType, false);
 			// If we fail...this has been already reported!
 		}
 
@@ -657,7 +694,7 @@ void KviIrcView::appendLine(KviIrcViewLine * ptr, const QDateTime & date, bool b
 			if(m_pMasterView->m_pLogFile && KVI_OPTION_BOOL(KviOption_boolStripControlCodesInLogs))
 			{
 				if(KVI_OPTION_MSGTYPE(ptr->iMsgType).logEnabled())
-					m_pMasterView->add2Log(ptr->szText, date, ptr->iMsgType, false);
+					m_pMasterView->add2Log(ptr->textString(), date, ptr->iMsgType, false);
 			}
 			ptr->uIndex = m_pMasterView->m_uNextLineIndex;
 			m_pMasterView->m_uNextLineIndex++;
@@ -669,6 +706,24 @@ void KviIrcView::appendLine(KviIrcViewLine * ptr, const QDateTime & date, bool b
 		}
 	}
 
+}
+
+void KviIrcView::appendLine(KviIrcViewLine * ptr, const QDateTime & date, bool bRepaint)
+{
+	// This one appends a KviIrcViewLine to
+	// the buffer list (at the end)
+
+	if(m_bMouseIsDown)
+	{
+		// Do not move the view!
+		// So we append the text line to a temp queue
+		// and then we'll add it when the mouse button is released
+		m_pMessagesStoppedWhileSelecting.push_back(ptr);
+		return;
+	}
+
+	logAndIndexLine(ptr, date);
+
 	if(m_pLastLine)
 	{
 		// There is at least one line in the view
@@ -743,6 +798,10 @@ void KviIrcView::removeHeadLine(bool bRepaint)
 		return;
 	if(m_pFirstLine == m_pCursorLine)
 		m_pCursorLine = nullptr;
+	if(m_pFirstLine == m_pRewrapUpLine)
+		m_pRewrapUpLine = nullptr; // nothing above anyway
+	if(m_pFirstLine == m_pRewrapDownLine)
+		m_pRewrapDownLine = m_pFirstLine->pNext;
 
 	if(m_pFirstLine->pNext)
 	{
@@ -750,14 +809,14 @@ void KviIrcView::removeHeadLine(bool bRepaint)
 		aux_ptr->pPrev = nullptr;                       // becomes the first
 		if(m_pFirstLine == m_pCurLine)
 			m_pCurLine = aux_ptr;                       // move the cur line if necessary
-		delete_text_line(m_pFirstLine, &m_hAnimatedSmiles); // delete the struct
+		delete_text_line(m_pFirstLine, m_pLineStore, &m_hAnimatedSmiles); // delete the struct
 		m_pFirstLine = aux_ptr;                             // set the last
 		m_iNumLines--;                                      // and decrement the count
 	}
 	else
 	{	// unique line
 		m_pCurLine = nullptr;
-		delete_text_line(m_pFirstLine, &m_hAnimatedSmiles);
+		delete_text_line(m_pFirstLine, m_pLineStore, &m_hAnimatedSmiles);
 		m_pFirstLine = nullptr;
 		m_iNumLines = 0;
 		m_pLastLine = nullptr;
@@ -790,8 +849,58 @@ bool KviIrcView::messageShouldGoToMessageView(int iMsgType)
 	return false;
 }
 
+void KviIrcView::adoptLines(KviIrcView * pFrom)
+{
+	// the lines moved here from pFrom still live in its line store: copy them to ours
+	m_pLastLinkUnderMouse = nullptr;
+	pFrom->m_pLastLinkUnderMouse = nullptr;
+
+	for(KviIrcViewLine * l = m_pFirstLine; l; l = l->pNext)
+	{
+		if(m_pLineStore->owns(l))
+			continue;
+
+		KviIrcViewGlyphCache::instance()->drop(l);
+		QList<KviAnimatedPixmap *> lSmiles = pFrom->m_hAnimatedSmiles.values(l);
+		pFrom->m_hAnimatedSmiles.remove(l);
+		if(pFrom->m_pSelectionInitLine == l)
+			pFrom->m_pSelectionInitLine = nullptr;
+		if(pFrom->m_pSelectionEndLine == l)
+			pFrom->m_pSelectionEndLine = nullptr;
+
+		KviIrcViewLine * pNew = m_pLineStore->adoptLine(l);
+
+		for(auto & pSmile : lSmiles)
+		{
+			disconnect(pSmile, SIGNAL(frameChanged()), this, SLOT(animatedIconChange()));
+			connect(pSmile, SIGNAL(frameChanged()), this, SLOT(animatedIconChange()));
+			m_hAnimatedSmiles.insert(pNew, pSmile);
+		}
+
+		if(pNew->pPrev)
+			pNew->pPrev->pNext = pNew;
+		else
+			m_pFirstLine = pNew;
+		if(pNew->pNext)
+			pNew->pNext->pPrev = pNew;
+		else
+			m_pLastLine = pNew;
+		if(m_pCurLine == l)
+			m_pCurLine = pNew;
+		if(m_pCursorLine == l)
+			m_pCursorLine = pNew;
+		if(m_pSelectionInitLine == l)
+			m_pSelectionInitLine = pNew;
+		if(m_pSelectionEndLine == l)
+			m_pSelectionEndLine = pNew;
+		l = pNew;
+	}
+}
+
 void KviIrcView::splitMessagesTo(KviIrcView * v)
 {
+	stopRewrap();
+	v->stopRewrap();
 	v->emptyBuffer(false);
 
 	KviIrcViewLine * l = m_pFirstLine;
@@ -833,6 +942,8 @@ void KviIrcView::splitMessagesTo(KviIrcView * v)
 		}
 	}
 
+	v->adoptLines(this);
+
 	v->m_pCurLine = v->m_pLastLine;
 	m_pCurLine = m_pLastLine;
 
@@ -853,6 +964,9 @@ void KviIrcView::splitMessagesTo(KviIrcView * v)
 
 void KviIrcView::appendMessagesFrom(KviIrcView * v)
 {
+	stopRewrap();
+	v->stopRewrap();
+
 	if(!m_pLastLine)
 	{
 		m_pFirstLine = v->m_pFirstLine;
@@ -863,6 +977,7 @@ void KviIrcView::appendMessagesFrom(KviIrcView * v)
 		v->m_pFirstLine->pPrev = m_pLastLine;
 	}
 	m_pLastLine = v->m_pLastLine;
+	adoptLines(v);
 	m_pCurLine = m_pLastLine;
 	m_pCursorLine = nullptr;
 	v->m_pFirstLine = nullptr;
@@ -882,6 +997,9 @@ void KviIrcView::appendMessagesFrom(KviIrcView * v)
 
 void KviIrcView::joinMessagesFrom(KviIrcView * v)
 {
+	stopRewrap();
+	v->stopRewrap();
+
 	KviIrcViewLine * l1 = m_pFirstLine;
 	KviIrcViewLine * l2 = v->m_pFirstLine;
 	KviIrcViewLine * tmp;
@@ -930,6 +1048,8 @@ void KviIrcView::joinMessagesFrom(KviIrcView * v)
 		}
 	}
 
+	adoptLines(v);
+
 	m_pCurLine = m_pLastLine;
 	m_pCursorLine = nullptr;
 	v->m_pFirstLine = nullptr;
@@ -1012,6 +1132,13 @@ void KviIrcView::fastScroll(int lines)
 		}
 		else
 			lines = 0;
+
+		if(heightToPaint >= widgetHeight)
+		{
+			// the whole page changed: scrolling would gain nothing
+			update();
+			return;
+		}
 	}
 
 	scroll(0, -(heightToPaint - 1), QRect(1, 1, widgetWidth - 2, widgetHeight - 2));
@@ -1046,6 +1173,9 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 		return;                               // can't show stuff here
 	}
 
+	QElapsedTimer paintTimer;
+	paintTimer.start();
+
 	int scrollbarWidth = m_pScrollBar->width();
 	int toolWidgetHeight = (m_pToolWidget && m_pToolWidget->isVisible()) ? m_pToolWidget->sizeHint().height() : 0;
 	int widgetWidth = width() - scrollbarWidth;
@@ -1149,6 +1279,8 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 	// Make sure that we have enough space to paint something...
 	if(maxLineWidth < m_iMinimumPaintWidth)
 		pCurTextLine = nullptr;
+	else if(maxLineWidth != m_iRewrapWidth)
+		startRewrap(maxLineWidth); // the visible lines are wrapped below, the rest in the background
 
 	bool bLineMarkPainted = !KVI_OPTION_BOOL(KviOption_boolTrackLastReadTextViewLine);
 	int iLinesPerPage = 0;
@@ -1157,12 +1289,17 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 	while((curBottomCoord >= KVI_IRCVIEW_VERTICAL_BORDER) && pCurTextLine)
 	{
 		// Paint pCurTextLine
-		if(maxLineWidth != pCurTextLine->iMaxLineWidth)
+		if((maxLineWidth != pCurTextLine->iMaxLineWidth) || !pCurTextLine->pBlocks)
 		{
 			// Width of the widget or the font has been changed
 			// from the last time that this line was painted
+			// (or the line was far from the view and lost its blocks)
 			calculateLineWraps(pCurTextLine, maxLineWidth);
 		}
+		else
+		{
+			m_pLineStore->touchBlocks(pCurTextLine);
+		}
 
 		// the evil multiplication
 		// in an i486 it can get up to 42 clock cycles
@@ -1344,7 +1481,7 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 				pa.setPen(KVI_OPTION_COLOR(KviOption_colorIrcViewBackground));               \
 				break;                                                                       \
 			case KVI_COLOR_CUSTOM:                                                           \
-				pa.setPen(_custom);                                                          \
+				pa.setPen(QColor(_custom));                                                  \
 				break;                                                                       \
 			case KVI_COLOR_OWN:                                                              \
 				pa.setPen(KVI_OPTION_COLOR(KviOption_colorUserListViewOwnForeground));       \
@@ -1352,8 +1489,8 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 		}                                                                                    \
 	}
 
-#define DRAW_SELECTED_TEXT(_text_str, _text_idx, _text_len, _text_width)                                                                                                               \
-	SET_PEN(KVI_OPTION_MSGTYPE(KVI_OUT_SELECT).fore(), block->pChunk ? block->pChunk->customFore : QColor());                                                                          \
+#define DRAW_SELECTED_TEXT(_text_line, _text_idx, _text_len, _text_width)                                                                                                              \
+	SET_PEN(KVI_OPTION_MSGTYPE(KVI_OUT_SELECT).fore(), block->pChunk ? block->pChunk->customFore : 0);                                                                                 \
 	{                                                                                                                                                                                  \
 		float theWdth = _text_width;                                                                                                                                                     \
 		if(theWdth < 0)                                                                                                                                                                \
@@ -1364,13 +1501,13 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 	if (m_bUseRealBold)                                                                                                                                             \
 		pPenFont.setBold(curBold);                                                                                                                                  \
 	pa.setFont(pPenFont);                                                                                                                                           \
-	pa.drawText(curLeftCoord, curBottomCoord, _text_str.mid(_text_idx, _text_len));                                                                                 \
+	pa.drawText(curLeftCoord, curBottomCoord, _text_line->textMid(_text_idx, _text_len));                                                                           \
 	if(curBold && !m_bUseRealBold)                                                                                                                                  \
-		pa.drawText(curLeftCoord + 1, curBottomCoord, _text_str.mid(_text_idx, _text_len));                                                                         \
+		pa.drawText(curLeftCoord + 1, curBottomCoord, _text_line->textMid(_text_idx, _text_len));                                                                   \
 	curLeftCoord += _text_width;
 
-#define DRAW_NORMAL_TEXT(_text_str, _text_idx, _text_len, _text_width)                                                                                              \
-	SET_PEN(curFore, block->pChunk ? block->pChunk->customFore : QColor());                                                                                         \
+#define DRAW_NORMAL_TEXT(_text_line, _text_idx, _text_len, _text_width)                                                                                             \
+	SET_PEN(curFore, block->pChunk ? block->pChunk->customFore : 0);                                                                                                \
 	if(curBack != KviControlCodes::Transparent)                                                                                                                     \
 	{                                                                                                                                                               \
 		int theWdth = _text_width;                                                                                                                                  \
@@ -1382,9 +1519,9 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 	if (m_bUseRealBold)                                                                                                                                             \
 	    pPenFont.setBold(curBold);                                                                                                                                  \
 	pa.setFont(pPenFont);                                                                                                                                           \
-	pa.drawText(curLeftCoord, curBottomCoord, _text_str.mid(_text_idx, _text_len));                                                                                 \
+	pa.drawText(curLeftCoord, curBottomCoord, _text_line->textMid(_text_idx, _text_len));                                                                           \
 	if(curBold && !m_bUseRealBold)                                                                                                                                  \
-		pa.drawText(curLeftCoord + 1, curBottomCoord, _text_str.mid(_text_idx, _text_len));                                                                         \
+		pa.drawText(curLeftCoord + 1, curBottomCoord, _text_line->textMid(_text_idx, _text_len));                                                                   \
 	if(curUnderline)                                                                                                                                                \
 	{                                                                                                                                                               \
 		int theWdth = _text_width;                                                                                                                                  \
@@ -1412,33 +1549,33 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 					switch(m_pWrappedBlockSelectionInfo->selection_type)
 					{
 						case KVI_IRCVIEW_BLOCK_SELECTION_TOTAL:
-							DRAW_SELECTED_TEXT(pCurTextLine->szText, block->block_start,
+							DRAW_SELECTED_TEXT(pCurTextLine, block->block_start,
 							    block->block_len, block->block_width)
 							break;
 						case KVI_IRCVIEW_BLOCK_SELECTION_LEFT:
-							DRAW_SELECTED_TEXT(pCurTextLine->szText, block->block_start,
+							DRAW_SELECTED_TEXT(pCurTextLine, block->block_start,
 							    m_pWrappedBlockSelectionInfo->part_1_length,
 							    m_pWrappedBlockSelectionInfo->part_1_width)
-							DRAW_NORMAL_TEXT(pCurTextLine->szText, block->block_start + m_pWrappedBlockSelectionInfo->part_1_length,
+							DRAW_NORMAL_TEXT(pCurTextLine, block->block_start + m_pWrappedBlockSelectionInfo->part_1_length,
 							    m_pWrappedBlockSelectionInfo->part_2_length,
 							    m_pWrappedBlockSelectionInfo->part_2_width)
 							break;
 						case KVI_IRCVIEW_BLOCK_SELECTION_RIGHT:
-							DRAW_NORMAL_TEXT(pCurTextLine->szText, block->block_start,
+							DRAW_NORMAL_TEXT(pCurTextLine, block->block_start,
 							    m_pWrappedBlockSelectionInfo->part_1_length,
 							    m_pWrappedBlockSelectionInfo->part_1_width)
-							DRAW_SELECTED_TEXT(pCurTextLine->szText, block->block_start + m_pWrappedBlockSelectionInfo->part_1_length,
+							DRAW_SELECTED_TEXT(pCurTextLine, block->block_start + m_pWrappedBlockSelectionInfo->part_1_length,
 							    m_pWrappedBlockSelectionInfo->part_2_length,
 							    m_pWrappedBlockSelectionInfo->part_2_width)
 							break;
 						case KVI_IRCVIEW_BLOCK_SELECTION_CENTRAL:
-							DRAW_NORMAL_TEXT(pCurTextLine->szText, block->block_start,
+							DRAW_NORMAL_TEXT(pCurTextLine, block->block_start,
 							    m_pWrappedBlockSelectionInfo->part_1_length,
 							    m_pWrappedBlockSelectionInfo->part_1_width)
-							DRAW_SELECTED_TEXT(pCurTextLine->szText, block->block_start + m_pWrappedBlockSelectionInfo->part_1_length,
+							DRAW_SELECTED_TEXT(pCurTextLine, block->block_start + m_pWrappedBlockSelectionInfo->part_1_length,
 							    m_pWrappedBlockSelectionInfo->part_2_length,
 							    m_pWrappedBlockSelectionInfo->part_2_width)
-							DRAW_NORMAL_TEXT(pCurTextLine->szText, block->block_start + m_pWrappedBlockSelectionInfo->part_1_length + m_pWrappedBlockSelectionInfo->part_2_length,
+							DRAW_NORMAL_TEXT(pCurTextLine, block->block_start + m_pWrappedBlockSelectionInfo->part_1_length + m_pWrappedBlockSelectionInfo->part_2_length,
 							    m_pWrappedBlockSelectionInfo->part_3_length,
 							    m_pWrappedBlockSelectionInfo->part_3_width)
 							break;
@@ -1471,7 +1608,7 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 						}
 						// else simply a zero characters block
 					}
-					DRAW_NORMAL_TEXT(pCurTextLine->szText, block->block_start, block->block_len, wdth)
+					DRAW_NORMAL_TEXT(pCurTextLine, block->block_start, block->block_len, wdth)
 				}
 			}
 			else
@@ -1490,7 +1627,7 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 						pa.fillRect(curLeftCoord, curBottomCoord - m_iFontLineSpacing + m_iFontDescent, wdth, m_iFontLineSpacing, getMircColor((unsigned char)curBack));
 					}
 					QString tmpQ;
-					tmpQ.setUtf16(block->pChunk->szSmileId, kvi_wstrlen(block->pChunk->szSmileId));
+					tmpQ.setUtf16(pCurTextLine->smileId(block->pChunk), kvi_wstrlen(pCurTextLine->smileId(block->pChunk)));
 					QPixmap * daIcon = nullptr;
 					KviTextIcon * pIcon = g_pTextIconManager->lookupTextIcon(tmpQ);
 					if(pIcon)
@@ -1520,7 +1657,7 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 
 					// FIXME: We could avoid this XSetForeground if the curFore was not changed....
 
-					SET_PEN(curFore, block->pChunk ? block->pChunk->customFore : QColor());
+					SET_PEN(curFore, block->pChunk ? block->pChunk->customFore : 0);
 
 					if(curBack != KviControlCodes::Transparent && curBack <= KVI_EXTCOLOR_MAX)
 					{
@@ -1537,16 +1674,24 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 
 					if(curLink)
 					{
-						SET_PEN(KVI_OPTION_MSGTYPE(KVI_OUT_LINK).fore(), block->pChunk ? block->pChunk->customFore : QColor());
+						SET_PEN(KVI_OPTION_MSGTYPE(KVI_OUT_LINK).fore(), block->pChunk ? block->pChunk->customFore : 0);
 						pa.drawLine(curLeftCoord, curBottomCoord + 2, curLeftCoord + wdth, curBottomCoord + 2);
 					}
 
-					pa.drawText(curLeftCoord, curBottomCoord, pCurTextLine->szText.mid(block->block_start, block->block_len));
-
-					if (bBold && !m_bUseRealBold)
+					if(block->block_len > 0)
 					{
-						// Draw doubled font (simulate bold)
-						pa.drawText(curLeftCoord + 1, curBottomCoord, pCurTextLine->szText.mid(block->block_start, block->block_len));
+						// reuse the text shaped by the previous paint events
+						const QStaticText & t = KviIrcViewGlyphCache::instance()->blockText(pCurTextLine, i);
+						// static text is positioned by its top left corner
+						QPointF pt(curLeftCoord, curBottomCoord - m_fFontAscent[((newFont.style() == QFont::StyleItalic) ? 1 : 0) | ((m_bUseRealBold && bBold) ? 2 : 0)]);
+						pa.drawStaticText(pt, t);
+
+						if(bBold && !m_bUseRealBold)
+						{
+							// Draw doubled font (simulate bold)
+							pt.rx() += 1;
+							pa.drawStaticText(pt, t);
+						}
 					}
 					if(curUnderline)
 					{
@@ -1679,6 +1824,23 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 	widgetWidth--;
 	pa.drawLine(1, widgetHeight - 1, widgetWidth, widgetHeight - 1);
 	pa.drawLine(widgetWidth, 1, widgetWidth, widgetHeight);
+
+	trimWrappedBlocks();
+
+	qint64 iSecond = paintTimer.msecsSinceReference() / 1000;
+	if(iSecond != m_iPaintRateSecond)
+	{
+		m_uPaintRate = (iSecond == m_iPaintRateSecond + 1) ? m_uPaintsInSecond : 0;
+		m_uPaintsInSecond = 0;
+		m_iPaintRateSecond = iSecond;
+	}
+	m_uPaintsInSecond++;
+
+	qint64 iElapsed = paintTimer.nsecsElapsed();
+	m_uPaintCount++;
+	m_iPaintTime += iElapsed;
+	if(KviIrcViewRepaintScheduler::exists())
+		KviIrcViewRepaintScheduler::instance()->paintDone(iElapsed);
 }
 
 //
@@ -1687,7 +1849,241 @@ void KviIrcView::paintEvent(QPaintEvent * p)
 
 #define IRCVIEW_ISHIGHSURROGATE(c) ((c).unicode() >= 0xD800 && (c).unicode() <= 0xDBFF)
 #define IRCVIEW_ISLOWSURROGATE(c) ((c).unicode() >= 0xDC00 && (c).unicode() <= 0xDFFF)
-#define IRCVIEW_WCHARWIDTH(c) (((c).unicode() < 0xff) ? m_iFontCharacterWidth[(c).unicode()] : m_pFm->horizontalAdvance(c))
+#define IRCVIEW_WCHARWIDTH(c) (((c).unicode() < 0xff) ? m_iFontCharacterWidth[(c).unicode()] : m_pCharWidthCache->width((c).unicode()))
+// p must point to a high surrogate
+#define IRCVIEW_SURROGATEPAIRWIDTH(p) m_pCharWidthCache->width(QChar::surrogateToUcs4(*(p), *((p) + 1)))
+
+KviIrcViewGlyphCache::KviIrcViewGlyphCache()
+{
+	m_pNewest = nullptr;
+	m_pOldest = nullptr;
+	m_uBytes = 0;
+	m_uHits = 0;
+	m_uMisses = 0;
+	m_uEvictions = 0;
+}
+
+KviIrcViewGlyphCache::~KviIrcViewGlyphCache()
+{
+	while(m_pOldest)
+		remove(m_pOldest);
+}
+
+KviIrcViewGlyphCache * KviIrcViewGlyphCache::m_pInstance = nullptr;
+
+KviIrcViewGlyphCache * KviIrcViewGlyphCache::instance()
+{
+	// shared by all the views
+	if(!m_pInstance)
+		m_pInstance = new KviIrcViewGlyphCache();
+	return m_pInstance;
+}
+
+void KviIrcViewGlyphCache::destroy()
+{
+	delete m_pInstance;
+	m_pInstance = nullptr;
+}
+
+void KviIrcViewGlyphCache::unlink(KviIrcViewLineGlyphCache * c)
+{
+	if(c->pNewer)
+		c->pNewer->pOlder = c->pOlder;
+	else
+		m_pNewest = c->pOlder;
+	if(c->pOlder)
+		c->pOlder->pNewer = c->pNewer;
+	else
+		m_pOldest = c->pNewer;
+}
+
+void KviIrcViewGlyphCache::linkAsNewest(KviIrcViewLineGlyphCache * c)
+{
+	c->pNewer = nullptr;
+	c->pOlder = m_pNewest;
+	if(m_pNewest)
+		m_pNewest->pNewer = c;
+	else
+		m_pOldest = c;
+	m_pNewest = c;
+}
+
+void KviIrcViewGlyphCache::remove(KviIrcViewLineGlyphCache * c)
+{
+	unlink(c);
+	m_uBytes -= c->uBytes;
+	c->pLine->pGlyphCache = nullptr;
+	delete c;
+}
+
+const QStaticText & KviIrcViewGlyphCache::blockText(KviIrcViewLine * pLine, int iBlock)
+{
+	KviIrcViewLineGlyphCache * c = pLine->pGlyphCache;
+
+	if(c && (c->iMaxLineWidth != pLine->iMaxLineWidth))
+	{
+		// wrapped again without telling us
+		remove(c);
+		c = nullptr;
+	}
+
+	if(c)
+	{
+		if(c != m_pNewest)
+		{
+			unlink(c);
+			linkAsNewest(c);
+		}
+	}
+	else
+	{
+		c = new KviIrcViewLineGlyphCache;
+		c->pLine = pLine;
+		c->iMaxLineWidth = pLine->iMaxLineWidth;
+		c->vBlocks.resize(pLine->iBlockCount);
+		c->uBytes = sizeof(KviIrcViewLineGlyphCache) + (pLine->iBlockCount * sizeof(QStaticText));
+		m_uBytes += c->uBytes;
+		pLine->pGlyphCache = c;
+		linkAsNewest(c);
+	}
+
+	QStaticText & t = c->vBlocks[iBlock];
+	if(!t.text().isEmpty())
+	{
+		m_uHits++;
+		return t;
+	}
+
+	m_uMisses++;
+
+	KviIrcViewWrappedBlock * block = &(pLine->pBlocks[iBlock]);
+	t.setTextFormat(Qt::PlainText);
+	t.setText(pLine->textMid(block->block_start, block->block_len));
+
+	// a rough estimate of the layout data: glyph indexes, positions and the item
+	std::size_t uBytes = 64 + (block->block_len * 32);
+	c->uBytes += uBytes;
+	m_uBytes += uBytes;
+
+	// never evict the line we're returning the text of
+	while((m_uBytes > KVI_IRCVIEW_GLYPH_CACHE_BUDGET) && (m_pOldest != c))
+	{
+		m_uEvictions++;
+		remove(m_pOldest);
+	}
+
+	return t;
+}
+
+void KviIrcView::glyphCacheStatistics(kvi_u64_t & uHits, kvi_u64_t & uMisses, kvi_u64_t & uEvictions, kvi_u64_t & uBytes)
+{
+	if(!KviIrcViewGlyphCache::exists())
+	{
+		uHits = uMisses = uEvictions = uBytes = 0;
+		return;
+	}
+	KviIrcViewGlyphCache * c = KviIrcViewGlyphCache::instance();
+	uHits = c->hits();
+	uMisses = c->misses();
+	uEvictions = c->evictions();
+	uBytes = c->bytes();
+}
+
+KviIrcViewRepaintScheduler * KviIrcViewRepaintScheduler::m_pInstance = nullptr;
+
+KviIrcViewRepaintScheduler::KviIrcViewRepaintScheduler()
+    : QObject(g_pApp)
+{
+	m_pInstance = this;
+	m_iTimer = 0;
+	m_iFrameInterval = displayFrameInterval();
+	m_iFramePaintTime = 0;
+	m_LastFrame.start();
+}
+
+KviIrcViewRepaintScheduler::~KviIrcViewRepaintScheduler()
+{
+	if(m_iTimer)
+		killTimer(m_iTimer);
+	for(auto v : m_vDirty)
+		v->m_bRepaintScheduled = false;
+	m_pInstance = nullptr;
+}
+
+KviIrcViewRepaintScheduler * KviIrcViewRepaintScheduler::instance()
+{
+	if(!m_pInstance)
+		(void)new KviIrcViewRepaintScheduler();
+	return m_pInstance;
+}
+
+int KviIrcViewRepaintScheduler::displayFrameInterval()
+{
+	QScreen * pScreen = g_pMainWindow ? g_pMainWindow->screen() : QGuiApplication::primaryScreen();
+	qreal fRate = pScreen ? pScreen->refreshRate() : 0.0;
+	if(fRate < 1.0)
+		fRate = 60.0; // unknown: assume the usual display
+	return qMax(1, qRound(1000.0 / fRate));
+}
+
+void KviIrcViewRepaintScheduler::schedule(KviIrcView * v)
+{
+	if(v->m_bRepaintScheduled)
+		return;
+	v->m_bRepaintScheduled = true;
+	m_vDirty.push_back(v);
+
+	if(m_iTimer)
+		return;
+
+	// keep the pace: the next frame comes one interval after the previous one
+	qint64 iDelay = m_iFrameInterval - m_LastFrame.elapsed();
+	m_iTimer = startTimer(iDelay > 0 ? (int)iDelay : 0, Qt::PreciseTimer);
+}
+
+void KviIrcViewRepaintScheduler::unschedule(KviIrcView * v)
+{
+	if(!v->m_bRepaintScheduled)
+		return;
+	v->m_bRepaintScheduled = false;
+	m_vDirty.erase(std::remove(m_vDirty.begin(), m_vDirty.end(), v), m_vDirty.end());
+}
+
+void KviIrcViewRepaintScheduler::timerEvent(QTimerEvent * e)
+{
+	if(e->timerId() != m_iTimer)
+	{
+		QObject::timerEvent(e);
+		return;
+	}
+
+	killTimer(m_iTimer);
+	m_iTimer = 0;
+	m_LastFrame.restart();
+
+	// Painting should take at most half of the time between two frames:
+	// if it takes more then the inflow is higher than what we can show
+	// and we slow down, batching more lines in each repaint.
+	int iDisplayInterval = displayFrameInterval();
+	int iPaintMSecs = (int)(m_iFramePaintTime / 1000000);
+	m_iFramePaintTime = 0;
+	m_iFrameInterval = qBound(iDisplayInterval, 2 * iPaintMSecs, KVI_IRCVIEW_MAX_REPAINT_INTERVAL);
+
+	std::vector<KviIrcView *> vDirty;
+	vDirty.swap(m_vDirty);
+	for(auto v : vDirty)
+	{
+		v->m_bRepaintScheduled = false;
+		v->scheduledRepaint();
+	}
+}
+
+int KviIrcView::repaintFrameInterval()
+{
+	if(!KviIrcViewRepaintScheduler::exists())
+		return 0;
+	return KviIrcViewRepaintScheduler::instance()->frameInterval();
+}
 
 void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
 {
@@ -1695,10 +2091,9 @@ void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
 	if(maxWidth <= m_iIconWidth)
 		return;
 
-	if(ptr->iBlockCount != 0)
-		KviMemory::free(ptr->pBlocks); // free any previous wrap blocks
+	KviIrcViewGlyphCache::instance()->drop(ptr); // the shaped blocks are no longer valid
 
-	ptr->pBlocks = (KviIrcViewWrappedBlock *)KviMemory::allocate(sizeof(KviIrcViewWrappedBlock)); // alloc one block
+	m_pLineStore->allocateBlocks(ptr, 1);                                                         // alloc one block (reusing any previous ones)
 	ptr->iMaxLineWidth = maxWidth;                                                                // calculus for this width
 	ptr->iBlockCount = 0;                                                                         // it will be ++
 	ptr->uLineWraps = 0;                                                                          // no line wraps yet
@@ -1714,7 +2109,7 @@ void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
 
 	int maxBlockLen = ptr->pChunks->iTextLen; // ptr->pChunks[0].iTextLen
 
-	const QChar * unicode = ptr->szText.unicode();
+	const QChar * unicode = ptr->text();
 
 	for(;;)
 	{
@@ -1736,7 +2131,7 @@ void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
 				if(IRCVIEW_ISHIGHSURROGATE(*p) && curBlockLen < maxBlockLen - 1)
 				{
 					// extract and calculate width of both chars together
-					curBlockWidth += m_pFm->horizontalAdvance(QString(p, 2));
+					curBlockWidth += IRCVIEW_SURROGATEPAIRWIDTH(p);
 					curBlockLen += 2;
 					p += 2;
 				} else {
@@ -1763,7 +2158,7 @@ void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
 				return;
 
 			// Process the next block of data in the next loop
-			ptr->pBlocks = (KviIrcViewWrappedBlock *)KviMemory::reallocate(ptr->pBlocks, (ptr->iBlockCount + 1) * sizeof(KviIrcViewWrappedBlock));
+			m_pLineStore->allocateBlocks(ptr, ptr->iBlockCount + 1);
 			ptr->pBlocks[ptr->iBlockCount].block_start = ptr->pChunks[curAttrBlock].iTextStart;
 			ptr->pBlocks[ptr->iBlockCount].block_len = 0;
 			ptr->pBlocks[ptr->iBlockCount].block_width = 0;
@@ -1784,7 +2179,7 @@ void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
 				// avoid splitting in the middle of a surrogate pair
 				p--;
 				curBlockLen--;
-				curLineWidth -= m_pFm->horizontalAdvance(QString(p, 2));
+				curLineWidth -= IRCVIEW_SURROGATEPAIRWIDTH(p);
 			} else {
 				curLineWidth -= IRCVIEW_WCHARWIDTH(*p);
 			}
@@ -1800,7 +2195,7 @@ void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
 				// avoid splitting in the middle of a surrogate pair
 				p--;
 				curBlockLen--;
-				curLineWidth -= m_pFm->horizontalAdvance(QString(p, 2));
+				curLineWidth -= IRCVIEW_SURROGATEPAIRWIDTH(p);
 			} else {
 				curLineWidth -= IRCVIEW_WCHARWIDTH(*p);
 			}
@@ -1817,7 +2212,7 @@ void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
 				ptr->pBlocks[ptr->iBlockCount].pChunk = nullptr;
 				ptr->pBlocks[ptr->iBlockCount].block_width = 0;
 				ptr->iBlockCount++;
-				ptr->pBlocks = (KviIrcViewWrappedBlock *)KviMemory::reallocate(ptr->pBlocks, (ptr->iBlockCount + 1) * sizeof(KviIrcViewWrappedBlock));
+				m_pLineStore->allocateBlocks(ptr, ptr->iBlockCount + 1);
 				ptr->pBlocks[ptr->iBlockCount].block_start = p - unicode;
 				ptr->pBlocks[ptr->iBlockCount].block_len = 0;
 				ptr->pBlocks[ptr->iBlockCount].block_width = 0;
@@ -1838,7 +2233,7 @@ void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
 					if(IRCVIEW_ISHIGHSURROGATE(*p) && curBlockLen < maxBlockLen - 1)
 					{
 						// extract and calculate width of both chars together
-						curLineWidth += m_pFm->horizontalAdvance(QString(p, 2));
+						curLineWidth += IRCVIEW_SURROGATEPAIRWIDTH(p);
 						// add the second char
 						p++;
 						curBlockLen++;
@@ -1871,7 +2266,7 @@ void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
 		ptr->pBlocks[ptr->iBlockCount].block_width = -1; // word wrap --> negative block_width
 		maxBlockLen -= curBlockLen;
 		ptr->iBlockCount++;
-		ptr->pBlocks = (KviIrcViewWrappedBlock *)KviMemory::reallocate(ptr->pBlocks, (ptr->iBlockCount + 1) * sizeof(KviIrcViewWrappedBlock));
+		m_pLineStore->allocateBlocks(ptr, ptr->iBlockCount + 1);
 		ptr->pBlocks[ptr->iBlockCount].block_start = p - unicode;
 		ptr->pBlocks[ptr->iBlockCount].block_len = 0;
 		ptr->pBlocks[ptr->iBlockCount].block_width = 0;
@@ -1897,6 +2292,135 @@ void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
 	ptr->iBlockCount++;
 }
 
+//
+// The IrcView : wrapped blocks cache
+//
+// The blocks take more memory than the text itself: only the lines
+// around the view keep them. The others keep just the number of wraps
+// (that is what scrolling needs) and get their blocks again when shown.
+//
+
+static void drop_wrapped_blocks(KviIrcViewLine * l, KviIrcViewLineStore * pStore, KviIrcViewWrappedBlock *& pLastLinkUnderMouse)
+{
+	if(!l->pBlocks)
+		return;
+	if(pLastLinkUnderMouse && (pLastLinkUnderMouse >= l->pBlocks) && (pLastLinkUnderMouse < (l->pBlocks + l->iBlockCount)))
+		pLastLinkUnderMouse = nullptr;
+	KviIrcViewGlyphCache::instance()->drop(l);
+	pStore->freeBlocks(l);
+}
+
+unsigned int KviIrcView::wrappedBlocksCacheLines()
+{
+	// a few pages: scrolling back and forth shouldn't wrap the same lines again
+	unsigned int uRows = (m_iFontLineSpacing > 0) ? (height() / m_iFontLineSpacing) : 0;
+	return qMax((unsigned int)KVI_IRCVIEW_WRAPPED_BLOCKS_CACHE_LINES, 2 * uRows);
+}
+
+bool KviIrcView::ensureWrappedBlocks(KviIrcViewLine * ptr)
+{
+	if(!ptr->pBlocks && (ptr->iMaxLineWidth > 0))
+		calculateLineWraps(ptr, ptr->iMaxLineWidth);
+	return ptr->pBlocks && ptr->iBlockCount;
+}
+
+void KviIrcView::trimWrappedBlocks()
+{
+	// the painted lines have just been touched: the least recently used
+	// ones are those far from the view (only the lines with blocks are walked)
+	unsigned int uKeep = wrappedBlocksCacheLines();
+	if(m_pLineStore->blockLines() <= (2 * uKeep))
+		return;
+	while(m_pLineStore->blockLines() > uKeep)
+		drop_wrapped_blocks(m_pLineStore->oldestBlockLine(), m_pLineStore, m_pLastLinkUnderMouse);
+}
+
+//
+// The IrcView : background re-wrap
+//
+// When the width or the font changes only the visible lines are wrapped
+// synchronously in paintEvent(). The rest of the buffer is re-wrapped
+// here in small time slices, going away from the current line
+// in both directions, so later scrolls and jumps find it ready.
+//
+
+void KviIrcView::startRewrap(int maxWidth)
+{
+	m_iRewrapWidth = maxWidth;
+	if(!m_pCurLine)
+	{
+		stopRewrap();
+		return;
+	}
+	m_pRewrapUpLine = m_pCurLine;
+	m_pRewrapDownLine = m_pCurLine->pNext;
+	m_uRewrapDistance = 0;
+	m_pRewrapTimer->start();
+}
+
+void KviIrcView::stopRewrap()
+{
+	m_pRewrapTimer->stop();
+	m_pRewrapUpLine = nullptr;
+	m_pRewrapDownLine = nullptr;
+}
+
+void KviIrcView::rewrapStep()
+{
+	// hidden views will restart from scratch in their next paint event
+	if(!m_pFm || !isVisible())
+	{
+		stopRewrap();
+		m_iRewrapWidth = -1;
+		return;
+	}
+
+	QElapsedTimer t;
+	t.start();
+
+	int iCount = 0;
+	unsigned int uKeep = wrappedBlocksCacheLines();
+
+	while(m_pRewrapUpLine || m_pRewrapDownLine)
+	{
+		// the lines far from the view need only the number of wraps
+		bool bKeepBlocks = (m_uRewrapDistance < uKeep);
+
+		// scrolling back in the history is far more common than scrolling down
+		// from a line in the middle: give the upper part twice the attention
+		for(int i = 0; (i < 2) && m_pRewrapUpLine; i++)
+		{
+			if(m_pRewrapUpLine->iMaxLineWidth != m_iRewrapWidth)
+			{
+				calculateLineWraps(m_pRewrapUpLine, m_iRewrapWidth);
+				if(!bKeepBlocks)
+					drop_wrapped_blocks(m_pRewrapUpLine, m_pLineStore, m_pLastLinkUnderMouse);
+			}
+			m_pRewrapUpLine = m_pRewrapUpLine->pPrev;
+		}
+
+		if(m_pRewrapDownLine)
+		{
+			if(m_pRewrapDownLine->iMaxLineWidth != m_iRewrapWidth)
+			{
+				calculateLineWraps(m_pRewrapDownLine, m_iRewrapWidth);
+				if(!bKeepBlocks)
+					drop_wrapped_blocks(m_pRewrapDownLine, m_pLineStore, m_pLastLinkUnderMouse);
+			}
+			m_pRewrapDownLine = m_pRewrapDownLine->pNext;
+		}
+
+		m_uRewrapDistance++;
+		iCount++;
+		if(((iCount & 15) == 0) && (t.elapsed() >= KVI_IRCVIEW_REWRAP_SLICE))
+		{
+			// give the event loop a chance to run
+			m_pRewrapTimer->start();
+			return;
+		}
+	}
+}
+
 //
 // checkSelectionBlock
 //
@@ -1904,7 +2428,7 @@ void KviIrcView::calculateLineWraps(KviIrcViewLine * ptr, int maxWidth)
 bool KviIrcView::checkSelectionBlock(KviIrcViewLine * line, int bufIndex)
 {
 	// Checks if the specified chunk in the specified ircviewline is part of the current selection
-	const QChar * unicode = line->szText.unicode();
+	const QChar * unicode = line->text();
 	const QChar * p = unicode + line->pBlocks[bufIndex].block_start;
 
 	if(!m_pSelectionInitLine || !m_pSelectionEndLine)
@@ -1983,7 +2507,7 @@ bool KviIrcView::checkSelectionBlock(KviIrcViewLine * line, int bufIndex)
 				if(IRCVIEW_ISHIGHSURROGATE(*p) && i < m_pWrappedBlockSelectionInfo->part_1_length - 1)
 				{
 					// extract and calculate width of both chars together
-					www = m_pFm->horizontalAdvance(QString(p, 2));
+					www = IRCVIEW_SURROGATEPAIRWIDTH(p);
 					p += 2;
 					i++;
 				} else {
@@ -1999,7 +2523,7 @@ bool KviIrcView::checkSelectionBlock(KviIrcViewLine * line, int bufIndex)
 				if(IRCVIEW_ISHIGHSURROGATE(*p) && i < m_pWrappedBlockSelectionInfo->part_2_length - 1)
 				{
 					// extract and calculate width of both chars together
-					www = m_pFm->horizontalAdvance(QString(p, 2));
+					www = IRCVIEW_SURROGATEPAIRWIDTH(p);
 					p += 2;
 					i++;
 				} else {
@@ -2025,7 +2549,7 @@ bool KviIrcView::checkSelectionBlock(KviIrcViewLine * line, int bufIndex)
 				if(IRCVIEW_ISHIGHSURROGATE(*p) && i < m_pWrappedBlockSelectionInfo->part_1_length - 1)
 				{
 					// extract and calculate width of both chars together
-					www = m_pFm->horizontalAdvance(QString(p, 2));
+					www = IRCVIEW_SURROGATEPAIRWIDTH(p);
 					p += 2;
 					i++;
 				} else {
@@ -2052,7 +2576,7 @@ bool KviIrcView::checkSelectionBlock(KviIrcViewLine * line, int bufIndex)
 				if(IRCVIEW_ISHIGHSURROGATE(*p) && i < m_pWrappedBlockSelectionInfo->part_1_length - 1)
 				{
 					// extract and calculate width of both chars together
-					www = m_pFm->horizontalAdvance(QString(p, 2));
+					www = IRCVIEW_SURROGATEPAIRWIDTH(p);
 					p += 2;
 					i++;
 				} else {
@@ -2106,7 +2630,7 @@ bool KviIrcView::checkSelectionBlock(KviIrcViewLine * line, int bufIndex)
 				if(IRCVIEW_ISHIGHSURROGATE(*p) && i < m_pWrappedBlockSelectionInfo->part_1_length - 1)
 				{
 					// extract and calculate width of both chars together
-					www = m_pFm->horizontalAdvance(QString(p, 2));
+					www = IRCVIEW_SURROGATEPAIRWIDTH(p);
 					p += 2;
 					i++;
 				} else {
@@ -2161,7 +2685,7 @@ bool KviIrcView::checkSelectionBlock(KviIrcViewLine * line, int bufIndex)
 				if(IRCVIEW_ISHIGHSURROGATE(*p) && i < m_pWrappedBlockSelectionInfo->part_1_length - 1)
 				{
 					// extract and calculate width of both chars together
-					www = m_pFm->horizontalAdvance(QString(p, 2));
+					www = IRCVIEW_SURROGATEPAIRWIDTH(p);
 					p += 2;
 					i++;
 				} else {
@@ -2190,6 +2714,7 @@ void KviIrcView::recalcFontVariables(const QFont & font, const QFontInfo & fi)
 		delete m_pFm;
 
 	m_pFm = new QFontMetricsF(font);
+	m_pCharWidthCache->setFontMetrics(m_pFm);
 
 	m_iFontLineSpacing = m_pFm->lineSpacing();
 
@@ -2221,6 +2746,16 @@ void KviIrcView::recalcFontVariables(const QFont & font, const QFontInfo & fi)
 		//printf("m_bUseRealBold = %d\n", m_bUseRealBold);
 	}
 
+	// QStaticText is drawn by its top left corner: we need the ascent of the variants we paint with
+	for(int i = 0; i < 4; i++)
+	{
+		QFont variant(font);
+		variant.setStyle((i & 1) ? QFont::StyleItalic : QFont::StyleNormal);
+		if(m_bUseRealBold)
+			variant.setBold(i & 2);
+		m_fFontAscent[i] = QFontMetricsF(variant).ascent();
+	}
+
 	// fix for #489 (horizontal tabulations)
 	m_iFontCharacterWidth[9] = m_pFm->horizontalAdvance("\t");
 
@@ -2542,11 +3077,11 @@ void KviIrcView::findNext(const QString & szText, bool bCaseS, bool bRegExp, boo
 			if(bRegExp)
 			{
 				KviRegExp re(szText, bCaseS ? KviRegExp::CaseSensitive : KviRegExp::CaseInsensitive, bExtended ? KviRegExp::RegExp : KviRegExp::Wildcard);
-				idx = re.indexIn(l->szText, 0);
+				idx = re.indexIn(l->textString(), 0);
 			}
 			else
 			{
-				QString tmp = l->szText;
+				QString tmp = l->textString();
 				idx = tmp.indexOf(szText, 0, bCaseS ? Qt::CaseSensitive : Qt::CaseInsensitive);
 			}
 
@@ -2601,11 +3136,11 @@ void KviIrcView::findPrev(const QString & szText, bool bCaseS, bool bRegExp, boo
 			if(bRegExp)
 			{
 				KviRegExp re(szText, bCaseS ? KviRegExp::CaseSensitive : KviRegExp::CaseInsensitive, bExtended ? KviRegExp::RegExp : KviRegExp::Wildcard);
-				idx = re.indexIn(l->szText, 0);
+				idx = re.indexIn(l->textString(), 0);
 			}
 			else
 			{
-				QString tmp = l->szText;
+				QString tmp = l->textString();
 				idx = tmp.indexOf(szText, 0, bCaseS ? Qt::CaseSensitive : Qt::CaseInsensitive);
 			}
 
@@ -2688,6 +3223,10 @@ int KviIrcView::getVisibleCharIndexAt(KviIrcViewLine *, int xPos, int yPos)
 			continue;
 		}
 
+		// the line may have lost its blocks meanwhile
+		if(!ensureWrappedBlocks(l))
+			return -1;
+
 		/*
 		 * Profane description: if we are here we have found the right line where our mouse is over; l is the KviIrcViewLine *,
 		 * iTop is the line start y coordinate. Now we have to go through this line's text and find the exact text under the mouse.
@@ -2737,7 +3276,7 @@ int KviIrcView::getVisibleCharIndexAt(KviIrcViewLine *, int xPos, int yPos)
 					return 0; // Mouse is out of this row boundaries
 
 				if(i >= l->iBlockCount)
-					return l->szText.size();
+					return l->iTextLen;
 
 				// run up to the chunk containing the mouse position
 				for(; iLeft + l->pBlocks[i].block_width < xPos;)
@@ -2753,7 +3292,7 @@ int KviIrcView::getVisibleCharIndexAt(KviIrcViewLine *, int xPos, int yPos)
 					}
 					i++;
 					if(i >= l->iBlockCount)
-						return l->szText.size();
+						return l->iTextLen;
 				}
 				// now, get the right character inside the block
 				int retValue = 0, oldIndex = 0, oldLeft = iLeft;
@@ -2763,15 +3302,15 @@ int KviIrcView::getVisibleCharIndexAt(KviIrcViewLine *, int xPos, int yPos)
 				{
 					oldIndex = retValue; oldLeft = iLeft;
 
-					curChar = l->szText.at(l->pBlocks[i].block_start + retValue);
+					curChar = l->text()[l->pBlocks[i].block_start + retValue];
 					if (IRCVIEW_ISHIGHSURROGATE(curChar)) // Surrogate pair
 					{
-						iLeft += m_pFm->horizontalAdvance(l->szText.mid(l->pBlocks[i].block_start + retValue), 2);
+						iLeft += IRCVIEW_SURROGATEPAIRWIDTH(l->text() + l->pBlocks[i].block_start + retValue);
 						retValue+=2;
 					}
 					else
 					{
-						iLeft += (curChar.unicode() < 0xff) ? m_iFontCharacterWidth[curChar.unicode()] : m_pFm->horizontalAdvance(curChar);
+						iLeft += IRCVIEW_WCHARWIDTH(curChar);
 						retValue++;
 					}
 				}
@@ -2822,6 +3361,10 @@ KviIrcViewWrappedBlock * KviIrcView::getLinkUnderMouse(int xPos, int yPos, QRect
 			continue;
 		}
 
+		// the line may have lost its blocks meanwhile
+		if(!ensureWrappedBlocks(l))
+			return nullptr;
+
 		/*
 		 * Profane description: if we are here we have found the right line where our mouse is over; l is the KviIrcViewLine *,
 		 * iTop is the line start y coordinate. Now we have to go through this line's text and find the exact text under the mouse.
@@ -2977,7 +3520,7 @@ KviIrcViewWrappedBlock * KviIrcView::getLinkUnderMouse(int xPos, int yPos, QRect
 							}
 							if(linkCmd)
 							{
-								linkCmd->setUtf16(l->pBlocks[iLastEscapeBlock].pChunk->szPayload, kvi_wstrlen(l->pBlocks[iLastEscapeBlock].pChunk->szPayload));
+								linkCmd->setUtf16(l->payload(l->pBlocks[iLastEscapeBlock].pChunk), kvi_wstrlen(l->payload(l->pBlocks[iLastEscapeBlock].pChunk)));
 								*linkCmd = linkCmd->trimmed();
 								if((*linkCmd) == "nc")
 									(*linkCmd) = "n";
@@ -3014,7 +3557,7 @@ KviIrcViewWrappedBlock * KviIrcView::getLinkUnderMouse(int xPos, int yPos, QRect
 													}
 													break;
 											}
-											szLink.append(l->szText.mid(l->pBlocks[iEndOfLInk].block_start, l->pBlocks[iEndOfLInk].block_len));
+											szLink.append(l->textMid(l->pBlocks[iEndOfLInk].block_start, l->pBlocks[iEndOfLInk].block_len));
 										}
 										else
 										{
@@ -3032,7 +3575,7 @@ KviIrcViewWrappedBlock * KviIrcView::getLinkUnderMouse(int xPos, int yPos, QRect
 										break; // finished : not a word wrap
 									else
 									{
-										linkText->append(l->szText.mid(l->pBlocks[bufIndex].block_start, l->pBlocks[bufIndex].block_len));
+										linkText->append(l->textMid(l->pBlocks[bufIndex].block_start, l->pBlocks[bufIndex].block_len));
 									}
 								}
 							}
@@ -3051,7 +3594,7 @@ KviIrcViewWrappedBlock * KviIrcView::getLinkUnderMouse(int xPos, int yPos, QRect
 							{
 								*linkCmd = "[!txt]";
 								QString tmp;
-								tmp.setUtf16(l->pBlocks[i].pChunk->szPayload, kvi_wstrlen(l->pBlocks[i].pChunk->szPayload));
+								tmp.setUtf16(l->payload(l->pBlocks[i].pChunk), kvi_wstrlen(l->payload(l->pBlocks[i].pChunk)));
 								linkCmd->append(tmp);
 								*linkCmd = linkCmd->trimmed();
 							}
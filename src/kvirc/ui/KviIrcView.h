@@ -37,25 +37,37 @@
 
 class QScrollBar;
 class QLineEdit;
-class QFile;
 class QFontMetrics;
 class QMenu;
 class QScreen;
+class QTimer;
 
 class KviWindow;
 class KviMainWindow;
 class KviConsoleWindow;
 class KviIrcViewToolWidget;
+class KviIrcViewCharWidthCache;
 class KviIrcViewToolTip;
 class KviAnimatedPixmap;
+class KviLogFileWriter;
 
 struct KviIrcViewLineChunk;
 struct KviIrcViewWrappedBlock;
 struct KviIrcViewLine;
+struct KviIrcViewLineBuilder;
+class KviIrcViewLineStore;
 struct KviIrcViewWrappedBlockSelectionInfo;
 
 #define KVI_IRCVIEW_INVALID_LINE_MARK_INDEX 0xffffffff
 
+// A line for KviIrcView::appendTextBatch()
+struct KviIrcViewBatchLine
+{
+	int iMsgType;
+	QString szText;
+	QDateTime datetime;
+};
+
 class KVIRC_API KviIrcView : public QWidget
 {
 	Q_OBJECT
@@ -65,6 +77,7 @@ class KVIRC_API KviIrcView : public QWidget
 public:
 	friend class KviIrcViewToolTip;
 	friend class KviIrcViewToolWidget;
+	friend class KviIrcViewRepaintScheduler;
 
 public:
 	KviIrcView(QWidget * parent, KviWindow * pWnd);
@@ -81,6 +94,7 @@ private:
 	KviIrcViewLine * m_pCurLine; // Bottom line in the view
 	KviIrcViewLine * m_pLastLine;
 	KviIrcViewLine * m_pCursorLine;
+	KviIrcViewLineStore * m_pLineStore; // the memory of the lines
 	unsigned int m_uLineMarkLineIndex;
 	QRect m_lineMarkArea;
 
@@ -108,7 +122,25 @@ private:
 	int m_iFontLineWidth;
 	int m_iFontDescent;
 	float m_iFontCharacterWidth[256];
+	KviIrcViewCharWidthCache * m_pCharWidthCache; // widths of the characters above 0xff
 	bool m_bUseRealBold;
+	float m_fFontAscent[4]; // of the normal, italic, bold and bold italic variants
+
+	// paint statistics
+	kvi_u64_t m_uPaintCount;
+	kvi_i64_t m_iPaintTime;         // in nanoseconds
+	kvi_u64_t m_uPaintRequests;     // repaints requested by appended lines
+	kvi_u64_t m_uSkippedRepaints;   // requested repaints dropped because the view was hidden
+	unsigned int m_uPaintRate;      // paint events in the last full second
+	unsigned int m_uPaintsInSecond; // paint events in the current second
+	qint64 m_iPaintRateSecond;
+
+	// Background re-wrapping of the lines that are not visible
+	QTimer * m_pRewrapTimer;
+	KviIrcViewLine * m_pRewrapUpLine;   // next line to re-wrap going towards the first one
+	KviIrcViewLine * m_pRewrapDownLine; // next line to re-wrap going towards the last one
+	int m_iRewrapWidth;                 // the width the lines are being re-wrapped to
+	unsigned int m_uRewrapDistance;     // lines re-wrapped in each direction so far
 
 	int m_iWrapMargin;
 	int m_iMinimumPaintWidth;
@@ -131,11 +163,11 @@ private:
 	int m_iMouseTimer;
 	KviWindow * m_pKviWindow;
 	KviIrcViewWrappedBlockSelectionInfo * m_pWrappedBlockSelectionInfo;
-	QFile * m_pLogFile;
+	KviLogFileWriter * m_pLogFile;
 	KviMainWindow * m_pFrm;
 	bool m_bAcceptDrops;
-	int m_iUnprocessedPaintEventRequests;
-	bool m_bPostedPaintEventPending;
+	int m_iUnprocessedPaintEventRequests; // lines appended since the last full repaint
+	bool m_bRepaintScheduled;             // waiting for the next frame of KviIrcViewRepaintScheduler
 	std::vector<KviIrcViewLine *> m_pMessagesStoppedWhileSelecting;
 	KviIrcView * m_pMasterView;
 	QFontMetricsF * m_pFm; // assume this valid only inside a paint event (may be 0 in other circumstances)
@@ -149,6 +181,12 @@ private:
 
 	QMultiHash<KviIrcViewLine *, KviAnimatedPixmap *> m_hAnimatedSmiles;
 
+	// Scrollback snapshot waiting to be loaded at the first show (see restoreSnapshot())
+	QString m_szSnapshotFile;
+	unsigned int m_uSnapshotSkip;      // records in the file before them
+	unsigned int m_uSnapshotLines;     // lines still in the file
+	unsigned int m_uSnapshotBaseIndex; // first of the line indexes reserved for them
+
 public:
 	void clearUnreaded();
 	void applyOptions();
@@ -163,6 +201,10 @@ public:
 		TriggersNotification = 8
 	};
 	void appendText(int msg_type, const kvi_wchar_t * data_ptr, int iFlags = 0, const QDateTime & datetime = QDateTime());
+	// Appends many lines at once (history playback, log replays):
+	// the lines are linked in a single step, the buffer is trimmed once
+	// and the view is repainted once.
+	void appendTextBatch(const std::vector<KviIrcViewBatchLine> & vLines, int iFlags = 0);
 	void clearLineMark(bool bRepaint = false);
 	bool hasLineMark() { return m_uLineMarkLineIndex != KVI_IRCVIEW_INVALID_LINE_MARK_INDEX; };
 	void removeHeadLine(bool bRepaint = false);
@@ -184,10 +226,19 @@ public:
 	// Stops previous logging session too...
 	bool startLogging(const QString & fname = QString(), bool bPrependCurBuffer = false);
 	void stopLogging();
-	bool isLogging() { return (m_pLogFile != nullptr); };
+	// false also when the writer lost its file (e.g. it couldn't open a new segment)
+	bool isLogging();
 	void getLogFileName(QString & buffer);
 	void add2Log(const QString & szBuffer, const QDateTime & date, int iMsgType, bool bPrependDate);
 
+	// Scrollback snapshots
+	// Writes the newest uMaxLines parsed lines to the specified file
+	bool saveSnapshot(const QString & szFileName, unsigned int uMaxLines);
+	// Checks the file and reserves room for its lines: they are loaded
+	// above the current ones when the view is shown for the first time
+	bool restoreSnapshot(const QString & szFileName);
+	bool hasPendingSnapshot() const { return m_uSnapshotLines > 0; };
+
 	// Channel view splitting
 	void setMasterView(KviIrcView * v);
 	void splitMessagesTo(KviIrcView * v);
@@ -196,6 +247,17 @@ public:
 
 	qint64 lastMouseClickTime() const { return m_iLastMouseClickTime; }
 
+	// Paint statistics: the processed paint events and the time spent in them (nanoseconds)
+	kvi_u64_t paintCount() const { return m_uPaintCount; };
+	kvi_i64_t paintTime() const { return m_iPaintTime; };
+	kvi_u64_t paintRequests() const { return m_uPaintRequests; };
+	kvi_u64_t skippedRepaints() const { return m_uSkippedRepaints; };
+	unsigned int paintRate() const { return m_uPaintRate; };
+	// The current pace of the scheduled repaints of all the views (milliseconds)
+	static int repaintFrameInterval();
+	// The shaped text cache is shared by all the views
+	static void glyphCacheStatistics(kvi_u64_t & uHits, kvi_u64_t & uMisses, kvi_u64_t & uEvictions, kvi_u64_t & uBytes);
+
 	// Return true if the specified message type should be "split" to the user message specific view.
 	bool messageShouldGoToMessageView(int iMsgType);
 
@@ -206,8 +268,8 @@ public:
 	void scrollTop();
 	void scrollBottom();
 	QSize sizeHint() const override;
-	const QString & lastLineOfText();
-	const QString & lastMessageText();
+	QString lastLineOfText();
+	QString lastMessageText();
 	void setFont(const QFont & f);
 	void scrollToMarker();
 
@@ -222,10 +284,10 @@ protected:
 	void dragEnterEvent(QDragEnterEvent * e) override;
 	void dropEvent(QDropEvent * e) override;
 	void showEvent(QShowEvent * e) override;
-	bool event(QEvent * e) override;
 	void wheelEvent(QWheelEvent * e) override;
 	void keyPressEvent(QKeyEvent * e) override;
 	void maybeTip(const QPoint & pnt);
+	void loadSnapshot();
 	void leaveEvent(QEvent *) override;
 
 private:
@@ -235,11 +297,20 @@ private:
 	KviIrcViewLine * getVisibleLineAt(int yPos);
 	int getVisibleCharIndexAt(KviIrcViewLine * line, int xPos, int yPos);
 	void getLinkEscapeCommand(QString & buffer, const QString & escape_cmd, const QString & escape_label);
+	void logAndIndexLine(KviIrcViewLine * ptr, const QDateTime & date);
 	void appendLine(KviIrcViewLine * ptr, const QDateTime & date, bool bRepaint);
-	void postUpdateEvent();
+	void adoptLines(KviIrcView * pFrom);
+	void postUpdateEvent(int iNewLines = 1);
+	void scheduledRepaint();
 	void fastScroll(int lines = 1);
-	const kvi_wchar_t * getTextLine(int msg_type, const kvi_wchar_t * data_ptr, KviIrcViewLine * line_ptr, bool bEnableTimeStamp = true, const QDateTime & datetime = QDateTime());
+	const kvi_wchar_t * getTextLine(int msg_type, const kvi_wchar_t * data_ptr, KviIrcViewLineBuilder * line_ptr, bool bEnableTimeStamp = true, const QDateTime & datetime = QDateTime());
+	KviIrcViewLine * packLine(KviIrcViewLineBuilder & b, int iMsgType);
 	void calculateLineWraps(KviIrcViewLine * ptr, int maxWidth);
+	bool ensureWrappedBlocks(KviIrcViewLine * ptr);
+	unsigned int wrappedBlocksCacheLines();
+	void trimWrappedBlocks();
+	void startRewrap(int maxWidth);
+	void stopRewrap();
 	void recalcFontVariables(const QFont & font, const QFontInfo & fi);
 	bool checkSelectionBlock(KviIrcViewLine * line, int bufIndex);
 	KviIrcViewWrappedBlock * getLinkUnderMouse(int xPos, int yPos, QRect * pRect = nullptr, QString * linkCmd = nullptr, QString * linkText = nullptr);
@@ -264,6 +335,7 @@ protected slots:
 	void screenChanged(QScreen *);
 	void masterDead();
 	void animatedIconChange();
+	void rewrapStep();
 signals:
 	void rightClicked();
 	void dndEntered();
@@ -0,0 +1,99 @@
+//===========================================================================
+//
+//   File : KviIrcView_charwidth.cpp
+//   Creation date : Mon Oct 19 2026 18:02:51 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2000-2026 Szymon Stefanek (pragma at kvirc dot net)
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//===========================================================================
+
+//
+// The character widths of the KviIrcView (see KviIrcViewCharWidthCache in KviIrcView_private.h)
+//
+// This file doesn't depend on KviIrcView itself: the wrap benchmark
+// is built on top of it.
+//
+
+#include "KviIrcView_private.h"
+
+KviIrcViewCharWidthCache::KviIrcViewCharWidthCache()
+{
+	m_pFm = nullptr;
+	for(auto & pPlane : m_pPlanes)
+		pPlane = nullptr;
+}
+
+KviIrcViewCharWidthCache::~KviIrcViewCharWidthCache()
+{
+	clear();
+}
+
+void KviIrcViewCharWidthCache::setFontMetrics(QFontMetricsF * pFm)
+{
+	clear();
+	m_pFm = pFm;
+}
+
+void KviIrcViewCharWidthCache::clear()
+{
+	for(auto & pPlane : m_pPlanes)
+	{
+		if(!pPlane)
+			continue;
+		for(int i = 0; i < 256; i++)
+			delete[] pPlane[i];
+		delete[] pPlane;
+		pPlane = nullptr;
+	}
+}
+
+float KviIrcViewCharWidthCache::measure(unsigned int uCodePoint)
+{
+	float fWidth;
+	if(uCodePoint < 0x10000)
+	{
+		fWidth = m_pFm->horizontalAdvance(QChar(uCodePoint));
+	}
+	else
+	{
+		QChar pair[2] = { QChar(QChar::highSurrogate(uCodePoint)), QChar(QChar::lowSurrogate(uCodePoint)) };
+		fWidth = m_pFm->horizontalAdvance(QString(pair, 2));
+	}
+
+	if((uCodePoint >> 16) >= KVI_IRCVIEW_CHARWIDTH_PLANES)
+		return fWidth; // invalid code point: don't cache it
+
+	float ** & pPlane = m_pPlanes[uCodePoint >> 16];
+	if(!pPlane)
+	{
+		pPlane = new float *[256];
+		for(int i = 0; i < 256; i++)
+			pPlane[i] = nullptr;
+	}
+
+	float * & pPage = pPlane[(uCodePoint >> 8) & 0xff];
+	if(!pPage)
+	{
+		pPage = new float[256];
+		for(int i = 0; i < 256; i++)
+			pPage[i] = -1.0; // not measured yet
+	}
+
+	pPage[uCodePoint & 0xff] = fWidth;
+	return fWidth;
+}
@@ -550,13 +550,13 @@ void KviIrcView::mouseReleaseEvent(QMouseEvent * e)
 								{
 									//the entire chunk is included
 									addControlCharacter(pC, szSelectionText);
-									szSelectionText.append(tempLine->szText.mid(pC->iTextStart, pC->iTextLen));
+									szSelectionText.append(tempLine->textMid(pC->iTextStart, pC->iTextLen));
 								}
 								else
 								{
 									//ends in this chunk
 									addControlCharacter(pC, szSelectionText);
-									szSelectionText.append(tempLine->szText.mid(pC->iTextStart, endChar - pC->iTextStart));
+									szSelectionText.append(tempLine->textMid(pC->iTextStart, endChar - pC->iTextStart));
 									break;
 								}
 							}
@@ -569,13 +569,13 @@ void KviIrcView::mouseReleaseEvent(QMouseEvent * e)
 									if(endChar >= (pC->iTextLen + pC->iTextLen))
 									{
 										//don't end in this chunk
-										szSelectionText.append(tempLine->szText.mid(initChar, pC->iTextLen - (initChar - pC->iTextStart)));
+										szSelectionText.append(tempLine->textMid(initChar, pC->iTextLen - (initChar - pC->iTextStart)));
 										bStarted = true;
 									}
 									else
 									{
 										//ends in this chunk
-										szSelectionText.append(tempLine->szText.mid(initChar, endChar - initChar));
+										szSelectionText.append(tempLine->textMid(initChar, endChar - initChar));
 										break;
 									}
 								}
@@ -584,7 +584,7 @@ void KviIrcView::mouseReleaseEvent(QMouseEvent * e)
 					}
 					else
 					{
-						szSelectionText.append(tempLine->szText.mid(initChar, endChar - initChar));
+						szSelectionText.append(tempLine->textMid(initChar, endChar - initChar));
 					}
 					break;
 				}
@@ -602,7 +602,7 @@ void KviIrcView::mouseReleaseEvent(QMouseEvent * e)
 							{
 								//the entire chunk is included
 								addControlCharacter(pC, szSelectionText);
-								szSelectionText.append(tempLine->szText.mid(pC->iTextStart, pC->iTextLen));
+								szSelectionText.append(tempLine->textMid(pC->iTextStart, pC->iTextLen));
 							}
 							else
 							{
@@ -610,7 +610,7 @@ void KviIrcView::mouseReleaseEvent(QMouseEvent * e)
 								{
 									//starts in this chunk
 									addControlCharacter(pC, szSelectionText);
-									szSelectionText.append(tempLine->szText.mid(initChar, pC->iTextLen - (initChar - pC->iTextStart)));
+									szSelectionText.append(tempLine->textMid(initChar, pC->iTextLen - (initChar - pC->iTextStart)));
 									bStarted = true;
 								}
 							}
@@ -618,7 +618,7 @@ void KviIrcView::mouseReleaseEvent(QMouseEvent * e)
 					}
 					else
 					{
-						szSelectionText.append(tempLine->szText.mid(initChar));
+						szSelectionText.append(tempLine->textMid(initChar));
 					}
 					szSelectionText.append("\n");
 				}
@@ -638,20 +638,20 @@ void KviIrcView::mouseReleaseEvent(QMouseEvent * e)
 							{
 								//the entire chunk is included
 								addControlCharacter(pC, szSelectionText);
-								szSelectionText.append(tempLine->szText.mid(pC->iTextStart, pC->iTextLen));
+								szSelectionText.append(tempLine->textMid(pC->iTextStart, pC->iTextLen));
 							}
 							else
 							{
 								//ends in this chunk
 								addControlCharacter(pC, szSelectionText);
-								szSelectionText.append(tempLine->szText.mid(pC->iTextStart, endChar - pC->iTextStart));
+								szSelectionText.append(tempLine->textMid(pC->iTextStart, endChar - pC->iTextStart));
 								break;
 							}
 						}
 					}
 					else
 					{
-						szSelectionText.append(tempLine->szText.left(endChar));
+						szSelectionText.append(tempLine->textMid(0, endChar));
 					}
 					break;
 				}
@@ -666,12 +666,12 @@ void KviIrcView::mouseReleaseEvent(QMouseEvent * e)
 							pC = &tempLine->pChunks[i];
 							//the entire chunk is included
 							addControlCharacter(pC, szSelectionText);
-							szSelectionText.append(tempLine->szText.mid(pC->iTextStart, pC->iTextLen));
+							szSelectionText.append(tempLine->textMid(pC->iTextStart, pC->iTextLen));
 						}
 					}
 					else
 					{
-						szSelectionText.append(tempLine->szText);
+						szSelectionText.append(tempLine->text(), tempLine->iTextLen);
 					}
 					szSelectionText.append("\n");
 				}
@@ -1222,20 +1222,6 @@ void KviIrcView::dropEvent(QDropEvent * e)
 	}
 }
 
-bool KviIrcView::event(QEvent * e)
-{
-	if(e->type() == QEvent::User)
-	{
-		KVI_ASSERT(m_bPostedPaintEventPending);
-		if(m_iUnprocessedPaintEventRequests)
-			repaint();
-		// else we just had a pointEvent that did the job
-		m_bPostedPaintEventPending = false;
-		return true;
-	}
-	return QWidget::event(e);
-}
-
 void KviIrcView::wheelEvent(QWheelEvent * e)
 {
 	static bool bHere = false;
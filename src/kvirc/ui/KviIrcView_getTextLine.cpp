@@ -161,7 +161,7 @@ static inline bool url_compare_helper(const kvi_wchar_t * pData1, const kvi_wcha
 const kvi_wchar_t * KviIrcView::getTextLine(
 		int iMsgType,
 		const kvi_wchar_t * data_ptr,
-		KviIrcViewLine * line_ptr,
+		KviIrcViewLineBuilder * line_ptr,
 		bool bEnableTimeStamp,
 		const QDateTime & datetime_param
 	)
@@ -181,7 +181,7 @@ const kvi_wchar_t * KviIrcView::getTextLine(
 
 	//Alloc the first attribute
 	line_ptr->uChunkCount = 1;
-	line_ptr->pChunks = (KviIrcViewLineChunk *)KviMemory::allocate(sizeof(KviIrcViewLineChunk));
+	line_ptr->pChunks = (KviIrcViewLineBuilderChunk *)KviMemory::allocate(sizeof(KviIrcViewLineBuilderChunk));
 	//And fill it up
 	line_ptr->pChunks[0].type = KviControlCodes::Color;
 	line_ptr->pChunks[0].iTextStart = 0;
@@ -209,7 +209,7 @@ const kvi_wchar_t * KviIrcView::getTextLine(
 			line_ptr->pChunks[0].iTextLen = 0;
 
 			line_ptr->uChunkCount = 3;
-			line_ptr->pChunks = (KviIrcViewLineChunk *)KviMemory::reallocate((void *)line_ptr->pChunks, 3 * sizeof(KviIrcViewLineChunk));
+			line_ptr->pChunks = (KviIrcViewLineBuilderChunk *)KviMemory::reallocate((void *)line_ptr->pChunks, 3 * sizeof(KviIrcViewLineBuilderChunk));
 
 			line_ptr->pChunks[1].type = KviControlCodes::Color;
 			line_ptr->pChunks[1].iTextStart = 0;
@@ -290,8 +290,8 @@ const kvi_wchar_t * KviIrcView::getTextLine(
 	
 	#define NEW_LINE_CHUNK(_chunk_type)                                                             \
 		line_ptr->uChunkCount++;                                                                    \
-		line_ptr->pChunks = (KviIrcViewLineChunk *)KviMemory::reallocate((void *)line_ptr->pChunks, \
-		    line_ptr->uChunkCount * sizeof(KviIrcViewLineChunk));                                   \
+		line_ptr->pChunks = (KviIrcViewLineBuilderChunk *)KviMemory::reallocate((void *)line_ptr->pChunks, \
+		    line_ptr->uChunkCount * sizeof(KviIrcViewLineBuilderChunk));                            \
 		iCurChunk++;                                                                                \
 		line_ptr->pChunks[iCurChunk].type = _chunk_type;                                            \
 		line_ptr->pChunks[iCurChunk].iTextStart = iTextIdx;                                         \
@@ -649,8 +649,10 @@ found_command_escape:
 									KviUserListEntry * e = ((KviChannelWindow *)m_pKviWindow)->userListView()->findEntry(QString((QChar *)next_cr, term_cr - next_cr));
 									if(e)
 									{
+										QColor customFore;
 										line_ptr->pChunks[iCurChunk].colors.fore = KVI_COLOR_CUSTOM;
-										e->color(line_ptr->pChunks[iCurChunk].customFore);
+										e->color(customFore);
+										line_ptr->pChunks[iCurChunk].customFore = customFore.rgb();
 										bColorSet = true;
 									}
 								}
@@ -738,7 +740,7 @@ found_icon_escape:
 							//FIXME: that's ugly
 							disconnect(icon->animatedPixmap(), SIGNAL(frameChanged()), this, SLOT(animatedIconChange()));
 							connect(icon->animatedPixmap(), SIGNAL(frameChanged()), this, SLOT(animatedIconChange()));
-							m_hAnimatedSmiles.insert(line_ptr, icon->animatedPixmap());
+							line_ptr->vAnimatedSmiles.push_back(icon->animatedPixmap());
 						}
 						data_ptr = p;
 						NEW_LINE_CHUNK(KviControlCodes::UnIcon)
@@ -1200,7 +1202,7 @@ check_emoticon_char:
 									//FIXME: that's ugly
 									disconnect(icon->animatedPixmap(), SIGNAL(frameChanged()), this, SLOT(animatedIconChange()));
 									connect(icon->animatedPixmap(), SIGNAL(frameChanged()), this, SLOT(animatedIconChange()));
-									m_hAnimatedSmiles.insert(line_ptr, icon->animatedPixmap());
+									line_ptr->vAnimatedSmiles.push_back(icon->animatedPixmap());
 								}
 
 								// we got an icon for this emoticon
@@ -1286,6 +1288,15 @@ void KviIrcView::reapplyMessageColors()
 	}
 }
 
+KviIrcViewLine * KviIrcView::packLine(KviIrcViewLineBuilder & b, int iMsgType)
+{
+	KviIrcViewLine * pLine = m_pLineStore->allocateLine(b, iMsgType);
+	for(auto & pSmile : b.vAnimatedSmiles)
+		m_hAnimatedSmiles.insert(pLine, pSmile);
+	b.clear(); // ready for the next line
+	return pLine;
+}
+
 void KviIrcView::appendText(int iMsgType, const kvi_wchar_t * data_ptr, int iFlags, const QDateTime & datetime)
 {
 	//appends a text string to the buffer list
@@ -1307,18 +1318,14 @@ void KviIrcView::appendText(int iMsgType, const kvi_wchar_t * data_ptr, int iFla
 		}
 	}
 
+	KviIrcViewLineBuilder builder;
+
 	while(*data_ptr)
 	{
 		// have more data to process
 
-		KviIrcViewLine * line_ptr = new KviIrcViewLine; //create a line struct
-
-		line_ptr->iMsgType = iMsgType;
-		line_ptr->iMaxLineWidth = -1;
-		line_ptr->iBlockCount = 0;
-		line_ptr->uLineWraps = 0;
-
-		data_ptr = getTextLine(iMsgType, data_ptr, line_ptr, !(iFlags & NoTimestamp), datetime);
+		data_ptr = getTextLine(iMsgType, data_ptr, &builder, !(iFlags & NoTimestamp), datetime);
+		KviIrcViewLine * line_ptr = packLine(builder, iMsgType); //create a line struct
 
 		appendLine(line_ptr, datetime, !(iFlags & NoRepaint));
 
@@ -1340,3 +1347,133 @@ void KviIrcView::appendText(int iMsgType, const kvi_wchar_t * data_ptr, int iFla
 		}
 	}
 }
+
+void KviIrcView::appendTextBatch(const std::vector<KviIrcViewBatchLine> & vLines, int iFlags)
+{
+	if(vLines.empty())
+		return;
+
+	if(m_bMouseIsDown)
+	{
+		// the lines are queued until the selection ends anyway
+		for(auto & l : vLines)
+		{
+			const QChar * pC = l.szText.constData();
+			if(pC)
+				appendText(l.iMsgType, (const kvi_wchar_t *)pC, iFlags, l.datetime);
+		}
+		return;
+	}
+
+	m_pLastLinkUnderMouse = nullptr;
+
+	bool bFollowing = (m_pCurLine == m_pLastLine); // also true for an empty buffer
+	KviIrcViewLine * pFirst = nullptr;
+	KviIrcViewLine * pLast = nullptr;
+	int iCount = 0;
+
+	KviIrcViewLineBuilder builder;
+
+	// Only the newest m_iMaxLines lines can survive the trim below: the older ones are
+	// logged but never parsed (each line of the batch makes at least one line of the view)
+	std::size_t uFirstParsed = (vLines.size() > (std::size_t)m_iMaxLines) ? (vLines.size() - m_iMaxLines) : 0;
+
+	// Parse the lines in a private chain: nothing is shown until the whole batch is ready
+	for(std::size_t u = 0; u < vLines.size(); u++)
+	{
+		const KviIrcViewBatchLine & l = vLines[u];
+		const kvi_wchar_t * data_ptr = (const kvi_wchar_t *)l.szText.constData();
+		if(!data_ptr)
+			continue;
+
+		if(KVI_OPTION_MSGTYPE(l.iMsgType).logEnabled())
+		{
+			// a slave view has no log files!
+			KviIrcView * pLogView = m_pLogFile ? this : ((m_pMasterView && m_pMasterView->m_pLogFile) ? m_pMasterView : nullptr);
+			if(pLogView)
+			{
+				if(!KVI_OPTION_BOOL(KviOption_boolStripControlCodesInLogs))
+					pLogView->add2Log(l.szText, l.datetime, l.iMsgType, true);
+				else if(u < uFirstParsed)
+					pLogView->add2Log(KviControlCodes::stripControlBytes(l.szText), l.datetime, l.iMsgType, true);
+				// else logAndIndexLine() logs the parsed line
+			}
+		}
+
+		if(iFlags & TriggersNotification)
+		{
+			if(!m_bHaveUnreadedHighlightedMessages && l.iMsgType == KVI_OUT_HIGHLIGHT)
+				m_bHaveUnreadedHighlightedMessages = true;
+			if(!m_bHaveUnreadedMessages && (l.iMsgType == KVI_OUT_CHANPRIVMSG || l.iMsgType == KVI_OUT_CHANPRIVMSGCRYPTED || l.iMsgType == KVI_OUT_CHANNELNOTICE || l.iMsgType == KVI_OUT_CHANNELNOTICECRYPTED || l.iMsgType == KVI_OUT_ACTION || l.iMsgType == KVI_OUT_ACTIONCRYPTED || l.iMsgType == KVI_OUT_QUERYPRIVMSG || l.iMsgType == KVI_OUT_QUERYPRIVMSGCRYPTED || l.iMsgType == KVI_OUT_DCCCHATMSG || l.iMsgType == KVI_OUT_DCCCHATMSGCRYPTED || l.iMsgType == KVI_OUT_HIGHLIGHT))
+				m_bHaveUnreadedMessages = true;
+		}
+
+		if(u < uFirstParsed)
+			continue;
+
+		while(*data_ptr)
+		{
+			data_ptr = getTextLine(l.iMsgType, data_ptr, &builder, !(iFlags & NoTimestamp), l.datetime);
+			KviIrcViewLine * line_ptr = packLine(builder, l.iMsgType);
+
+			logAndIndexLine(line_ptr, l.datetime);
+
+			line_ptr->pPrev = pLast;
+			line_ptr->pNext = nullptr;
+			if(pLast)
+				pLast->pNext = line_ptr;
+			else
+				pFirst = line_ptr;
+			pLast = line_ptr;
+			iCount++;
+
+			if(iFlags & SetLineMark)
+			{
+				if(KVI_OPTION_BOOL(KviOption_boolTrackLastReadTextViewLine))
+				{
+					m_uLineMarkLineIndex = line_ptr->uIndex;
+					iFlags &= ~SetLineMark;
+				}
+			}
+		}
+	}
+
+	if(!pFirst)
+		return;
+
+	// Splice the chain at the end of the buffer
+	if(m_pLastLine)
+	{
+		m_pLastLine->pNext = pFirst;
+		pFirst->pPrev = m_pLastLine;
+	}
+	else
+	{
+		m_pFirstLine = pFirst;
+	}
+	m_pLastLine = pLast;
+	m_iNumLines += iCount;
+	if(bFollowing)
+		m_pCurLine = pLast;
+
+	// Trim the buffer once
+	int iRemoved = 0;
+	while(m_iNumLines > m_iMaxLines)
+	{
+		removeHeadLine(false);
+		iRemoved++;
+	}
+
+	// Sync the scroll bar: set the last value first so the cur line doesn't move
+	m_bSkipScrollBarRepaint = true;
+	if(bFollowing)
+		m_iLastScrollBarValue = m_iNumLines;
+	else
+		m_iLastScrollBarValue = qMax(0, m_iLastScrollBarValue - iRemoved);
+	m_pScrollBar->setRange(0, m_iNumLines);
+	m_pScrollBar->setValue(m_iLastScrollBarValue);
+	m_bSkipScrollBarRepaint = false;
+
+	if(bFollowing && !(iFlags & NoRepaint))
+		postUpdateEvent(iCount);
+}
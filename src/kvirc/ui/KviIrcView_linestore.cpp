@@ -0,0 +1,361 @@
+//===========================================================================
+//
+//   File : KviIrcView_linestore.cpp
+//   Creation date : Tue Oct 20 2026 03:12:44 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2000-2026 Szymon Stefanek (pragma at kvirc dot net)
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//===========================================================================
+
+//
+// The memory of the KviIrcView lines (see KviIrcViewLineStore in KviIrcView_private.h)
+//
+// This file doesn't depend on KviIrcView itself: the scrollback
+// memory benchmark is built on top of it.
+//
+
+#include "KviIrcView_private.h"
+#include "KviControlCodes.h"
+#include "KviMemory.h"
+
+struct KviIrcViewLineStorePage
+{
+	KviIrcViewLineStore * pStore;
+	std::size_t uSize;     // of the records area that follows this header
+	std::size_t uUsed;     // bytes of the records area given away
+	unsigned int uRecords; // live records
+};
+
+// the wrapped blocks of a line are preceded by its links in the list of the lines with blocks
+struct KviIrcViewLineStoreBlocks
+{
+	KviIrcViewLine * pOlder;
+	KviIrcViewLine * pNewer;
+};
+
+// each record is preceded by a pointer to its page and is 8 byte aligned
+static inline std::size_t linestore_record_size(std::size_t uBytes)
+{
+	return (uBytes + sizeof(KviIrcViewLineStorePage *) + 7) & ~(std::size_t)7;
+}
+
+static inline bool linestore_chunk_has_payload(unsigned char type)
+{
+	// the payload is garbage for the other chunk types
+	return (type == KviControlCodes::Escape) || (type == KviControlCodes::Icon);
+}
+
+static inline KviIrcViewLineStorePage * linestore_page(const void * pRecord)
+{
+	return *((KviIrcViewLineStorePage * const *)(((const char *)pRecord) - sizeof(KviIrcViewLineStorePage *)));
+}
+
+static inline KviIrcViewLineStoreBlocks * linestore_blocks(const KviIrcViewLine * pLine)
+{
+	return ((KviIrcViewLineStoreBlocks *)pLine->pBlocks) - 1;
+}
+
+// the size of the record of the line, without the page pointer
+static std::size_t linestore_line_bytes(const KviIrcViewLine * pLine)
+{
+	std::size_t uChars = pLine->iTextLen;
+	for(unsigned int i = 0; i < pLine->uChunkCount; i++)
+	{
+		const KviIrcViewLineChunk * c = pLine->pChunks + i;
+		if(!linestore_chunk_has_payload(c->type))
+			continue;
+		uChars += kvi_wstrlen(pLine->payload(c)) + 1;
+		if(c->uFlags & KVI_IRCVIEW_CHUNK_FLAG_SMILEID)
+			uChars += kvi_wstrlen(pLine->smileId(c)) + 1;
+	}
+	return sizeof(KviIrcViewLine) + (pLine->uChunkCount * sizeof(KviIrcViewLineChunk)) + (uChars * sizeof(kvi_wchar_t));
+}
+
+KviIrcViewLineBuilder::KviIrcViewLineBuilder()
+{
+	pChunks = nullptr;
+	uChunkCount = 0;
+}
+
+KviIrcViewLineBuilder::~KviIrcViewLineBuilder()
+{
+	clear();
+}
+
+void KviIrcViewLineBuilder::clear()
+{
+	for(unsigned int i = 0; i < uChunkCount; i++)
+	{
+		if(linestore_chunk_has_payload(pChunks[i].type))
+		{
+			if((pChunks[i].type == KviControlCodes::Icon) && (pChunks[i].szPayload != pChunks[i].szSmileId))
+				KviMemory::free(pChunks[i].szSmileId);
+			KviMemory::free(pChunks[i].szPayload);
+		}
+	}
+	if(pChunks)
+		KviMemory::free(pChunks);
+	pChunks = nullptr;
+	uChunkCount = 0;
+	szText = QString();
+	vAnimatedSmiles.clear();
+}
+
+KviIrcViewLineStore::KviIrcViewLineStore()
+{
+	m_pCurrentPage = nullptr;
+	m_uPageBytes = 0;
+	m_uLineBytes = 0;
+	m_uLines = 0;
+	m_uPages = 0;
+	m_uBlockLines = 0;
+	m_pOldestBlockLine = nullptr;
+	m_pNewestBlockLine = nullptr;
+}
+
+KviIrcViewLineStore::~KviIrcViewLineStore()
+{
+	// the view has freed all its lines: only the current page may be left
+	if(m_pCurrentPage)
+		KviMemory::free(m_pCurrentPage);
+}
+
+void * KviIrcViewLineStore::allocate(std::size_t uBytes)
+{
+	uBytes = linestore_record_size(uBytes);
+
+	KviIrcViewLineStorePage * pPage;
+	if(uBytes > (KVI_IRCVIEW_LINESTORE_PAGE_SIZE / 4))
+	{
+		// a page of its own
+		pPage = nullptr;
+	}
+	else
+	{
+		// the page we leave is freed by its last record
+		if(m_pCurrentPage && ((m_pCurrentPage->uUsed + uBytes) > m_pCurrentPage->uSize))
+			m_pCurrentPage = nullptr;
+		pPage = m_pCurrentPage;
+	}
+
+	if(!pPage)
+	{
+		std::size_t uSize = (uBytes > (KVI_IRCVIEW_LINESTORE_PAGE_SIZE / 4)) ? uBytes : (KVI_IRCVIEW_LINESTORE_PAGE_SIZE - sizeof(KviIrcViewLineStorePage));
+		pPage = (KviIrcViewLineStorePage *)KviMemory::allocate((int)(sizeof(KviIrcViewLineStorePage) + uSize));
+		pPage->pStore = this;
+		pPage->uSize = uSize;
+		pPage->uUsed = 0;
+		pPage->uRecords = 0;
+		m_uPageBytes += sizeof(KviIrcViewLineStorePage) + uSize;
+		m_uPages++;
+		if(uBytes <= (KVI_IRCVIEW_LINESTORE_PAGE_SIZE / 4))
+			m_pCurrentPage = pPage;
+	}
+
+	char * p = ((char *)(pPage + 1)) + pPage->uUsed;
+	pPage->uUsed += uBytes;
+	pPage->uRecords++;
+	*((KviIrcViewLineStorePage **)p) = pPage;
+	return p + sizeof(KviIrcViewLineStorePage *);
+}
+
+void KviIrcViewLineStore::free(void * pRecord)
+{
+	KviIrcViewLineStorePage * pPage = linestore_page(pRecord);
+	pPage->uRecords--;
+	if(pPage->uRecords)
+		return;
+
+	if(pPage == m_pCurrentPage)
+	{
+		// start over
+		pPage->uUsed = 0;
+		return;
+	}
+
+	m_uPageBytes -= sizeof(KviIrcViewLineStorePage) + pPage->uSize;
+	m_uPages--;
+	KviMemory::free(pPage);
+}
+
+KviIrcViewLine * KviIrcViewLineStore::allocateLine(KviIrcViewLineBuilder & b, int iMsgType)
+{
+	// the chunk strings are packed after the text
+	std::size_t uChars = b.szText.length();
+	for(unsigned int i = 0; i < b.uChunkCount; i++)
+	{
+		KviIrcViewLineBuilderChunk * c = b.pChunks + i;
+		if(!linestore_chunk_has_payload(c->type))
+			continue;
+		uChars += kvi_wstrlen(c->szPayload) + 1;
+		if((c->type == KviControlCodes::Icon) && (c->szSmileId != c->szPayload))
+			uChars += kvi_wstrlen(c->szSmileId) + 1;
+	}
+
+	std::size_t uBytes = sizeof(KviIrcViewLine) + (b.uChunkCount * sizeof(KviIrcViewLineChunk)) + (uChars * sizeof(kvi_wchar_t));
+	KviIrcViewLine * pLine = (KviIrcViewLine *)allocate(uBytes);
+	m_uLineBytes += linestore_record_size(uBytes);
+	m_uLines++;
+
+	pLine->uIndex = 0;
+	pLine->iMsgType = iMsgType;
+	pLine->pChunks = (KviIrcViewLineChunk *)(pLine + 1);
+	pLine->uChunkCount = b.uChunkCount;
+	pLine->iTextLen = b.szText.length();
+	pLine->uLineWraps = 0;
+	pLine->pBlocks = nullptr;
+	pLine->iMaxLineWidth = -1;
+	pLine->iBlockCount = 0;
+	pLine->pPrev = nullptr;
+	pLine->pNext = nullptr;
+	pLine->pGlyphCache = nullptr;
+
+	kvi_wchar_t * pText = (kvi_wchar_t *)pLine->text();
+	if(pLine->iTextLen)
+		KviMemory::copy(pText, b.szText.unicode(), pLine->iTextLen * sizeof(kvi_wchar_t));
+	unsigned int uOffset = pLine->iTextLen;
+
+	for(unsigned int i = 0; i < b.uChunkCount; i++)
+	{
+		KviIrcViewLineBuilderChunk * c = b.pChunks + i;
+		KviIrcViewLineChunk * pChunk = pLine->pChunks + i;
+		pChunk->iTextStart = c->iTextStart;
+		pChunk->iTextLen = c->iTextLen;
+		pChunk->customFore = c->customFore;
+		pChunk->uPayload = 0;
+		pChunk->type = c->type;
+		pChunk->colors.back = c->colors.back;
+		pChunk->colors.fore = c->colors.fore;
+		pChunk->uFlags = 0;
+
+		if(!linestore_chunk_has_payload(c->type))
+			continue;
+
+		pChunk->uPayload = uOffset;
+		int iLen = kvi_wstrlen(c->szPayload) + 1;
+		KviMemory::copy(pText + uOffset, c->szPayload, iLen * sizeof(kvi_wchar_t));
+		uOffset += iLen;
+
+		if((c->type == KviControlCodes::Icon) && (c->szSmileId != c->szPayload))
+		{
+			pChunk->uFlags |= KVI_IRCVIEW_CHUNK_FLAG_SMILEID;
+			iLen = kvi_wstrlen(c->szSmileId) + 1;
+			KviMemory::copy(pText + uOffset, c->szSmileId, iLen * sizeof(kvi_wchar_t));
+			uOffset += iLen;
+		}
+	}
+
+	return pLine;
+}
+
+void KviIrcViewLineStore::freeLine(KviIrcViewLine * pLine)
+{
+	freeBlocks(pLine);
+	m_uLineBytes -= linestore_record_size(linestore_line_bytes(pLine));
+	m_uLines--;
+	free(pLine);
+}
+
+bool KviIrcViewLineStore::owns(const KviIrcViewLine * pLine) const
+{
+	return linestore_page(pLine)->pStore == this;
+}
+
+KviIrcViewLine * KviIrcViewLineStore::adoptLine(KviIrcViewLine * pLine)
+{
+	KviIrcViewLineStore * pOwner = linestore_page(pLine)->pStore;
+	if(pOwner == this)
+		return pLine;
+
+	// the blocks point to the old chunks
+	pOwner->freeBlocks(pLine);
+
+	std::size_t uBytes = linestore_line_bytes(pLine);
+	KviIrcViewLine * pNew = (KviIrcViewLine *)allocate(uBytes);
+	m_uLineBytes += linestore_record_size(uBytes);
+	m_uLines++;
+	KviMemory::copy(pNew, pLine, (int)uBytes);
+	pNew->pChunks = (KviIrcViewLineChunk *)(pNew + 1);
+
+	pOwner->m_uLineBytes -= linestore_record_size(uBytes);
+	pOwner->m_uLines--;
+	pOwner->free(pLine);
+	return pNew;
+}
+
+void KviIrcViewLineStore::unlinkBlocks(KviIrcViewLine * pLine)
+{
+	KviIrcViewLineStoreBlocks * b = linestore_blocks(pLine);
+	if(b->pOlder)
+		linestore_blocks(b->pOlder)->pNewer = b->pNewer;
+	else
+		m_pOldestBlockLine = b->pNewer;
+	if(b->pNewer)
+		linestore_blocks(b->pNewer)->pOlder = b->pOlder;
+	else
+		m_pNewestBlockLine = b->pOlder;
+}
+
+void KviIrcViewLineStore::linkBlocksAsNewest(KviIrcViewLine * pLine)
+{
+	KviIrcViewLineStoreBlocks * b = linestore_blocks(pLine);
+	b->pOlder = m_pNewestBlockLine;
+	b->pNewer = nullptr;
+	if(m_pNewestBlockLine)
+		linestore_blocks(m_pNewestBlockLine)->pNewer = pLine;
+	else
+		m_pOldestBlockLine = pLine;
+	m_pNewestBlockLine = pLine;
+}
+
+void KviIrcViewLineStore::allocateBlocks(KviIrcViewLine * pLine, int iCount)
+{
+	int iBytes = sizeof(KviIrcViewLineStoreBlocks) + (iCount * sizeof(KviIrcViewWrappedBlock));
+	if(pLine->pBlocks)
+	{
+		// the links are moved along with the blocks
+		KviIrcViewLineStoreBlocks * b = (KviIrcViewLineStoreBlocks *)KviMemory::reallocate(linestore_blocks(pLine), iBytes);
+		pLine->pBlocks = (KviIrcViewWrappedBlock *)(b + 1);
+		touchBlocks(pLine);
+		return;
+	}
+
+	KviIrcViewLineStoreBlocks * b = (KviIrcViewLineStoreBlocks *)KviMemory::allocate(iBytes);
+	pLine->pBlocks = (KviIrcViewWrappedBlock *)(b + 1);
+	linkBlocksAsNewest(pLine);
+	m_uBlockLines++;
+}
+
+void KviIrcViewLineStore::touchBlocks(KviIrcViewLine * pLine)
+{
+	if(!pLine->pBlocks || (pLine == m_pNewestBlockLine))
+		return;
+	unlinkBlocks(pLine);
+	linkBlocksAsNewest(pLine);
+}
+
+void KviIrcViewLineStore::freeBlocks(KviIrcViewLine * pLine)
+{
+	if(!pLine->pBlocks)
+		return;
+	unlinkBlocks(pLine);
+	KviMemory::free(linestore_blocks(pLine));
+	pLine->pBlocks = nullptr;
+	pLine->iBlockCount = 0;
+	m_uBlockLines--;
+}
@@ -28,20 +28,14 @@
 
 #include "KviIrcView.h"
 #include "KviIrcView_private.h"
+#include "KviLogFileWriter.h"
 #include "KviLocale.h"
 #include "KviOptions.h"
 #include "kvi_out.h"
 #include "KviQString.h"
 #include "KviWindow.h"
 
-#ifdef COMPILE_ZLIB_SUPPORT
-#include <zlib.h>
-#endif
-
-#include <QFileInfo>
-#include <QFile>
 #include <QDateTime>
-#include <QTextCodec>
 #include <QLocale>
 
 void KviIrcView::stopLogging()
@@ -52,35 +46,16 @@ void KviIrcView::stopLogging()
 		QString szLogEnd = QString(__tr2qs("### Log session terminated ###"));
 		add2Log(szLogEnd, date, KVI_OUT_LOG, true);
 		m_pLogFile->close();
-#ifdef COMPILE_ZLIB_SUPPORT
-		if(KVI_OPTION_BOOL(KviOption_boolGzipLogs))
-		{
-			if(m_pLogFile->open(QIODevice::ReadOnly))
-			{
-				QByteArray bytes;
-				bytes = m_pLogFile->readAll();
-				m_pLogFile->close();
-				QFileInfo fi(*m_pLogFile);
-				QString szFname = fi.absolutePath() + QString("/") + fi.completeBaseName();
-				gzFile file = gzopen(QTextCodec::codecForLocale()->fromUnicode(szFname).data(), "ab9");
-				if(file)
-				{
-					gzwrite(file, bytes.data(), bytes.size());
-					gzclose(file);
-					m_pLogFile->remove();
-				}
-				else
-				{
-					qDebug("Can't open compressed stream");
-				}
-			}
-		}
-#endif
 		delete m_pLogFile;
 		m_pLogFile = nullptr;
 	}
 }
 
+bool KviIrcView::isLogging()
+{
+	return m_pLogFile && m_pLogFile->isOpen();
+}
+
 void KviIrcView::getLogFileName(QString & buffer)
 {
 	if(m_pLogFile)
@@ -95,7 +70,7 @@ void KviIrcView::getTextBuffer(QString & buffer)
 		return;
 	for(KviIrcViewLine * l = m_pFirstLine; l; l = l->pNext)
 	{
-		buffer.append(l->szText);
+		buffer.append(l->text(), l->iTextLen);
 		buffer.append("\n");
 	}
 }
@@ -103,41 +78,12 @@ void KviIrcView::getTextBuffer(QString & buffer)
 void KviIrcView::flushLog()
 {
 	if(m_pLogFile)
-	{
-#ifdef COMPILE_ZLIB_SUPPORT
-		if(KVI_OPTION_BOOL(KviOption_boolGzipLogs))
-		{
-			m_pLogFile->close();
-			if(m_pLogFile->open(QIODevice::ReadOnly))
-			{
-				QByteArray bytes;
-				bytes = m_pLogFile->readAll();
-				m_pLogFile->close();
-				QFileInfo fi(*m_pLogFile);
-				QString szFname = fi.absolutePath() + QString("/") + fi.completeBaseName();
-				gzFile file = gzopen(QTextCodec::codecForLocale()->fromUnicode(szFname).data(), "ab9");
-				if(file)
-				{
-					gzwrite(file, bytes.data(), bytes.size());
-					gzclose(file);
-					m_pLogFile->remove();
-				}
-				else
-				{
-					qDebug("Can't open compressed stream");
-				}
-			}
-			m_pLogFile->open(QIODevice::Append | QIODevice::WriteOnly);
-		}
-		else
-#endif
-			m_pLogFile->flush();
-	}
+		m_pLogFile->sync();
 	else if(m_pMasterView)
 		m_pMasterView->flushLog();
 }
 
-const QString & KviIrcView::lastMessageText()
+QString KviIrcView::lastMessageText()
 {
 	KviIrcViewLine * pCur = m_pLastLine;
 	while(pCur)
@@ -155,18 +101,18 @@ const QString & KviIrcView::lastMessageText()
 			case KVI_OUT_OWNPRIVMSG:
 			case KVI_OUT_OWNPRIVMSGCRYPTED:
 			case KVI_OUT_HIGHLIGHT:
-				return pCur->szText;
+				return pCur->textString();
 		}
 		pCur = pCur->pPrev;
 	}
 	return KviQString::Empty;
 }
 
-const QString & KviIrcView::lastLineOfText()
+QString KviIrcView::lastLineOfText()
 {
 	if(!m_pLastLine)
 		return KviQString::Empty;
-	return m_pLastLine->szText;
+	return m_pLastLine->textString();
 }
 
 void KviIrcView::setMasterView(KviIrcView * v)
@@ -195,30 +141,13 @@ bool KviIrcView::startLogging(const QString & fname, bool bPrependCurBuffer)
 		m_pKviWindow->getDefaultLogFileName(szFname);
 	}
 
-#ifdef COMPILE_ZLIB_SUPPORT
-	if(KVI_OPTION_BOOL(KviOption_boolGzipLogs))
-		szFname += ".tmp";
-#endif
+	m_pLogFile = new KviLogFileWriter();
 
-	m_pLogFile = new QFile(szFname);
-
-	if(m_pLogFile->exists())
+	if(!m_pLogFile->open(szFname))
 	{
-		if(!m_pLogFile->open(QIODevice::Append | QIODevice::WriteOnly))
-		{
-			delete m_pLogFile;
-			m_pLogFile = nullptr;
-			return false;
-		}
-	}
-	else
-	{
-		if(!m_pLogFile->open(QIODevice::WriteOnly))
-		{
-			delete m_pLogFile;
-			m_pLogFile = nullptr;
-			return false;
-		}
+		delete m_pLogFile;
+		m_pLogFile = nullptr;
+		return false;
 	}
 
 	QDateTime date = QDateTime::currentDateTime();
@@ -239,53 +168,42 @@ bool KviIrcView::startLogging(const QString & fname, bool bPrependCurBuffer)
 
 void KviIrcView::add2Log(const QString & szBuffer, const QDateTime & aDate, int iMsgType, bool bPrependDate)
 {
-	QByteArray tmp;
+	// build the whole line and hand it to the writer in a single call
+	QString szLine;
 
 	if(iMsgType >= 0 && !KVI_OPTION_BOOL(KviOption_boolStripMsgTypeInLogs))
-	{
-		QString szMessageType = QString("%1 ").arg(iMsgType);
-
-		tmp = szMessageType.toUtf8();
-
-		if(m_pLogFile->write(tmp.data(), tmp.length()) == -1)
-			qDebug("WARNING: can't write to the log file.");
-	}
+		szLine = QString("%1 ").arg(iMsgType);
 
 	if(bPrependDate)
 	{
-		QString szDate;
 		QDateTime date = aDate.isValid() ? aDate : QDateTime::currentDateTime();
 		switch(KVI_OPTION_UINT(KviOption_uintOutputDatetimeFormat))
 		{
 			case 0:
-				szDate = date.toString("[hh:mm:ss] ");
+				szLine += date.toString("[hh:mm:ss] ");
 				break;
 			case 1:
-				szDate = date.toString(Qt::ISODate);
+				szLine += date.toString(Qt::ISODate);
 				if (date.timeSpec() == Qt::LocalTime)
 				{
 					// Log milliseconds. QDateTime.fromString can parse them already.
 					// However, the format is more complicated if a timezone is present,
 					// so only log them for local time.
-					szDate += date.toString(".zzz");
+					szLine += date.toString(".zzz");
 				}
-				szDate += " ";
+				szLine += " ";
 				break;
 			case 2:
-				szDate = QLocale().toString(date, QLocale::ShortFormat);
-				szDate += " ";
+				szLine += QLocale().toString(date, QLocale::ShortFormat);
+				szLine += " ";
 				break;
 		}
-
-		tmp = szDate.toUtf8();
-
-		if(m_pLogFile->write(tmp.data(), tmp.length()) == -1)
-			qDebug("WARNING: can't write to the log file.");
 	}
 
-	tmp = szBuffer.toUtf8();
+	szLine += szBuffer;
+
+	QByteArray tmp = szLine.toUtf8();
 	tmp.append('\n');
 
-	if(m_pLogFile->write(tmp.data(), tmp.length()) == -1)
-		qDebug("WARNING: can't write to the log file.");
+	m_pLogFile->write(tmp);
 }
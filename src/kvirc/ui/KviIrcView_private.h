@@ -25,8 +25,17 @@
 //=============================================================================
 
 #include "kvi_settings.h"
+#include "kvi_inttypes.h"
+#include "KviCString.h"
 
 #include <QString>
+#include <QFontMetricsF>
+#include <QColor>
+#include <QStaticText>
+#include <QObject>
+#include <QElapsedTimer>
+
+#include <vector>
 
 //
 // Internal data structures
@@ -77,20 +86,46 @@
 //     resets the color, bold and underline flags
 //
 
-struct KviIrcViewLineChunk
+// At parse time getTextLine() builds the chunks with their own strings:
+// they are packed in the line store (see KviIrcViewLineStore) once the line is complete.
+//
+
+struct KviIrcViewLineBuilderChunk
 {
-	unsigned char type;      // chunk type
-	int iTextStart;          // index in the szText string of the beginning of the block
-	int iTextLen;            // length in chars of the block (excluding the terminator)
 	kvi_wchar_t * szPayload; // KVI_TEXT_ESCAPE attribute command buffer and KVI_TEXT_ICON icon name (non zeroed for other attributes!!!)
 	kvi_wchar_t * szSmileId;
+	int iTextStart;          // index in the szText string of the beginning of the block
+	int iTextLen;            // length in chars of the block (excluding the terminator)
+	QRgb customFore;         // used with KVI_COLOR_CUSTOM (a QColor would take four times the space)
+	unsigned char type;      // chunk type
 	struct
 	{
 		unsigned char back; // optional background color for KVI_TEXT_COLOR attribute
 		unsigned char fore; // optional foreground color for KVI_TEXT_COLOR attribute (used also for KVI_TEXT_ESCAPE!!!)
 	} _KVI_PACKED colors;   // anonymous
-	                        //	QColor customBack;
-	QColor customFore;
+};
+
+// The packed chunk: a run of text with the same attributes.
+// There is one of these for each attribute change in each line of the
+// scrollback: the strings live in the line record (see KviIrcViewLine::payload())
+// so this is 20 bytes.
+
+// the smile id is stored after the payload (otherwise it's the payload itself)
+#define KVI_IRCVIEW_CHUNK_FLAG_SMILEID 1
+
+struct KviIrcViewLineChunk
+{
+	int iTextStart;          // index in the line text of the beginning of the block
+	int iTextLen;            // length in chars of the block (excluding the terminator)
+	QRgb customFore;         // used with KVI_COLOR_CUSTOM
+	unsigned int uPayload;   // offset of the payload from the line text, in chars (KVI_TEXT_ESCAPE and KVI_TEXT_ICON only!!!)
+	unsigned char type;      // chunk type
+	struct
+	{
+		unsigned char back; // optional background color for KVI_TEXT_COLOR attribute
+		unsigned char fore; // optional foreground color for KVI_TEXT_COLOR attribute (used also for KVI_TEXT_ESCAPE!!!)
+	} _KVI_PACKED colors;   // anonymous
+	unsigned char uFlags;
 };
 
 //
@@ -105,30 +140,72 @@ struct KviIrcViewWrappedBlock
 	float block_width;              // width of the block in pixels
 } _KVI_PACKED;
 
+struct KviIrcViewLineGlyphCache;
+
+//
+// A text line in the IrcView's memory
+//
+// The line is a single record of the line store: this struct is followed
+// by the chunks, the text and the chunk strings (zero terminated).
+//
+
 struct KviIrcViewLine
 {
-	// this is a text line in the IrcView's memory
 	unsigned int uIndex; // index of the text line (needed for find and splitting)
-	QString szText;      // data string without color codes nor escapes...
 	int iMsgType;        // type of the line (defines icon and colors)
 
-	// At line insert time the szData text is split in parts which
+	// At line insert time the text is split in parts which
 	// signal attribute changes (or icons)
-	unsigned int uChunkCount;      // number of allocated chunks
-	KviIrcViewLineChunk * pChunks; // pointer to the allocated structures
+	KviIrcViewLineChunk * pChunks; // right after this struct
+	unsigned int uChunkCount;      // number of chunks
+	int iTextLen;                  // length of the text without color codes nor escapes
 
 	// At paint time the data is re-split in drawable chunks which
 	// are either real data chunks or line wraps.
 	// The algorightm that does this is lazy and computes it
-	// only once for a given widget width (iMaxLineWidth)
+	// only once for a given widget width (iMaxLineWidth).
+	// The blocks are kept only for the lines near the view (see KviIrcView::trimWrappedBlocks())
+	// while the number of wraps stays valid for the whole buffer.
 	unsigned int uLineWraps;          // number of line wraps (lines - 1)
+	KviIrcViewWrappedBlock * pBlocks; // pointer to the re-split paintable blocks or 0 if not cached
 	int iMaxLineWidth;                // width that the blocks were calculated for (lazy calculation)
 	int iBlockCount;                  // number of allocated paintable blocks
-	KviIrcViewWrappedBlock * pBlocks; // pointer to the re-split paintable blocks
 
 	// next and previous line
 	KviIrcViewLine * pPrev;
 	KviIrcViewLine * pNext;
+
+	// shaped text of the blocks, built at paint time (see KviIrcViewGlyphCache)
+	KviIrcViewLineGlyphCache * pGlyphCache;
+
+	const QChar * text() const { return (const QChar *)(pChunks + uChunkCount); };
+	// a deep copy of the whole text
+	QString textString() const { return QString(text(), iTextLen); };
+	// like QString::mid() on the text (but never a shallow copy of the store memory)
+	QString textMid(int iStart, int iLen = -1) const
+	{
+		if(iStart > iTextLen)
+			return QString();
+		if(iStart < 0)
+		{
+			if(iLen >= 0)
+			{
+				iLen += iStart;
+				if(iLen <= 0)
+					return QString();
+			}
+			iStart = 0;
+		}
+		if((iLen < 0) || (iLen > (iTextLen - iStart)))
+			iLen = iTextLen - iStart;
+		return QString(text() + iStart, iLen);
+	};
+	const kvi_wchar_t * payload(const KviIrcViewLineChunk * c) const { return ((const kvi_wchar_t *)text()) + c->uPayload; };
+	const kvi_wchar_t * smileId(const KviIrcViewLineChunk * c) const
+	{
+		const kvi_wchar_t * p = payload(c);
+		return (c->uFlags & KVI_IRCVIEW_CHUNK_FLAG_SMILEID) ? (p + kvi_wstrlen(p) + 1) : p;
+	};
 };
 
 struct KviIrcViewWrappedBlockSelectionInfo
@@ -148,6 +225,236 @@ struct KviIrcViewWrappedBlockSelectionInfo
 #undef _KVI_PACKED
 #endif //!COMPILE_ON_WINDOWS
 
+class KviAnimatedPixmap;
+
+//
+// A line being parsed by getTextLine()
+//
+
+struct KviIrcViewLineBuilder
+{
+	KviIrcViewLineBuilder();
+	~KviIrcViewLineBuilder();
+
+	QString szText;                       // data string without color codes nor escapes...
+	KviIrcViewLineBuilderChunk * pChunks; // allocated with KviMemory
+	unsigned int uChunkCount;
+	std::vector<KviAnimatedPixmap *> vAnimatedSmiles;
+
+	// frees the chunks and their strings
+	void clear();
+};
+
+//
+// The memory of the lines of a view
+//
+// The lines are packed in records (the line struct, its chunks, its text
+// and its chunk strings) that are carved out of large pages.
+// A view drops its lines mostly in the order they were added so the pages
+// empty out in order too: a page is freed when its last record goes away.
+// The records that take more than a quarter of a page get a page of their own.
+//
+
+#define KVI_IRCVIEW_LINESTORE_PAGE_SIZE (32 * 1024)
+
+struct KviIrcViewLineStorePage;
+
+class KviIrcViewLineStore
+{
+public:
+	KviIrcViewLineStore();
+	~KviIrcViewLineStore();
+
+private:
+	KviIrcViewLineStorePage * m_pCurrentPage; // where the new records go
+	std::size_t m_uPageBytes;                 // allocated in pages
+	std::size_t m_uLineBytes;                 // used by the records of the live lines
+	unsigned int m_uLines;
+	unsigned int m_uPages;
+	unsigned int m_uBlockLines;               // lines that have their wrapped blocks
+	KviIrcViewLine * m_pOldestBlockLine;      // least recently used line with blocks
+	KviIrcViewLine * m_pNewestBlockLine;      // most recently used line with blocks
+
+public:
+	// packs the parsed line in a new record (the builder keeps its data)
+	KviIrcViewLine * allocateLine(KviIrcViewLineBuilder & b, int iMsgType);
+	void freeLine(KviIrcViewLine * pLine);
+	bool owns(const KviIrcViewLine * pLine) const;
+	// moves a line of another store to a new record of this one and returns it.
+	// The old pointer is no longer valid and the line loses its wrapped blocks
+	KviIrcViewLine * adoptLine(KviIrcViewLine * pLine);
+
+	// allocates or resizes the wrapped blocks of the line and marks them as used.
+	// The lines that have blocks are linked from the least to the most recently used
+	void allocateBlocks(KviIrcViewLine * pLine, int iCount);
+	// marks the blocks of the line as used
+	void touchBlocks(KviIrcViewLine * pLine);
+	// drops the wrapped blocks of the line (the number of wraps stays valid)
+	void freeBlocks(KviIrcViewLine * pLine);
+	KviIrcViewLine * oldestBlockLine() const { return m_pOldestBlockLine; };
+
+	std::size_t pageBytes() const { return m_uPageBytes; };
+	std::size_t lineBytes() const { return m_uLineBytes; };
+	unsigned int lines() const { return m_uLines; };
+	unsigned int pages() const { return m_uPages; };
+	unsigned int blockLines() const { return m_uBlockLines; };
+
+private:
+	void * allocate(std::size_t uBytes);
+	void free(void * pRecord);
+	void unlinkBlocks(KviIrcViewLine * pLine);
+	void linkBlocksAsNewest(KviIrcViewLine * pLine);
+};
+
+//
+// Sparse cache of the character widths for the whole unicode range
+//
+// The code points are split in 17 planes of 256 pages of 256 characters.
+// Planes and pages are allocated (and the widths measured) on first use
+// so Latin-only views pay nothing and CJK or emoji heavy ones
+// query the font metrics only once per distinct character.
+// The cache must be cleared when the font metrics change.
+//
+
+#define KVI_IRCVIEW_CHARWIDTH_PLANES 17
+
+class KviIrcViewCharWidthCache
+{
+public:
+	KviIrcViewCharWidthCache();
+	~KviIrcViewCharWidthCache();
+
+private:
+	QFontMetricsF * m_pFm; // not owned
+	float ** m_pPlanes[KVI_IRCVIEW_CHARWIDTH_PLANES];
+
+public:
+	// drops all the cached widths and starts using the specified metrics
+	void setFontMetrics(QFontMetricsF * pFm);
+	void clear();
+
+	float width(unsigned int uCodePoint)
+	{
+		if((uCodePoint >> 16) < KVI_IRCVIEW_CHARWIDTH_PLANES)
+		{
+			float ** pPlane = m_pPlanes[uCodePoint >> 16];
+			if(pPlane)
+			{
+				float * pPage = pPlane[(uCodePoint >> 8) & 0xff];
+				if(pPage && (pPage[uCodePoint & 0xff] >= 0))
+					return pPage[uCodePoint & 0xff];
+			}
+		}
+		return measure(uCodePoint);
+	}
+
+private:
+	float measure(unsigned int uCodePoint);
+};
+
+//
+// Cache of the shaped text of the painted lines
+//
+// Shaping the text is the most expensive part of a paint event.
+// The visible blocks of each line are shaped once (as QStaticText)
+// and the result is kept until the line is wrapped again.
+// The caches of all the views share a memory budget: when it's
+// exceeded the least recently painted lines lose their cache.
+//
+
+// the shared memory budget, in bytes
+#define KVI_IRCVIEW_GLYPH_CACHE_BUDGET (8 * 1024 * 1024)
+
+struct KviIrcViewLineGlyphCache
+{
+	KviIrcViewLine * pLine;
+	int iMaxLineWidth;                   // the wrap width the blocks were shaped for
+	std::size_t uBytes;                  // estimated memory usage
+	std::vector<QStaticText> vBlocks;    // one per wrapped block, built on first paint
+	KviIrcViewLineGlyphCache * pNewer;   // LRU list links
+	KviIrcViewLineGlyphCache * pOlder;
+};
+
+class KviIrcViewGlyphCache
+{
+public:
+	KviIrcViewGlyphCache();
+	~KviIrcViewGlyphCache();
+
+private:
+	static KviIrcViewGlyphCache * m_pInstance;
+
+	KviIrcViewLineGlyphCache * m_pNewest;
+	KviIrcViewLineGlyphCache * m_pOldest;
+	std::size_t m_uBytes;
+	kvi_u64_t m_uHits;
+	kvi_u64_t m_uMisses;
+	kvi_u64_t m_uEvictions;
+
+public:
+	static KviIrcViewGlyphCache * instance();
+	// called when the last view dies: the fonts must go away before the application does
+	static void destroy();
+	static bool exists() { return m_pInstance != nullptr; };
+
+	// returns the shaped text of the specified block of the line (that must have been wrapped already)
+	const QStaticText & blockText(KviIrcViewLine * pLine, int iBlock);
+	// must be called when the line is deleted or its blocks are recalculated
+	void drop(KviIrcViewLine * pLine)
+	{
+		if(pLine->pGlyphCache)
+			remove(pLine->pGlyphCache);
+	}
+
+	std::size_t bytes() const { return m_uBytes; };
+	kvi_u64_t hits() const { return m_uHits; };
+	kvi_u64_t misses() const { return m_uMisses; };
+	kvi_u64_t evictions() const { return m_uEvictions; };
+
+private:
+	void remove(KviIrcViewLineGlyphCache * c);
+	void unlink(KviIrcViewLineGlyphCache * c);
+	void linkAsNewest(KviIrcViewLineGlyphCache * c);
+};
+
+// the slowest pace of the scheduled repaints when painting can't keep up with the inflow
+#define KVI_IRCVIEW_MAX_REPAINT_INTERVAL 250
+
+class KviIrcView;
+
+//
+// Collects the views that have new lines and repaints them
+// at most once per display frame.
+//
+class KviIrcViewRepaintScheduler : public QObject
+{
+public:
+	KviIrcViewRepaintScheduler();
+	~KviIrcViewRepaintScheduler();
+
+private:
+	static KviIrcViewRepaintScheduler * m_pInstance;
+
+	std::vector<KviIrcView *> m_vDirty;
+	int m_iTimer;
+	int m_iFrameInterval;        // milliseconds, stretched when painting is too slow
+	QElapsedTimer m_LastFrame;
+	kvi_i64_t m_iFramePaintTime; // nanoseconds spent in paint events since the last frame
+
+public:
+	static KviIrcViewRepaintScheduler * instance();
+	static bool exists() { return m_pInstance != nullptr; };
+
+	void schedule(KviIrcView * v);
+	void unschedule(KviIrcView * v);
+	void paintDone(kvi_i64_t iNSecs) { m_iFramePaintTime += iNSecs; };
+	int frameInterval() const { return m_iFrameInterval; };
+
+protected:
+	void timerEvent(QTimerEvent * e) override;
+	static int displayFrameInterval();
+};
+
 //
 // Screen layout
 //
@@ -0,0 +1,479 @@
+//===========================================================================
+//
+//   File : KviIrcView_snapshot.cpp
+//   Creation date : Mon Oct 19 2026 23:58:12 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2000-2026 Szymon Stefanek (pragma at kvirc dot net)
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//===========================================================================
+
+//
+// The scrollback snapshots: the parsed lines of a view are dumped to a file
+// and read back in a later session without going through getTextLine() again
+//
+
+#include "KviIrcView.h"
+#include "KviIrcView_private.h"
+#include "KviControlCodes.h"
+#include "KviMemory.h"
+#include "KviTextIconManager.h"
+#include "KviAnimatedPixmap.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QScrollBar>
+
+#include <cstring>
+
+#define KVI_IRCVIEW_SNAPSHOT_VERSION 1
+// longer strings are taken as a sign of a damaged file (and their byte size must fit an int)
+#define KVI_IRCVIEW_SNAPSHOT_MAX_STRING_LEN 0x1000000
+
+// The file starts with this header and continues with uLineCount line records.
+// Everything is in the native byte order (uVersion doubles as the byte order check)
+// and the records are 4 byte aligned so the file can be mapped and walked in place.
+struct KviIrcViewSnapshotHeader
+{
+	char cMagic[4]; // "KVSS"
+	quint32 uVersion;
+	quint32 uLineCount;
+	quint32 uReserved;
+};
+
+// A line: followed by uTextLen utf16 chars (padded to 4 bytes) and uChunkCount chunks
+struct KviIrcViewSnapshotLine
+{
+	quint32 uSize; // of the whole record, this header included
+	qint32 iMsgType;
+	quint32 uTextLen;
+	quint32 uChunkCount;
+};
+
+// A chunk: followed by the payload and the smile id utf16 chars (each padded to 4 bytes)
+struct KviIrcViewSnapshotChunk
+{
+	qint32 iTextStart;
+	qint32 iTextLen;
+	quint32 uCustomFore;
+	quint32 uPayloadLen;
+	quint32 uSmileIdLen;
+	quint8 uType;
+	quint8 uBack;
+	quint8 uFore;
+	quint8 uSmileIdIsPayload;
+};
+
+static inline qint64 snapshot_padded(qint64 iBytes)
+{
+	return (iBytes + 3) & ~qint64(3);
+}
+
+static void snapshot_append_string(QByteArray & data, const kvi_wchar_t * pStr, int iLen)
+{
+	int iBytes = iLen * sizeof(kvi_wchar_t);
+	data.append((const char *)pStr, iBytes);
+	data.append((int)(snapshot_padded(iBytes) - iBytes), '\0');
+}
+
+static void snapshot_append_line(QByteArray & data, KviIrcViewLine * pLine)
+{
+	int iStart = data.size();
+
+	KviIrcViewSnapshotLine l;
+	l.uSize = 0; // patched below
+	l.iMsgType = pLine->iMsgType;
+	l.uTextLen = pLine->iTextLen;
+	l.uChunkCount = pLine->uChunkCount;
+	data.append((const char *)&l, sizeof(l));
+	snapshot_append_string(data, (const kvi_wchar_t *)pLine->text(), pLine->iTextLen);
+
+	for(unsigned int i = 0; i < pLine->uChunkCount; i++)
+	{
+		KviIrcViewLineChunk * pChunk = pLine->pChunks + i;
+
+		KviIrcViewSnapshotChunk c;
+		c.iTextStart = pChunk->iTextStart;
+		c.iTextLen = pChunk->iTextLen;
+		c.uCustomFore = pChunk->customFore;
+		c.uType = pChunk->type;
+		c.uBack = pChunk->colors.back;
+		c.uFore = pChunk->colors.fore;
+		c.uSmileIdIsPayload = 0;
+		c.uPayloadLen = 0;
+		c.uSmileIdLen = 0;
+
+		// the payload is garbage for the other chunk types
+		bool bEscape = (pChunk->type == KviControlCodes::Escape);
+		bool bIcon = (pChunk->type == KviControlCodes::Icon);
+		if(bEscape || bIcon)
+			c.uPayloadLen = kvi_wstrlen(pLine->payload(pChunk));
+		if(bIcon)
+		{
+			if(!(pChunk->uFlags & KVI_IRCVIEW_CHUNK_FLAG_SMILEID))
+				c.uSmileIdIsPayload = 1;
+			else
+				c.uSmileIdLen = kvi_wstrlen(pLine->smileId(pChunk));
+		}
+
+		data.append((const char *)&c, sizeof(c));
+		if(c.uPayloadLen)
+			snapshot_append_string(data, pLine->payload(pChunk), c.uPayloadLen);
+		if(c.uSmileIdLen)
+			snapshot_append_string(data, pLine->smileId(pChunk), c.uSmileIdLen);
+	}
+
+	quint32 uSize = data.size() - iStart;
+	std::memcpy(data.data() + iStart, &uSize, sizeof(uSize));
+}
+
+// Returns the size of the record at p or 0 if it is broken
+static quint32 snapshot_record_size(const uchar * p, const uchar * pEnd)
+{
+	if((pEnd - p) < (int)sizeof(KviIrcViewSnapshotLine))
+		return 0;
+	quint32 uSize;
+	std::memcpy(&uSize, p, sizeof(uSize));
+	if((uSize < sizeof(KviIrcViewSnapshotLine)) || (uSize & 3) || (uSize > (quint32)(pEnd - p)))
+		return 0;
+	return uSize;
+}
+
+static kvi_wchar_t * snapshot_read_string(const uchar *& p, const uchar * pEnd, quint32 uLen)
+{
+	// the length comes from the file: check it before multiplying
+	if((uLen > (quint64)(pEnd - p) / sizeof(kvi_wchar_t)) || (uLen > KVI_IRCVIEW_SNAPSHOT_MAX_STRING_LEN))
+		return nullptr;
+	qint64 iBytes = (qint64)uLen * sizeof(kvi_wchar_t);
+	if((pEnd - p) < snapshot_padded(iBytes))
+		return nullptr;
+	kvi_wchar_t * pStr = (kvi_wchar_t *)KviMemory::allocate((int)iBytes + sizeof(kvi_wchar_t));
+	KviMemory::copy(pStr, p, (int)iBytes);
+	pStr[uLen] = 0;
+	p += snapshot_padded(iBytes);
+	return pStr;
+}
+
+// Fills the builder with the line stored in the record [p,pEnd): returns false if the record is broken
+static bool snapshot_read_line(const uchar * p, const uchar * pEnd, KviIrcViewLineBuilder & b, int & iMsgType)
+{
+	KviIrcViewSnapshotLine l;
+	std::memcpy(&l, p, sizeof(l));
+	p += sizeof(l);
+
+	if((l.uChunkCount < 1) || (l.uTextLen > (quint64)(pEnd - p) / sizeof(kvi_wchar_t)) || (l.uTextLen > KVI_IRCVIEW_SNAPSHOT_MAX_STRING_LEN))
+		return false;
+	// each chunk takes at least its header
+	if(l.uChunkCount > (quint64)(pEnd - p) / sizeof(KviIrcViewSnapshotChunk))
+		return false;
+	qint64 iTextBytes = (qint64)l.uTextLen * sizeof(kvi_wchar_t);
+	if((pEnd - p) < snapshot_padded(iTextBytes))
+		return false;
+
+	b.szText = QString((const QChar *)p, l.uTextLen);
+	p += snapshot_padded(iTextBytes);
+	iMsgType = l.iMsgType;
+	b.uChunkCount = 0;
+	b.pChunks = (KviIrcViewLineBuilderChunk *)KviMemory::allocate((int)(l.uChunkCount * sizeof(KviIrcViewLineBuilderChunk)));
+
+	bool bOk = true;
+	for(unsigned int i = 0; i < l.uChunkCount; i++)
+	{
+		KviIrcViewSnapshotChunk c;
+		if((pEnd - p) < (int)sizeof(c))
+		{
+			bOk = false;
+			break;
+		}
+		std::memcpy(&c, p, sizeof(c));
+		p += sizeof(c);
+
+		KviIrcViewLineBuilderChunk * pChunk = b.pChunks + i;
+		pChunk->iTextStart = c.iTextStart;
+		pChunk->iTextLen = c.iTextLen;
+		pChunk->customFore = c.uCustomFore;
+		pChunk->type = c.uType;
+		pChunk->colors.back = c.uBack;
+		pChunk->colors.fore = c.uFore;
+		pChunk->szPayload = nullptr;
+		pChunk->szSmileId = nullptr;
+
+		if((pChunk->iTextStart < 0) || (pChunk->iTextLen < 0) || (((qint64)pChunk->iTextStart + pChunk->iTextLen) > (qint64)l.uTextLen))
+		{
+			bOk = false;
+			break;
+		}
+
+		if((pChunk->type == KviControlCodes::Escape) || (pChunk->type == KviControlCodes::Icon))
+		{
+			// counted now: from here on the builder owns the chunk strings
+			b.uChunkCount = i + 1;
+			pChunk->szPayload = snapshot_read_string(p, pEnd, c.uPayloadLen);
+			if(!pChunk->szPayload)
+			{
+				pChunk->type = KviControlCodes::Reset; // nothing to free
+				bOk = false;
+				break;
+			}
+			if(pChunk->type == KviControlCodes::Icon)
+			{
+				pChunk->szSmileId = c.uSmileIdIsPayload ? pChunk->szPayload : snapshot_read_string(p, pEnd, c.uSmileIdLen);
+				if(!pChunk->szSmileId)
+				{
+					pChunk->szSmileId = pChunk->szPayload;
+					bOk = false;
+					break;
+				}
+			}
+		}
+		b.uChunkCount = i + 1;
+	}
+
+	if(!bOk)
+	{
+		b.clear();
+		return false;
+	}
+
+	return true;
+}
+
+// Maps (or reads) the snapshot file and checks its header: returns the first record or nullptr
+static const uchar * snapshot_open(QFile & f, QByteArray & buffer, const uchar *& pEnd, quint32 & uLineCount)
+{
+	if(!f.open(QFile::ReadOnly))
+		return nullptr;
+	if(f.size() < (qint64)sizeof(KviIrcViewSnapshotHeader))
+		return nullptr;
+
+	const uchar * p = f.map(0, f.size());
+	if(!p)
+	{
+		buffer = f.readAll();
+		p = (const uchar *)buffer.constData();
+	}
+	pEnd = p + f.size();
+
+	KviIrcViewSnapshotHeader h;
+	std::memcpy(&h, p, sizeof(h));
+	if((std::memcmp(h.cMagic, "KVSS", 4) != 0) || (h.uVersion != KVI_IRCVIEW_SNAPSHOT_VERSION))
+		return nullptr;
+
+	uLineCount = h.uLineCount;
+	return p + sizeof(h);
+}
+
+bool KviIrcView::saveSnapshot(const QString & szFileName, unsigned int uMaxLines)
+{
+	QByteArray data;
+	KviIrcViewSnapshotHeader h;
+	std::memcpy(h.cMagic, "KVSS", 4);
+	h.uVersion = KVI_IRCVIEW_SNAPSHOT_VERSION;
+	h.uLineCount = 0;
+	h.uReserved = 0;
+	data.append((const char *)&h, sizeof(h));
+
+	// the newest uMaxLines lines
+	KviIrcViewLine * pFirst = nullptr;
+	unsigned int uLines = 0;
+	for(KviIrcViewLine * l = m_pLastLine; l && (uLines < uMaxLines); l = l->pPrev)
+	{
+		pFirst = l;
+		uLines++;
+	}
+
+	// the lines of the previous session that are still waiting to be shown come first:
+	// they are copied as they are, without building them
+	unsigned int uPending = qMin(m_uSnapshotLines, uMaxLines - uLines);
+	if(m_uSnapshotLines)
+	{
+		QFile f(m_szSnapshotFile);
+		QByteArray buffer;
+		const uchar * pEnd = nullptr;
+		quint32 uCount = 0;
+		const uchar * p = snapshot_open(f, buffer, pEnd, uCount);
+		// the pending lines are m_uSnapshotLines records after m_uSnapshotSkip ones: keep the newest uPending
+		unsigned int uSkip = m_uSnapshotSkip + (m_uSnapshotLines - uPending);
+		unsigned int uCopied = 0;
+		while(p && (uCopied < uPending))
+		{
+			quint32 uSize = snapshot_record_size(p, pEnd);
+			if(!uSize)
+				break;
+			if(uSkip)
+				uSkip--;
+			else
+			{
+				data.append((const char *)p, uSize);
+				uCopied++;
+			}
+			p += uSize;
+		}
+		// the pending lines now live at the beginning of the new file
+		m_uSnapshotBaseIndex += m_uSnapshotLines - uCopied;
+		m_uSnapshotSkip = 0;
+		m_uSnapshotLines = uCopied;
+		m_szSnapshotFile = szFileName;
+		h.uLineCount += uCopied;
+	}
+
+	for(KviIrcViewLine * l = pFirst; l; l = l->pNext)
+		snapshot_append_line(data, l);
+	h.uLineCount += uLines;
+	std::memcpy(data.data(), &h, sizeof(h));
+
+	QSaveFile f(szFileName);
+	if(!f.open(QFile::WriteOnly | QFile::Truncate))
+		return false;
+	if(f.write(data) != data.size())
+	{
+		f.cancelWriting();
+		return false;
+	}
+	return f.commit();
+}
+
+bool KviIrcView::restoreSnapshot(const QString & szFileName)
+{
+	// the split views share the line indexes of their master: keep it simple
+	if(m_pMasterView || m_uSnapshotLines)
+		return false;
+
+	QFile f(szFileName);
+	QByteArray buffer;
+	const uchar * pEnd = nullptr;
+	quint32 uCount = 0;
+	if(!snapshot_open(f, buffer, pEnd, uCount) || !uCount)
+		return false;
+
+	// reserve the indexes of the lines now: they must come before the ones appended meanwhile
+	m_szSnapshotFile = szFileName;
+	m_uSnapshotLines = qMin(uCount, (quint32)m_iMaxLines);
+	m_uSnapshotSkip = uCount - m_uSnapshotLines; // the oldest ones wouldn't fit
+	m_uSnapshotBaseIndex = m_uNextLineIndex;
+	m_uNextLineIndex += m_uSnapshotLines;
+
+	if(isVisible())
+		loadSnapshot();
+	return true;
+}
+
+void KviIrcView::loadSnapshot()
+{
+	unsigned int uLines = m_uSnapshotLines;
+	unsigned int uIndex = m_uSnapshotBaseIndex;
+	unsigned int uSkip = m_uSnapshotSkip;
+	QFile f(m_szSnapshotFile);
+	m_uSnapshotSkip = 0;
+	m_uSnapshotLines = 0;
+	m_szSnapshotFile.clear();
+
+	QByteArray buffer;
+	const uchar * pEnd = nullptr;
+	quint32 uCount = 0;
+	const uchar * p = snapshot_open(f, buffer, pEnd, uCount);
+	if(!p)
+		return;
+
+	// skip the oldest records that didn't fit when restoring: saveSnapshot() writes the
+	// pending lines first and the ones that follow them are already in the buffer
+	while(uSkip > 0)
+	{
+		quint32 uSize = snapshot_record_size(p, pEnd);
+		if(!uSize)
+			return;
+		p += uSize;
+		uSkip--;
+	}
+
+	KviIrcViewLine * pFirst = nullptr;
+	KviIrcViewLine * pLast = nullptr;
+	int iCount = 0;
+	KviIrcViewLineBuilder builder;
+
+	while(uLines > 0)
+	{
+		quint32 uSize = snapshot_record_size(p, pEnd);
+		if(!uSize)
+			break;
+		int iMsgType = 0;
+		bool bOk = snapshot_read_line(p, p + uSize, builder, iMsgType);
+		p += uSize;
+		uLines--;
+		if(!bOk)
+			continue;
+
+		for(unsigned int i = 0; i < builder.uChunkCount; i++)
+		{
+			if(builder.pChunks[i].type != KviControlCodes::Icon)
+				continue;
+			QString szSmileId;
+			szSmileId.setUtf16(builder.pChunks[i].szSmileId, kvi_wstrlen(builder.pChunks[i].szSmileId));
+			KviTextIcon * pIcon = g_pTextIconManager->lookupTextIcon(szSmileId);
+			if(pIcon && pIcon->animatedPixmap())
+			{
+				disconnect(pIcon->animatedPixmap(), SIGNAL(frameChanged()), this, SLOT(animatedIconChange()));
+				connect(pIcon->animatedPixmap(), SIGNAL(frameChanged()), this, SLOT(animatedIconChange()));
+				builder.vAnimatedSmiles.push_back(pIcon->animatedPixmap());
+			}
+		}
+
+		KviIrcViewLine * pLine = packLine(builder, iMsgType);
+		pLine->uIndex = uIndex++;
+
+		pLine->pPrev = pLast;
+		if(pLast)
+			pLast->pNext = pLine;
+		else
+			pFirst = pLine;
+		pLast = pLine;
+		iCount++;
+	}
+
+	if(!pFirst)
+		return;
+
+	// the lines of the previous session go before everything else
+	bool bFollowing = (m_pCurLine == m_pLastLine);
+	pLast->pNext = m_pFirstLine;
+	if(m_pFirstLine)
+		m_pFirstLine->pPrev = pLast;
+	else
+		m_pLastLine = pLast;
+	m_pFirstLine = pFirst;
+	m_iNumLines += iCount;
+	if(!m_pCurLine)
+		m_pCurLine = m_pLastLine;
+
+	int iRemoved = 0;
+	while(m_iNumLines > m_iMaxLines)
+	{
+		removeHeadLine(false);
+		iRemoved++;
+	}
+
+	m_bSkipScrollBarRepaint = true;
+	if(bFollowing)
+		m_iLastScrollBarValue = m_iNumLines;
+	else
+		m_iLastScrollBarValue += iCount - iRemoved;
+	m_pScrollBar->setRange(0, m_iNumLines);
+	m_pScrollBar->setValue(m_iLastScrollBarValue);
+	m_bSkipScrollBarRepaint = false;
+
+	update();
+}
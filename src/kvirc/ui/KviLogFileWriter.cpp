@@ -0,0 +1,316 @@
+//=============================================================================
+//
+//   File : KviLogFileWriter.cpp
+//   Creation date : Mon Oct 19 2026 21:36:12 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2000-2026 Szymon Stefanek (pragma at kvirc dot net)
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviLogFileWriter.h"
+#include "KviOptions.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QTimerEvent>
+
+#ifdef COMPILE_ZLIB_SUPPORT
+#include <zlib.h>
+#endif
+
+// the buffer is written immediately when it grows over this size
+#define KVI_LOGFILEWRITER_MAX_BUFFER_SIZE 65536
+
+KviLogFileWriter::KviLogFileWriter()
+    : QObject()
+{
+	m_pFile = nullptr;
+	m_bCompressed = false;
+	m_uSegment = 1;
+	m_uIndexedSegments = 0;
+	m_iSegmentSize = 0;
+	m_iFlushTimer = 0;
+}
+
+KviLogFileWriter::~KviLogFileWriter()
+{
+	close();
+}
+
+QString KviLogFileWriter::segmentFileName(const QString & szFirstSegment, unsigned int uSegment)
+{
+	if(uSegment <= 1)
+		return szFirstSegment;
+
+	QString szRet = szFirstSegment;
+	QString szSuffix = QString("+%1").arg(uSegment);
+	int iIdx = szRet.lastIndexOf(".log", -1, Qt::CaseInsensitive);
+	// don't get fooled by a ".log" in the middle of the name
+	if(iIdx != -1 && (iIdx + 4 == szRet.length() || szRet.mid(iIdx + 4).compare(".gz", Qt::CaseInsensitive) == 0))
+		szRet.insert(iIdx, szSuffix);
+	else
+		szRet.append(szSuffix);
+	return szRet;
+}
+
+QString KviLogFileWriter::segmentIndexFileName(const QString & szFirstSegment)
+{
+	QString szRet = szFirstSegment;
+	if(szRet.endsWith(".gz", Qt::CaseInsensitive))
+		szRet.chop(3);
+	if(szRet.endsWith(".log", Qt::CaseInsensitive))
+		szRet.chop(4);
+	szRet.append(".segments");
+	return szRet;
+}
+
+void KviLogFileWriter::readSegmentIndex(const QString & szFirstSegment, QStringList & lSegments)
+{
+	lSegments.clear();
+
+	QFile f(segmentIndexFileName(szFirstSegment));
+	if(!f.open(QIODevice::ReadOnly))
+		return;
+
+	QDir dir = QFileInfo(szFirstSegment).absoluteDir();
+
+	while(!f.atEnd())
+	{
+		QString szLine = QString::fromUtf8(f.readLine()).trimmed();
+		QStringList lParts = szLine.split('\t');
+		if(lParts.count() < 2)
+			continue;
+		bool bOk;
+		unsigned int uSegment = lParts.at(0).toUInt(&bOk);
+		if(!bOk || uSegment != (unsigned int)lSegments.count() + 1)
+			continue; // broken or duplicate entry
+		lSegments.append(dir.filePath(lParts.at(1)));
+	}
+}
+
+bool KviLogFileWriter::open(const QString & szFileName)
+{
+	close();
+
+	m_szFirstSegment = szFileName;
+#ifdef COMPILE_ZLIB_SUPPORT
+	m_bCompressed = KVI_OPTION_BOOL(KviOption_boolGzipLogs);
+#else
+	m_bCompressed = false;
+#endif
+
+	QStringList lSegments;
+	readSegmentIndex(m_szFirstSegment, lSegments);
+	m_uIndexedSegments = lSegments.count();
+	m_uSegment = lSegments.isEmpty() ? 1 : lSegments.count();
+
+	return openSegment();
+}
+
+bool KviLogFileWriter::openSegment()
+{
+	m_szFileName = segmentFileName(m_szFirstSegment, m_uSegment);
+
+	m_pFile = new QFile(m_bCompressed ? m_szFileName + ".tmp" : m_szFileName);
+	if(!m_pFile->open(QIODevice::Append | QIODevice::WriteOnly))
+	{
+		delete m_pFile;
+		m_pFile = nullptr;
+		return false;
+	}
+
+	m_iSegmentSize = m_pFile->size();
+	if(m_bCompressed)
+		m_iSegmentSize += QFileInfo(m_szFileName).size();
+	return true;
+}
+
+void KviLogFileWriter::close()
+{
+	if(!m_pFile)
+		return;
+	flush();
+	closeSegment();
+}
+
+void KviLogFileWriter::closeSegment()
+{
+	if(m_iFlushTimer)
+	{
+		killTimer(m_iFlushTimer);
+		m_iFlushTimer = 0;
+	}
+#ifdef COMPILE_ZLIB_SUPPORT
+	if(m_bCompressed)
+		compressPendingData();
+#endif
+	m_pFile->close();
+	delete m_pFile;
+	m_pFile = nullptr;
+}
+
+void KviLogFileWriter::write(const QByteArray & szData)
+{
+	if(!m_pFile)
+		return;
+
+	m_szBuffer.append(szData);
+
+	unsigned int uLatency = KVI_OPTION_UINT(KviOption_uintLogWriteLatency);
+	if((uLatency == 0) || (m_szBuffer.size() >= KVI_LOGFILEWRITER_MAX_BUFFER_SIZE))
+		flush();
+	else if(!m_iFlushTimer)
+		m_iFlushTimer = startTimer(uLatency);
+}
+
+void KviLogFileWriter::flush()
+{
+	if(m_iFlushTimer)
+	{
+		killTimer(m_iFlushTimer);
+		m_iFlushTimer = 0;
+	}
+
+	if(!m_pFile || m_szBuffer.isEmpty())
+		return;
+
+	// the buffer contains only complete lines so the segments are never split mid-line.
+	// For compressed logs the limit is checked against the compressed size plus the
+	// still uncompressed data: the segments end up being a bit smaller than requested.
+	qint64 iLimit = (qint64)KVI_OPTION_UINT(KviOption_uintLogRotationSize) * 1024 * 1024;
+	if(iLimit && (m_iSegmentSize > 0) && (m_iSegmentSize + m_szBuffer.size() > iLimit))
+	{
+		rotate();
+		if(!m_pFile)
+		{
+			m_szBuffer.clear();
+			return;
+		}
+	}
+
+	qint64 iWritten = m_pFile->write(m_szBuffer);
+	if(iWritten == -1)
+		qDebug("WARNING: can't write to the log file.");
+	else
+		m_iSegmentSize += iWritten;
+	m_pFile->flush();
+	m_szBuffer.clear();
+}
+
+void KviLogFileWriter::sync()
+{
+	if(!m_pFile)
+		return;
+	flush();
+#ifdef COMPILE_ZLIB_SUPPORT
+	if(m_bCompressed)
+	{
+		compressPendingData();
+		if(!m_pFile->open(QIODevice::Append | QIODevice::WriteOnly))
+		{
+			qDebug("WARNING: can't reopen the log file.");
+			delete m_pFile;
+			m_pFile = nullptr;
+		}
+	}
+#endif
+}
+
+void KviLogFileWriter::rotate()
+{
+	// a rotation that failed to open the next segment is retried at the next flush:
+	// the segments that are already in the index must not be listed again
+	bool bIndexFirst = (m_uIndexedSegments < 1);
+	QDateTime start;
+	if(bIndexFirst)
+	{
+		// the first rotation of this log: the index doesn't exist yet
+		QFileInfo fi(m_bCompressed ? m_szFileName + ".tmp" : m_szFileName);
+		start = fi.birthTime().isValid() ? fi.birthTime() : QDateTime::currentDateTime();
+	}
+
+	closeSegment();
+
+	if(bIndexFirst)
+		appendToIndex(1, m_szFileName, start);
+
+	m_uSegment++;
+	if(openSegment())
+	{
+		if(m_uSegment > m_uIndexedSegments)
+			appendToIndex(m_uSegment, m_szFileName, QDateTime::currentDateTime());
+		return;
+	}
+
+	// keep writing to the current segment: it will grow over the limit
+	qDebug("WARNING: can't open the log file segment %s", m_szFileName.toUtf8().data());
+	m_uSegment--;
+	if(!openSegment())
+		qDebug("WARNING: can't reopen the log file %s, logging stopped", m_szFileName.toUtf8().data());
+}
+
+void KviLogFileWriter::appendToIndex(unsigned int uSegment, const QString & szFileName, const QDateTime & start)
+{
+	QFile f(segmentIndexFileName(m_szFirstSegment));
+	if(!f.open(QIODevice::Append | QIODevice::WriteOnly))
+	{
+		qDebug("WARNING: can't write the log segment index.");
+		return;
+	}
+	QByteArray szLine = QString("%1\t%2\t%3\n").arg(uSegment).arg(QFileInfo(szFileName).fileName(), start.toString(Qt::ISODate)).toUtf8();
+	if(f.write(szLine) == szLine.size())
+		m_uIndexedSegments = uSegment;
+	f.close();
+}
+
+#ifdef COMPILE_ZLIB_SUPPORT
+void KviLogFileWriter::compressPendingData()
+{
+	// appends the contents of the .tmp file to the .gz one as a new gzip member
+	m_pFile->close();
+	if(!m_pFile->open(QIODevice::ReadOnly))
+		return;
+	QByteArray bytes = m_pFile->readAll();
+	m_pFile->close();
+
+	if(bytes.isEmpty())
+		return;
+
+	gzFile file = gzopen(QFile::encodeName(m_szFileName).data(), "ab9");
+	if(file)
+	{
+		gzwrite(file, bytes.data(), bytes.size());
+		gzclose(file);
+		m_pFile->remove();
+		m_iSegmentSize = QFileInfo(m_szFileName).size();
+	}
+	else
+	{
+		qDebug("Can't open compressed stream");
+	}
+}
+#endif
+
+void KviLogFileWriter::timerEvent(QTimerEvent * e)
+{
+	if(e->timerId() == m_iFlushTimer)
+		flush();
+	else
+		QObject::timerEvent(e);
+}
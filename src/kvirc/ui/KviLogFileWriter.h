@@ -0,0 +1,103 @@
+#ifndef _KVI_LOGFILEWRITER_H_
+#define _KVI_LOGFILEWRITER_H_
+//=============================================================================
+//
+//   File : KviLogFileWriter.h
+//   Creation date : Mon Oct 19 2026 21:36:12 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2000-2026 Szymon Stefanek (pragma at kvirc dot net)
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+/**
+* \file KviLogFileWriter.h
+* \brief The buffered writer behind the KviIrcView logs
+*
+* The lines are collected in memory and written in large chunks
+* at most KviOption_uintLogWriteLatency msecs after they arrive.
+*
+* When a log grows over KviOption_uintLogRotationSize MiB it continues
+* in a new segment file: the segment N of channel_x.net_2026.10.19.log
+* is channel_x.net_2026.10.19+N.log. The segments are listed in
+* channel_x.net_2026.10.19.segments, one per line, as
+* "N<tab>file name<tab>ISO start time". The index exists only
+* for the logs that have been rotated at least once.
+*
+* Compressed logs are written to a plain .tmp file that is appended
+* to the .gz one by sync() and close().
+*/
+
+#include "kvi_settings.h"
+
+#include <QObject>
+#include <QByteArray>
+#include <QDateTime>
+#include <QString>
+#include <QStringList>
+
+class QFile;
+class QTimerEvent;
+
+class KVIRC_API KviLogFileWriter : public QObject
+{
+public:
+	KviLogFileWriter();
+	~KviLogFileWriter();
+
+protected:
+	QFile * m_pFile;          // the file we're writing to (a .tmp one for compressed logs)
+	QString m_szFileName;     // the current segment
+	QString m_szFirstSegment; // the name the log has been opened with
+	bool m_bCompressed;
+	unsigned int m_uSegment;  // 1 based
+	unsigned int m_uIndexedSegments; // the ones already listed in the index
+	qint64 m_iSegmentSize;
+	QByteArray m_szBuffer;
+	int m_iFlushTimer;
+
+public:
+	// continues the last segment of an existing log
+	bool open(const QString & szFileName);
+	void close();
+	bool isOpen() const { return m_pFile != nullptr; };
+	// the data is expected to contain complete lines
+	void write(const QByteArray & szData);
+	// writes the buffered lines to the disk
+	void flush();
+	// flushes and, for compressed logs, moves the pending data to the .gz file
+	void sync();
+	const QString & fileName() const { return m_szFileName; };
+	unsigned int segment() const { return m_uSegment; };
+
+	static QString segmentFileName(const QString & szFirstSegment, unsigned int uSegment);
+	static QString segmentIndexFileName(const QString & szFirstSegment);
+	// the segment file names in order, empty if the log has never been rotated
+	static void readSegmentIndex(const QString & szFirstSegment, QStringList & lSegments);
+
+protected:
+	bool openSegment();
+	void closeSegment();
+	void rotate();
+	void appendToIndex(unsigned int uSegment, const QString & szFileName, const QDateTime & start);
+#ifdef COMPILE_ZLIB_SUPPORT
+	void compressPendingData();
+#endif
+	void timerEvent(QTimerEvent * e) override;
+};
+
+#endif //!_KVI_LOGFILEWRITER_H_
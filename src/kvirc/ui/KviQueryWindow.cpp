@@ -102,6 +102,8 @@ KviQueryWindow::KviQueryWindow(KviConsoleWindow * lpConsole, const QString & szN
 
 	if(KVI_OPTION_BOOL(KviOption_boolAutoLogQueries))
 		m_pIrcView->startLogging();
+
+	restoreScrollbackSnapshot();
 	// FIXME: #warning "Maybe tell the user all that we know about the remote szEnd(s)....channels..."
 
 	m_pIrcView->enableDnd(true);
@@ -112,6 +114,8 @@ KviQueryWindow::KviQueryWindow(KviConsoleWindow * lpConsole, const QString & szN
 
 KviQueryWindow::~KviQueryWindow()
 {
+	saveScrollbackSnapshot();
+
 	m_pUserListView->partAll();
 	if(type() == KviWindow::DeadQuery)
 	{
@@ -336,7 +340,10 @@ KviUserListEntry * KviQueryWindow::setTarget(const QString & szNick, const QStri
 	if((!pEntry->globalData()->avatar()) && (!szUser.isEmpty()) && (szUser != "*"))
 		m_pConsole->checkDefaultAvatar(pEntry->globalData(), szNick, szUser, szHost);
 
+	QString szOldName = windowName();
 	setWindowName(szNick);
+	if(connection())
+		connection()->queryRenamed(this, szOldName);
 	updateCaption();
 
 	if(KVI_OPTION_BOOL(KviOption_boolEnableQueryTracing))
@@ -399,7 +406,10 @@ bool KviQueryWindow::nickChange(const QString & szOldNick, const QString & szNew
 	if(!bRet)
 		return false; // ugh!! ?
 
+	QString szOldName = windowName();
 	setWindowName(szNewNick);
+	if(connection())
+		connection()->queryRenamed(this, szOldName);
 	updateCaption();
 	updateLabelText();
 	return true;
@@ -433,6 +443,9 @@ void KviQueryWindow::toggleListView()
 
 void KviQueryWindow::setDeadQuery()
 {
+	// the network name is not known anymore after this point
+	saveScrollbackSnapshot();
+
 	m_iFlags |= Dead;
 
 	m_pUserListView->enableUpdates(false);
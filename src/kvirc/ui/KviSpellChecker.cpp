@@ -0,0 +1,240 @@
+//=============================================================================
+//
+//   File : KviSpellChecker.cpp
+//   Creation date : Mon Oct 19 2026 18:02:47 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2000-2026 Szymon Stefanek (pragma at kvirc dot net)
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "KviSpellChecker.h"
+#include "KviModuleManager.h"
+#include "KviModule.h"
+#include "KviApplication.h"
+
+#include <QEvent>
+
+// the cache is dropped when it grows over this number of words
+#define KVI_SPELLCHECKER_MAX_CACHED_WORDS 20000
+
+class KviSpellCheckerResultEvent : public QEvent
+{
+public:
+	KviSpellCheckerResultEvent(unsigned int uGeneration)
+	    : QEvent(QEvent::User), m_uGeneration(uGeneration){};
+
+public:
+	unsigned int m_uGeneration;
+	QHash<QString, bool> m_hResults;
+};
+
+KviSpellCheckerThread::KviSpellCheckerThread(KviSpellChecker * pChecker, KviSpellCheckerInterface * pInterface)
+    : QThread(), m_pChecker(pChecker), m_pInterface(pInterface)
+{
+	m_bStop = false;
+}
+
+KviSpellCheckerThread::~KviSpellCheckerThread()
+{
+	stop();
+}
+
+void KviSpellCheckerThread::enqueue(const QString & szWord)
+{
+	QMutexLocker locker(&m_Mutex);
+	m_lQueue.append(szWord);
+	m_Condition.wakeOne();
+}
+
+void KviSpellCheckerThread::stop()
+{
+	m_Mutex.lock();
+	m_bStop = true;
+	m_Condition.wakeOne();
+	m_Mutex.unlock();
+	wait();
+}
+
+void KviSpellCheckerThread::run()
+{
+	for(;;)
+	{
+		m_Mutex.lock();
+		while(m_lQueue.isEmpty() && !m_bStop)
+			m_Condition.wait(&m_Mutex);
+		if(m_bStop)
+		{
+			m_Mutex.unlock();
+			return;
+		}
+		// a paste or a long line usually queues many words: check them in a single batch
+		QStringList lWords;
+		lWords.swap(m_lQueue);
+		m_Mutex.unlock();
+
+		KviSpellCheckerResultEvent * e = new KviSpellCheckerResultEvent(m_pInterface->dictionaryGeneration());
+		for(auto & szWord : lWords)
+			e->m_hResults.insert(szWord, m_pInterface->check(szWord));
+
+		QCoreApplication::postEvent(m_pChecker, e);
+	}
+}
+
+KviSpellChecker * KviSpellChecker::m_pInstance = nullptr;
+
+KviSpellChecker::KviSpellChecker()
+    : QObject(g_pModuleManager)
+{
+	m_pInstance = this;
+	m_pModule = nullptr;
+	m_pInterface = nullptr;
+	m_pThread = nullptr;
+	m_bModuleUnavailable = false;
+	m_uGeneration = 0;
+	connect(g_pModuleManager, SIGNAL(moduleAboutToUnload(KviModule *)), this, SLOT(moduleAboutToUnload(KviModule *)));
+}
+
+KviSpellChecker::~KviSpellChecker()
+{
+	releaseInterface();
+	m_pInstance = nullptr;
+}
+
+KviSpellChecker * KviSpellChecker::instance()
+{
+	if(!m_pInstance)
+		(void)new KviSpellChecker();
+	return m_pInstance;
+}
+
+bool KviSpellChecker::ensureInterface()
+{
+	if(m_pInterface)
+		return true;
+	if(m_bModuleUnavailable)
+		return false; // don't try to load it at every keystroke
+
+	m_pModule = g_pModuleManager->getModule("spellchecker");
+	if(m_pModule && m_pModule->ctrl("spellchecker::getInterface", (void *)&m_pInterface) && m_pInterface)
+	{
+		m_pModule->lock();
+		m_uGeneration = m_pInterface->dictionaryGeneration();
+		m_pThread = new KviSpellCheckerThread(this, m_pInterface);
+		m_pThread->start(QThread::LowPriority);
+		return true;
+	}
+
+	qDebug("Can't get the spell checker interface: spell checking disabled");
+	m_pModule = nullptr;
+	m_pInterface = nullptr;
+	m_bModuleUnavailable = true;
+	return false;
+}
+
+void KviSpellChecker::releaseInterface()
+{
+	if(m_pThread)
+	{
+		delete m_pThread; // stops it
+		m_pThread = nullptr;
+	}
+	if(m_pModule)
+	{
+		m_pModule->unlock();
+		m_pModule = nullptr;
+	}
+	m_pInterface = nullptr;
+	m_hCache.clear();
+	m_hPending.clear();
+}
+
+void KviSpellChecker::moduleAboutToUnload(KviModule * m)
+{
+	if(m != m_pModule)
+		return;
+	// the results still in the event queue are discarded in event()
+	releaseInterface();
+	// after an explicit unload we may try to load it again later
+	m_bModuleUnavailable = false;
+}
+
+KviSpellChecker::Result KviSpellChecker::check(const QString & szWord)
+{
+	if(!ensureInterface())
+		return Correct; // assume correct
+
+	unsigned int uGeneration = m_pInterface->dictionaryGeneration();
+	if(uGeneration != m_uGeneration)
+	{
+		// the dictionaries have been reloaded
+		m_hCache.clear();
+		m_hPending.clear();
+		m_uGeneration = uGeneration;
+	}
+
+	QHash<QString, bool>::const_iterator it = m_hCache.constFind(szWord);
+	if(it != m_hCache.constEnd())
+		return it.value() ? Correct : Mistake;
+
+	if(!m_hPending.contains(szWord))
+	{
+		m_hPending.insert(szWord);
+		m_pThread->enqueue(szWord);
+	}
+
+	return Pending;
+}
+
+void KviSpellChecker::suggestions(const QString & szWord, QStringList & lSuggestions)
+{
+	lSuggestions.clear();
+	if(!ensureInterface())
+		return;
+	m_pInterface->suggestions(szWord, lSuggestions);
+}
+
+bool KviSpellChecker::event(QEvent * e)
+{
+	if(e->type() != QEvent::User)
+		return QObject::event(e);
+
+	KviSpellCheckerResultEvent * r = static_cast<KviSpellCheckerResultEvent *>(e);
+
+	// results from a thread that has been stopped
+	if(!m_pInterface)
+		return true;
+
+	if(r->m_uGeneration != m_uGeneration)
+	{
+		// results for an old set of dictionaries: let the editors ask again
+		emit resultsAvailable();
+		return true;
+	}
+
+	if(m_hCache.count() > KVI_SPELLCHECKER_MAX_CACHED_WORDS)
+		m_hCache.clear(); // crude, but it happens very rarely
+
+	for(QHash<QString, bool>::const_iterator it = r->m_hResults.constBegin(); it != r->m_hResults.constEnd(); ++it)
+	{
+		m_hCache.insert(it.key(), it.value());
+		m_hPending.remove(it.key());
+	}
+
+	emit resultsAvailable();
+	return true;
+}
@@ -0,0 +1,149 @@
+#ifndef _KVI_SPELLCHECKER_H_
+#define _KVI_SPELLCHECKER_H_
+//=============================================================================
+//
+//   File : KviSpellChecker.h
+//   Creation date : Mon Oct 19 2026 18:02:47 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2000-2026 Szymon Stefanek (pragma at kvirc dot net)
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+/**
+* \file KviSpellChecker.h
+* \brief Asynchronous and cached access to the spellchecker module
+*
+* The spellchecker module exports a KviSpellCheckerInterface via its
+* "spellchecker::getInterface" ctrl operation. KviSpellChecker wraps it
+* with a word result cache and performs the dictionary lookups in
+* a slave thread so the input editors never block while typing.
+*/
+
+#include "kvi_settings.h"
+#include "KviQString.h"
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+class KviModule;
+
+/**
+* \class KviSpellCheckerInterface
+* \brief The interface implemented by the spellchecker module
+*
+* All the methods must be thread safe.
+*/
+class KviSpellCheckerInterface
+{
+public:
+	virtual ~KviSpellCheckerInterface() = default;
+
+	// returns true if the word is spelled correctly in any of the loaded dictionaries
+	virtual bool check(const QString & szWord) = 0;
+	virtual void suggestions(const QString & szWord, QStringList & lSuggestions) = 0;
+	// incremented every time the set of loaded dictionaries changes
+	virtual unsigned int dictionaryGeneration() = 0;
+};
+
+class KviSpellChecker;
+
+/**
+* \class KviSpellCheckerThread
+* \brief Performs the dictionary lookups for KviSpellChecker
+*/
+class KviSpellCheckerThread : public QThread
+{
+public:
+	KviSpellCheckerThread(KviSpellChecker * pChecker, KviSpellCheckerInterface * pInterface);
+	~KviSpellCheckerThread();
+
+protected:
+	KviSpellChecker * m_pChecker;
+	KviSpellCheckerInterface * m_pInterface;
+	QMutex m_Mutex;
+	QWaitCondition m_Condition;
+	QStringList m_lQueue;
+	bool m_bStop;
+
+public:
+	void enqueue(const QString & szWord);
+	// stops the thread and waits for it to finish
+	void stop();
+
+protected:
+	void run() override;
+};
+
+/**
+* \class KviSpellChecker
+* \brief The one and only spell checking frontend
+*/
+class KVIRC_API KviSpellChecker : public QObject
+{
+	Q_OBJECT
+	friend class KviSpellCheckerThread;
+
+public:
+	enum Result
+	{
+		Correct,
+		Mistake,
+		Pending /**< The lookup has been queued: resultsAvailable() will be emitted */
+	};
+
+protected:
+	KviSpellChecker();
+	~KviSpellChecker();
+
+protected:
+	static KviSpellChecker * m_pInstance;
+
+	KviModule * m_pModule; // locked while we use its interface
+	KviSpellCheckerInterface * m_pInterface;
+	KviSpellCheckerThread * m_pThread;
+	bool m_bModuleUnavailable;
+	unsigned int m_uGeneration; // dictionary generation the cache refers to
+	QHash<QString, bool> m_hCache;
+	QSet<QString> m_hPending;
+
+public:
+	// created on first use, destroyed together with the module manager
+	static KviSpellChecker * instance();
+
+	// never blocks: unknown words are looked up in the background
+	Result check(const QString & szWord);
+	// blocks: meant to be used only on explicit user request
+	void suggestions(const QString & szWord, QStringList & lSuggestions);
+
+protected:
+	bool ensureInterface();
+	void releaseInterface();
+	bool event(QEvent * e) override;
+protected slots:
+	void moduleAboutToUnload(KviModule * m);
+signals:
+	// emitted in the GUI thread when some pending words have been checked
+	void resultsAvailable();
+};
+
+#endif //!_KVI_SPELLCHECKER_H_
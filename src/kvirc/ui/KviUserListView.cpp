@@ -57,6 +57,8 @@
 #include <QPaintEvent>
 #include <QScrollBar>
 
+#include <utility>
+
 #ifdef COMPILE_PSEUDO_TRANSPARENCY
 extern QPixmap * g_pShadedChildGlobalDesktopBackground;
 #endif
@@ -221,7 +223,8 @@ KviUserListView::KviUserListView(QWidget * pParent, KviWindowToolPageButton * pB
 	setObjectName(pName);
 
 	m_pKviWindow = pWnd;
-	m_pEntryDict = new KviPointerHashTable<QString, KviUserListEntry>(iDictSize, false);
+	// indexed by the casemapped nicknames, see key()
+	m_pEntryDict = new KviPointerHashTable<QString, KviUserListEntry>(iDictSize, true);
 	m_pEntryDict->setAutoDelete(true);
 
 	m_pUsersLabel = new QLabel(this);
@@ -618,7 +621,7 @@ bool KviUserListView::completeNickStandard(const QString & szBegin, const QStrin
 void KviUserListView::insertUserEntry(const QString & szNnick, KviUserListEntry * pUserEntry)
 {
 	// Complex insertion task :)
-	m_pEntryDict->insert(szNnick, pUserEntry);
+	m_pEntryDict->insert(key(szNnick), pUserEntry);
 	m_iTotalHeight += pUserEntry->m_iHeight;
 
 	bool bGotTopItem = false;
@@ -833,11 +836,12 @@ void KviUserListView::insertUserEntry(const QString & szNnick, KviUserListEntry
 
 KviUserListEntry * KviUserListView::join(const QString & szNick, const QString & szUser, const QString & szHost, int iFlags)
 {
-	KviUserListEntry * pEntry = m_pEntryDict->find(szNick);
+	KviUserListEntry * pEntry = m_pEntryDict->find(key(szNick));
 	if(!pEntry)
 	{
 		// add an entry to the global dict
 		KviIrcUserEntry * pGlobalData = m_pIrcUserDataBase->insertUser(szNick, szUser, szHost);
+		pGlobalData->addUserList(this);
 		// calculate the flags and update the counters
 		pEntry = new KviUserListEntry(this, szNick, pGlobalData, iFlags, (szUser == QString()));
 		insertUserEntry(szNick, pEntry);
@@ -888,7 +892,7 @@ void KviUserListView::triggerUpdate()
 
 bool KviUserListView::avatarChanged(const QString & szNick)
 {
-	KviUserListEntry * pUserEntry = m_pEntryDict->find(szNick);
+	KviUserListEntry * pUserEntry = m_pEntryDict->find(key(szNick));
 	if(!pUserEntry)
 		return false;
 
@@ -938,7 +942,7 @@ bool KviUserListView::avatarChanged(const QString & szNick)
 
 bool KviUserListView::userActionVerifyMask(const QString & szNick, const QString & szUser, const QString & szHost, int iActionTemperature, QString & szOldUser, QString & szOldHost)
 {
-	KviUserListEntry * pEntry = m_pEntryDict->find(szNick);
+	KviUserListEntry * pEntry = m_pEntryDict->find(key(szNick));
 	if(pEntry)
 	{
 		pEntry->m_lastActionTime = kvi_unixTime();
@@ -987,7 +991,7 @@ bool KviUserListView::userActionVerifyMask(const QString & szNick, const QString
 
 void KviUserListView::userAction(const QString & szNick, const QString & szUser, const QString & szHost, int iActionTemperature)
 {
-	KviUserListEntry * pEntry = m_pEntryDict->find(szNick);
+	KviUserListEntry * pEntry = m_pEntryDict->find(key(szNick));
 	if(pEntry)
 	{
 		pEntry->m_lastActionTime = kvi_unixTime();
@@ -1010,7 +1014,7 @@ void KviUserListView::userAction(const QString & szNick, const QString & szUser,
 
 void KviUserListView::userAction(KviIrcMask * pUser, int iActionTemperature)
 {
-	KviUserListEntry * pEntry = m_pEntryDict->find(pUser->nick());
+	KviUserListEntry * pEntry = m_pEntryDict->find(key(pUser->nick()));
 	if(pEntry)
 	{
 		pEntry->m_lastActionTime = kvi_unixTime();
@@ -1033,7 +1037,7 @@ void KviUserListView::userAction(KviIrcMask * pUser, int iActionTemperature)
 
 void KviUserListView::userAction(const QString & szNick, int iActionTemperature)
 {
-	KviUserListEntry * pEntry = m_pEntryDict->find(szNick);
+	KviUserListEntry * pEntry = m_pEntryDict->find(key(szNick));
 	if(pEntry)
 	{
 		pEntry->m_lastActionTime = kvi_unixTime();
@@ -1051,7 +1055,7 @@ void KviUserListView::userAction(const QString & szNick, int iActionTemperature)
 
 kvi_time_t KviUserListView::getUserJoinTime(const QString & szNick)
 {
-	KviUserListEntry * pEntry = m_pEntryDict->find(szNick);
+	KviUserListEntry * pEntry = m_pEntryDict->find(key(szNick));
 	if(!pEntry)
 		return (kvi_time_t)0;
 
@@ -1060,7 +1064,7 @@ kvi_time_t KviUserListView::getUserJoinTime(const QString & szNick)
 
 kvi_time_t KviUserListView::getUserLastActionTime(const QString & szNick)
 {
-	KviUserListEntry * pEntry = m_pEntryDict->find(szNick);
+	KviUserListEntry * pEntry = m_pEntryDict->find(key(szNick));
 	if(!pEntry)
 		return (kvi_time_t)0;
 
@@ -1069,7 +1073,7 @@ kvi_time_t KviUserListView::getUserLastActionTime(const QString & szNick)
 
 int KviUserListView::getUserModeLevel(const QString & szNick)
 {
-	KviUserListEntry * pEntry = m_pEntryDict->find(szNick);
+	KviUserListEntry * pEntry = m_pEntryDict->find(key(szNick));
 	if(!pEntry)
 		return 0;
 
@@ -1108,14 +1112,14 @@ void KviUserListView::prependUserFlag(const QString & szNick, QString & szBuffer
 
 int KviUserListView::flags(const QString & szNick)
 {
-	KviUserListEntry * pEntry = m_pEntryDict->find(szNick);
+	KviUserListEntry * pEntry = m_pEntryDict->find(key(szNick));
 	return pEntry ? pEntry->m_iFlags : 0;
 }
 
 #define SET_FLAG_FUNC(__funcname, __flag)                               \
 	bool KviUserListView::__funcname(const QString & szNick, bool bYes) \
 	{                                                                   \
-		KviUserListEntry * pEntry = m_pEntryDict->find(szNick);         \
+		KviUserListEntry * pEntry = m_pEntryDict->find(key(szNick));    \
 		if(!pEntry)                                                     \
 			return false;                                               \
 		m_pEntryDict->setAutoDelete(false);                             \
@@ -1147,7 +1151,7 @@ SET_FLAG_FUNC(setVoice, KviIrcUserEntry::Voice)
 #define GET_FLAG_FUNC(__funcname, __flag)                                                                \
 	bool KviUserListView::__funcname(const QString & szNick, bool bAtLeast)                              \
 	{                                                                                                    \
-		KviUserListEntry * pEntry = m_pEntryDict->find(szNick);                                          \
+		KviUserListEntry * pEntry = m_pEntryDict->find(key(szNick));                                     \
 		return pEntry ? (bAtLeast ? (pEntry->m_iFlags >= __flag) : (pEntry->m_iFlags & __flag)) : false; \
 	}
 
@@ -1216,7 +1220,7 @@ void KviUserListView::select(const QString & szNick)
 		++it;
 	}
 
-	KviUserListEntry * pEntry = m_pEntryDict->find(szNick);
+	KviUserListEntry * pEntry = m_pEntryDict->find(key(szNick));
 	if(pEntry)
 	{
 		pEntry->m_bSelected = true;
@@ -1233,7 +1237,7 @@ void KviUserListView::select(const QString & szNick)
 
 void KviUserListView::ensureVisible(const QString & szNick)
 {
-	KviUserListEntry * pUserEntry = m_pEntryDict->find(szNick);
+	KviUserListEntry * pUserEntry = m_pEntryDict->find(key(szNick));
 	if(!pUserEntry)
 		return;
 
@@ -1294,7 +1298,7 @@ void KviUserListView::ensureVisible(const QString & szNick)
 
 bool KviUserListView::partInternal(const QString & szNick, bool bRemoveDefinitively)
 {
-	KviUserListEntry * pUserEntry = m_pEntryDict->find(szNick);
+	KviUserListEntry * pUserEntry = m_pEntryDict->find(key(szNick));
 	if(!pUserEntry)
 		return false; // not there
 
@@ -1331,6 +1335,7 @@ bool KviUserListView::partInternal(const QString & szNick, bool bRemoveDefinitiv
 	if(bRemoveDefinitively)
 	{
 		pUserEntry->detachAvatarData();
+		pUserEntry->m_pGlobalData->removeUserList(this);
 		m_pIrcUserDataBase->removeUser(szNick, pUserEntry->m_pGlobalData);
 	}
 
@@ -1359,7 +1364,7 @@ bool KviUserListView::partInternal(const QString & szNick, bool bRemoveDefinitiv
 
 	int iHeight = pUserEntry->m_iHeight;
 
-	m_pEntryDict->remove(szNick);
+	m_pEntryDict->remove(key(szNick));
 
 	if(bGotTopItem)
 	{
@@ -1384,7 +1389,7 @@ bool KviUserListView::partInternal(const QString & szNick, bool bRemoveDefinitiv
 
 bool KviUserListView::nickChange(const QString & szOldNick, const QString & szNewNick)
 {
-	KviUserListEntry * pEntry = m_pEntryDict->find(szOldNick);
+	KviUserListEntry * pEntry = m_pEntryDict->find(key(szOldNick));
 	if(pEntry)
 	{
 		QString szUser = pEntry->m_pGlobalData->user();
@@ -1403,7 +1408,7 @@ bool KviUserListView::nickChange(const QString & szOldNick, const QString & szNe
 		KviIrcUserEntry::Gender gender = pEntry->m_pGlobalData->gender();
 		bool bBot = pEntry->m_pGlobalData->isBot();
 		part(szOldNick);
-		KVI_ASSERT(!m_pEntryDict->find(szOldNick));
+		KVI_ASSERT(!m_pEntryDict->find(key(szOldNick)));
 
 		pEntry = join(szNewNick, szUser, szHost, iFlags);
 		pEntry->m_pGlobalData->setGender(gender);
@@ -1463,8 +1468,8 @@ void KviUserListView::partAllButOne(const QString & szWhoNot)
 	KviPointerHashTableIterator<QString, KviUserListEntry> it(*m_pEntryDict);
 	while(it.current())
 	{
-		if(!KviQString::equalCI(szWhoNot, it.currentKey()))
-			list.append(it.currentKey());
+		if(it.currentKey() != key(szWhoNot))
+			list.append(it.current()->nick());
 		++it;
 	}
 	for(auto & it2 : list)
@@ -1473,13 +1478,48 @@ void KviUserListView::partAllButOne(const QString & szWhoNot)
 	}
 }
 
+QString KviUserListView::key(const QString & szNick) const
+{
+	// the dead windows have no database but their list is empty anyway
+	return m_pIrcUserDataBase ? m_pIrcUserDataBase->key(szNick) : szNick;
+}
+
+void KviUserListView::caseMappingChanged()
+{
+	// only the entries whose key changes are moved
+	std::vector<std::pair<QString, KviUserListEntry *>> vMoved;
+	KviPointerHashTableIterator<QString, KviUserListEntry> it(*m_pEntryDict);
+	while(KviUserListEntry * pEntry = it.current())
+	{
+		if(it.currentKey() != key(pEntry->nick()))
+			vMoved.emplace_back(it.currentKey(), pEntry);
+		++it;
+	}
+
+	if(vMoved.empty())
+		return;
+
+	m_pEntryDict->setAutoDelete(false);
+	for(auto & p : vMoved)
+		m_pEntryDict->remove(p.first);
+	for(auto & p : vMoved)
+	{
+		// two nicknames that were different may be the same user now: the first one
+		// wins and the other keeps its old key so it is still cleaned up with the list
+		QString szKey = key(p.second->nick());
+		m_pEntryDict->insert(m_pEntryDict->find(szKey) ? p.first : szKey, p.second);
+	}
+	m_pEntryDict->setAutoDelete(true);
+}
+
 void KviUserListView::removeAllEntries()
 {
 	KviPointerHashTableIterator<QString, KviUserListEntry> it(*m_pEntryDict);
 	while(it.current())
 	{
 		//it.current()->resetAvatarConnection();
-		m_pIrcUserDataBase->removeUser(it.currentKey(),
+		((KviUserListEntry *)it.current())->m_pGlobalData->removeUserList(this);
+		m_pIrcUserDataBase->removeUser(it.current()->nick(),
 		    ((KviUserListEntry *)it.current())->m_pGlobalData);
 		++it;
 	}
@@ -396,7 +396,13 @@ public:
 	* \param szNick The nickname to find
 	* \return KviUserListEntry *
 	*/
-	KviUserListEntry * findEntry(const QString & szNick) { return szNick.isEmpty() ? 0 : m_pEntryDict->find(szNick); };
+	KviUserListEntry * findEntry(const QString & szNick) { return szNick.isEmpty() ? 0 : m_pEntryDict->find(key(szNick)); };
+
+	/**
+	* \brief Rebuilds the keys after a casemapping switch of the user database
+	* \return void
+	*/
+	void caseMappingChanged();
 
 	/**
 	* \brief Appends the selected nicknames to the buffer
@@ -784,6 +790,13 @@ protected:
 	*/
 	void removeAllEntries();
 
+	/**
+	* \brief Returns the key used to index the nickname: see KviIrcUserDataBase::key()
+	* \param szNick The nickname of the user
+	* \return QString
+	*/
+	QString key(const QString & szNick) const;
+
 	/**
 	* \brief Called when a user parts a channel
 	* \param szNick The nickname of the user
@@ -54,6 +54,7 @@
 #include "KviKvsScript.h"
 #include "KviTalToolTip.h"
 #include "KviKvsEventTriggers.h"
+#include "KviLogFileWriter.h"
 
 #include <QPixmap>
 #include <QCursor>
@@ -392,14 +393,14 @@ void KviWindow::textEncodingButtonClicked()
 	m_pTextEncodingButton->setChecked(false);
 }
 
-const QString & KviWindow::lastLineOfText()
+QString KviWindow::lastLineOfText()
 {
 	if(m_pIrcView)
 		return m_pIrcView->lastLineOfText();
 	return KviQString::Empty;
 }
 
-const QString & KviWindow::lastMessageText()
+QString KviWindow::lastMessageText()
 {
 	if(m_pIrcView)
 		return m_pIrcView->lastMessageText();
@@ -500,6 +501,52 @@ void KviWindow::getConfigGroupName(QString & szBuffer)
 	szBuffer = typeString();
 }
 
+bool KviWindow::getScrollbackSnapshotFileName(QString & szBuffer)
+{
+	// the network name is part of the name only while connected
+	if(((type() != KviWindow::Channel) && (type() != KviWindow::Query)) || !connection())
+		return false;
+
+	g_pApp->getLocalKvircDirectory(szBuffer, KviApplication::Snapshots);
+	KviQString::ensureLastCharIs(szBuffer, KVI_PATH_SEPARATOR_CHAR);
+	KviFileUtils::makeDir(szBuffer);
+
+	QString szBase;
+	getBaseLogFileName(szBase);
+	KviFileUtils::encodeFileName(szBase);
+	szBase = szBase.toLower();
+	szBase.replace("%%2e", "%2e");
+
+	szBuffer += QString("%1_%2.kvss").arg(typeString(), szBase);
+	return true;
+}
+
+void KviWindow::saveScrollbackSnapshot()
+{
+	if(!KVI_OPTION_BOOL(KviOption_boolKeepScrollbackSnapshots) || !m_pIrcView)
+		return;
+
+	QString szFileName;
+	if(!getScrollbackSnapshotFileName(szFileName))
+		return;
+
+	if(!m_pIrcView->saveSnapshot(szFileName, KVI_OPTION_UINT(KviOption_uintScrollbackSnapshotLines)))
+		qDebug("Failed to save the scrollback snapshot %s", szFileName.toUtf8().data());
+}
+
+void KviWindow::restoreScrollbackSnapshot()
+{
+	if(!KVI_OPTION_BOOL(KviOption_boolKeepScrollbackSnapshots) || !m_pIrcView)
+		return;
+
+	QString szFileName;
+	if(!getScrollbackSnapshotFileName(szFileName))
+		return;
+
+	if(QFile::exists(szFileName))
+		m_pIrcView->restoreSnapshot(szFileName);
+}
+
 void KviWindow::getDefaultLogFileName(QString & szBuffer)
 {
 	return getDefaultLogFileName(szBuffer, QDate::currentDate(), KVI_OPTION_BOOL(KviOption_boolGzipLogs),
@@ -1186,6 +1233,36 @@ void KviWindow::internalOutput(KviIrcView * pView, int iMsgType, const kvi_wchar
 			pWnd->outputNoFmt(iMsgType, pwText, iFlags, datetime);
 	}
 
+	highlightWindowListItem(iMsgType);
+}
+
+void KviWindow::outputBatch(std::vector<KviIrcViewBatchLine> & vLines, int iFlags)
+{
+	if(!m_pIrcView)
+	{
+		// the output proxy gets them one by one
+		for(auto & l : vLines)
+			outputNoFmt(l.iMsgType, l.szText, iFlags, l.datetime);
+		return;
+	}
+
+	for(auto & l : vLines)
+		preprocessMessage(l.szText);
+
+	if(!hasAttention())
+	{
+		iFlags |= KviIrcView::TriggersNotification;
+		if(!m_pIrcView->hasLineMark())
+			iFlags |= KviIrcView::SetLineMark;
+	}
+	m_pIrcView->appendTextBatch(vLines, iFlags);
+
+	for(auto & l : vLines)
+		highlightWindowListItem(l.iMsgType);
+}
+
+void KviWindow::highlightWindowListItem(int iMsgType)
+{
 	if(!m_pWindowListItem)
 		return;
 
@@ -1415,21 +1492,30 @@ void KviWindow::pasteLastLog()
 				if (!fi.exists() || !fi.isFile())
 					continue;
 
-				// Load the log
-				QByteArray log = loadLogFile(szFileName, bGzip);
+				// a log rotated because of its size continues in other segments: the newest lines are in the last one
+				QStringList lSegments;
+				KviLogFileWriter::readSegmentIndex(szFileName, lSegments);
+				if(lSegments.isEmpty())
+					lSegments.append(szFileName);
 
-				if(log.size() == 0)
-					continue;
+				for(int iSegment = lSegments.count() - 1; iSegment >= 0; iSegment--)
+				{
+					// Load the log
+					QByteArray log = loadLogFile(lSegments.at(iSegment), bGzip);
 
-				QList<QByteArray> list = log.split('\n');
-				unsigned int uCount = list.size();
+					if(log.size() == 0)
+						continue;
 
-				while (uCount)
-				{
-					vLines.emplace_back(QString(list.at(--uCount)), date, uDatetimeFormat);
+					QList<QByteArray> list = log.split('\n');
+					unsigned int uCount = list.size();
+
+					while (uCount)
+					{
+						vLines.emplace_back(QString(list.at(--uCount)), date, uDatetimeFormat);
 
-					if (vLines.size() == uMaxLines)
-						goto enough;
+						if (vLines.size() == uMaxLines)
+							goto enough;
+					}
 				}
 			}
 
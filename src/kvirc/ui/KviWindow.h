@@ -47,6 +47,8 @@
 #include <QByteArray>
 #include <QDateTime>
 
+#include <vector>
+
 class QPushButton;
 class QPixmap;
 class QTextCodec;
@@ -54,6 +56,7 @@ class KviMainWindow;
 class KviWindowListItem;
 class KviConfigurationFile;
 class KviIrcView;
+struct KviIrcViewBatchLine;
 class KviConsoleWindow;
 class KviIrcConnection;
 class KviWindowToolPageButton;
@@ -357,8 +360,8 @@ public:
 	virtual void getWindowListTipText(QString & szBuffer) { szBuffer = m_szPlainTextCaption; }
 
 	// This is meaningful only if view() is non nullptr
-	const QString & lastLineOfText();
-	const QString & lastMessageText();
+	QString lastLineOfText();
+	QString lastMessageText();
 
 	const QString & textEncoding() const { return m_szTextEncoding; }
 	// returns true if the encoding could be successfully set
@@ -381,6 +384,11 @@ public:
 
 	void delayedClose(); // close that jumps out of the current event loop
 
+	// Scrollback snapshots of the channels and the queries (see KviIrcView::saveSnapshot())
+	bool getScrollbackSnapshotFileName(QString & szBuffer);
+	void saveScrollbackSnapshot();
+	void restoreScrollbackSnapshot();
+
 	// Interesting overridables:
 	virtual void getConfigGroupName(QString & szBuffer);
 	virtual void getBaseLogFileName(QString & szBuffer);
@@ -392,6 +400,9 @@ public:
 	virtual const QString & plainTextCaption() { return m_szPlainTextCaption; };
 
 	void internalOutput(KviIrcView * pView, int iMsgType, const kvi_wchar_t * pwText, int iFlags = 0, const QDateTime & datetime = QDateTime());
+	// Many lines at once (history playback, log replays): see KviIrcView::appendTextBatch().
+	// The lines are preprocessed in place.
+	void outputBatch(std::vector<KviIrcViewBatchLine> & vLines, int iFlags = 0);
 	// You *might* want to override these too.. but better don't touch them :D
 	virtual void output(int iMsgType, const char * pcFormat, ...);
 	virtual void output(int iMsgType, const kvi_wchar_t * pwFormat, ...);
@@ -509,6 +520,7 @@ protected:
 	bool focusNextPrevChild(bool bNext) override;
 
 	virtual void preprocessMessage(QString & szMessage);
+	void highlightWindowListItem(int iMsgType);
 public slots:
 	void dock();
 	void undock();
@@ -1780,6 +1780,72 @@ static bool chan_kvs_fnc_matchmask(KviKvsModuleFunctionCall * c)
 	return true;
 }
 
+/*
+	@doc: chan.matchingmasks
+	@type:
+		function
+	@title:
+		$chan.matchingmasks
+	@short:
+		Returns the channel list masks that match an user
+	@syntax:
+		<array> $chan.matchingmasks(<mode:char>,<user_mask:string>[,window_id])
+	@description:
+		Returns an array with all the masks of the list for channel mode <mode>
+		that match <user_mask> on the channel identified by [window_id].[br]
+		<user_mask> must be in the nick!user@host form: it is usually
+		the complete mask of an user (e.g. [fnc]$mask[/fnc](<nick>,0)).[br]
+		The most specific masks (the ones with more non-wildcard characters) come first.[br]
+		Only the list entries in the nick!user@host form are taken into account (so, for example, the extended bans are not).[br]
+		If [window_id] is empty, the current window is used.[br]
+		If the window designated by [window_id] is not a channel a warning is printed and an empty array is returned.[br]
+		Unlike [fnc]$chan.matchmask[/fnc] this function uses an index over the channel lists, so
+		it's fast also on channels with thousands of bans.[br]
+	@examples:
+		[example]
+			# in an OnJoin handler
+			if($length($chan.matchingmasks(b,$0!$1@$2)) > 0)
+				echo "$0 matches a ban"
+		[/example]
+	@seealso:
+		[fnc]$chan.matchmask[/fnc]
+		[fnc]$chan.masklist[/fnc]
+*/
+
+static bool chan_kvs_fnc_matchingmasks(KviKvsModuleFunctionCall * c)
+{
+	QString szWinId, szMask, szMode;
+
+	KVSM_PARAMETERS_BEGIN(c)
+	KVSM_PARAMETER("mode", KVS_PT_NONEMPTYSTRING, 0, szMode)
+	KVSM_PARAMETER("user mask", KVS_PT_STRING, 0, szMask)
+	KVSM_PARAMETER("window id", KVS_PT_STRING, KVS_PF_OPTIONAL, szWinId)
+	KVSM_PARAMETERS_END(c)
+
+	char cMode = szMode.at(0).unicode();
+
+	KviKvsArray * pArray = new KviKvsArray();
+	c->returnValue()->setArray(pArray);
+
+	KviChannelWindow * ch = chan_kvs_find_channel(c, szWinId);
+
+	if(!ch)
+		return true;
+
+	KviIrcMask mask(szMask);
+	std::vector<KviMaskEntry *> l;
+	ch->matchingModeMasks(cMode, mask.nick(), mask.user(), mask.host(), l);
+
+	int idx = 0;
+	for(auto e : l)
+	{
+		pArray->set(idx, new KviKvsVariant(e->szMask));
+		idx++;
+	}
+
+	return true;
+}
+
 /*
 	@doc: chan.usermodelevel
 	@type:
@@ -1973,6 +2039,7 @@ static bool chan_module_init(KviModule * m)
 	KVSM_REGISTER_FUNCTION(m, "matchqban", chan_kvs_fnc_matchqban);
 	KVSM_REGISTER_FUNCTION(m, "matchbanexception", chan_kvs_fnc_matchbanexception);
 	KVSM_REGISTER_FUNCTION(m, "matchinvite", chan_kvs_fnc_matchinvite);
+	KVSM_REGISTER_FUNCTION(m, "matchingmasks", chan_kvs_fnc_matchingmasks);
 	KVSM_REGISTER_FUNCTION(m, "matchmask", chan_kvs_fnc_matchmask);
 	KVSM_REGISTER_FUNCTION(m, "mode", chan_kvs_fnc_mode);
 	KVSM_REGISTER_FUNCTION(m, "modeParam", chan_kvs_fnc_modeParam);
@@ -569,6 +569,9 @@ void DccMarshal::snActivated(int)
 
 		if(m_pSSL)
 		{
+			// repeated transfers with the same peer can resume the session
+			if(m_bOutgoing)
+				m_pSSL->setSessionKey(QString("dcc:%1").arg(m_szIp));
 			emit startingSSLHandshake();
 			doSSLHandshake(0);
 		}
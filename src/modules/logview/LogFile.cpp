@@ -46,11 +46,10 @@
 #include <QStringConverter>
 #endif
 
-#ifdef COMPILE_ZLIB_SUPPORT
-#include <zlib.h>
-#endif
+// a seek point is saved every this number of lines
+#define KVI_LOGFILE_INDEX_STEP 1024
 
-LogFile::LogFile(const QString & szName)
+LogFile::LogFile(const QString & szName, unsigned int uSegment)
 {
 	m_szFilename = szName;
 
@@ -100,6 +99,22 @@ LogFile::LogFile(const QString & szName)
 
 	QString szDate = szTmpName.section('_', -1).section('.', 0, -2);
 
+	// the segments of the rotated logs: "2009.11.03+2"
+	// the number comes from the segment index when there is one, else from the name
+	m_uSegment = uSegment ? uSegment : 1;
+	int iPlus = szDate.lastIndexOf('+');
+	if(iPlus != -1)
+	{
+		bool bOk;
+		unsigned int uNameSegment = szDate.mid(iPlus + 1).toUInt(&bOk);
+		if(bOk && uNameSegment > 1)
+		{
+			if(!uSegment)
+				m_uSegment = uNameSegment;
+			szDate.truncate(iPlus);
+		}
+	}
+
 	switch(KVI_OPTION_UINT(KviOption_uintOutputDatetimeFormat))
 	{
 		case 1:
@@ -160,48 +175,96 @@ LogFile::LogFile(const QString & szName)
 
 void LogFile::getText(QString & szText) const
 {
-	QString szLogName = fileName();
-	QFile logFile;
-#ifdef COMPILE_ZLIB_SUPPORT
-	if(m_bCompressed)
+	LogFileReader reader(m_szFilename, m_bCompressed);
+	if(!reader.open())
 	{
-		gzFile file = gzopen(szLogName.toLocal8Bit().data(), "rb");
-		if(file)
-		{
-			char cBuff[1025];
-			int iLen;
-			QByteArray data;
-			//QCString data;
-			iLen = gzread(file, cBuff, 1024);
-			while(iLen > 0)
-			{
-				cBuff[iLen] = 0;
-				data.append(cBuff);
-				iLen = gzread(file, cBuff, 1024);
-			}
-			gzclose(file);
-			szText = QString::fromUtf8(data);
-		}
-		else
-		{
-			qDebug("Can't open compressed file %s", szLogName.toLocal8Bit().data());
-		}
+		qDebug("Can't open log file %s", m_szFilename.toLocal8Bit().data());
+		return;
 	}
-	else
+
+	QByteArray data;
+	QByteArray szLine;
+	while(reader.readLine(szLine))
 	{
-#endif
-		logFile.setFileName(szLogName);
+		data.append(szLine);
+		data.append('\n');
+	}
+	szText = QString::fromUtf8(data);
+}
+
+bool LogFile::buildIndex()
+{
+	QFileInfo fi(m_szFilename);
+	if(!fi.exists())
+		return false;
 
-		if(!logFile.open(QIODevice::ReadOnly))
-			return;
+	// the logs of the open windows keep growing
+	if((fi.size() == m_iIndexedSize) && (fi.lastModified() == m_indexedModificationTime))
+		return true;
 
-		QByteArray bytes;
-		bytes = logFile.readAll();
-		szText = QString::fromUtf8(bytes.data(), bytes.size());
-		logFile.close();
-#ifdef COMPILE_ZLIB_SUPPORT
+	m_vSeekPoints.clear();
+	m_iLineCount = 0;
+	m_iIndexedSize = -1;
+
+	LogFileReader reader(m_szFilename, m_bCompressed);
+	if(!reader.open())
+		return false;
+
+	QByteArray szLine;
+	for(;;)
+	{
+		if((m_iLineCount % KVI_LOGFILE_INDEX_STEP) == 0)
+			m_vSeekPoints.push_back(reader.position());
+		if(!reader.readLine(szLine))
+			break;
+		m_iLineCount++;
 	}
-#endif
+
+	m_iIndexedSize = fi.size();
+	m_indexedModificationTime = fi.lastModified();
+	return true;
+}
+
+bool LogFile::getLines(qint64 iFirst, int iCount, QStringList & lLines)
+{
+	lLines.clear();
+
+	if(!buildIndex())
+		return false;
+	if(iFirst < 0 || iFirst >= m_iLineCount)
+		return true;
+
+	LogFileReader reader(m_szFilename, m_bCompressed);
+	if(!reader.open())
+		return false;
+	if(!reader.seek(m_vSeekPoints[iFirst / KVI_LOGFILE_INDEX_STEP]))
+		return false;
+
+	QByteArray szLine;
+	for(qint64 i = iFirst - (iFirst % KVI_LOGFILE_INDEX_STEP); i < iFirst; i++)
+	{
+		if(!reader.readLine(szLine))
+			return true;
+	}
+
+	while((iCount-- > 0) && reader.readLine(szLine))
+		lLines.append(QString::fromUtf8(szLine));
+	return true;
+}
+
+bool LogFile::containsText(const QString & szMask) const
+{
+	LogFileReader reader(m_szFilename, m_bCompressed);
+	if(!reader.open())
+		return false;
+
+	QByteArray szLine;
+	while(reader.readLine(szLine))
+	{
+		if(KviQString::matchString(szMask, QString::fromUtf8(szLine)))
+			return true;
+	}
+	return false;
 }
 
 void LogFile::createLog(ExportType exportType, QString szLog, QString * pszFile) const
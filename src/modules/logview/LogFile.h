@@ -32,7 +32,13 @@
 * This file was originally part of LogViewWindow.h
 */
 
+#include "LogFileReader.h"
+
 #include <QDate>
+#include <QDateTime>
+#include <QStringList>
+
+#include <vector>
 
 class QString;
 
@@ -56,6 +62,12 @@ struct LogFileData
 * Examples:
 * query_noldor.azzurra_2009.05.20.log
 * channel_#slackware.azzurra_2009.11.03.log
+*
+* The logs that have been rotated because of their size continue
+* in numbered segments:
+* channel_#slackware.azzurra_2009.11.03+2.log
+* listed in channel_#slackware.azzurra_2009.11.03.segments
+* (see KviLogFileWriter::readSegmentIndex())
 */
 class LogFile
 {
@@ -88,9 +100,10 @@ public:
 	/**
 	* \brief Constructs the log file object
 	* \param szName The name of the log
+	* \param uSegment The segment number read from the segment index, 0 to guess it from the name
 	* \return LogFile
 	*/
-	LogFile(const QString & szName);
+	LogFile(const QString & szName, unsigned int uSegment = 0);
 
 private:
 	Type m_eType;
@@ -100,6 +113,13 @@ private:
 	QString m_szName;
 	QString m_szNetwork;
 	QDate m_date;
+	unsigned int m_uSegment;
+
+	// the sparse line index: a seek point every KVI_LOGFILE_INDEX_STEP lines
+	qint64 m_iIndexedSize = -1;
+	QDateTime m_indexedModificationTime;
+	qint64 m_iLineCount = 0;
+	std::vector<LogFileSeekPoint> m_vSeekPoints;
 
 public:
 	/**
@@ -138,6 +158,12 @@ public:
 	*/
 	const QDate & date() const { return m_date; };
 
+	/**
+	* \brief Returns the segment number of the log, 1 for the first file of a day
+	* \return unsigned int
+	*/
+	unsigned int segment() const { return m_uSegment; };
+
 	/**
 	* \brief Returns the text of the log file
 	* \param szText The buffer where to save the contents of the log
@@ -145,6 +171,36 @@ public:
 	*/
 	void getText(QString & szText) const;
 
+	/**
+	* \brief Scans the log and builds its line index, if it has changed since the last time
+	* \return bool
+	*/
+	bool buildIndex();
+
+	/**
+	* \brief Returns the number of lines in the log, valid after buildIndex()
+	* \return qint64
+	*/
+	qint64 lineCount() const { return m_iLineCount; };
+
+	/**
+	* \brief Reads a range of lines using the line index
+	* \param iFirst The first line to read
+	* \param iCount The maximum number of lines to read
+	* \param lLines The buffer for the lines
+	* \return bool
+	*/
+	bool getLines(qint64 iFirst, int iCount, QStringList & lLines);
+
+	/**
+	* \brief Returns true if any line of the log matches the wildcard mask
+	*
+	* The log is streamed: it is never loaded in memory as a whole
+	* \param szMask The mask to match
+	* \return bool
+	*/
+	bool containsText(const QString & szMask) const;
+
 	/**
 	* \brief Exports the log and creates the file in the selected format
 	* \param exportType The type of file to export the log as. Either PlainText or HTML.
@@ -0,0 +1,248 @@
+//=============================================================================
+//
+//   File : LogFileReader.cpp
+//   Creation date : Mon Oct 19 2026 22:41:05 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2000-2026 Szymon Stefanek (pragma at kvirc dot net)
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+#include "LogFileReader.h"
+
+#include <cstring>
+
+#define KVI_LOGFILEREADER_CHUNK_SIZE 65536
+
+LogFileReader::LogFileReader(const QString & szFileName, bool bCompressed)
+    : m_file(szFileName), m_bCompressed(bCompressed)
+{
+	m_position.iRawOffset = 0;
+	m_position.iSkip = 0;
+}
+
+LogFileReader::~LogFileReader()
+{
+	close();
+}
+
+bool LogFileReader::open()
+{
+	close();
+	if(!m_file.open(QIODevice::ReadOnly))
+		return false;
+	m_bOpen = true;
+	return seek({ 0, 0 });
+}
+
+void LogFileReader::close()
+{
+#ifdef COMPILE_ZLIB_SUPPORT
+	if(m_bZStreamInit)
+	{
+		inflateEnd(&m_zStream);
+		m_bZStreamInit = false;
+	}
+	m_szRawBuffer.clear();
+#endif
+	m_szBuffer.clear();
+	m_iBufferPos = 0;
+	if(m_bOpen)
+	{
+		m_file.close();
+		m_bOpen = false;
+	}
+}
+
+bool LogFileReader::seek(const LogFileSeekPoint & point)
+{
+	if(!m_bOpen)
+		return false;
+
+	m_szBuffer.clear();
+	m_iBufferPos = 0;
+	m_bEof = false;
+
+	if(!m_bCompressed)
+	{
+		m_position.iRawOffset = 0;
+		m_position.iSkip = point.iRawOffset + point.iSkip;
+		return m_file.seek(m_position.iSkip);
+	}
+
+#ifdef COMPILE_ZLIB_SUPPORT
+	if(!startDecoding(point.iRawOffset))
+		return false;
+
+	// a seek point never crosses the end of its member
+	qint64 iSkip = point.iSkip;
+	while(iSkip > 0)
+	{
+		if(!fill())
+			return false;
+		int iLen = (int)qMin(iSkip, (qint64)m_szBuffer.size());
+		m_iBufferPos = iLen;
+		m_position.iSkip += iLen;
+		iSkip -= iLen;
+	}
+	return true;
+#else
+	qDebug("Can't read compressed log files: zlib support is not compiled in");
+	return false;
+#endif
+}
+
+#ifdef COMPILE_ZLIB_SUPPORT
+bool LogFileReader::startDecoding(qint64 iRawOffset)
+{
+	if(m_bZStreamInit)
+	{
+		inflateEnd(&m_zStream);
+		m_bZStreamInit = false;
+	}
+
+	memset(&m_zStream, 0, sizeof(m_zStream));
+	// 15 + 32: the default window size with gzip header detection
+	if(inflateInit2(&m_zStream, 15 + 32) != Z_OK)
+		return false;
+	m_bZStreamInit = true;
+	m_bMemberEnded = false;
+	m_szRawBuffer.clear();
+
+	if(!m_file.seek(iRawOffset))
+		return false;
+	m_iRawReadOffset = iRawOffset;
+
+	m_position.iRawOffset = iRawOffset;
+	m_position.iSkip = 0;
+	return true;
+}
+#endif
+
+bool LogFileReader::fill()
+{
+	m_szBuffer.clear();
+	m_iBufferPos = 0;
+
+	if(m_bEof)
+		return false;
+
+	if(!m_bCompressed)
+	{
+		m_szBuffer = m_file.read(KVI_LOGFILEREADER_CHUNK_SIZE);
+		if(m_szBuffer.isEmpty())
+		{
+			m_bEof = true;
+			return false;
+		}
+		return true;
+	}
+
+#ifdef COMPILE_ZLIB_SUPPORT
+	if(m_bMemberEnded)
+	{
+		// the next member starts right after the end of this one
+		if((m_zStream.avail_in == 0) && m_file.atEnd())
+		{
+			m_bEof = true;
+			return false;
+		}
+		inflateReset(&m_zStream);
+		m_bMemberEnded = false;
+		m_position.iRawOffset = m_iRawReadOffset - m_zStream.avail_in;
+		m_position.iSkip = 0;
+	}
+
+	// decode a single member at a time so the positions always refer to one of them
+	m_szBuffer.resize(KVI_LOGFILEREADER_CHUNK_SIZE);
+	m_zStream.next_out = (Bytef *)m_szBuffer.data();
+	m_zStream.avail_out = KVI_LOGFILEREADER_CHUNK_SIZE;
+
+	while(m_zStream.avail_out > 0)
+	{
+		if(m_zStream.avail_in == 0)
+		{
+			m_szRawBuffer = m_file.read(KVI_LOGFILEREADER_CHUNK_SIZE);
+			if(m_szRawBuffer.isEmpty())
+				break; // truncated file
+			m_iRawReadOffset += m_szRawBuffer.size();
+			m_zStream.next_in = (Bytef *)m_szRawBuffer.data();
+			m_zStream.avail_in = m_szRawBuffer.size();
+		}
+
+		int iRet = inflate(&m_zStream, Z_NO_FLUSH);
+		if(iRet == Z_STREAM_END)
+		{
+			m_bMemberEnded = true;
+			break;
+		}
+		if(iRet != Z_OK)
+		{
+			// garbage after the last member or a broken file: keep what we have
+			qDebug("Error decoding the compressed log file %s", m_file.fileName().toUtf8().data());
+			m_bEof = true;
+			break;
+		}
+	}
+
+	m_szBuffer.resize(KVI_LOGFILEREADER_CHUNK_SIZE - m_zStream.avail_out);
+	if(m_szBuffer.isEmpty())
+	{
+		if(m_bMemberEnded && !m_bEof)
+			return fill(); // an empty member
+		m_bEof = true;
+		return false;
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool LogFileReader::readLine(QByteArray & szLine)
+{
+	szLine.clear();
+	bool bGotData = false;
+
+	for(;;)
+	{
+		if(m_iBufferPos >= m_szBuffer.size())
+		{
+			if(!fill())
+				return bGotData;
+		}
+
+		int iEnd = m_szBuffer.indexOf('\n', m_iBufferPos);
+		if(iEnd == -1)
+		{
+			// the line continues in the next chunk
+			int iLen = m_szBuffer.size() - m_iBufferPos;
+			szLine.append(m_szBuffer.constData() + m_iBufferPos, iLen);
+			m_position.iSkip += iLen;
+			m_iBufferPos = m_szBuffer.size();
+			bGotData = true;
+			continue;
+		}
+
+		szLine.append(m_szBuffer.constData() + m_iBufferPos, iEnd - m_iBufferPos);
+		m_position.iSkip += iEnd - m_iBufferPos + 1;
+		m_iBufferPos = iEnd + 1;
+		if(szLine.endsWith('\r'))
+			szLine.chop(1);
+		return true;
+	}
+}
@@ -0,0 +1,124 @@
+#ifndef _LOGFILEREADER_H_
+#define _LOGFILEREADER_H_
+//=============================================================================
+//
+//   File : LogFileReader.h
+//   Creation date : Mon Oct 19 2026 22:41:05 CEST
+//
+//   This file is part of the KVIrc IRC client distribution
+//   Copyright (C) 2000-2026 Szymon Stefanek (pragma at kvirc dot net)
+//
+//   This program is FREE software. You can redistribute it and/or
+//   modify it under the terms of the GNU General Public License
+//   as published by the Free Software Foundation; either version 2
+//   of the License, or (at your option) any later version.
+//
+//   This program is distributed in the HOPE that it will be USEFUL,
+//   but WITHOUT ANY WARRANTY; without even the implied warranty of
+//   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//   See the GNU General Public License for more details.
+//
+//   You should have received a copy of the GNU General Public License
+//   along with this program. If not, write to the Free Software Foundation,
+//   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+//=============================================================================
+
+/**
+* \file LogFileReader.h
+* \brief Reads plain and compressed log files one line at a time
+*
+* Only a small chunk of the file is kept in memory. The reader can be
+* positioned at any line it has passed over before by saving its
+* position(). Compressed logs can be entered only at the start of a gzip
+* member: KVIrc appends one member at every log flush, so a seek point
+* is made of the member start and of the decoded bytes to skip in it.
+*/
+
+#include "kvi_settings.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#ifdef COMPILE_ZLIB_SUPPORT
+#include <zlib.h>
+#endif
+
+/**
+* \struct LogFileSeekPoint
+* \brief A position in a log file
+*/
+struct LogFileSeekPoint
+{
+	qint64 iRawOffset; /**< the file offset where the decoding starts: always 0 for plain files */
+	qint64 iSkip;      /**< the decoded bytes to skip from there */
+};
+
+/**
+* \class LogFileReader
+* \brief A forward only line reader for log files
+*/
+class LogFileReader
+{
+public:
+	LogFileReader(const QString & szFileName, bool bCompressed);
+	~LogFileReader();
+
+private:
+	QFile m_file;
+	bool m_bCompressed;
+	bool m_bOpen = false;
+	bool m_bEof = false;
+	QByteArray m_szBuffer; // decoded data
+	int m_iBufferPos = 0;
+	LogFileSeekPoint m_position; // of m_szBuffer[m_iBufferPos]
+#ifdef COMPILE_ZLIB_SUPPORT
+	z_stream m_zStream;
+	bool m_bZStreamInit = false;
+	bool m_bMemberEnded = false;
+	QByteArray m_szRawBuffer;
+	qint64 m_iRawReadOffset = 0; // the file offset after the data in m_szRawBuffer
+#endif
+
+public:
+	/**
+	* \brief Opens the file and positions the reader at its start
+	* \return bool
+	*/
+	bool open();
+
+	/**
+	* \brief Closes the file
+	* \return void
+	*/
+	void close();
+
+	/**
+	* \brief Positions the reader at a point previously returned by position()
+	* \param point The seek point
+	* \return bool
+	*/
+	bool seek(const LogFileSeekPoint & point);
+
+	/**
+	* \brief Reads the next line, without the line terminator
+	* \param szLine The buffer for the line
+	* \return bool false at the end of the file
+	*/
+	bool readLine(QByteArray & szLine);
+
+	/**
+	* \brief Returns the position of the next line
+	* \return const LogFileSeekPoint &
+	*/
+	const LogFileSeekPoint & position() const { return m_position; };
+
+private:
+	bool fill();
+#ifdef COMPILE_ZLIB_SUPPORT
+	bool startDecoding(qint64 iRawOffset);
+#endif
+};
+
+#endif // _LOGFILEREADER_H_
@@ -96,5 +96,8 @@ LogListViewItemType::LogListViewItemType(QTreeWidget * pPar, LogFile::Type eType
 LogListViewLog::LogListViewLog(QTreeWidgetItem * pPar, LogFile::Type eType, std::shared_ptr<LogFile> pLog)
     : LogListViewItem(pPar, eType, pLog)
 {
-	setText(0, m_pFileData->date().toString("yyyy-MM-dd"));
+	if(m_pFileData->segment() > 1)
+		setText(0, QString("%1 (%2)").arg(m_pFileData->date().toString("yyyy-MM-dd")).arg(m_pFileData->segment()));
+	else
+		setText(0, m_pFileData->date().toString("yyyy-MM-dd"));
 }
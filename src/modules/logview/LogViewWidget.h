@@ -75,7 +75,10 @@ public:
 protected:
 	bool operator<(const QTreeWidgetItem & other) const
 	{
-		return m_pFileData->date() < ((LogListViewLog *)&other)->m_pFileData->date();
+		const LogFile * pOther = ((LogListViewLog *)&other)->m_pFileData.get();
+		if(m_pFileData->date() != pOther->date())
+			return m_pFileData->date() < pOther->date();
+		return m_pFileData->segment() < pOther->segment();
 	}
 };
 
@@ -40,9 +40,11 @@
 #include "KviFileUtils.h"
 #include "KviFileDialog.h"
 #include "KviControlCodes.h"
+#include "KviLogFileWriter.h"
 
 #include "ExportOperation.h"
 
+#include <QHash>
 #include <QList>
 #include <QFileInfo>
 #include <QDir>
@@ -60,10 +62,14 @@
 #include <QTabWidget>
 #include <QCheckBox>
 #include <QMenu>
+#include <QApplication>
 #include <QtConcurrent>
 
 #include <climits> //for INT_MAX
 
+// the number of log lines shown at once
+#define KVI_LOGVIEW_PAGE_LINES 5000
+
 extern LogViewWindow * g_pLogViewWindow;
 
 LogViewListView::LogViewListView(QWidget * pParent)
@@ -182,9 +188,27 @@ LogViewWindow::LogViewWindow()
 	pWidget->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
 	pLayout->addWidget(pWidget, 11, 1);
 
-	m_pIrcView = new KviIrcView(m_pSplitter, this);
+	m_pRightLayout = new KviTalVBox(m_pSplitter);
+
+	m_pIrcView = new KviIrcView(m_pRightLayout, this);
 	m_pIrcView->setMaxBufferSize(INT_MAX);
 	m_pIrcView->setFocusPolicy(Qt::ClickFocus);
+	m_pRightLayout->setStretchFactor(m_pIrcView, 1);
+
+	// the logs are shown one page at a time
+	m_pPageLayout = new KviTalHBox(m_pRightLayout);
+	m_pFirstPageButton = new QPushButton(__tr2qs_ctx("First", "log"), m_pPageLayout);
+	connect(m_pFirstPageButton, SIGNAL(clicked()), this, SLOT(firstPage()));
+	m_pPreviousPageButton = new QPushButton(__tr2qs_ctx("Previous", "log"), m_pPageLayout);
+	connect(m_pPreviousPageButton, SIGNAL(clicked()), this, SLOT(previousPage()));
+	m_pPageLabel = new QLabel(m_pPageLayout);
+	m_pPageLabel->setAlignment(Qt::AlignCenter);
+	m_pPageLayout->setStretchFactor(m_pPageLabel, 1);
+	m_pNextPageButton = new QPushButton(__tr2qs_ctx("Next", "log"), m_pPageLayout);
+	connect(m_pNextPageButton, SIGNAL(clicked()), this, SLOT(nextPage()));
+	m_pLastPageButton = new QPushButton(__tr2qs_ctx("Last", "log"), m_pPageLayout);
+	connect(m_pLastPageButton, SIGNAL(clicked()), this, SLOT(lastPage()));
+	m_pPageLayout->setVisible(false);
 
 	QList<int> li;
 	li.append(110);
@@ -261,6 +285,19 @@ void LogViewWindow::recurseDirectory(const QString & szDir)
 {
 	QDir dir(szDir);
 	QFileInfoList list = dir.entryInfoList();
+
+	// the rotated logs list their segments in an index: the names are a fallback
+	QHash<QString, unsigned int> hSegments;
+	for(auto & info : list)
+	{
+		if(!info.isFile() || (info.suffix() != "segments"))
+			continue;
+		QStringList lSegments;
+		KviLogFileWriter::readSegmentIndex(dir.absoluteFilePath(info.completeBaseName() + ".log"), lSegments);
+		for(int i = 0; i < lSegments.count(); i++)
+			hSegments.insert(QFileInfo(lSegments.at(i)).absoluteFilePath(), i + 1);
+	}
+
 	for(int i = 0; i < list.count(); i++)
 	{
 		QFileInfo info = list[i];
@@ -272,7 +309,7 @@ void LogViewWindow::recurseDirectory(const QString & szDir)
 		}
 		else if((info.suffix() == "gz") || (info.suffix() == "log"))
 		{
-			m_logList.emplace_back(new LogFile(info.filePath()));
+			m_logList.emplace_back(new LogFile(info.filePath(), hSegments.value(info.absoluteFilePath(), 0)));
 		}
 	}
 }
@@ -339,9 +376,7 @@ void LogViewWindow::filterNext()
 
 	if(!m_pContentsMask->text().isEmpty())
 	{
-		QString szBuffer;
-		pFile->getText(szBuffer);
-		if(!KviQString::matchString(m_pContentsMask->text(), szBuffer))
+		if(!pFile->containsText(m_pContentsMask->text()))
 			goto filter_next;
 	}
 
@@ -424,15 +459,41 @@ void LogViewWindow::itemSelected(QTreeWidgetItem * it, QTreeWidgetItem *)
 {
 	//A parent node
 	m_pIrcView->clearBuffer();
+	m_pCurrentLog.reset();
 	if(!it || !it->parent() || !(((LogListViewItem *)it)->m_pFileData))
+	{
+		updatePageControls();
+		return;
+	}
+
+	m_pCurrentLog = ((LogListViewItem *)it)->m_pFileData;
+
+	// a single streaming pass over the file: only the seek points are kept
+	QApplication::setOverrideCursor(Qt::WaitCursor);
+	m_pCurrentLog->buildIndex();
+	QApplication::restoreOverrideCursor();
+
+	// start at the end, as the windows do
+	lastPage();
+}
+
+void LogViewWindow::showPage(qint64 iFirstLine)
+{
+	m_pIrcView->clearBuffer();
+	if(!m_pCurrentLog)
+	{
+		updatePageControls();
 		return;
+	}
 
-	QString szText;
-	((LogListViewItem *)it)->m_pFileData->getText(szText);
+	QStringList lines;
+	m_pCurrentLog->getLines(iFirstLine, KVI_LOGVIEW_PAGE_LINES, lines);
+	m_iFirstLine = iFirstLine;
 
-	QStringList lines = szText.split('\n');
 	bool bOk;
 	int iMsgType;
+	std::vector<KviIrcViewBatchLine> vLines;
+	vLines.reserve(lines.count());
 	for(auto & line : lines)
 	{
 		QString szNum = line.section(' ', 0, 0);
@@ -440,11 +501,55 @@ void LogViewWindow::itemSelected(QTreeWidgetItem * it, QTreeWidgetItem *)
 		if(iMsgType < 0 || iMsgType > (KVI_NUM_MSGTYPE_OPTIONS - 1))
 			iMsgType = 0;
 		if(bOk)
-			outputNoFmt(iMsgType, line.section(' ', 1), KviIrcView::NoRepaint | KviIrcView::NoTimestamp);
+			vLines.push_back({ iMsgType, line.section(' ', 1), QDateTime() });
 		else
-			outputNoFmt(0, line, KviIrcView::NoRepaint | KviIrcView::NoTimestamp);
+			vLines.push_back({ 0, line, QDateTime() });
 	}
+	// a single splice and trim of the view buffer for the whole page
+	outputBatch(vLines, KviIrcView::NoRepaint | KviIrcView::NoTimestamp);
 	m_pIrcView->repaint();
+
+	updatePageControls();
+}
+
+void LogViewWindow::updatePageControls()
+{
+	qint64 iLines = m_pCurrentLog ? m_pCurrentLog->lineCount() : 0;
+	if(iLines <= KVI_LOGVIEW_PAGE_LINES)
+	{
+		m_pPageLayout->setVisible(false);
+		return;
+	}
+
+	qint64 iLast = qMin(m_iFirstLine + KVI_LOGVIEW_PAGE_LINES, iLines);
+	m_pPageLabel->setText(__tr2qs_ctx("Lines %1-%2 of %3", "log").arg(m_iFirstLine + 1).arg(iLast).arg(iLines));
+	m_pFirstPageButton->setEnabled(m_iFirstLine > 0);
+	m_pPreviousPageButton->setEnabled(m_iFirstLine > 0);
+	m_pNextPageButton->setEnabled(iLast < iLines);
+	m_pLastPageButton->setEnabled(iLast < iLines);
+	m_pPageLayout->setVisible(true);
+}
+
+void LogViewWindow::firstPage()
+{
+	showPage(0);
+}
+
+void LogViewWindow::previousPage()
+{
+	showPage(qMax(m_iFirstLine - KVI_LOGVIEW_PAGE_LINES, (qint64)0));
+}
+
+void LogViewWindow::nextPage()
+{
+	if(m_pCurrentLog && (m_iFirstLine + KVI_LOGVIEW_PAGE_LINES < m_pCurrentLog->lineCount()))
+		showPage(m_iFirstLine + KVI_LOGVIEW_PAGE_LINES);
+}
+
+void LogViewWindow::lastPage()
+{
+	qint64 iLines = m_pCurrentLog ? m_pCurrentLog->lineCount() : 0;
+	showPage(qMax(iLines - KVI_LOGVIEW_PAGE_LINES, (qint64)0));
 }
 
 void LogViewWindow::rightButtonClicked(QTreeWidgetItem * pItem, const QPoint &)
@@ -491,6 +596,8 @@ void LogViewWindow::deleteCurrent()
 
 			delete pItem;
 			m_pIrcView->clearBuffer();
+			m_pCurrentLog.reset();
+			updatePageControls();
 		}
 		return;
 	}
@@ -552,6 +659,8 @@ void LogViewWindow::exportLog(LogFile::ExportType exportType)
 		std::shared_ptr<LogFile> pLog { pItem->log() };
 
 		QString szDate = pLog->date().toString("yyyy.MM.dd");
+		if(pLog->segment() > 1)
+			szDate += QString("+%1").arg(pLog->segment());
 
 		QString szLog = KVI_OPTION_STRING(KviOption_stringLogsExportPath).trimmed();
 		if(!szLog.isEmpty())
@@ -48,6 +48,7 @@ class QLineEdit;
 class QDateEdit;
 class QTabWidget;
 class QCheckBox;
+class QLabel;
 
 class LogViewListView : public QTreeWidget
 {
@@ -107,10 +108,23 @@ protected:
 	QTimer * m_pTimer;
 	QMenu * m_pExportLogPopup;
 
+	// Paging
+	KviTalVBox * m_pRightLayout;
+	KviTalHBox * m_pPageLayout;
+	QPushButton * m_pFirstPageButton;
+	QPushButton * m_pPreviousPageButton;
+	QPushButton * m_pNextPageButton;
+	QPushButton * m_pLastPageButton;
+	QLabel * m_pPageLabel;
+	std::shared_ptr<LogFile> m_pCurrentLog;
+	qint64 m_iFirstLine = 0;
+
 protected:
 	void exportLog(LogFile::ExportType exportType);
 	void recurseDirectory(const QString & szDir);
 	void setupItemList();
+	void showPage(qint64 iFirstLine);
+	void updatePageControls();
 
 	QPixmap * myIconPtr() override;
 	void resizeEvent(QResizeEvent * pEvent) override;
@@ -127,6 +141,10 @@ protected slots:
 	void cacheFileList();
 	void filterNext();
 	void exportLog(QAction * pAction);
+	void firstPage();
+	void previousPage();
+	void nextPage();
+	void lastPage();
 };
 
 #endif //_LOGVIEWWINDOW_H_
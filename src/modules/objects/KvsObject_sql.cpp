@@ -27,7 +27,13 @@
 #include "KviLocale.h"
 #include "KvsObject_sql.h"
 #include "KvsObject_memoryBuffer.h"
+#include "KviApplication.h"
+#include "KviConsoleWindow.h"
+#include "KviDebugWindow.h"
+#include "KviKvsRunTimeContext.h"
 #include <cstdlib>
+#include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QHash>
 #include <QSqlDriver>
 #include <QSqlError>
@@ -107,6 +113,47 @@
 		Returns a hash containing the current query's record fields.
 		!fn: $queryFinish()
 		Sets the current query to inactive.
+		!fn: <boolean> $setAsync(<enabled:boolean>[,<batch_interval:uint>])
+		Enables or disables the asynchronous mode for this object.[br]
+		In asynchronous mode the queries passed to [classfnc]$queryExecAsync[/classfnc]() are executed
+		on a dedicated thread with its own connection to the database, so slow queries
+		or disk synchronizations don't freeze KVIrc.
+		The connection must have been already set up with [classfnc]$setConnection[/classfnc]().[br]
+		If <batch_interval> is greater than zero then the INSERT, UPDATE, DELETE and REPLACE statements are
+		automatically grouped in transactions that are committed every <batch_interval> milliseconds
+		(or before any other kind of statement is executed). This greatly speeds up frequent writes, especially on SQLite.
+		In this case the results of the batched statements are delivered after the transaction has been committed.[br]
+		Disabling the asynchronous mode commits the pending batch and waits for the queued queries to complete.
+		Calling [classfnc]$setConnection[/classfnc]() or [classfnc]$closeConnection[/classfnc]() disables the asynchronous mode too.[br]
+		Returns true if the operation is successful, false otherwise.
+		!fn: <boolean> $isAsync()
+		Returns true if the asynchronous mode is enabled.
+		!fn: <id:integer> $queryExecAsync(<query:string>[,<bindings:hash>])
+		Queues the query <query> for asynchronous execution and returns its unique identifier.[br]
+		The optional <bindings> hash maps placeholder names (including the placeholder mark, e.g [b]:nick[/b])
+		to the values to be bound, with the same rules as [classfnc]$queryBindValue[/classfnc]().[br]
+		When the query has been executed [classfnc]$queryFinishedEvent[/classfnc]() is called.
+		The queries are executed in the order they are queued.
+		!fn: $asyncFlush()
+		Commits the pending batch of asynchronous writes as soon as possible.
+		!fn: $queryFinishedEvent(<id:integer>,<ok:boolean>,<records:array>,<error:string>,<last_insert_id:variant>)
+		This function is called when an asynchronous query completes.
+		<id> is the identifier returned by [classfnc]$queryExecAsync[/classfnc](), <ok> tells if the query was successful,
+		<records> is an array of hashes, one for each resulting record (as returned by [classfnc]$queryRecord[/classfnc]()),
+		<error> is the error description in case of failure and <last_insert_id> is the id of the last inserted row, if known.[br]
+		The default implementation emits the [classsnd]queryFinished[/classsnd]() signal.
+	@signals:
+		!sg: $queryFinished(<id:integer>,<ok:boolean>,<records:array>,<error:string>,<last_insert_id:variant>)
+		This signal is emitted by the default implementation of [classfnc]$queryFinishedEvent[/classfnc]().
+	@examples:
+		[example]
+			%db = $new(sql)
+			%db->$setConnection("/tmp/log.sqlite","log")
+			%db->$queryExec("CREATE TABLE IF NOT EXISTS msgs (nick TEXT, text TEXT)")
+			[comment]# group the inserts in transactions committed every second[/comment]
+			%db->$setAsync(1,1000)
+			%db->$queryExecAsync("INSERT INTO msgs VALUES (:nick,:text)",{":nick":"pragma",":text":"hello"})
+		[/example]
 */
 
 KVSO_BEGIN_REGISTERCLASS(KvsObject_sql, "sql", "object")
@@ -129,14 +176,22 @@ KVSO_REGISTER_HANDLER_BY_NAME(KvsObject_sql, queryFirst)
 KVSO_REGISTER_HANDLER_BY_NAME(KvsObject_sql, queryRecord)
 KVSO_REGISTER_HANDLER_BY_NAME(KvsObject_sql, lastError)
 KVSO_REGISTER_HANDLER_BY_NAME(KvsObject_sql, features)
+KVSO_REGISTER_HANDLER_BY_NAME(KvsObject_sql, setAsync)
+KVSO_REGISTER_HANDLER_BY_NAME(KvsObject_sql, isAsync)
+KVSO_REGISTER_HANDLER_BY_NAME(KvsObject_sql, queryExecAsync)
+KVSO_REGISTER_HANDLER_BY_NAME(KvsObject_sql, asyncFlush)
+KVSO_REGISTER_HANDLER_BY_NAME(KvsObject_sql, queryFinishedEvent)
 KVSO_END_REGISTERCLASS(KvsObject_sql)
 
 KVSO_BEGIN_CONSTRUCTOR(KvsObject_sql, KviKvsObject)
 
 m_pCurrentSQlQuery = nullptr;
+m_pAsyncWorker = nullptr;
+m_iLastAsyncId = 0;
 KVSO_END_CONSTRUCTOR(KvsObject_sql)
 
 KVSO_BEGIN_DESTRUCTOR(KvsObject_sql)
+stopAsyncWorker();
 if(m_pCurrentSQlQuery)
 	delete m_pCurrentSQlQuery;
 m_pCurrentSQlQuery = nullptr;
@@ -164,6 +219,12 @@ KVSO_CLASS_FUNCTION(sql, setConnection)
 	}
 	else
 		szDbDriver = "QSQLITE";
+	stopAsyncWorker();
+	m_szDbName = szDbName;
+	m_szDbDriver = szDbDriver;
+	m_szUserName = szUserName;
+	m_szHostName = szHostName;
+	m_szPassword = szPassword;
 	QSqlDatabase db;
 	db = QSqlDatabase::addDatabase(szDbDriver, szConnectionName);
 	mSzConnectionName = szConnectionName;
@@ -292,6 +353,8 @@ KVSO_CLASS_FUNCTION(sql, closeConnection)
 	KVSO_PARAMETER("connection_name", KVS_PT_STRING, KVS_PF_OPTIONAL, szConnectionName)
 	KVSO_PARAMETERS_END(c)
 
+	stopAsyncWorker();
+
 	if(!szConnectionName.isEmpty())
 	{
 		QStringList connections = QSqlDatabase::connectionNames();
@@ -360,30 +423,36 @@ KVSO_CLASS_FUNCTION(sql, queryBindValue)
 	KVSO_PARAMETER("bindName", KVS_PT_STRING, 0, szFieldName)
 	KVSO_PARAMETER("value", KVS_PT_VARIANT, 0, v)
 	KVSO_PARAMETERS_END(c)
-	QString szType;
-	v->getTypeName(szType);
+	QVariant value;
+	if(variantToSqlValue(c, v, value))
+		m_pCurrentSQlQuery->bindValue(szFieldName, value);
+	return true;
+}
+
+bool KvsObject_sql::variantToSqlValue(KviKvsObjectFunctionCall * c, KviKvsVariant * v, QVariant & value)
+{
 	if(v->isString() || v->isNothing())
 	{
 		QString szText;
 		v->asString(szText);
-		m_pCurrentSQlQuery->bindValue(szFieldName, QVariant(szText));
+		value = QVariant(szText);
 	}
 	else if(v->isReal())
 	{
 		kvs_real_t i;
 		v->asReal(i);
-		m_pCurrentSQlQuery->bindValue(szFieldName, QVariant((double)i));
+		value = QVariant((double)i);
 	}
 	else if(v->isInteger())
 	{
 		kvs_int_t i;
 		v->asInteger(i);
-		m_pCurrentSQlQuery->bindValue(szFieldName, QVariant((int)i));
+		value = QVariant((int)i);
 	}
 	else if(v->isBoolean())
 	{
 		bool b = v->asBoolean();
-		m_pCurrentSQlQuery->bindValue(szFieldName, QVariant(b));
+		value = QVariant(b);
 	}
 	else if(v->isHObject())
 	{
@@ -392,15 +461,19 @@ KVSO_CLASS_FUNCTION(sql, queryBindValue)
 		KviKvsObject * pObject;
 		pObject = KviKvsKernel::instance()->objectController()->lookupObject(hOb);
 		if(pObject->inheritsClass("memorybuffer"))
-			m_pCurrentSQlQuery->bindValue(szFieldName, QVariant(*((KvsObject_memoryBuffer *)pObject)->pBuffer()));
+			value = QVariant(*((KvsObject_memoryBuffer *)pObject)->pBuffer());
 		else
+		{
 			c->warning(__tr2qs_ctx("Only memorybuffer class object is supported", "objects"));
+			return false;
+		}
 	}
 	else
 	{
 		QString szTypeName;
 		v->getTypeName(szTypeName);
 		c->warning(__tr2qs_ctx("Type value %Q not supported", "objects"), &szTypeName);
+		return false;
 	}
 	return true;
 }
@@ -461,8 +534,13 @@ KVSO_CLASS_FUNCTION(sql, queryLast)
 KVSO_CLASS_FUNCTION(sql, queryRecord)
 {
 	CHECK_QUERY_IS_INIT
+	c->returnValue()->setHash(recordToHash(m_pCurrentSQlQuery->record(), c->context()));
+	return true;
+}
+
+KviKvsHash * KvsObject_sql::recordToHash(const QSqlRecord & record, KviKvsRunTimeContext * pContext)
+{
 	KviKvsHash * pHash = new KviKvsHash();
-	QSqlRecord record = m_pCurrentSQlQuery->record();
 	for(int i = 0; i < record.count(); i++)
 	{
 		KviKvsVariant * pValue = nullptr;
@@ -475,7 +553,7 @@ KVSO_CLASS_FUNCTION(sql, queryRecord)
 		{
 			KviKvsObjectClass * pClass = KviKvsKernel::instance()->objectController()->lookupClass("memoryBuffer");
 			KviKvsVariantList params(new KviKvsVariant(QString()));
-			KviKvsObject * pObject = pClass->allocateInstance(nullptr, "", c->context(), &params);
+			KviKvsObject * pObject = pClass->allocateInstance(nullptr, "", pContext, &params);
 			*((KvsObject_memoryBuffer *)pObject)->pBuffer() = value.toByteArray();
 			pValue = new KviKvsVariant(pObject->handle());
 		}
@@ -484,8 +562,7 @@ KVSO_CLASS_FUNCTION(sql, queryRecord)
 		pHash->set(record.fieldName(i), pValue);
 		(void)pHash->get(record.fieldName(i));
 	}
-	c->returnValue()->setHash(pHash);
-	return true;
+	return pHash;
 }
 
 KVSO_CLASS_FUNCTION(sql, lastError)
@@ -513,3 +590,371 @@ KVSO_CLASS_FUNCTION(sql, lastError)
 	c->returnValue()->setString(szError);
 	return true;
 }
+
+KVSO_CLASS_FUNCTION(sql, setAsync)
+{
+	bool bEnable;
+	kvs_uint_t uBatchInterval = 0;
+	KVSO_PARAMETERS_BEGIN(c)
+	KVSO_PARAMETER("enabled", KVS_PT_BOOLEAN, 0, bEnable)
+	KVSO_PARAMETER("batch_interval", KVS_PT_UNSIGNEDINTEGER, KVS_PF_OPTIONAL, uBatchInterval)
+	KVSO_PARAMETERS_END(c)
+
+	if(!bEnable)
+	{
+		stopAsyncWorker();
+		c->returnValue()->setBoolean(true);
+		return true;
+	}
+
+	CHECK_QUERY_IS_INIT
+
+	if(!m_pAsyncWorker)
+	{
+		m_pAsyncWorker = new KvsObject_sqlAsyncWorker(this, QString("kvirc_sql_async_%1").arg((quintptr)this, 0, 16));
+		m_pAsyncWorker->m_szDbName = m_szDbName;
+		m_pAsyncWorker->m_szDbDriver = m_szDbDriver;
+		m_pAsyncWorker->m_szUserName = m_szUserName;
+		m_pAsyncWorker->m_szHostName = m_szHostName;
+		m_pAsyncWorker->m_szPassword = m_szPassword;
+		m_pAsyncWorker->setBatchInterval(uBatchInterval);
+		m_pAsyncWorker->start();
+	}
+	else
+	{
+		m_pAsyncWorker->setBatchInterval(uBatchInterval);
+	}
+
+	c->returnValue()->setBoolean(true);
+	return true;
+}
+
+KVSO_CLASS_FUNCTION(sql, isAsync)
+{
+	c->returnValue()->setBoolean(m_pAsyncWorker);
+	return true;
+}
+
+KVSO_CLASS_FUNCTION(sql, queryExecAsync)
+{
+	QString szQuery;
+	KviKvsHash * pBindings = nullptr;
+	KVSO_PARAMETERS_BEGIN(c)
+	KVSO_PARAMETER("query", KVS_PT_NONEMPTYSTRING, 0, szQuery)
+	KVSO_PARAMETER("bindings", KVS_PT_HASH, KVS_PF_OPTIONAL, pBindings)
+	KVSO_PARAMETERS_END(c)
+
+	if(!m_pAsyncWorker)
+	{
+		c->error(__tr2qs_ctx("The asynchronous mode is not enabled: call $setAsync() first", "objects"));
+		return false;
+	}
+
+	KvsObject_sqlAsyncQuery q;
+	q.iId = ++m_iLastAsyncId;
+	q.szQuery = szQuery;
+
+	if(pBindings)
+	{
+		KviPointerHashTableIterator<QString, KviKvsVariant> it(*(pBindings->dict()));
+		while(KviKvsVariant * v = it.current())
+		{
+			QVariant value;
+			if(variantToSqlValue(c, v, value))
+				q.hBindings.insert(it.currentKey(), value);
+			++it;
+		}
+	}
+
+	m_pAsyncWorker->enqueue(q);
+
+	c->returnValue()->setInteger(q.iId);
+	return true;
+}
+
+KVSO_CLASS_FUNCTION(sql, asyncFlush)
+{
+	if(m_pAsyncWorker)
+		m_pAsyncWorker->requestFlush();
+	return true;
+}
+
+KVSO_CLASS_FUNCTION(sql, queryFinishedEvent)
+{
+	emitSignal("queryFinished", c, c->params());
+	return true;
+}
+
+void KvsObject_sql::stopAsyncWorker()
+{
+	if(!m_pAsyncWorker)
+		return;
+	m_pAsyncWorker->stop();
+	delete m_pAsyncWorker;
+	m_pAsyncWorker = nullptr;
+}
+
+bool KvsObject_sql::event(QEvent * e)
+{
+	if(e->type() != KvsObject_sqlAsyncResultEvent::Type)
+		return KviKvsObject::event(e);
+
+	KvsObject_sqlAsyncResultEvent * ev = (KvsObject_sqlAsyncResultEvent *)e;
+
+	// the memoryBuffer objects created for BLOB fields and the callback need a context:
+	// the debug window takes the errors when there is no console
+	KviWindow * pWnd = g_pApp->activeConsole();
+	if(!pWnd)
+		pWnd = KviDebugWindow::instance();
+	if(!pWnd)
+	{
+		// the main window is gone: there is nobody to run the callback for
+		unsigned int uFailed = 0;
+		for(auto & r : ev->vResults)
+		{
+			if(!r.bOk)
+				uFailed++;
+		}
+		qDebug("WARNING: dropping %u asynchronous results (%u failed) of the sql object '%s': no window to deliver them to",
+		    (unsigned int)ev->vResults.size(), uFailed, getName().toUtf8().data());
+		return true;
+	}
+	KviKvsVariant ret;
+	KviKvsRunTimeContext ctx(nullptr, pWnd, KviKvsKernel::instance()->emptyParameterList(), &ret, nullptr);
+
+	for(auto & r : ev->vResults)
+	{
+		KviKvsArray * pRecords = new KviKvsArray();
+		for(int i = 0; i < r.lRecords.count(); i++)
+			pRecords->set(i, new KviKvsVariant(recordToHash(r.lRecords.at(i), &ctx)));
+
+		KviKvsVariant * pLastInsertId;
+		if(r.lastInsertId.isValid())
+			pLastInsertId = new KviKvsVariant((kvs_int_t)r.lastInsertId.toLongLong());
+		else
+			pLastInsertId = new KviKvsVariant();
+
+		KviKvsVariantList lParams;
+		lParams.append(new KviKvsVariant((kvs_int_t)r.iId));
+		lParams.append(new KviKvsVariant(r.bOk));
+		lParams.append(new KviKvsVariant(pRecords));
+		lParams.append(new KviKvsVariant(r.szError));
+		lParams.append(pLastInsertId);
+		callFunction(this, "queryFinishedEvent", QString(), &ctx, &ret, &lParams);
+	}
+	return true;
+}
+
+const QEvent::Type KvsObject_sqlAsyncResultEvent::Type = (QEvent::Type)QEvent::registerEventType();
+
+KvsObject_sqlAsyncWorker::KvsObject_sqlAsyncWorker(QObject * pReceiver, const QString & szConnectionName)
+    : QThread(), m_pReceiver(pReceiver), m_szConnectionName(szConnectionName)
+{
+	m_uBatchInterval = 0;
+	m_bFlushRequested = false;
+	m_bTerminateRequested = false;
+}
+
+KvsObject_sqlAsyncWorker::~KvsObject_sqlAsyncWorker()
+{
+	if(isRunning())
+		stop();
+}
+
+void KvsObject_sqlAsyncWorker::enqueue(const KvsObject_sqlAsyncQuery & q)
+{
+	QMutexLocker locker(&m_Mutex);
+	m_lQueue.append(q);
+	m_Condition.wakeOne();
+}
+
+void KvsObject_sqlAsyncWorker::setBatchInterval(unsigned int uBatchInterval)
+{
+	QMutexLocker locker(&m_Mutex);
+	m_uBatchInterval = uBatchInterval;
+	m_Condition.wakeOne();
+}
+
+void KvsObject_sqlAsyncWorker::requestFlush()
+{
+	QMutexLocker locker(&m_Mutex);
+	m_bFlushRequested = true;
+	m_Condition.wakeOne();
+}
+
+void KvsObject_sqlAsyncWorker::stop()
+{
+	m_Mutex.lock();
+	m_bTerminateRequested = true;
+	m_Condition.wakeOne();
+	m_Mutex.unlock();
+	wait();
+}
+
+void KvsObject_sqlAsyncWorker::postResults(std::vector<KvsObject_sqlAsyncResult> & vResults)
+{
+	if(vResults.empty())
+		return;
+	KvsObject_sqlAsyncResultEvent * e = new KvsObject_sqlAsyncResultEvent();
+	e->vResults.swap(vResults);
+	QCoreApplication::postEvent(m_pReceiver, e);
+}
+
+static bool sql_is_write_statement(const QString & szQuery)
+{
+	QString szTrimmed = szQuery.trimmed();
+	return szTrimmed.startsWith("INSERT", Qt::CaseInsensitive) ||
+	    szTrimmed.startsWith("UPDATE", Qt::CaseInsensitive) ||
+	    szTrimmed.startsWith("DELETE", Qt::CaseInsensitive) ||
+	    szTrimmed.startsWith("REPLACE", Qt::CaseInsensitive);
+}
+
+void KvsObject_sqlAsyncWorker::run()
+{
+	{
+		// QSqlDatabase connections can be used only by the thread that created them
+		QSqlDatabase db = QSqlDatabase::addDatabase(m_szDbDriver, m_szConnectionName);
+		db.setDatabaseName(m_szDbName);
+		db.setHostName(m_szHostName);
+		db.setUserName(m_szUserName);
+		db.setPassword(m_szPassword);
+		bool bOpen = db.open();
+		QString szOpenError = bOpen ? QString() : db.lastError().text();
+
+		QSqlQuery query(db);
+
+		// the batched writes are reported only after the commit
+		std::vector<KvsObject_sqlAsyncResult> vBatch;
+		bool bInTransaction = false;
+		QElapsedTimer batchTimer;
+
+		for(;;)
+		{
+			m_Mutex.lock();
+
+			bool bFlush = false;
+			while(m_lQueue.isEmpty() && !m_bTerminateRequested)
+			{
+				if(m_bFlushRequested)
+					break;
+				if(!bInTransaction)
+				{
+					m_Condition.wait(&m_Mutex);
+					continue;
+				}
+				qint64 iRemaining = (qint64)m_uBatchInterval - batchTimer.elapsed();
+				if((iRemaining <= 0) || !m_Condition.wait(&m_Mutex, (unsigned long)iRemaining))
+				{
+					bFlush = true;
+					break;
+				}
+			}
+
+			if(m_bFlushRequested)
+			{
+				bFlush = true;
+				m_bFlushRequested = false;
+			}
+
+			bool bTerminate = m_bTerminateRequested && m_lQueue.isEmpty();
+			bool bHaveQuery = !m_lQueue.isEmpty();
+			KvsObject_sqlAsyncQuery q;
+			if(bHaveQuery)
+				q = m_lQueue.takeFirst();
+			// setBatchInterval() may change it as soon as the mutex is released
+			unsigned int uBatchInterval = m_uBatchInterval;
+			bool bBatching = uBatchInterval > 0;
+
+			m_Mutex.unlock();
+
+			bool bWrite = bHaveQuery && bBatching && bOpen && sql_is_write_statement(q.szQuery);
+
+			if(bInTransaction && (bFlush || bTerminate || (bHaveQuery && !bWrite) || (batchTimer.elapsed() >= (qint64)uBatchInterval)))
+			{
+				// commit the batch before anything else to keep the statement order
+				bool bCommitted = db.commit();
+				QString szCommitError = bCommitted ? QString() : db.lastError().text();
+				for(auto & r : vBatch)
+				{
+					if(!bCommitted && r.bOk)
+					{
+						r.bOk = false;
+						r.szError = szCommitError;
+					}
+				}
+				postResults(vBatch);
+				vBatch.clear();
+				bInTransaction = false;
+			}
+
+			if(!bHaveQuery)
+			{
+				if(bTerminate)
+					break;
+				continue;
+			}
+
+			KvsObject_sqlAsyncResult r;
+			r.iId = q.iId;
+
+			if(!bOpen)
+			{
+				r.bOk = false;
+				r.szError = szOpenError;
+			}
+			else
+			{
+				if(bWrite && !bInTransaction)
+				{
+					bInTransaction = db.transaction();
+					batchTimer.start();
+				}
+
+				if(q.hBindings.isEmpty())
+				{
+					r.bOk = query.exec(q.szQuery);
+				}
+				else
+				{
+					r.bOk = query.prepare(q.szQuery);
+					if(r.bOk)
+					{
+						for(auto it = q.hBindings.constBegin(); it != q.hBindings.constEnd(); ++it)
+							query.bindValue(it.key(), it.value());
+						r.bOk = query.exec();
+					}
+				}
+
+				if(r.bOk)
+				{
+					if(query.isSelect())
+					{
+						while(query.next())
+							r.lRecords.append(query.record());
+					}
+					r.lastInsertId = query.lastInsertId();
+				}
+				else
+				{
+					r.szError = query.lastError().text();
+				}
+				query.finish();
+			}
+
+			if(bInTransaction)
+			{
+				vBatch.push_back(r);
+			}
+			else
+			{
+				std::vector<KvsObject_sqlAsyncResult> vResults;
+				vResults.push_back(r);
+				postResults(vResults);
+			}
+		}
+
+		db.close();
+	}
+
+	QSqlDatabase::removeDatabase(m_szConnectionName);
+}
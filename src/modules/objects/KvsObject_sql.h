@@ -30,7 +30,18 @@
 #include "KviKvsVariant.h"
 #include "object_macros.h"
 #include <QSqlQuery>
+#include <QSqlRecord>
 #include <QHash>
+#include <QEvent>
+#include <QList>
+#include <QMutex>
+#include <QThread>
+#include <QVariant>
+#include <QWaitCondition>
+
+#include <vector>
+
+class KvsObject_sqlAsyncWorker;
 
 class KvsObject_sql : public KviKvsObject
 {
@@ -39,6 +50,14 @@ public:
 protected:
 	QSqlQuery * m_pCurrentSQlQuery;
 	QString mSzConnectionName;
+	// the connection parameters: the async worker opens its own connection with them
+	QString m_szDbName;
+	QString m_szDbDriver;
+	QString m_szUserName;
+	QString m_szHostName;
+	QString m_szPassword;
+	KvsObject_sqlAsyncWorker * m_pAsyncWorker;
+	int m_iLastAsyncId;
 
 public:
 	bool setConnection(KviKvsObjectFunctionCall * c);
@@ -62,6 +81,91 @@ public:
 	bool queryFinish(KviKvsObjectFunctionCall * c);
 	bool closeConnection(KviKvsObjectFunctionCall * c);
 	bool lastError(KviKvsObjectFunctionCall * c);
+
+	bool setAsync(KviKvsObjectFunctionCall * c);
+	bool isAsync(KviKvsObjectFunctionCall * c);
+	bool queryExecAsync(KviKvsObjectFunctionCall * c);
+	bool asyncFlush(KviKvsObjectFunctionCall * c);
+	bool queryFinishedEvent(KviKvsObjectFunctionCall * c);
+
+protected:
+	bool event(QEvent * e) override;
+	void stopAsyncWorker();
+	bool variantToSqlValue(KviKvsObjectFunctionCall * c, KviKvsVariant * v, QVariant & value);
+	KviKvsHash * recordToHash(const QSqlRecord & record, KviKvsRunTimeContext * pContext);
+};
+
+//
+// INTERNAL CLASSES
+//
+
+class KvsObject_sqlAsyncQuery
+{
+public:
+	int iId;
+	QString szQuery;
+	QHash<QString, QVariant> hBindings;
+};
+
+class KvsObject_sqlAsyncResult
+{
+public:
+	int iId;
+	bool bOk;
+	QString szError;
+	QList<QSqlRecord> lRecords;
+	QVariant lastInsertId;
+};
+
+class KvsObject_sqlAsyncResultEvent : public QEvent
+{
+public:
+	static const QEvent::Type Type;
+
+	KvsObject_sqlAsyncResultEvent()
+	    : QEvent(Type){};
+
+public:
+	std::vector<KvsObject_sqlAsyncResult> vResults;
+};
+
+// Executes the queries of a single sql object on a dedicated connection.
+// The results are posted back to the object as KvsObject_sqlAsyncResultEvent,
+// in the same order the queries were queued.
+class KvsObject_sqlAsyncWorker : public QThread
+{
+public:
+	KvsObject_sqlAsyncWorker(QObject * pReceiver, const QString & szConnectionName);
+	~KvsObject_sqlAsyncWorker();
+
+public:
+	QString m_szDbName;
+	QString m_szDbDriver;
+	QString m_szUserName;
+	QString m_szHostName;
+	QString m_szPassword;
+
+protected:
+	QObject * m_pReceiver;
+	QString m_szConnectionName;
+	QMutex m_Mutex; // protects everything below
+	QWaitCondition m_Condition;
+	QList<KvsObject_sqlAsyncQuery> m_lQueue;
+	unsigned int m_uBatchInterval; // msecs, 0 disables batching
+	bool m_bFlushRequested;
+	bool m_bTerminateRequested;
+
+public:
+	// all these are called from the GUI thread
+	void enqueue(const KvsObject_sqlAsyncQuery & q);
+	void setBatchInterval(unsigned int uBatchInterval);
+	void requestFlush();
+	// flushes the pending batch and waits for the thread to exit
+	void stop();
+
+protected:
+	void run() override;
+	void postResults(std::vector<KvsObject_sqlAsyncResult> & vResults);
 };
 
 #endif //_CLASS_SQLITE_H_
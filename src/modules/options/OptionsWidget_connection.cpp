@@ -182,10 +182,32 @@ OptionsWidget_connectionSocket::OptionsWidget_connectionSocket(QWidget * parent)
 	                        "you want to rely on the DNS server to provide the best choice.",
 	                "options"));
 
-	b = addBoolSelector(0, 5, 0, 5, __tr2qs_ctx("Drop connection on SASL authentication failure", "options"), KviOption_boolDropConnectionOnSaslFailure);
+	b = addBoolSelector(0, 5, 0, 5, __tr2qs_ctx("Connect to the fastest server address", "options"), KviOption_boolConnectToFastestServerAddress);
+	mergeTip(b, __tr2qs_ctx("This option will cause KVIrc to look up both the IPv4 and the IPv6 "
+	                        "addresses of the server and to try them in parallel, with a short "
+	                        "delay between the attempts. The first connection that succeeds is used "
+	                        "and the others are dropped. This avoids long waits when one of the "
+	                        "address families is broken on your network.",
+	                "options"));
+
+	u = addUIntSelector(0, 6, 0, 6, __tr2qs_ctx("Remember server lookups for:", "options"), KviOption_uintDnsCacheTimeout, 0, 86400, 300);
+	u->setSuffix(__tr2qs_ctx(" sec", "options"));
+	mergeTip(u, __tr2qs_ctx("The addresses of the server hostnames are reused for this time "
+	                        "when reconnecting. Set it to 0 to always perform a new lookup.",
+	                "options"));
+
+	u = addUIntSelector(0, 7, 0, 7, __tr2qs_ctx("Spread the channel joins of the connections by:", "options"), KviOption_uintJoinBurstInterval, 0, 60000, 500);
+	u->setSuffix(__tr2qs_ctx(" msec", "options"));
+	mergeTip(u, __tr2qs_ctx("When many connections log in at the same time, like at startup or "
+	                        "after a network outage, each one waits this long after the previous "
+	                        "one before joining its channels. This keeps KVIrc responsive while "
+	                        "the channel windows are created. Set it to 0 to join immediately.",
+	                "options"));
+
+	b = addBoolSelector(0, 8, 0, 8, __tr2qs_ctx("Drop connection on SASL authentication failure", "options"), KviOption_boolDropConnectionOnSaslFailure);
 	mergeTip(b, __tr2qs_ctx("This option will close the socket if no SASL authentication or any SASL fallback had succeeded.", "options"));
 
-	addRowSpacer(0, 6, 0, 6);
+	addRowSpacer(0, 9, 0, 9);
 }
 
 OptionsWidget_connectionSocket::~OptionsWidget_connectionSocket()
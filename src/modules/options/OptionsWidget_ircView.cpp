@@ -160,7 +160,19 @@ OptionsWidget_ircViewFeatures::OptionsWidget_ircViewFeatures(QWidget * parent)
 	addBoolSelector(pGroup, __tr2qs_ctx("Channel links", "options"), KviOption_boolEnableChannelLinkToolTip);
 	addBoolSelector(pGroup, __tr2qs_ctx("Escape sequences", "options"), KviOption_boolEnableEscapeLinkToolTip);
 
-	addRowSpacer(0, 14, 0, 14);
+	pGroup = addGroupBox(0, 14, 0, 14, Qt::Horizontal, __tr2qs_ctx("Scrollback Snapshots", "options"));
+	KviBoolSelector * b = addBoolSelector(pGroup, __tr2qs_ctx("Restore the scrollback of channels and queries", "options"), KviOption_boolKeepScrollbackSnapshots);
+	mergeTip(b, __tr2qs_ctx("This option will cause KVIrc to save the last lines of the channels and the queries "
+	                        "when they are closed and to show them again the next time they are opened.", "options"));
+	s = addUIntSelector(pGroup, __tr2qs_ctx("Lines to keep:", "options"), KviOption_uintScrollbackSnapshotLines, 1, 32767, 500, KVI_OPTION_BOOL(KviOption_boolKeepScrollbackSnapshots));
+	s->setSuffix(__tr2qs_ctx(" lines", "options"));
+	connect(b, SIGNAL(toggled(bool)), s, SLOT(setEnabled(bool)));
+	s = addUIntSelector(pGroup, __tr2qs_ctx("Save them every:", "options"), KviOption_uintScrollbackSnapshotInterval, 0, 86400, 300, KVI_OPTION_BOOL(KviOption_boolKeepScrollbackSnapshots));
+	s->setSuffix(__tr2qs_ctx(" sec", "options"));
+	mergeTip(s, __tr2qs_ctx("Set it to 0 to save them only when the windows are closed.", "options"));
+	connect(b, SIGNAL(toggled(bool)), s, SLOT(setEnabled(bool)));
+
+	addRowSpacer(0, 15, 0, 15);
 }
 
 OptionsWidget_ircViewFeatures::~OptionsWidget_ircViewFeatures()
@@ -59,11 +59,25 @@ OptionsWidget_logging::OptionsWidget_logging(QWidget * parent)
 	mergeTip(us, __tr2qs_ctx("Save logs with the current interval.<br>"
 	                         "Set to 0 to disable this feature", "options"));
 
+	us = addUIntSelector(0, 6, 0, 6, __tr2qs_ctx("Write logs to disk after:", "options"), KviOption_uintLogWriteLatency, 0, 60000, 1000);
+	us->setSuffix(__tr2qs_ctx(" msec", "options"));
+
+	mergeTip(us, __tr2qs_ctx("The log lines are collected in memory and written in a single chunk after this delay.<br>"
+	                         "Set to 0 to write each line immediately", "options"));
+
+	us = addUIntSelector(0, 7, 0, 7, __tr2qs_ctx("Start a new log file after:", "options"), KviOption_uintLogRotationSize, 0, 99999, 100);
+	us->setSuffix(__tr2qs_ctx(" MiB", "options"));
+
+	mergeTip(us, __tr2qs_ctx("When a log file grows over this size the log continues in a new segment file.<br>"
+	                         "Set to 0 to disable this feature", "options"));
+
+	addBoolSelector(0, 8, 0, 8, __tr2qs_ctx("Start new log files every day", "options"), KviOption_boolRotateLogsDaily);
+
 #ifdef COMPILE_ZLIB_SUPPORT
-	addBoolSelector(0, 6, 0, 6, __tr2qs_ctx("Compress logs", "options"), KviOption_boolGzipLogs);
+	addBoolSelector(0, 9, 0, 9, __tr2qs_ctx("Compress logs", "options"), KviOption_boolGzipLogs);
 #endif
 
-	addRowSpacer(0, 7, 0, 7);
+	addRowSpacer(0, 10, 0, 10);
 }
 
 OptionsWidget_logging::~OptionsWidget_logging()
@@ -46,24 +46,28 @@ OptionsWidget_uparser::OptionsWidget_uparser(QWidget * parent)
 	addSeparator(0, 4, 0, 4);
 
 	addBoolSelector(0, 5, 0, 5, __tr2qs_ctx("Automatically unload unused modules", "options"), KviOption_boolCleanupUnusedModules);
-	addBoolSelector(0, 6, 0, 6, __tr2qs_ctx("Ignore module versions (dangerous)", "options"), KviOption_boolIgnoreModuleVersions);
+	b = addBoolSelector(0, 6, 0, 6, __tr2qs_ctx("Preload frequently used modules", "options"), KviOption_boolPreloadFrequentModules);
+	mergeTip(b, __tr2qs_ctx("This option will cause KVIrc to load the modules used in the recent sessions "
+	                        "in the background at startup, so the first command using them doesn't have to wait. "
+	                        "These modules are also never unloaded automatically.", "options"));
+	addBoolSelector(0, 7, 0, 7, __tr2qs_ctx("Ignore module versions (dangerous)", "options"), KviOption_boolIgnoreModuleVersions);
 
-	addSeparator(0, 7, 0, 7);
+	addSeparator(0, 8, 0, 8);
 
-	b = addBoolSelector(0, 8, 0, 8, __tr2qs_ctx("Relay errors and warnings to debug window", "options"), KviOption_boolScriptErrorsToDebugWindow);
+	b = addBoolSelector(0, 9, 0, 9, __tr2qs_ctx("Relay errors and warnings to debug window", "options"), KviOption_boolScriptErrorsToDebugWindow);
 	mergeTip(b, __tr2qs_ctx("This option will show the script errors and warnings "
 	                        "also in the special debug window. This makes tracking of scripts that might "
 	                        "be running in several windows far easier. The messages in the debug window "
 	                        "also contain a deeper call stack which will help you to identify the "
 	                        "scripting problems.", "options"));
 
-	b1 = addBoolSelector(0, 9, 0, 9, __tr2qs_ctx("Create debug window without focus", "options"), KviOption_boolShowMinimizedDebugWindow);
+	b1 = addBoolSelector(0, 10, 0, 10, __tr2qs_ctx("Create debug window without focus", "options"), KviOption_boolShowMinimizedDebugWindow);
 	mergeTip(b1, __tr2qs_ctx("This option prevents the debug window "
 	                         "from opening and diverting application focus.<br>"
 	                         "Enable this if you don't like the debug window "
 	                         "popping up while you're typing something in a channel.", "options"));
 
-	addRowSpacer(0, 10, 0, 10);
+	addRowSpacer(0, 11, 0, 11);
 }
 
 OptionsWidget_uparser::~OptionsWidget_uparser()
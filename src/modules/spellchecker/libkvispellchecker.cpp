@@ -24,12 +24,75 @@
 
 #include "KviModule.h"
 #include "KviOptions.h"
+#include "KviSpellChecker.h"
+
+#include <QMutex>
+#include <QAtomicInt>
 
 #include <enchant.h>
 #include <enchant-provider.h>
 
 static EnchantBroker * g_pEnchantBroker = nullptr;
 static KviPointerList<EnchantDict> * g_pEnchantDicts = nullptr;
+// the dictionaries are also used by the input editor spell checking thread
+static QMutex g_DictsMutex;
+static QAtomicInt g_iDictsGeneration;
+
+static bool spellchecker_check_word(const QString & szWord)
+{
+	QByteArray utf8 = szWord.toUtf8();
+	QMutexLocker locker(&g_DictsMutex);
+	bool bResult = g_pEnchantDicts->isEmpty();
+	KviPointerListIterator<EnchantDict> it(*g_pEnchantDicts);
+	for(bool b = it.moveFirst(); b; b = it.moveNext())
+		bResult |= enchant_dict_check(*it, utf8.data(), utf8.size()) == 0;
+	return bResult;
+}
+
+static void spellchecker_word_suggestions(const QString & szWord, QStringList & lSuggestions)
+{
+	QHash<QString, int> hAllSuggestions;
+
+	QMutexLocker locker(&g_DictsMutex);
+	if(!g_pEnchantDicts->isEmpty())
+	{
+		QByteArray utf8 = szWord.toUtf8();
+
+		KviPointerListIterator<EnchantDict> it(*g_pEnchantDicts);
+		for(bool b = it.moveFirst(); b; b = it.moveNext())
+		{
+			size_t iCount = 0;
+			char ** suggestions = enchant_dict_suggest(*it, utf8.data(), utf8.size(), &iCount);
+			if(suggestions)
+			{
+				for(size_t i = 0; i < iCount; i++)
+					hAllSuggestions.insert(QString::fromUtf8(suggestions[i]), 1);
+				enchant_dict_free_string_list(*it, suggestions);
+			}
+		}
+	}
+
+	lSuggestions = hAllSuggestions.keys();
+}
+
+class SpellCheckerInterface : public KviSpellCheckerInterface
+{
+public:
+	bool check(const QString & szWord) override
+	{
+		return spellchecker_check_word(szWord);
+	}
+	void suggestions(const QString & szWord, QStringList & lSuggestions) override
+	{
+		spellchecker_word_suggestions(szWord, lSuggestions);
+	}
+	unsigned int dictionaryGeneration() override
+	{
+		return (unsigned int)g_iDictsGeneration.loadAcquire();
+	}
+};
+
+static SpellCheckerInterface g_SpellCheckerInterface;
 
 /*
 	@doc: spellchecker.available_dictionaries
@@ -87,13 +150,8 @@ static bool spellchecker_kvs_check(KviKvsModuleFunctionCall * c)
 	KVSM_PARAMETERS_BEGIN(c)
 	KVSM_PARAMETER("word", KVS_PT_STRING, 0, szWord)
 	KVSM_PARAMETERS_END(c)
-	QByteArray utf8 = szWord.toUtf8();
-	bool bResult = g_pEnchantDicts->isEmpty();
-	KviPointerListIterator<EnchantDict> it(*g_pEnchantDicts);
-	for(bool b = it.moveFirst(); b; b = it.moveNext())
-		bResult |= enchant_dict_check(*it, utf8.data(), utf8.size()) == 0;
 
-	c->returnValue()->setBoolean(bResult);
+	c->returnValue()->setBoolean(spellchecker_check_word(szWord));
 	return true;
 }
 
@@ -120,29 +178,12 @@ static bool spellchecker_kvs_suggestions(KviKvsModuleFunctionCall * c)
 	KVSM_PARAMETER("word", KVS_PT_STRING, 0, szWord)
 	KVSM_PARAMETERS_END(c)
 
-	QHash<QString, int> hAllSuggestions;
-
-	if(!g_pEnchantDicts->isEmpty())
-	{
-		QByteArray utf8 = szWord.toUtf8();
-
-		KviPointerListIterator<EnchantDict> it(*g_pEnchantDicts);
-		for(bool b = it.moveFirst(); b; b = it.moveNext())
-		{
-			size_t iCount = 0;
-			char ** suggestions = enchant_dict_suggest(*it, utf8.data(), utf8.size(), &iCount);
-			if(suggestions)
-			{
-				for(size_t i = 0; i < iCount; i++)
-					hAllSuggestions.insert(QString::fromUtf8(suggestions[i]), 1);
-				enchant_dict_free_string_list(*it, suggestions);
-			}
-		}
-	}
+	QStringList lSuggestions;
+	spellchecker_word_suggestions(szWord, lSuggestions);
 
 	KviKvsArray * pArray = new KviKvsArray();
 
-	for(const auto & szSuggestion : hAllSuggestions.keys())
+	for(const auto & szSuggestion : lSuggestions)
 		pArray->append(new KviKvsVariant(szSuggestion));
 
 	c->returnValue()->setArray(pArray);
@@ -151,6 +192,9 @@ static bool spellchecker_kvs_suggestions(KviKvsModuleFunctionCall * c)
 
 static void spellchecker_reload_dicts()
 {
+	QMutexLocker locker(&g_DictsMutex);
+	g_iDictsGeneration.ref();
+
 	while(!g_pEnchantDicts->isEmpty())
 		enchant_broker_free_dict(g_pEnchantBroker, g_pEnchantDicts->takeFirst());
 
@@ -208,8 +252,22 @@ static bool spellchecker_module_init(KviModule * m)
 	return true;
 }
 
+static bool spellchecker_module_ctrl(KviModule *, const char * pcOperation, void * pParam)
+{
+	if(!kvi_strEqualCI("spellchecker::getInterface", pcOperation))
+		return false;
+
+	KviSpellCheckerInterface ** ppInterface = (KviSpellCheckerInterface **)pParam;
+	if(!ppInterface)
+		return false;
+
+	*ppInterface = &g_SpellCheckerInterface;
+	return true;
+}
+
 static bool spellchecker_module_cleanup(KviModule *)
 {
+	// KviSpellChecker has already stopped its thread (on moduleAboutToUnload())
 	while(!g_pEnchantDicts->isEmpty())
 		enchant_broker_free_dict(g_pEnchantBroker, g_pEnchantDicts->takeFirst());
 
@@ -227,6 +285,6 @@ KVIRC_MODULE(
     "Spell checker",
     spellchecker_module_init,
     0,
-    0,
+    spellchecker_module_ctrl,
     spellchecker_module_cleanup,
     0)
@@ -619,6 +619,62 @@ static bool window_kvs_fnc_hasOutput(KviKvsModuleFunctionCall * c)
 	return true;
 }
 
+/*
+	@doc: window.paintStats
+	@type:
+		function
+	@title:
+		$window.paintStats
+	@short:
+		Returns the painting statistics of a window text output widget
+	@syntax:
+		<hash> $window.paintStats
+		<hash> $window.paintStats(<window_id>)
+	@description:
+		Returns a hash with the painting statistics of the text output widget
+		of the window specified by <window_id>. The form with no parameters
+		works on the current window. The hash contains the following keys:[br]
+		[b]paints[/b]: the number of repaints performed since the window has been created[br]
+		[b]painttime[/b]: the total time spent in the repaints, in microseconds[br]
+		[b]paintrate[/b]: the number of repaints performed in the last second[br]
+		[b]requests[/b]: the number of repaints requested by the new lines of text[br]
+		[b]skipped[/b]: the number of requested repaints dropped because the window was not visible[br]
+		[b]frameinterval[/b]: the current interval between the repaints of the new lines of all the windows, in milliseconds[br]
+		[b]cachehits[/b], [b]cachemisses[/b], [b]cacheevictions[/b]: the counters of the shaped text cache[br]
+		[b]cachebytes[/b]: the approximate memory used by the shaped text cache[br]
+		The new lines of all the windows are painted together at most once per display frame:
+		the requests are coalesced so [b]paints[/b] is usually much lower than [b]requests[/b].
+		When painting can't keep up with the incoming text the frame interval grows
+		and more lines are shown in each repaint.
+		The shaped text cache is shared by all the windows.
+		If the window doesn't exist or has no text output widget then an empty hash is returned.
+	@seealso:
+		[fnc]$window.hasOutput[/fnc]
+*/
+
+static bool window_kvs_fnc_paintStats(KviKvsModuleFunctionCall * c)
+{
+	GET_KVS_FNC_WINDOW_ID
+	KviKvsHash * pHash = new KviKvsHash();
+	if(pWnd && pWnd->view())
+	{
+		kvi_u64_t uHits, uMisses, uEvictions, uBytes;
+		KviIrcView::glyphCacheStatistics(uHits, uMisses, uEvictions, uBytes);
+		pHash->set("paints", new KviKvsVariant((kvs_int_t)pWnd->view()->paintCount()));
+		pHash->set("painttime", new KviKvsVariant((kvs_int_t)(pWnd->view()->paintTime() / 1000)));
+		pHash->set("paintrate", new KviKvsVariant((kvs_int_t)pWnd->view()->paintRate()));
+		pHash->set("requests", new KviKvsVariant((kvs_int_t)pWnd->view()->paintRequests()));
+		pHash->set("skipped", new KviKvsVariant((kvs_int_t)pWnd->view()->skippedRepaints()));
+		pHash->set("frameinterval", new KviKvsVariant((kvs_int_t)KviIrcView::repaintFrameInterval()));
+		pHash->set("cachehits", new KviKvsVariant((kvs_int_t)uHits));
+		pHash->set("cachemisses", new KviKvsVariant((kvs_int_t)uMisses));
+		pHash->set("cacheevictions", new KviKvsVariant((kvs_int_t)uEvictions));
+		pHash->set("cachebytes", new KviKvsVariant((kvs_int_t)uBytes));
+	}
+	c->returnValue()->setHash(pHash);
+	return true;
+}
+
 /*
 	@doc: window.exists
 	@type:
@@ -1630,6 +1686,7 @@ static bool window_module_init(KviModule * m)
 	KVSM_REGISTER_FUNCTION(m, "console", window_kvs_fnc_console);
 	KVSM_REGISTER_FUNCTION(m, "hasUserFocus", window_kvs_fnc_hasUserFocus);
 	KVSM_REGISTER_FUNCTION(m, "hasOutput", window_kvs_fnc_hasOutput);
+	KVSM_REGISTER_FUNCTION(m, "paintStats", window_kvs_fnc_paintStats);
 	KVSM_REGISTER_FUNCTION(m, "isDocked", window_kvs_fnc_isDocked);
 	KVSM_REGISTER_FUNCTION(m, "isSplitView", window_kvs_fnc_isSplitView);
 	KVSM_REGISTER_FUNCTION(m, "isMinimized", window_kvs_fnc_fake); // compat only